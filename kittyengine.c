@@ -4,6 +4,26 @@
 #include <SDL2/SDL_image.h>
 #include <sys/time.h>
 #include <math.h>
+#include <float.h>
+#if defined(__GLIBC__) || defined(__APPLE__)
+#include <execinfo.h>
+#define K_HAS_BACKTRACE 1
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define K_HAS_MMAP 1
+#endif
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef _MSC_VER
+#define K_THREAD_LOCAL __declspec(thread)
+#else
+#define K_THREAD_LOCAL _Thread_local
+#endif
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -12,10 +32,21 @@
 
 #include "kittyengine.h"
 
+// Slot of the id map, a robin hood open addressing table from user id to object index
+typedef struct {
+    Uint64 id;      // 0 marks an empty slot
+    size_t index;
+} k_IdSlot;
+
 typedef struct {
     size_t total_allocated;
     size_t allocation_count;
     Kitty_Object* objects;
+    k_IdSlot* ids;          // power of two sized, at most 7/8 full
+    size_t id_capacity;
+    size_t id_count;
+    unsigned char* removed; // scratch bitmap of Kitty_RemoveObjects, kept across calls
+    size_t removed_capacity;
 } k_ObjectMSpace;
 
 static const char* window_title = "Kitty Engine Window";
@@ -26,21 +57,185 @@ static const size_t K_DEFAULT_OBJECT_MSPACE_SIZE = 1024 * 1024; // 1 MB
 
 static k_ObjectMSpace* object_mspace = NULL;
 
+// Tagged allocator: engine blocks are plain heap blocks, so callers may still free or replace the ones in public
+// fields; their size and tag live in a robin hood table keyed by address, like the id map. Loaded SDL surfaces are
+// kept there too, counted by bytes only. The table and the stats are shared with the raster, worker and loader
+// threads under k_memory_lock; the table itself comes from the C library and is not counted.
+typedef struct {
+    void* block;    // NULL marks an empty slot
+    size_t size;
+    enum Kitty_MemoryTag tag;
+    bool heap;      // false for SDL surfaces, which are not live blocks of the engine heap
+} k_BlockSlot;
+static k_BlockSlot* k_blocks = NULL;    // power of two sized, at most 7/8 full
+static size_t k_block_capacity = 0;
+static size_t k_block_count = 0;
+static Kitty_Allocator k_allocator = {0};  // NULL functions use the C library
+static Kitty_MemoryStats k_memory_stats = {0};
+static SDL_SpinLock k_memory_lock = 0;
+
+// Allocation check: frame functions raise k_frame_scope on their thread, workers and the raster thread raise it while
+// they run work a frame handed them, other threads (the world loader) never do. Allocations on a thread with the scope
+// up count towards the frame and, with the check on, are reported; reports live in a fixed array so the hook never allocates
+#define K_MAX_ALLOCATION_REPORTS 64
+static K_THREAD_LOCAL int k_frame_scope = 0;
+static SDL_atomic_t k_frame_allocations = {0};     // since the previous Kitty_FlipBuffers
+static SDL_atomic_t k_allocation_check = {0};
+static Kitty_AllocationReport k_allocation_reports[K_MAX_ALLOCATION_REPORTS];
+static size_t k_allocation_violations = 0;
+
 static size_t frame_num = 0;
 static clock_t start_time = 0;
 static double frame_time = 0;
 
-static clock_t timer_1 = 0;
+static double timer_1 = 0.0;
 
 //SDL VARS
 static SDL_Window* sdl_window = NULL;
 static SDL_Renderer* sdl_renderer = NULL;
 
+// Render backend, every draw call of the engine goes through it
+static Kitty_RenderBackend k_backend_slot = {0};
+static const Kitty_RenderBackend* k_backend = &k_backend_slot;
+static SDL_Texture* k_render_target = NULL;     // mirrors the backend, for code that draws into textures
+static SDL_BlendMode k_blend_mode = SDL_BLENDMODE_NONE;
+
 // Rendering Vars
 
 static Kitty_Vertex3D k_camera_position = {10.0f, 0.0f, 0.0f};
 static Kitty_Point3D k_camera_origin = {0.0f, 0.0f, 0.0f};
 
+static const float K_PROJECTION_DISTANCE = 100.0f; // viewer to projection plane, as in mesh rendering
+static const float K_NEAR_PLANE = 1.0f; // smallest view depth that is still drawn
+
+// Software framebuffer, composited over the renderer at the end of Kitty_RenderObjects.
+// Point clouds are recorded as draws during the frame and rasterized when it ends; with
+// frames in flight a raster thread draws frame N while the main thread presents frame N - 1.
+typedef struct {
+    Kitty_ObjPointCloud* cloud;
+    Kitty_Point3D position;     // mapped into the framebuffer
+    float scale;                // cloud scale times framebuffer scale
+    float splat;                // splat edge length in framebuffer pixels
+    float lod_bias;
+} k_PointCloudDraw;
+
+typedef struct {
+    Uint32* color;              // ARGB8888, window sized, lower scales use the front
+    float* depth;
+    int width;                  // at the scale the frame was recorded with
+    int height;
+    k_PointCloudDraw* draws;
+    size_t draw_count;
+    size_t draw_capacity;
+    bool used;                  // anything was recorded, else nothing is presented
+    double raster_ms;
+} k_Framebuffer;
+
+static k_Framebuffer k_framebuffers[KITTY_MAX_FRAMES_IN_FLIGHT];
+static k_Framebuffer* k_fb = NULL;      // recording the current frame
+static bool k_fb_used = false;
+static int k_frames_in_flight = 1;
+static size_t k_fb_sequence = 0;        // frames recorded, frame n uses k_framebuffers[n % k_frames_in_flight]
+static size_t k_fb_presented = 0;       // frames presented, always in order
+// Raster thread, only running while frames are in flight
+static SDL_Thread* k_raster_thread = NULL;
+static SDL_mutex* k_raster_mutex = NULL;
+static SDL_cond* k_raster_cond = NULL;
+static SDL_cond* k_raster_done_cond = NULL;
+static size_t k_raster_submitted = 0;
+static size_t k_raster_completed = 0;   // fence, frame n is done once this passes n
+static bool k_raster_quit = false;
+// Dynamic resolution: the framebuffer is rasterized at k_fb_scale and upscaled on present
+static Uint32* k_fb_upscaled = NULL;
+static int k_fb_capacity_width = 0;
+static int k_fb_capacity_height = 0;
+static float k_fb_scale = 1.0f;
+static double k_fb_raster_ms = 0.0;     // accumulating for the current frame
+static double k_fb_last_raster_ms = 0.0;
+static Kitty_DynamicResolution k_dynamic_resolution = {false, 8.0f, 0.5f, 1.0f, 0.3f, 0.05f, KITTY_UPSCALE_BILINEAR};
+
+// Coverage anti-aliasing: sample positions inside a pixel, and scratch for the batched draws
+static int k_aa_samples = KITTY_AA_OFF;
+static float k_aa_sample_x[16];
+static float k_aa_sample_y[16];
+static SDL_Rect* k_aa_spans = NULL;                 // interior runs
+static size_t k_aa_span_capacity = 0;
+static SDL_Point* k_aa_points[17];                  // edge pixels, bucketed by covered sample count
+static size_t k_aa_point_count[17];
+static size_t k_aa_point_capacity[17];
+
+// Post-processing chain, run over the software framebuffer before it is upscaled and presented
+#define K_POST_MAX_LEVELS 8
+static Kitty_PostEffect k_post_chain[KITTY_MAX_POST_EFFECTS];
+static size_t k_post_count = 0;
+static Uint32* k_post_levels[K_POST_MAX_LEVELS];   // downsampled images, the framebuffer itself is level 0
+static size_t k_post_level_capacity[K_POST_MAX_LEVELS];
+static Uint32* k_post_scratch = NULL;               // output of the horizontal blur pass
+static size_t k_post_scratch_capacity = 0;
+static void* k_post_column_sums = NULL;             // running sums of the vertical blur pass, a row per band
+static size_t k_post_column_sums_capacity = 0;
+static void* k_resample_scratch = NULL;             // column coordinates and blended rows of k_ResampleImage
+static size_t k_resample_scratch_capacity = 0;
+
+// Frame budget governor
+static Kitty_FrameGovernor k_governor = {false, 16.0f, 3, 60, 0.7f, 8};
+static Kitty_FrameStats k_frame_stats = {0};
+
+// Worker threads, shared by every parallel stage through k_ParallelFor
+typedef void (*k_JobFunc)(void* ctx, size_t begin, size_t end);
+static const int K_MAX_WORKERS = 15;
+static SDL_Thread* k_workers[15];
+static int k_worker_count = 0;
+static bool k_workers_started = false;
+static SDL_mutex* k_job_mutex = NULL;
+static SDL_cond* k_job_cond = NULL;
+static SDL_cond* k_job_done_cond = NULL;
+static struct {
+    k_JobFunc fn;
+    void* ctx;
+    size_t count;
+    size_t grain;
+    SDL_atomic_t next;
+    int active;             // workers still running the current job
+    Uint64 generation;      // bumped for every job so workers can tell it is new
+    bool frame;             // handed out by a frame function, workers count their allocations towards the frame
+    bool quit;
+} k_job;
+
+// Impostor atlas, pages of snapshot cells shared by every mesh with an impostor. Free cells sit on a free list and
+// used ones on a list from least to most recently drawn, so a full atlas hands out the cell drawn longest ago
+#define K_IMPOSTOR_CELL 64
+#define K_IMPOSTOR_ATLAS_SIZE 1024
+#define K_IMPOSTOR_CELLS ((K_IMPOSTOR_ATLAS_SIZE / K_IMPOSTOR_CELL) * (K_IMPOSTOR_ATLAS_SIZE / K_IMPOSTOR_CELL))
+#define K_IMPOSTOR_MAX_PAGES 16 // 4096 cells, pages are added as they fill up
+static const int K_IMPOSTOR_YAW_BUCKETS = 8;
+static const int K_IMPOSTOR_PITCH_BUCKETS = 4;
+typedef struct {
+    Kitty_Impostor* owner;      // NULL while free
+    size_t last_drawn;          // frame the owner last drew the cell
+    int prev;                   // neighbours in the recency list, next also links the free list
+    int next;
+} k_ImpostorCell;
+static SDL_Texture* k_impostor_pages[K_IMPOSTOR_MAX_PAGES];
+static int k_impostor_page_count = 0;
+static k_ImpostorCell k_impostor_cells[K_IMPOSTOR_MAX_PAGES * K_IMPOSTOR_CELLS];
+static int k_impostor_free = -1;
+static int k_impostor_oldest = -1;
+static int k_impostor_newest = -1;
+
+// Meshes whose morph weights or skeleton pose changed, processed in parallel before drawing
+static Kitty_ObjMesh** k_vertex_stage_queue = NULL;
+static size_t k_vertex_stage_queue_capacity = 0;
+// Vertices [begin, end) of one mesh for the skinning workers
+typedef struct {
+    Kitty_ObjMesh* mesh;
+    size_t begin;
+    size_t end;
+} k_SkinRange;
+#define K_SKIN_RANGE 1024 // vertices per skinning job, a multiple of the four SIMD lanes
+static k_SkinRange* k_skin_ranges = NULL;
+static size_t k_skin_range_capacity = 0;
+
 ///@brief Creates the memory space (dynamic array) that houses objects.
 static int k_CreateObjectMSpace();
 ///@brief Allocates more space in the object memory space.
@@ -49,10 +244,135 @@ static int k_AllocObjectMSpace();
 static int k_UnallocObjectMSpace();
 ///@brief Checks whether reallocation is needed and performs it.
 static int k_ReallocObjectMSpace();
+///@brief Resizes the object memory space once to fit count objects, in whole steps; used by the bulk calls.
+static int k_FitObjectMSpace(size_t count);
+///@brief Grows the id map so it holds count ids without passing its load limit.
+static int k_ReserveObjectIds(size_t count);
+///@brief Maps an id that is not in the map yet to an object index; room must be reserved.
+static void k_InsertObjectId(Uint64 id, size_t index);
+static k_IdSlot* k_FindObjectId(Uint64 id);
+static void k_EraseObjectId(Uint64 id);
+///@brief Points the id of an object that moved in the store at its new index.
+static void k_MoveObjectId(const Kitty_Object* obj, size_t index);
 ///@brief Frees (resets) the object memory space.
 static int k_FreeObjectMSpace();
 ///@brief Destroys the object memory space.
 static int k_DestroyObjectMSpace();
+///@brief Frees the resources owned by an object's data, then the data itself.
+static void k_FreeObjectData(Kitty_Object* obj);
+
+///@brief Draws the chunks of a tilemap that intersect the window.
+static int k_RenderTilemap(Kitty_ObjTilemap* map);
+///@brief Fills a polygon with a single active edge table scanline sweep.
+static int k_RenderPolygon(Kitty_ObjPolygon* poly);
+///@brief Sets up an empty polygon without contours.
+static void k_InitPolygon(Kitty_ObjPolygon* poly, bool filled, enum Kitty_FillRule fill_rule, Kitty_Color color);
+///@brief Appends a closed contour to a polygon, growing its buffers geometrically.
+static int k_PolygonAddContour(Kitty_ObjPolygon* poly, const Kitty_Point* points, size_t point_count);
+///@brief Draws the runs of a polyline, one batched call for hairlines or one polygon sweep for wide strokes.
+static int k_RenderPolyline(Kitty_ObjPolyline* line, const size_t* run_ends, size_t run_count);
+///@brief Re-flattens a path if needed and draws it through its polyline.
+static int k_RenderPath(Kitty_ObjPath* path);
+///@brief Folds new samples into the column caches and draws each series as one line.
+static int k_RenderPlot(Kitty_ObjPlot* plot);
+///@brief Picks and sizes the software framebuffer that records this frame.
+static int k_PrepareFramebuffer();
+///@brief Ends the recorded frame and presents the oldest frame in flight once the pipeline is full.
+static int k_PresentFramebuffer();
+///@brief Fills a triangle with exact interior spans and sampled coverage on its edge pixels.
+static int k_FillTriangleAA(float x0, float y0, float x1, float y1, float x2, float y2, Kitty_Color color);
+static void k_FreeAntiAliasing();
+///@brief Renders one frame, Kitty_RenderObjects wraps it in the allocation check scope.
+static int k_RenderObjects();
+///@brief Allocates from the engine heap and accounts the block under tag; free it with k_Free.
+static void* k_Alloc(size_t size, enum Kitty_MemoryTag tag);
+static void* k_Calloc(size_t count, size_t size, enum Kitty_MemoryTag tag);
+///@brief Resizes an engine block, keeping its tag; a NULL block is allocated under tag, one the engine did not allocate goes to realloc.
+static void* k_Realloc(void* block, size_t size, enum Kitty_MemoryTag tag);
+///@brief Frees an engine block, or with free() one the engine did not allocate.
+static void k_Free(void* block);
+///@brief Loads an image as RGBA32, counted by its bytes under tag until k_FreeSurface.
+static SDL_Surface* k_LoadSurface(const char* file_path, enum Kitty_MemoryTag tag, int* bits_per_pixel);
+///@brief Frees any surface, only the ones from k_LoadSurface were counted.
+static void k_FreeSurface(SDL_Surface* surface);
+///@brief Size in texels of a texture in any format.
+static void k_TextureExtent(const Kitty_Texture* texture, int* width, int* height);
+///@brief Runs the post-processing chain over a rasterized framebuffer, in place.
+static int k_RunPostChain(k_Framebuffer* fb);
+///@brief Fence: waits until every submitted frame is rasterized.
+static void k_WaitFramebuffers();
+///@brief Hands the point clouds recorded this frame to the raster stage.
+static void k_SubmitFramebuffer();
+///@brief Drains the pipeline and joins the raster thread.
+static void k_StopRasterThread();
+///@brief Monotonic wall clock in milliseconds.
+static double k_NowMs();
+///@brief Fires the timers that are due, called at the start of Kitty_UpdateObjectState.
+static void k_RunTimers();
+///@brief Frees the timer wheel and every outstanding timer.
+static void k_FreeTimers();
+///@brief Appends an engine record to the calling thread's log ring; obj may be NULL and index -1 when there is none.
+static void k_Log(int code, const Kitty_Object* obj, Sint64 index, Sint64 arg0, Sint64 arg1, Sint64 arg2);
+///@brief Frees the log rings of every thread.
+static void k_FreeLog();
+///@brief Draws a text object, reusing its last rasterization while throttled.
+static int k_RenderText(Kitty_ObjText* text_obj, bool throttled);
+///@brief Moves the quality level after a frame that took frame_ms.
+static void k_UpdateGovernor(double frame_ms);
+static float k_GovernorLodScale(enum Kitty_Priority priority, int level);
+///@brief Frees the software framebuffer.
+static void k_DestroyFramebuffer();
+///@brief Returns a scratch buffer of at least size bytes kept across frames, reallocated only while size grows.
+static void* k_GrowScratch(void** buffer, size_t* capacity, size_t size);
+///@brief Fills in a built in backend; user_data points at its static context.
+static void k_GetBuiltinBackend(enum Kitty_BackendType type, Kitty_RenderBackend* out);
+///@brief Destroys the current backend and installs another, resetting the target and blend mode.
+static void k_InstallBackend(const Kitty_RenderBackend* backend);
+static void k_SetDrawColor(Uint8 r, Uint8 g, Uint8 b, Uint8 a);
+static void k_SetBlendMode(SDL_BlendMode mode);
+static void k_DrawPoint(int x, int y);
+static void k_DrawLine(int x1, int y1, int x2, int y2);
+static void k_DrawLines(const SDL_Point* points, int count);
+static void k_DrawRect(const SDL_Rect* rect);
+static void k_FillRects(const SDL_Rect* rects, int count);
+static void k_CopyTexture(SDL_Texture* texture, const SDL_Rect* src, const SDL_Rect* dst);
+///@brief Redirects drawing into a texture (NULL for the window), optionally limited to a viewport.
+static void k_SetRenderTarget(SDL_Texture* target, const SDL_Rect* viewport);
+///@brief Creates an SDL texture and counts its estimated size (width * height * bytes per pixel) under tag,
+///as bytes and an allocation but not as a live block, which only heap blocks are.
+static SDL_Texture* k_CreateTexture(Uint32 format, int access, int width, int height, enum Kitty_MemoryTag tag);
+static SDL_Texture* k_CreateTextureFromSurface(SDL_Surface* surface, enum Kitty_MemoryTag tag);
+///@brief Destroys a texture made by k_CreateTexture or k_CreateTextureFromSurface and takes its size off tag.
+static void k_DestroyTexture(SDL_Texture* texture, enum Kitty_MemoryTag tag);
+///@brief Records a point cloud draw into this frame's software framebuffer.
+static int k_RenderPointCloud(Kitty_ObjPointCloud* cloud, float lod_scale);
+///@brief Builds the octree and SoA arrays of a point cloud.
+static int k_BuildPointCloud(Kitty_ObjPointCloud* cloud, const Kitty_Vertex3D* positions, const Kitty_Color* colors);
+///@brief Draws the chunks of a terrain that are in view, far to near.
+static int k_RenderTerrain(Kitty_ObjTerrain* terrain, float lod_scale);
+///@brief Checks the settings of a terrain with heights and builds its chunk bounds and LOD index lists.
+static int k_BuildTerrain(Kitty_ObjTerrain* terrain);
+static void k_FreeTerrain(Kitty_ObjTerrain* terrain);
+///@brief Runs fn over [0, count) in chunks of grain on the worker threads and the caller.
+static void k_ParallelFor(size_t count, size_t grain, k_JobFunc fn, void* ctx);
+///@brief Stops and joins the worker threads.
+static void k_StopWorkers();
+///@brief Runs the morph and skinning stages of every mesh whose pose changed, in parallel across meshes.
+static int k_RunVertexStages();
+///@brief Vertex stage of a mesh: the skinned vertices if it has a skin, else its own vertices.
+static const Kitty_Vertex3D* k_MeshVertices(Kitty_ObjMesh* mesh);
+static void k_FreeSkin(Kitty_Skin* skin);
+static void k_FreeMorph(Kitty_Morph* morph);
+static bool k_BlendMorphTargets(Kitty_ObjMesh* mesh);
+///@brief Rasterizes a mesh's faces at a screen position and scale.
+static int k_RenderMesh(Kitty_ObjMesh* m_obj, Kitty_Point3D position, float scale, bool textured);
+///@brief Draws a mesh as its atlas snapshot when small enough, otherwise face by face.
+static int k_RenderMeshImpostor(Kitty_ObjMesh* m_obj, bool textured, float lod_scale);
+static void k_FreeImpostor(Kitty_Impostor* impostor);
+static void k_DestroyImpostorAtlas();
+static Kitty_Matrix4 k_SampleJointTrack(const Kitty_JointTrack* track, float time);
+///@brief Sets up a polyline without points.
+static void k_InitPolyline(Kitty_ObjPolyline* line, float width, enum Kitty_LineJoin join, Kitty_Color color);
 
 
 int Kitty_Init(const char* title, int width, int height){
@@ -60,6 +380,8 @@ int Kitty_Init(const char* title, int width, int height){
     window_width = width;
     window_height = height;
 
+    k_frame_stats = (Kitty_FrameStats){0};
+
     size_t result = k_CreateObjectMSpace();
     if (result != KITTY_SUCCESS){
         return result; // Return error code
@@ -101,10 +423,17 @@ int Kitty_Init(const char* title, int width, int height){
         return KITTY_SDL_RENDERER_CREATION_ERROR; // SDL renderer creation failed
     }
 
+    Kitty_RenderBackend sdl_backend;
+    k_GetBuiltinBackend(KITTY_BACKEND_SDL, &sdl_backend);
+    k_InstallBackend(&sdl_backend);
+
     return KITTY_SUCCESS; // Success
 }
 
 int Kitty_Quit() {
+    k_StopRasterThread();
+    k_post_count = 0; // the chain may point at lookup tables that are freed after this
+    k_FreeTimers();
     size_t result = k_FreeObjectMSpace();
     if (result != KITTY_SUCCESS){
         return result; // Return error code
@@ -115,6 +444,20 @@ int Kitty_Quit() {
     }
 
     // Destroy SDL stuff
+    k_StopWorkers();
+    k_DestroyImpostorAtlas();
+    k_Free(k_vertex_stage_queue);
+    k_vertex_stage_queue = NULL;
+    k_vertex_stage_queue_capacity = 0;
+    k_Free(k_skin_ranges);
+    k_skin_ranges = NULL;
+    k_skin_range_capacity = 0;
+    k_FreeAntiAliasing();
+    k_DestroyFramebuffer();
+    if (k_backend->destroy){
+        k_backend->destroy(k_backend->user_data);
+    }
+    k_backend_slot = (Kitty_RenderBackend){0};
     if (sdl_renderer) {
         SDL_DestroyRenderer(sdl_renderer);
         sdl_renderer = NULL;
@@ -123,6 +466,7 @@ int Kitty_Quit() {
         SDL_DestroyWindow(sdl_window);
         sdl_window = NULL;
     }
+    k_FreeLog();
     SDL_Quit();
 
     return KITTY_SUCCESS; // Success
@@ -132,8 +476,9 @@ int Kitty_ClearScreen(Kitty_Color color) {
     if (!sdl_renderer) {
         return KITTY_SDL_RENDERER_NOT_INITIALIZED; // SDL renderer not initialized
     }
-    SDL_SetRenderDrawColor(sdl_renderer, color.r, color.g, color.b, color.a);
-    SDL_RenderClear(sdl_renderer);
+    k_frame_scope++;
+    k_backend->clear(k_backend->user_data, color);
+    k_frame_scope--;
     return KITTY_SUCCESS; // Success
 }
 
@@ -141,21 +486,76 @@ int Kitty_FlipBuffers() {
     if (!sdl_renderer) {
         return KITTY_SDL_RENDERER_NOT_INITIALIZED; // SDL renderer not initialized
     }
-    SDL_RenderPresent(sdl_renderer);
-    return KITTY_SUCCESS; // Success
+    k_frame_scope++;
+    int result = k_backend->present(k_backend->user_data);
+    k_frame_scope--;
+    k_frame_stats.allocations = (size_t)SDL_AtomicSet(&k_frame_allocations, 0); // the frame ends here
+    return result;
 }
 
 int Kitty_UpdateObjectState() {
+    k_RunTimers(); // outside the frame scope, callbacks are user code
+    k_frame_scope++;
     // Placeholder for future update logic
+    k_frame_scope--;
     return KITTY_SUCCESS; // Success
 }
 
 int Kitty_RenderObjects() {
+    k_frame_scope++;
+    int result = k_RenderObjects();
+    k_frame_scope--;
+    return result;
+}
+
+///@brief Logs an object that failed to draw and keeps the first error of the frame.
+static int k_ObjectFailed(int result, const Kitty_Object* obj, size_t index, int frame_result) {
+    k_Log(result, obj, (Sint64)index, obj->type, 0, 0);
+    return frame_result != KITTY_SUCCESS ? frame_result : result;
+}
+
+static int k_RenderObjects() {
     if (!sdl_renderer) {
         return KITTY_SDL_RENDERER_NOT_INITIALIZED; // SDL renderer not initialized
     }
 
     clock_t start = clock();
+    double wall_start = k_NowMs();
+    int level = k_frame_stats.quality_level;
+    k_frame_stats.meshes_flattened = 0;
+    k_frame_stats.lods_dropped = 0;
+    k_frame_stats.texts_skipped = 0;
+    k_frame_stats.texts_cached = 0;
+    k_frame_stats.fence_wait_ms = 0.0;
+    k_frame_stats.post_ms = 0.0;
+    k_frame_stats.impostors_over_capacity = 0;
+    int backend_result = k_backend->begin_frame(k_backend->user_data);
+    if (backend_result != KITTY_SUCCESS) {
+        k_Log(backend_result, NULL, -1, 0, 0, 0);
+        return backend_result;
+    }
+    double stage_start = k_NowMs();
+    int stage_result = k_RunVertexStages();
+    k_frame_stats.vertex_stage_ms = k_NowMs() - stage_start;
+    if (stage_result != KITTY_SUCCESS) {
+        k_Log(stage_result, NULL, -1, 0, 0, 0);
+        return stage_result;
+    }
+    int frame_result = KITTY_SUCCESS;
+    // point clouds are recorded and submitted first, so with frames in flight the raster thread
+    // splats them while the other objects are drawn; they are still shown in this frame
+    for (size_t i = 0; i < object_mspace->allocation_count; i++) {
+        Kitty_Object obj = object_mspace->objects[i];
+        if (obj.type != KITTY_OBJECT_POINT_CLOUD) {
+            continue;
+        }
+        Kitty_ObjPointCloud* pc_obj = (typeof(Kitty_ObjPointCloud)*)obj.data;
+        int pc_result = k_RenderPointCloud(pc_obj, k_GovernorLodScale(obj.priority, level));
+        if (pc_result != KITTY_SUCCESS) {
+            frame_result = k_ObjectFailed(pc_result, &obj, i, frame_result);
+        }
+    }
+    k_SubmitFramebuffer();
     for (size_t i = 0; i < object_mspace->allocation_count; i++) {
         Kitty_Object obj = object_mspace->objects[i];
         // Render based on object type
@@ -165,7 +565,7 @@ int Kitty_RenderObjects() {
                 Kitty_ObjCircle* c_obj = (typeof(Kitty_ObjCircle)*)obj.data;
                 Kitty_Color col = c_obj->color;
 
-                SDL_SetRenderDrawColor(sdl_renderer, col.r, col.g, col.b, col.a);
+                k_SetDrawColor(col.r, col.g, col.b, col.a);
                 
                 if (c_obj->filled) {
                     // Render filled circle
@@ -174,7 +574,7 @@ int Kitty_RenderObjects() {
                             int dx = c_obj->radius - w; // horizontal offset
                             int dy = c_obj->radius - h; // vertical offset
                             if ((dx*dx + dy*dy) <= (c_obj->radius * c_obj->radius)) {
-                                SDL_RenderDrawPoint(sdl_renderer, c_obj->position.x + dx, c_obj->position.y + dy);
+                                k_DrawPoint(c_obj->position.x + dx, c_obj->position.y + dy);
                             }
                         }
                     }
@@ -186,14 +586,14 @@ int Kitty_RenderObjects() {
                     int dy = 1;
                     int err = dx - ((int)c_obj->radius << 1);
                     while (x >= y) {
-                        SDL_RenderDrawPoint(sdl_renderer, c_obj->position.x + x, c_obj->position.y + y);
-                        SDL_RenderDrawPoint(sdl_renderer, c_obj->position.x + y, c_obj->position.y + x);
-                        SDL_RenderDrawPoint(sdl_renderer, c_obj->position.x - y, c_obj->position.y + x);
-                        SDL_RenderDrawPoint(sdl_renderer, c_obj->position.x - x, c_obj->position.y + y);
-                        SDL_RenderDrawPoint(sdl_renderer, c_obj->position.x - x, c_obj->position.y - y);
-                        SDL_RenderDrawPoint(sdl_renderer, c_obj->position.x - y, c_obj->position.y - x);
-                        SDL_RenderDrawPoint(sdl_renderer, c_obj->position.x + y, c_obj->position.y - x);
-                        SDL_RenderDrawPoint(sdl_renderer, c_obj->position.x + x, c_obj->position.y - y);
+                        k_DrawPoint(c_obj->position.x + x, c_obj->position.y + y);
+                        k_DrawPoint(c_obj->position.x + y, c_obj->position.y + x);
+                        k_DrawPoint(c_obj->position.x - y, c_obj->position.y + x);
+                        k_DrawPoint(c_obj->position.x - x, c_obj->position.y + y);
+                        k_DrawPoint(c_obj->position.x - x, c_obj->position.y - y);
+                        k_DrawPoint(c_obj->position.x - y, c_obj->position.y - x);
+                        k_DrawPoint(c_obj->position.x + y, c_obj->position.y - x);
+                        k_DrawPoint(c_obj->position.x + x, c_obj->position.y - y);
 
                         if (err <= 0) {
                             y++;
@@ -215,11 +615,11 @@ int Kitty_RenderObjects() {
                 Kitty_ObjRectangle* r_obj = (typeof(Kitty_ObjRectangle)*)obj.data;
                 Kitty_Color rect_col = r_obj->color;
                 SDL_Rect rect = {r_obj->position.x, r_obj->position.y, r_obj->width, r_obj->height};
-                SDL_SetRenderDrawColor(sdl_renderer, rect_col.r, rect_col.g, rect_col.b, rect_col.a);
+                k_SetDrawColor(rect_col.r, rect_col.g, rect_col.b, rect_col.a);
                 if (r_obj->filled) {
-                    SDL_RenderFillRect(sdl_renderer, &rect);
+                    k_FillRects(&rect, 1);
                 } else {
-                    SDL_RenderDrawRect(sdl_renderer, &rect);
+                    k_DrawRect(&rect);
                 }
 
                 break;
@@ -227,8 +627,8 @@ int Kitty_RenderObjects() {
                 // Render line 
                 Kitty_ObjLine* l_obj = (typeof(Kitty_ObjLine)*)obj.data;
                 Kitty_Color line_col = l_obj->color;
-                SDL_SetRenderDrawColor(sdl_renderer, line_col.r, line_col.g, line_col.b, line_col.a);
-                SDL_RenderDrawLine(sdl_renderer, l_obj->startPoint.x, l_obj->startPoint.y, l_obj->endPoint.x, l_obj->endPoint.y);
+                k_SetDrawColor(line_col.r, line_col.g, line_col.b, line_col.a);
+                k_DrawLine(l_obj->startPoint.x, l_obj->startPoint.y, l_obj->endPoint.x, l_obj->endPoint.y);
 
                 break;
 
@@ -236,10 +636,19 @@ int Kitty_RenderObjects() {
                 // Render triangle
                 Kitty_ObjTriangle* t_obj = (typeof(Kitty_ObjTriangle)*)obj.data;
                 Kitty_Color tri_col = t_obj->color;
-                SDL_SetRenderDrawColor(sdl_renderer, tri_col.r, tri_col.g, tri_col.b, tri_col.a);
-                SDL_RenderDrawLine(sdl_renderer, t_obj->vertex1.x, t_obj->vertex1.y, t_obj->vertex2.x, t_obj->vertex2.y);
-                SDL_RenderDrawLine(sdl_renderer, t_obj->vertex2.x, t_obj->vertex2.y, t_obj->vertex3.x, t_obj->vertex3.y);
-                SDL_RenderDrawLine(sdl_renderer, t_obj->vertex3.x, t_obj->vertex3.y, t_obj->vertex1.x, t_obj->vertex1.y);
+                if (t_obj->filled && k_aa_samples > 1){
+                    // the coverage fill draws the edges itself, an aliased outline would undo it
+                    int aa_result = k_FillTriangleAA(t_obj->vertex1.x, t_obj->vertex1.y, t_obj->vertex2.x, t_obj->vertex2.y,
+                                                     t_obj->vertex3.x, t_obj->vertex3.y, tri_col);
+                    if (aa_result != KITTY_SUCCESS){
+                        frame_result = k_ObjectFailed(aa_result, &obj, i, frame_result);
+                    }
+                    break;
+                }
+                k_SetDrawColor(tri_col.r, tri_col.g, tri_col.b, tri_col.a);
+                k_DrawLine(t_obj->vertex1.x, t_obj->vertex1.y, t_obj->vertex2.x, t_obj->vertex2.y);
+                k_DrawLine(t_obj->vertex2.x, t_obj->vertex2.y, t_obj->vertex3.x, t_obj->vertex3.y);
+                k_DrawLine(t_obj->vertex3.x, t_obj->vertex3.y, t_obj->vertex1.x, t_obj->vertex1.y);
 
                 if (t_obj->filled){
                     // Color in triangle using points, simple scanline fill
@@ -263,7 +672,7 @@ int Kitty_RenderObjects() {
                                 nodeX[i] = nodeX[i + 1];
                                 nodeX[i + 1] = temp;
                             }
-                            SDL_RenderDrawLine(sdl_renderer, nodeX[i], y, nodeX[i + 1], y);
+                            k_DrawLine(nodeX[i], y, nodeX[i + 1], y);
                         }
                     }
                 }
@@ -274,289 +683,114 @@ int Kitty_RenderObjects() {
                 // Render pixel
                 Kitty_ObjPixel* p_obj = (typeof(Kitty_ObjPixel)*)obj.data;
                 Kitty_Color pixel_col = p_obj->color;
-                SDL_SetRenderDrawColor(sdl_renderer, pixel_col.r, pixel_col.g, pixel_col.b, pixel_col.a);
-                SDL_RenderDrawPoint(sdl_renderer, p_obj->position.x, p_obj->position.y);
+                k_SetDrawColor(pixel_col.r, pixel_col.g, pixel_col.b, pixel_col.a);
+                k_DrawPoint(p_obj->position.x, p_obj->position.y);
 
                 break;
 
             case KITTY_OBJECT_TEXT:
-                //load font here to add multiple font support
                 Kitty_ObjText* text_obj = (typeof(Kitty_ObjText)*)obj.data;
-                TTF_Font* font = TTF_OpenFont("arial.ttf", 24); // Load a font
-                if (!font) {
-                    return KITTY_SDL_TTF_ERROR; // Font loading failed
-                }
-
-                SDL_Color sdl_color = {text_obj->color.r, text_obj->color.g, text_obj->color.b, text_obj->color.a};
-                SDL_Surface* text_surface = TTF_RenderText_Solid(font, text_obj->text, sdl_color);
-                if (!text_surface) {
-                    TTF_CloseFont(font);
-                    return KITTY_SDL_TTF_ERROR; // Text rendering failed
+                // low priority text goes first, first throttled then skipped
+                if (obj.priority == KITTY_PRIORITY_LOW && level >= 2) {
+                    k_frame_stats.texts_skipped++;
+                    break;
                 }
-                SDL_Texture* text_texture = SDL_CreateTextureFromSurface(sdl_renderer, text_surface);
-                if (!text_texture) {
-                    SDL_FreeSurface(text_surface);
-                    TTF_CloseFont(font);
-                    return KITTY_SDL_TTF_ERROR; // Texture creation failed
+                bool throttled = (obj.priority == KITTY_PRIORITY_LOW && level >= 1) || (obj.priority == KITTY_PRIORITY_NORMAL && level >= 3);
+                int text_result = k_RenderText(text_obj, throttled);
+                if (text_result != KITTY_SUCCESS) {
+                    frame_result = k_ObjectFailed(text_result, &obj, i, frame_result);
                 }
-                SDL_Rect text_rect = {text_obj->position.x, text_obj->position.y, text_surface->w, text_surface->h};
-                SDL_RenderCopy(sdl_renderer, text_texture, NULL, &text_rect);
-                SDL_DestroyTexture(text_texture);
-                SDL_FreeSurface(text_surface);
-                TTF_CloseFont(font);
-
 
                 break;
 
             case KITTY_OBJECT_MESH:
-                //turn mesh into triangles (wireframe for now)
-
                 Kitty_ObjMesh* m_obj = (typeof(Kitty_ObjMesh)*)obj.data;
-                Kitty_Point3D position = m_obj->position;
-
-                //sort faces by depth bubble sort
-                for (size_t j = 0; j < m_obj->face_count - 1; j++){
-                    for (size_t k = 0; k < m_obj->face_count - j - 1; k++){
-                        Kitty_Face face1 = m_obj->faces[k];
-                        Kitty_Face face2 = m_obj->faces[k + 1];
-
-                        float z1 = (m_obj->vertices[face1.a].z + m_obj->vertices[face1.b].z + m_obj->vertices[face1.c].z) / 3.0f;
-                        float z2 = (m_obj->vertices[face2.a].z + m_obj->vertices[face2.b].z + m_obj->vertices[face2.c].z) / 3.0f;
-
-                        if (z1 < z2){
-                            //swap
-                            Kitty_Face temp_face = m_obj->faces[k];
-                            Kitty_Color temp_color = m_obj->face_colors[k];
-                            m_obj->faces[k] = m_obj->faces[k + 1];
-                            m_obj->face_colors[k] = m_obj->face_colors[k + 1];
-                            m_obj->faces[k + 1] = temp_face;
-                            m_obj->face_colors[k + 1] = temp_color;
-                        }
-                    }
+                // under load textured meshes fall back to flat fill, most important last
+                bool textured = m_obj->wrap && level < (obj.priority == KITTY_PRIORITY_HIGH ? 3 : 2);
+                if (m_obj->wrap && !textured) {
+                    k_frame_stats.meshes_flattened++;
                 }
+                int m_result = m_obj->impostor ? k_RenderMeshImpostor(m_obj, textured, k_GovernorLodScale(obj.priority, level))
+                                               : k_RenderMesh(m_obj, m_obj->position, (int)m_obj->scale, textured);
+                if (m_result != KITTY_SUCCESS) {
+                    frame_result = k_ObjectFailed(m_result, &obj, i, frame_result);
+                }
+                break;
 
-                // create wireframe of mesh, each vertex offset by position
-                for (size_t f = 0; f < m_obj->face_count; f++){
-                    Kitty_Face face = m_obj->faces[f];
-                    Kitty_Color face_col = m_obj->face_colors[f];
-                    int scale = m_obj->scale;
-                    Kitty_Vertex3D v1 = m_obj->vertices[face.a];
-                    Kitty_Vertex3D v2 = m_obj->vertices[face.b];
-                    Kitty_Vertex3D v3 = m_obj->vertices[face.c];
-                    Kitty_UV uv1 = m_obj->uvs[face.uv_a];
-                    Kitty_UV uv2 = m_obj->uvs[face.uv_b];
-                    Kitty_UV uv3 = m_obj->uvs[face.uv_c];
-
-                    //ugly but we gotta copy to modify
-                    float v1x = v1.x;
-                    float v1y = v1.y;
-                    float v1z = v1.z;
-
-                    float v2x = v2.x;
-                    float v2y = v2.y;
-                    float v2z = v2.z;
-
-                    float v3x = v3.x;
-                    float v3y = v3.y;
-                    float v3z = v3.z;
-
-
-                    float uv1u = uv1.u;
-                    float uv1v = uv1.v;
-
-                    float uv2u = uv2.u;
-                    float uv2v = uv2.v;
-
-                    float uv3u = uv3.u;
-                    float uv3v = uv3.v;
-
-                    //apply perspective
-                    float distance = 100.0f; // Distance from the viewer to the projection plane
-                    float persp_1 = distance / (distance + v1z - position.z);
-                    float persp_2 = distance / (distance + v2z - position.z);
-                    float persp_3 = distance / (distance + v3z - position.z);
-
-                    v1x = v1x * persp_1;
-                    v1y = v1y * persp_1;
-                    v2x = v2x * persp_2;
-                    v2y = v2y * persp_2;
-                    v3x = v3x * persp_3;
-                    v3y = v3y * persp_3;
-
-                    uv1u = uv1u * persp_1;
-                    uv1v = uv1v * persp_1;
-                    uv2u = uv2u * persp_2;
-                    uv2v = uv2v * persp_2;
-                    uv3u = uv3u * persp_3;
-                    uv3v = uv3v * persp_3;
-
-                    //calculate face normals
-                    Kitty_Vertex3D edge1 = KittyM_Point2PointV3(v2, v1);
-                    Kitty_Vertex3D edge2 = KittyM_Point2PointV3(v3, v1);
-                    Kitty_Vertex3D face_normal = KittyM_CrossProduct3(edge1, edge2);
-                    face_normal = KittyM_VectorNormalize3(face_normal);
-
-                    //backface culling
-                    Kitty_Vertex3D view_vector = KittyM_Point2PointV3(k_camera_position, (Kitty_Vertex3D){position.x, position.y, position.z});
-                    view_vector = KittyM_VectorNormalize3(view_vector);
-                    float dot_product = KittyM_DotProduct3(face_normal, view_vector);
-                    if (dot_product < 0){
-                        continue; //skip face
-                    }
-
-                    //copied vertices
-                    Kitty_Point3D* vertices[3] = {
-                        &(Kitty_Point3D){position.x + (v1x * scale), position.y + (v1y * scale), position.z + (v1.z * scale)},
-                        &(Kitty_Point3D){position.x + (v2x * scale), position.y + (v2y * scale), position.z + (v2.z * scale)},
-                        &(Kitty_Point3D){position.x + (v3x * scale), position.y + (v3y * scale), position.z + (v3.z * scale)}
-                    };
-
-                    if (m_obj->wire){
-                        SDL_SetRenderDrawColor(sdl_renderer, face_col.r, face_col.g, face_col.b, face_col.a);
-
-                        SDL_RenderDrawLine(sdl_renderer,
-                                        position.x + (v1x * scale),
-                                        position.y + (v1y * scale),
-                                        position.x + (v2x * scale),
-                                        position.y + (v2y * scale));
-                            
-                        SDL_RenderDrawLine(sdl_renderer,
-                                        position.x + (v2x * scale),
-                                        position.y + (v2y * scale),
-                                        position.x + (v3x * scale),
-                                        position.y + (v3y * scale));
-
-                        SDL_RenderDrawLine(sdl_renderer,
-                                        position.x + (v3x * scale),
-                                        position.y + (v3y * scale),
-                                        position.x + (v1x * scale),
-                                        position.y + (v1y * scale));
-                    }
-
-
-                    if (!m_obj->wire && !m_obj->wrap){
-                        SDL_SetRenderDrawColor(sdl_renderer, face_col.r, face_col.g, face_col.b, face_col.a);
-
-                        //simple scanline fill
-                        int minY = (position.y + (v1y * scale)) < (position.y + (v2y * scale)) ? ((position.y + (v1y * scale)) < (position.y + (v3y * scale)) ? (position.y + (v1y * scale)) : (position.y + (v3y * scale))) : ((position.y + (v2y * scale)) < (position.y + (v3y * scale)) ? (position.y + (v2y * scale)) : (position.y + (v3y * scale)));
-                        int maxY = (position.y + (v1y * scale)) > (position.y + (v2y * scale)) ? ((position.y + (v1y * scale)) > (position.y + (v3y * scale)) ? (position.y + (v1y * scale)) : (position.y + (v3y * scale))) : ((position.y + (v2y * scale)) > (position.y + (v3y * scale)) ? (position.y + (v2y * scale)) : (position.y + (v3y * scale)));
-
-                        for (int y = minY; y <= maxY; y++){
-                            int nodes = 0;
-                            int nodeX[3];
-                            for (int i = 0; i < 3; i++){
-                                Kitty_Point3D* v1p = vertices[i];
-                                Kitty_Point3D* v2p = vertices[(i + 1) % 3];
-                                if ((v1p->y < y && v2p->y >= y) || (v2p->y < y && v1p->y >= y)){
-                                    nodeX[nodes++] = v1p->x + (y - v1p->y) * (v2p->x - v1p->x) / (v2p->y - v1p->y);
-                                }
-                            }
-                            for (int i = 0; i < nodes - 1; i += 2){
-                                if (nodeX[i] > nodeX[i + 1]){
-                                    int temp = nodeX[i];
-                                    nodeX[i] = nodeX[i + 1];
-                                    nodeX[i + 1] = temp;
-                                }
-                                SDL_RenderDrawLine(sdl_renderer, nodeX[i], y, nodeX[i + 1], y);
-                            }
-                        }
-                    } 
-                    else if (m_obj->wrap) {
-                        int minY = (position.y + (v1y * scale)) < (position.y + (v2y * scale)) ? ((position.y + (v1y * scale)) < (position.y + (v3y * scale)) ? (position.y + (v1y * scale)) : (position.y + (v3y * scale))) : ((position.y + (v2y * scale)) < (position.y + (v3y * scale)) ? (position.y + (v2y * scale)) : (position.y + (v3y * scale)));
-                        int maxY = (position.y + (v1y * scale)) > (position.y + (v2y * scale)) ? ((position.y + (v1y * scale)) > (position.y + (v3y * scale)) ? (position.y + (v1y * scale)) : (position.y + (v3y * scale))) : ((position.y + (v2y * scale)) > (position.y + (v3y * scale)) ? (position.y + (v2y * scale)) : (position.y + (v3y * scale)));
-
-                        // perspective-correct setup:
-                        // uv1u/v, uv2u/v, uv3u/v were pre-multiplied by persp_1/2/3 earlier
-                        float U_p[3] = { uv1u, uv2u, uv3u }; // u' = u * persp
-                        float V_p[3] = { uv1v, uv2v, uv3v }; // v' = v * persp
-                        float W_p[3] = { persp_1, persp_2, persp_3 }; // w' = persp
-
-                        for (int y = minY; y <= maxY; y++){
-                            int nodes = 0;
-                            int   nodeX[3];
-                            float nodeU_p[3], nodeV_p[3], nodeW_p[3];
-
-                            // find edge intersections and interpolate u', v', w' at the intersections
-                            for (int i = 0; i < 3; i++){
-                                int j = (i + 1) % 3;
-                                Kitty_Point3D* v1p = vertices[i];
-                                Kitty_Point3D* v2p = vertices[j];
-                                if ((v1p->y < y && v2p->y >= y) || (v2p->y < y && v1p->y >= y)){
-                                    float dy = (float)v2p->y - (float)v1p->y;
-                                    if (fabsf(dy) < 1e-6f) continue; // avoid div by zero
-                                    float t = ((float)y - (float)v1p->y) / dy;
-
-                                    nodeX[nodes]   = (int)( (float)v1p->x + t * ((float)v2p->x - (float)v1p->x) );
-                                    nodeU_p[nodes] = U_p[i] + t * (U_p[j] - U_p[i]);
-                                    nodeV_p[nodes] = V_p[i] + t * (V_p[j] - V_p[i]);
-                                    nodeW_p[nodes] = W_p[i] + t * (W_p[j] - W_p[i]);
-                                    nodes++;
-                                }
-                            }
-
-                            if (nodes < 2) continue;
+            case KITTY_OBJECT_TILEMAP:
+                Kitty_ObjTilemap* tm_obj = (typeof(Kitty_ObjTilemap)*)obj.data;
+                int tm_result = k_RenderTilemap(tm_obj);
+                if (tm_result != KITTY_SUCCESS) {
+                    frame_result = k_ObjectFailed(tm_result, &obj, i, frame_result);
+                }
 
-                            // ensure left->right ordering; swap accompanying attributes
-                            if (nodeX[0] > nodeX[1]){
-                                int   tx = nodeX[0];    nodeX[0] = nodeX[1];    nodeX[1] = tx;
-                                float tu = nodeU_p[0];  nodeU_p[0] = nodeU_p[1]; nodeU_p[1] = tu;
-                                float tv = nodeV_p[0];  nodeV_p[0] = nodeV_p[1]; nodeV_p[1] = tv;
-                                float tw = nodeW_p[0];  nodeW_p[0] = nodeW_p[1]; nodeW_p[1] = tw;
-                            }
+                break;
 
-                            int x0 = nodeX[0];
-                            int x1 = nodeX[1];
-                            if (x1 == x0) continue;
+            case KITTY_OBJECT_POLYGON:
+                Kitty_ObjPolygon* poly_obj = (typeof(Kitty_ObjPolygon)*)obj.data;
+                int poly_result = k_RenderPolygon(poly_obj);
+                if (poly_result != KITTY_SUCCESS) {
+                    frame_result = k_ObjectFailed(poly_result, &obj, i, frame_result);
+                }
 
-                            for (int x = x0; x <= x1; x++){
-                                float tx = (float)(x - x0) / (float)(x1 - x0);
-                                // interpolate u', v', w' across the scanline
-                                float u_p = nodeU_p[0] + tx * (nodeU_p[1] - nodeU_p[0]);
-                                float v_p = nodeV_p[0] + tx * (nodeV_p[1] - nodeV_p[0]);
-                                float w_p = nodeW_p[0] + tx * (nodeW_p[1] - nodeW_p[0]);
+                break;
 
-                                if (fabsf(w_p) < 1e-8f) continue; // avoid div by zero
+            case KITTY_OBJECT_POLYLINE:
+                Kitty_ObjPolyline* pl_obj = (typeof(Kitty_ObjPolyline)*)obj.data;
+                int pl_result = k_RenderPolyline(pl_obj, &pl_obj->point_count, 1);
+                if (pl_result != KITTY_SUCCESS) {
+                    frame_result = k_ObjectFailed(pl_result, &obj, i, frame_result);
+                }
 
-                                // recover perspective-correct u, v
-                                float u = u_p / w_p;
-                                float v = v_p / w_p;
+                break;
 
-                                //if v, u < 0 or > 1 wrap to other side
-                                if (u < 0) u = 1.0f + fmodf(u, 1.0f);
-                                if (v < 0) v = 1.0f + fmodf(v, 1.0f);
-                                u = fmodf(u, 1.0f);
-                                v = fmodf(v, 1.0f);
+            case KITTY_OBJECT_PATH:
+                Kitty_ObjPath* path_obj = (typeof(Kitty_ObjPath)*)obj.data;
+                int path_result = k_RenderPath(path_obj);
+                if (path_result != KITTY_SUCCESS) {
+                    frame_result = k_ObjectFailed(path_result, &obj, i, frame_result);
+                }
 
+                break;
 
-                                int tex_width  = m_obj->texture->sdl_surface->w;
-                                int tex_height = m_obj->texture->sdl_surface->h;
-                                int tex_pitch  = m_obj->texture->sdl_surface->pitch;
+            case KITTY_OBJECT_PLOT:
+                Kitty_ObjPlot* plot_obj = (typeof(Kitty_ObjPlot)*)obj.data;
+                int plot_result = k_RenderPlot(plot_obj);
+                if (plot_result != KITTY_SUCCESS) {
+                    frame_result = k_ObjectFailed(plot_result, &obj, i, frame_result);
+                }
 
-                                int tex_x = (int)(u * tex_width);
-                                int tex_y = (int)(v * tex_height);
-                                if ((unsigned)tex_x >= (unsigned)tex_width || (unsigned)tex_y >= (unsigned)tex_height) continue;
+                break;
 
-                                Uint32* pixels = (Uint32*)m_obj->texture->sdl_surface->pixels;
-                                Uint32 color = pixels[tex_y * (tex_pitch / 4) + tex_x];
+            case KITTY_OBJECT_POINT_CLOUD:
+                // recorded before the other objects
+                break;
 
-                                Uint8 r, g, b, a;
-                                SDL_GetRGBA(color, m_obj->texture->sdl_surface->format, &r, &g, &b, &a);
-                                SDL_SetRenderDrawColor(sdl_renderer, r, g, b, 255);
-                                SDL_RenderDrawPoint(sdl_renderer, x, y);
-                            }
-                        }
-                    }
+            case KITTY_OBJECT_TERRAIN:
+                Kitty_ObjTerrain* terrain_obj = (typeof(Kitty_ObjTerrain)*)obj.data;
+                int terrain_result = k_RenderTerrain(terrain_obj, k_GovernorLodScale(obj.priority, level));
+                if (terrain_result != KITTY_SUCCESS) {
+                    frame_result = k_ObjectFailed(terrain_result, &obj, i, frame_result);
                 }
 
                 break;
 
             default:
-                return KITTY_UNKNOWN_ERROR; // Unknown object type
+                frame_result = k_ObjectFailed(KITTY_UNKNOWN_ERROR, &obj, i, frame_result); // Unknown object type
+                break;
+        }
+    }
+    if (k_fb_presented != k_fb_sequence) {
+        int fb_result = k_PresentFramebuffer();
+        if (fb_result != KITTY_SUCCESS) {
+            k_Log(fb_result, NULL, -1, 0, 0, 0);
+            return fb_result;
         }
     }
+    k_UpdateGovernor(k_NowMs() - wall_start);
     frame_num++;
     frame_time = (clock() - start) * 1000.0 / CLOCKS_PER_SEC; // in milliseconds
-    return KITTY_SUCCESS; // Success
+    return frame_result;
 }
 
 int Kitty_ClearObjects() {
@@ -579,10 +813,22 @@ int Kitty_AddObject(Kitty_Object obj) {
     if (!object_mspace) {
         return KITTY_MEMORYSPACE_NOT_INITIALIZED; // Memory space not initialized
     }
+    if (obj.id != 0) {
+        if (k_FindObjectId(obj.id)) {
+            return KITTY_DUPLICATE_OBJECT_ID; // Id already taken
+        }
+        int id_result = k_ReserveObjectIds(object_mspace->id_count + 1);
+        if (id_result != KITTY_SUCCESS) {
+            return id_result; // Return error code
+        }
+    }
     size_t result = k_ReallocObjectMSpace();
     if (result != KITTY_SUCCESS) {
         return result; // Return error code
     }
+    if (obj.id != 0) {
+        k_InsertObjectId(obj.id, object_mspace->allocation_count);
+    }
     object_mspace->objects[object_mspace->allocation_count] = obj;
     object_mspace->allocation_count++;
     return KITTY_SUCCESS; // Success
@@ -595,9 +841,11 @@ int Kitty_RemoveObject(size_t index) {
     if (index >= object_mspace->allocation_count) {
         return KITTY_INVALID_OBJECT_INDEX; // Invalid object index
     }
+    k_EraseObjectId(object_mspace->objects[index].id);
     // Shift objects down to fill the gap
     for (size_t i = index; i < object_mspace->allocation_count - 1; i++) {
         object_mspace->objects[i] = object_mspace->objects[i + 1];
+        k_MoveObjectId(&object_mspace->objects[i], i);
     }
     object_mspace->allocation_count--;
     size_t result = k_ReallocObjectMSpace();
@@ -607,6 +855,115 @@ int Kitty_RemoveObject(size_t index) {
     return KITTY_SUCCESS; // Success
 }
 
+int Kitty_AddObjects(const Kitty_Object* objects, size_t count) {
+    if (!object_mspace) {
+        return KITTY_MEMORYSPACE_NOT_INITIALIZED; // Memory space not initialized
+    }
+    if (count == 0) {
+        return KITTY_SUCCESS; // Nothing to add
+    }
+    if (!objects || count > SIZE_MAX / sizeof(Kitty_Object) - object_mspace->allocation_count - 1) {
+        return KITTY_INVALID_ARGUMENT; // No objects or too many
+    }
+    int result = k_ReserveObjectIds(object_mspace->id_count + count);
+    if (result != KITTY_SUCCESS) {
+        return result; // Return error code
+    }
+    result = k_FitObjectMSpace(object_mspace->allocation_count + count);
+    if (result != KITTY_SUCCESS) {
+        return result; // Return error code
+    }
+    size_t first = object_mspace->allocation_count;
+    for (size_t i = 0; i < count; i++) {
+        if (objects[i].id == 0) {
+            continue;
+        }
+        if (k_FindObjectId(objects[i].id)) {
+            // taken by a stored object or earlier in the batch, undo the ids registered so far
+            for (size_t j = 0; j < i; j++) {
+                k_EraseObjectId(objects[j].id);
+            }
+            return KITTY_DUPLICATE_OBJECT_ID;
+        }
+        k_InsertObjectId(objects[i].id, first + i);
+    }
+    memcpy(object_mspace->objects + first, objects, count * sizeof(Kitty_Object));
+    object_mspace->allocation_count += count;
+    return KITTY_SUCCESS; // Success
+}
+
+int Kitty_RemoveObjects(const size_t* indices, size_t count) {
+    if (!object_mspace) {
+        return KITTY_MEMORYSPACE_NOT_INITIALIZED; // Memory space not initialized
+    }
+    if (count == 0) {
+        return KITTY_SUCCESS; // Nothing to remove
+    }
+    if (!indices) {
+        return KITTY_INVALID_ARGUMENT; // No indices
+    }
+    size_t object_count = object_mspace->allocation_count;
+    for (size_t i = 0; i < count; i++) {
+        if (indices[i] >= object_count) {
+            return KITTY_INVALID_OBJECT_INDEX; // Invalid object index, nothing removed
+        }
+    }
+    // mark first so the indices may come in any order and repeat, then compact once
+    size_t bitmap_size = (object_count + 7) / 8;
+    unsigned char* doomed = (unsigned char*)k_GrowScratch((void**)&object_mspace->removed, &object_mspace->removed_capacity, bitmap_size);
+    if (!doomed) {
+        return KITTY_MEMORY_ALLOCATION_FAILURE; // Memory allocation failed
+    }
+    memset(doomed, 0, bitmap_size);
+    for (size_t i = 0; i < count; i++) {
+        doomed[indices[i] >> 3] |= (unsigned char)(1u << (indices[i] & 7));
+    }
+    size_t kept = 0;
+    for (size_t i = 0; i < object_count; i++) {
+        if (doomed[i >> 3] & (1u << (i & 7))) {
+            k_EraseObjectId(object_mspace->objects[i].id);
+        } else {
+            if (kept != i) {
+                object_mspace->objects[kept] = object_mspace->objects[i];
+                k_MoveObjectId(&object_mspace->objects[kept], kept);
+            }
+            kept++;
+        }
+    }
+    object_mspace->allocation_count = kept;
+    return k_FitObjectMSpace(kept);
+}
+
+int Kitty_RemoveIf(Kitty_ObjectPredicate predicate, void* user_data, size_t* out_removed) {
+    if (out_removed) {
+        *out_removed = 0;
+    }
+    if (!object_mspace) {
+        return KITTY_MEMORYSPACE_NOT_INITIALIZED; // Memory space not initialized
+    }
+    if (!predicate) {
+        return KITTY_INVALID_ARGUMENT; // No predicate
+    }
+    size_t object_count = object_mspace->allocation_count;
+    size_t kept = 0;
+    for (size_t i = 0; i < object_count; i++) {
+        if (predicate(&object_mspace->objects[i], user_data)) {
+            k_EraseObjectId(object_mspace->objects[i].id);
+        } else {
+            if (kept != i) {
+                object_mspace->objects[kept] = object_mspace->objects[i];
+                k_MoveObjectId(&object_mspace->objects[kept], kept);
+            }
+            kept++;
+        }
+    }
+    object_mspace->allocation_count = kept;
+    if (out_removed) {
+        *out_removed = object_count - kept;
+    }
+    return k_FitObjectMSpace(kept);
+}
+
 int Kitty_GetObject(size_t index, Kitty_Object* out_obj) {
     if (!object_mspace) {
         return KITTY_MEMORYSPACE_NOT_INITIALIZED; // Memory space not initialized
@@ -618,19 +975,106 @@ int Kitty_GetObject(size_t index, Kitty_Object* out_obj) {
     return KITTY_SUCCESS; // Success
 }
 
+size_t Kitty_GetObjectCount() {
+    return object_mspace ? object_mspace->allocation_count : 0;
+}
+
+int Kitty_SetObjectID(size_t index, Uint64 id) {
+    if (!object_mspace) {
+        return KITTY_MEMORYSPACE_NOT_INITIALIZED; // Memory space not initialized
+    }
+    if (index >= object_mspace->allocation_count) {
+        return KITTY_INVALID_OBJECT_INDEX; // Invalid object index
+    }
+    Kitty_Object* obj = &object_mspace->objects[index];
+    if (obj->id == id) {
+        return KITTY_SUCCESS; // Nothing to change
+    }
+    if (id != 0) {
+        if (k_FindObjectId(id)) {
+            return KITTY_DUPLICATE_OBJECT_ID; // Id already taken
+        }
+        int result = k_ReserveObjectIds(object_mspace->id_count + 1);
+        if (result != KITTY_SUCCESS) {
+            return result; // Return error code
+        }
+    }
+    k_EraseObjectId(obj->id);
+    if (id != 0) {
+        k_InsertObjectId(id, index);
+    }
+    obj->id = id;
+    return KITTY_SUCCESS; // Success
+}
+
+int Kitty_FindObject(Uint64 id, size_t* out_index) {
+    if (!object_mspace) {
+        return KITTY_MEMORYSPACE_NOT_INITIALIZED; // Memory space not initialized
+    }
+    if (!out_index) {
+        return KITTY_INVALID_ARGUMENT; // Nowhere to write the index
+    }
+    k_IdSlot* slot = k_FindObjectId(id);
+    if (!slot) {
+        return KITTY_OBJECT_NOT_FOUND; // No object has this id
+    }
+    *out_index = slot->index;
+    return KITTY_SUCCESS; // Success
+}
+
+Uint64 Kitty_ObjectIDFromName(const char* name) {
+    Uint64 hash = 14695981039346656037ULL;
+    for (const unsigned char* c = (const unsigned char*)(name ? name : ""); *c; c++) {
+        hash = (hash ^ *c) * 1099511628211ULL;
+    }
+    return hash ? hash : 1; // 0 means no id
+}
+
+int Kitty_SetObjectPriority(size_t index, enum Kitty_Priority priority) {
+    if (!object_mspace) {
+        return KITTY_MEMORYSPACE_NOT_INITIALIZED; // Memory space not initialized
+    }
+    if (index >= object_mspace->allocation_count) {
+        return KITTY_INVALID_OBJECT_INDEX; // Invalid object index
+    }
+    if (priority < KITTY_PRIORITY_LOW || priority > KITTY_PRIORITY_HIGH) {
+        return KITTY_INVALID_ARGUMENT; // Unknown priority
+    }
+    object_mspace->objects[index].priority = priority;
+    return KITTY_SUCCESS; // Success
+}
+
+int Kitty_SetObjectPriorityByID(Uint64 id, enum Kitty_Priority priority) {
+    size_t index;
+    int result = Kitty_FindObject(id, &index);
+    if (result) {
+        return result;
+    }
+    return Kitty_SetObjectPriority(index, priority);
+}
+
 int Kitty_AddVertexToObjMesh(Kitty_Object* obj, Kitty_Vertex3D vertex) {
     if (!obj || obj->type != KITTY_OBJECT_MESH) {
         return KITTY_INVALID_OBJECT_INDEX; // Invalid object or not a mesh
     }
     Kitty_ObjMesh* mesh = (Kitty_ObjMesh*)obj->data;
+    if (mesh->skin) {
+        return KITTY_INVALID_ARGUMENT; // Weights are bound per vertex, rebind the skin after changing the vertices
+    }
     size_t new_size = (mesh->vertex_count + 1) * sizeof(Kitty_Vertex3D);
-    Kitty_Vertex3D* new_vertices = (Kitty_Vertex3D*)realloc(mesh->vertices, new_size);
+    Kitty_Vertex3D* new_vertices = (Kitty_Vertex3D*)k_Realloc(mesh->vertices, new_size, KITTY_MEMORY_MESHES);
     if (!new_vertices) {
         return KITTY_MEMORY_ALLOCATION_FAILURE; // Memory allocation failed
     }
     mesh->vertices = new_vertices;
     mesh->vertices[mesh->vertex_count] = vertex;
     mesh->vertex_count++;
+    if (mesh->morph) {
+        mesh->morph->needs_reset = true;
+    }
+    if (mesh->impostor) {
+        mesh->impostor->stale = true;
+    }
     return KITTY_SUCCESS; // Success
 }
 
@@ -640,8 +1084,8 @@ int Kitty_AddFaceToObjMesh(Kitty_Object* obj, Kitty_Face face, Kitty_Color face_
     }
     Kitty_ObjMesh* mesh = (Kitty_ObjMesh*)obj->data;
     size_t new_size = (mesh->face_count + 1) * sizeof(Kitty_Face);
-    Kitty_Face* new_faces = (Kitty_Face*)realloc(mesh->faces, new_size);
-    Kitty_Color* new_face_colors = (Kitty_Color*)realloc(mesh->face_colors, new_size);
+    Kitty_Face* new_faces = (Kitty_Face*)k_Realloc(mesh->faces, new_size, KITTY_MEMORY_MESHES);
+    Kitty_Color* new_face_colors = (Kitty_Color*)k_Realloc(mesh->face_colors, new_size, KITTY_MEMORY_MESHES);
     if (!new_faces) {
         return KITTY_MEMORY_ALLOCATION_FAILURE; // Memory allocation failed
     }
@@ -663,7 +1107,7 @@ int Kitty_AddUVToObjMesh(Kitty_Object* obj, Kitty_UV uv) {
     }
     Kitty_ObjMesh* mesh = (Kitty_ObjMesh*)obj->data;
     size_t new_size = (mesh->uv_count + 1) * sizeof(Kitty_UV);
-    Kitty_UV* new_uvs = (Kitty_UV*)realloc(mesh->uvs, new_size);
+    Kitty_UV* new_uvs = (Kitty_UV*)k_Realloc(mesh->uvs, new_size, KITTY_MEMORY_MESHES);
     if (!new_uvs) {
         return KITTY_MEMORY_ALLOCATION_FAILURE; // Memory allocation failed
     }
@@ -677,14 +1121,25 @@ Kitty_Texture* Kitty_LoadTexture(const char* file_path) {
     if (!sdl_renderer) {
         return NULL; // SDL renderer not initialized
     }
-    SDL_Surface* surface = IMG_Load(file_path);
-    SDL_Surface* optimized_surface = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA32, 0);
+    SDL_Surface* surface = k_LoadSurface(file_path, KITTY_MEMORY_TEXTURES, NULL);
     if (!surface) {
-
         return NULL; // Image loading failed
     }
-    Kitty_Texture* texture = (Kitty_Texture*)malloc(sizeof(Kitty_Texture));
-    texture->sdl_surface = optimized_surface;
+    Kitty_Texture* texture = (Kitty_Texture*)calloc(1, sizeof(Kitty_Texture));
+    if (!texture) {
+        k_FreeSurface(surface);
+        return NULL; // Memory allocation failed
+    }
+    texture->sdl_surface = surface;
+    return texture;
+}
+
+Kitty_Texture* Kitty_LoadTextureAs(const char* file_path, enum Kitty_TextureFormat format) {
+    Kitty_Texture* texture = Kitty_LoadTexture(file_path);
+    if (texture && Kitty_ConvertTexture(texture, format) != KITTY_SUCCESS) {
+        Kitty_FreeTexture(texture);
+        return NULL;
+    }
     return texture;
 }
 
@@ -736,6 +1191,64 @@ int Kitty_LoadDotObj(FILE* file, Kitty_Object* mesh) {
     return 0;
 }
 
+int Kitty_LoadDotObjMorphTarget(FILE* file, Kitty_Object* mesh) {
+    if (!file || !mesh || mesh->type != KITTY_OBJECT_MESH) {
+        return KITTY_INVALID_OBJECT_INDEX; // Invalid object or not a mesh
+    }
+    Kitty_ObjMesh* mesh_data = (Kitty_ObjMesh*)mesh->data;
+
+    // only the moved vertices are kept, the rest of the keyframe is dropped
+    Uint32* indices = (Uint32*)k_Alloc(mesh_data->vertex_count * sizeof(Uint32) + 1, KITTY_MEMORY_MESHES);
+    Kitty_Vertex3D* deltas = (Kitty_Vertex3D*)k_Alloc(mesh_data->vertex_count * sizeof(Kitty_Vertex3D) + 1, KITTY_MEMORY_MESHES);
+    if (!indices || !deltas) {
+        k_Free(indices);
+        k_Free(deltas);
+        return KITTY_MEMORY_ALLOCATION_FAILURE; // Memory allocation failed
+    }
+    size_t vertex = 0;
+    size_t count = 0;
+    char line[128];
+    while (fgets(line, sizeof(line), file)) {
+        if (strncmp(line, "v ", 2) != 0) {
+            continue;
+        }
+        Kitty_Vertex3D v;
+        if (vertex >= mesh_data->vertex_count || sscanf(line, "v %f %f %f", &v.x, &v.y, &v.z) != 3) {
+            vertex = mesh_data->vertex_count + 1; // more vertices than the mesh, or garbage
+            break;
+        }
+        Kitty_Vertex3D base = mesh_data->vertices[vertex];
+        Kitty_Vertex3D delta = {v.x - base.x, v.y - base.y, v.z - base.z};
+        if (fabsf(delta.x) > 1e-6f || fabsf(delta.y) > 1e-6f || fabsf(delta.z) > 1e-6f) {
+            indices[count] = (Uint32)vertex;
+            deltas[count] = delta;
+            count++;
+        }
+        vertex++;
+    }
+
+    int result = KITTY_INVALID_ARGUMENT; // Keyframe does not match the mesh
+    if (vertex == mesh_data->vertex_count) {
+        result = Kitty_AddMorphTarget(mesh, indices, deltas, count);
+    }
+    k_Free(indices);
+    k_Free(deltas);
+    return result;
+}
+
+int Kitty_LoadDotObjSequence(FILE** files, size_t file_count, Kitty_Object* mesh) {
+    if (!files) {
+        return KITTY_INVALID_ARGUMENT; // No files
+    }
+    for (size_t i = 0; i < file_count; i++) {
+        int result = Kitty_LoadDotObjMorphTarget(files[i], mesh);
+        if (result != KITTY_SUCCESS) {
+            return result;
+        }
+    }
+    return KITTY_SUCCESS; // Success
+}
+
 size_t Kitty_GetFrameNumber() {
     return frame_num;
 }
@@ -748,71 +1261,304 @@ double Kitty_GetFrameTime() {
     return frame_time;
 }
 
-void Kitty_SetTimer1() {
-    timer_1 = clock();
+int Kitty_SetDynamicResolution(Kitty_DynamicResolution settings) {
+    if (settings.min_scale <= 0.0f || settings.max_scale > 1.0f || settings.min_scale > settings.max_scale ||
+        settings.budget_ms <= 0.0f || settings.smoothing <= 0.0f || settings.smoothing > 1.0f || settings.deadband < 0.0f) {
+        return KITTY_INVALID_ARGUMENT; // Scales must lie in (0, 1], smoothing in (0, 1]
+    }
+    k_dynamic_resolution = settings;
+    k_fb_scale = SDL_min(SDL_max(k_fb_scale, settings.min_scale), settings.max_scale);
+    return KITTY_SUCCESS; // Success
 }
 
-bool Kitty_Timer1Trip(long milliseconds) {
-    clock_t current_time = clock();
-    long elapsed_time = (current_time - timer_1) * 1000 / CLOCKS_PER_SEC;
-    return elapsed_time >= milliseconds;
+Kitty_DynamicResolution Kitty_GetDynamicResolution() {
+    return k_dynamic_resolution;
 }
 
-void Kitty_RotateCamera(float angle_x, float angle_y, float angle_z) {
-    //rotate k_camera_position aroind k_camera_origin by angle_x, angle_y, angle_z (in degrees)
-    Kitty_Vertex3D dir = {
-        k_camera_position.x - k_camera_origin.x,
-        k_camera_position.y - k_camera_origin.y,
-        k_camera_position.z - k_camera_origin.z
-    };
-    // Rotate around X axis
-    float cos_x = cosf(angle_x);
-    float sin_x = sinf(angle_x);
-    float y1 = dir.y * cos_x - dir.z * sin_x;
-    float z1 = dir.y * sin_x + dir.z * cos_x;
-    dir.y = y1;
-    dir.z = z1;
-    // Rotate around Y axis
-    float cos_y = cosf(angle_y);
-    float sin_y = sinf(angle_y);
-    float x2 = dir.x * cos_y + dir.z * sin_y;
-    float z2 = -dir.x * sin_y + dir.z * cos_y;
-    dir.x = x2;
-    dir.z = z2;
-    // Rotate around Z axis
-    float cos_z = cosf(angle_z);
-    float sin_z = sinf(angle_z);
-    float x3 = dir.x * cos_z - dir.y * sin_z;
-    float y3 = dir.x * sin_z + dir.y * cos_z;
-    dir.x = x3;
-    dir.y = y3;
-    k_camera_position.x = k_camera_origin.x + dir.x;
-    k_camera_position.y = k_camera_origin.y + dir.y;
-    k_camera_position.z = k_camera_origin.z + dir.z;
+int Kitty_SetResolutionScale(float scale) {
+    if (scale <= 0.0f || scale > 1.0f) {
+        return KITTY_INVALID_ARGUMENT; // Scale must lie in (0, 1]
+    }
+    k_fb_scale = scale;
+    return KITTY_SUCCESS; // Success
 }
 
-Kitty_Vertex3D Kitty_GetCameraPosition() {
-    return k_camera_position;
+float Kitty_GetResolutionScale() {
+    return k_fb_scale;
 }
 
-void Kitty_SetCameraPosition(Kitty_Vertex3D position) {
-    k_camera_position = position;
+double Kitty_GetRasterTime() {
+    return k_fb_last_raster_ms;
 }
 
-void Kitty_SetCameraOrigin(Kitty_Point3D origin) {
-    k_camera_origin = origin;
+int Kitty_SetAntiAliasing(enum Kitty_AntiAliasing level) {
+    // sample positions in the unit pixel, each level spreads its samples over distinct rows and columns
+    static const float rotated_grid[8] = {0.375f, 0.125f, 0.875f, 0.375f, 0.125f, 0.625f, 0.625f, 0.875f};
+    static const int pattern_8x[16] = {9, 5, 7, 11, 13, 9, 5, 3, 3, 13, 1, 7, 11, 15, 15, 1}; // sixteenths
+    switch (level) {
+        case KITTY_AA_OFF:
+            break;
+        case KITTY_AA_4X:
+            for (int i = 0; i < 4; i++) {
+                k_aa_sample_x[i] = rotated_grid[i * 2];
+                k_aa_sample_y[i] = rotated_grid[i * 2 + 1];
+            }
+            break;
+        case KITTY_AA_8X:
+            for (int i = 0; i < 8; i++) {
+                k_aa_sample_x[i] = pattern_8x[i * 2] / 16.0f;
+                k_aa_sample_y[i] = pattern_8x[i * 2 + 1] / 16.0f;
+            }
+            break;
+        case KITTY_AA_16X:
+            for (int i = 0; i < 16; i++) {
+                k_aa_sample_x[i] = (4 * (i % 4) + i / 4 + 0.5f) / 16.0f;
+                k_aa_sample_y[i] = (4 * (i / 4) + i % 4 + 0.5f) / 16.0f;
+            }
+            break;
+        default:
+            return KITTY_INVALID_ARGUMENT;
+    }
+    k_aa_samples = level;
+    return KITTY_SUCCESS;
 }
 
-Kitty_Object* Kitty_CreateCircle(Kitty_Point position, float radius, bool filled, Kitty_Color color) {
-    Kitty_Object* obj = (Kitty_Object*)malloc(sizeof(Kitty_Object));
-    if (!obj) {
-        return NULL; // Memory allocation failed
-    }
-    obj->type = KITTY_OBJECT_CIRCLE;
-    obj->data = malloc(sizeof(Kitty_ObjCircle));
-    if (!obj->data) {
-        free(obj);
-        return NULL; // Memory allocation failed
+enum Kitty_AntiAliasing Kitty_GetAntiAliasing() {
+    return (enum Kitty_AntiAliasing)k_aa_samples;
+}
+
+int Kitty_SetPostChain(const Kitty_PostEffect* effects, size_t count) {
+    if (count > KITTY_MAX_POST_EFFECTS || (count > 0 && !effects)) {
+        return KITTY_INVALID_ARGUMENT;
+    }
+    int depth = 0;
+    for (size_t i = 0; i < count; i++) {
+        switch (effects[i].type) {
+            case KITTY_POST_BOX_BLUR:
+            case KITTY_POST_GAUSSIAN_BLUR:
+                if (effects[i].radius < 1) {
+                    return KITTY_INVALID_ARGUMENT;
+                }
+                break;
+            case KITTY_POST_COLOR_LUT:
+                if (!effects[i].lut || !effects[i].lut->entries || effects[i].lut->size < 2) {
+                    return KITTY_INVALID_ARGUMENT;
+                }
+                break;
+            case KITTY_POST_DOWNSAMPLE:
+                if (++depth > K_POST_MAX_LEVELS) {
+                    return KITTY_INVALID_ARGUMENT; // nested too deep
+                }
+                break;
+            case KITTY_POST_UPSAMPLE:
+                if (--depth < 0) {
+                    return KITTY_INVALID_ARGUMENT; // nothing to go back to
+                }
+                break;
+            default:
+                return KITTY_INVALID_ARGUMENT;
+        }
+    }
+    if (count > 0) {
+        memcpy(k_post_chain, effects, count * sizeof(Kitty_PostEffect));
+    }
+    k_post_count = count;
+    return KITTY_SUCCESS;
+}
+
+Kitty_ColorLUT* Kitty_CreateColorLUT(int size) {
+    if (size < 2 || size > 64) {
+        return NULL;
+    }
+    Kitty_ColorLUT* lut = (Kitty_ColorLUT*)k_Alloc(sizeof(Kitty_ColorLUT), KITTY_MEMORY_FRAME);
+    if (!lut) {
+        return NULL;
+    }
+    lut->size = size;
+    lut->entries = (Uint32*)k_Alloc((size_t)size * size * size * sizeof(Uint32), KITTY_MEMORY_FRAME);
+    if (!lut->entries) {
+        k_Free(lut);
+        return NULL;
+    }
+    for (int b = 0; b < size; b++) {
+        for (int g = 0; g < size; g++) {
+            for (int r = 0; r < size; r++) {
+                lut->entries[r + size * (g + size * b)] = 0xFF000000u | (Uint32)(r * 255 / (size - 1)) << 16 |
+                                                          (Uint32)(g * 255 / (size - 1)) << 8 | (Uint32)(b * 255 / (size - 1));
+            }
+        }
+    }
+    return lut;
+}
+
+void Kitty_FreeColorLUT(Kitty_ColorLUT* lut) {
+    if (!lut) {
+        return;
+    }
+    k_Free(lut->entries);
+    k_Free(lut);
+}
+
+int Kitty_SetColorLUTEntry(Kitty_ColorLUT* lut, int r, int g, int b, Kitty_Color color) {
+    if (!lut || r < 0 || g < 0 || b < 0 || r >= lut->size || g >= lut->size || b >= lut->size) {
+        return KITTY_INVALID_ARGUMENT;
+    }
+    lut->entries[r + lut->size * (g + lut->size * b)] = 0xFF000000u | (Uint32)color.r << 16 | (Uint32)color.g << 8 | color.b;
+    return KITTY_SUCCESS;
+}
+
+int Kitty_SetFramesInFlight(int count) {
+    if (count < 1 || count > KITTY_MAX_FRAMES_IN_FLIGHT) {
+        return KITTY_INVALID_ARGUMENT;
+    }
+    if (count != k_frames_in_flight) {
+        k_StopRasterThread(); // slots are indexed by frame modulo count, start over
+        k_frames_in_flight = count;
+    }
+    return KITTY_SUCCESS;
+}
+
+int Kitty_GetFramesInFlight() {
+    return k_frames_in_flight;
+}
+
+int Kitty_SetFrameGovernor(Kitty_FrameGovernor settings) {
+    if (settings.budget_ms <= 0.0f || settings.degrade_after < 1 || settings.restore_after < 1 ||
+        settings.headroom <= 0.0f || settings.headroom > 1.0f || settings.text_interval < 1) {
+        return KITTY_INVALID_ARGUMENT; // Budget and frame counts must be positive, headroom in (0, 1]
+    }
+    k_governor = settings;
+    return KITTY_SUCCESS; // Success
+}
+
+Kitty_FrameGovernor Kitty_GetFrameGovernor() {
+    return k_governor;
+}
+
+int Kitty_SetQualityLevel(int level) {
+    if (level < 0 || level >= KITTY_QUALITY_LEVELS) {
+        return KITTY_INVALID_ARGUMENT; // No such level
+    }
+    if (level != k_frame_stats.quality_level) {
+        k_Log(KITTY_EVENT_QUALITY_CHANGED, NULL, -1, k_frame_stats.quality_level, level, 0);
+        k_frame_stats.quality_level = level;
+        k_frame_stats.level_changes++;
+    }
+    k_frame_stats.frames_over_budget = 0;
+    k_frame_stats.frames_with_headroom = 0;
+    return KITTY_SUCCESS; // Success
+}
+
+Kitty_FrameStats Kitty_GetFrameStats() {
+    return k_frame_stats;
+}
+
+int Kitty_SetRenderBackend(enum Kitty_BackendType type) {
+    if (!sdl_renderer) {
+        return KITTY_SDL_RENDERER_NOT_INITIALIZED;
+    }
+    if (type != KITTY_BACKEND_SDL && type != KITTY_BACKEND_SOFTWARE && type != KITTY_BACKEND_NULL) {
+        return KITTY_INVALID_ARGUMENT;
+    }
+    Kitty_RenderBackend backend;
+    k_GetBuiltinBackend(type, &backend);
+    k_InstallBackend(&backend);
+    return KITTY_SUCCESS;
+}
+
+int Kitty_SetCustomRenderBackend(const Kitty_RenderBackend* backend) {
+    if (!sdl_renderer) {
+        return KITTY_SDL_RENDERER_NOT_INITIALIZED;
+    }
+    if (!backend || !backend->begin_frame || !backend->clear || !backend->set_color || !backend->set_blend_mode ||
+        !backend->draw_points || !backend->draw_lines || !backend->draw_rect || !backend->fill_rects ||
+        !backend->copy_texture || !backend->set_target || !backend->present_framebuffer || !backend->present ||
+        !backend->read_back) {
+        return KITTY_INVALID_ARGUMENT;
+    }
+    k_InstallBackend(backend);
+    return KITTY_SUCCESS;
+}
+
+const Kitty_RenderBackend* Kitty_GetRenderBackend() {
+    return k_backend;
+}
+
+int Kitty_ReadPixels(Uint32* pixels, int pitch) {
+    if (!sdl_renderer) {
+        return KITTY_SDL_RENDERER_NOT_INITIALIZED;
+    }
+    if (!pixels || pitch < window_width * (int)sizeof(Uint32)) {
+        return KITTY_INVALID_ARGUMENT;
+    }
+    return k_backend->read_back(k_backend->user_data, pixels, pitch);
+}
+
+void Kitty_SetTimer1() {
+    timer_1 = k_NowMs();
+}
+
+bool Kitty_Timer1Trip(long milliseconds) {
+    return k_NowMs() - timer_1 >= (double)milliseconds;
+}
+
+void Kitty_RotateCamera(float angle_x, float angle_y, float angle_z) {
+    //rotate k_camera_position aroind k_camera_origin by angle_x, angle_y, angle_z (in degrees)
+    Kitty_Vertex3D dir = {
+        k_camera_position.x - k_camera_origin.x,
+        k_camera_position.y - k_camera_origin.y,
+        k_camera_position.z - k_camera_origin.z
+    };
+    // Rotate around X axis
+    float cos_x = cosf(angle_x);
+    float sin_x = sinf(angle_x);
+    float y1 = dir.y * cos_x - dir.z * sin_x;
+    float z1 = dir.y * sin_x + dir.z * cos_x;
+    dir.y = y1;
+    dir.z = z1;
+    // Rotate around Y axis
+    float cos_y = cosf(angle_y);
+    float sin_y = sinf(angle_y);
+    float x2 = dir.x * cos_y + dir.z * sin_y;
+    float z2 = -dir.x * sin_y + dir.z * cos_y;
+    dir.x = x2;
+    dir.z = z2;
+    // Rotate around Z axis
+    float cos_z = cosf(angle_z);
+    float sin_z = sinf(angle_z);
+    float x3 = dir.x * cos_z - dir.y * sin_z;
+    float y3 = dir.x * sin_z + dir.y * cos_z;
+    dir.x = x3;
+    dir.y = y3;
+    k_camera_position.x = k_camera_origin.x + dir.x;
+    k_camera_position.y = k_camera_origin.y + dir.y;
+    k_camera_position.z = k_camera_origin.z + dir.z;
+}
+
+Kitty_Vertex3D Kitty_GetCameraPosition() {
+    return k_camera_position;
+}
+
+void Kitty_SetCameraPosition(Kitty_Vertex3D position) {
+    k_camera_position = position;
+}
+
+void Kitty_SetCameraOrigin(Kitty_Point3D origin) {
+    k_camera_origin = origin;
+}
+
+Kitty_Object* Kitty_CreateCircle(Kitty_Point position, float radius, bool filled, Kitty_Color color) {
+    Kitty_Object* obj = (Kitty_Object*)malloc(sizeof(Kitty_Object));
+    if (!obj) {
+        return NULL; // Memory allocation failed
+    }
+    obj->type = KITTY_OBJECT_CIRCLE;
+    obj->priority = KITTY_PRIORITY_NORMAL;
+    obj->id = 0;
+    obj->data = malloc(sizeof(Kitty_ObjCircle));
+    if (!obj->data) {
+        free(obj);
+        return NULL; // Memory allocation failed
     }
     Kitty_ObjCircle* circle_data = (Kitty_ObjCircle*)obj->data;
     circle_data->position = position;
@@ -828,6 +1574,8 @@ Kitty_Object* Kitty_CreateRectangle(Kitty_Point position, int width, int height,
         return NULL; // Memory allocation failed
     }
     obj->type = KITTY_OBJECT_RECTANGLE;
+    obj->priority = KITTY_PRIORITY_NORMAL;
+    obj->id = 0;
     obj->data = malloc(sizeof(Kitty_ObjRectangle));
     if (!obj->data) {
         free(obj);
@@ -848,6 +1596,8 @@ Kitty_Object* Kitty_CreateLine(Kitty_Point startPosition, Kitty_Point endPositio
         return NULL; // Memory allocation failed
     }
     obj->type = KITTY_OBJECT_LINE;
+    obj->priority = KITTY_PRIORITY_NORMAL;
+    obj->id = 0;
     obj->data = malloc(sizeof(Kitty_ObjLine));
     if (!obj->data) {
         free(obj);
@@ -866,6 +1616,8 @@ Kitty_Object* Kitty_CreateTriangle(Kitty_Point vertex1, Kitty_Point vertex2, Kit
         return NULL; // Memory allocation failed
     }
     obj->type = KITTY_OBJECT_TRIANGLE;
+    obj->priority = KITTY_PRIORITY_NORMAL;
+    obj->id = 0;
     obj->data = malloc(sizeof(Kitty_ObjTriangle));
     if (!obj->data) {
         free(obj);
@@ -886,6 +1638,8 @@ Kitty_Object* Kitty_CreatePixel(Kitty_Point position, Kitty_Color color) {
         return NULL; // Memory allocation failed
     }
     obj->type = KITTY_OBJECT_PIXEL;
+    obj->priority = KITTY_PRIORITY_NORMAL;
+    obj->id = 0;
     obj->data = malloc(sizeof(Kitty_ObjPixel));
     if (!obj->data) {
         free(obj);
@@ -903,6 +1657,8 @@ Kitty_Object* Kitty_CreateMesh(){
         return NULL; // Memory allocation failed
     }
     obj->type = KITTY_OBJECT_MESH;
+    obj->priority = KITTY_PRIORITY_NORMAL;
+    obj->id = 0;
     obj->data = malloc(sizeof(Kitty_ObjMesh));
     if (!obj->data) {
         free(obj);
@@ -913,6 +1669,8 @@ Kitty_Object* Kitty_CreateMesh(){
     mesh_data->faces = NULL;
     mesh_data->face_colors = NULL;
     mesh_data->uvs = NULL;
+    mesh_data->texture = NULL;
+    mesh_data->virtual_texture = NULL;
     mesh_data->scale = 1;
     mesh_data->position = (Kitty_Point3D){0, 0, 0};
     mesh_data->vertex_count = 0;
@@ -920,6 +1678,9 @@ Kitty_Object* Kitty_CreateMesh(){
     mesh_data->uv_count = 0;
     mesh_data->wire = false;
     mesh_data->wrap = true;
+    mesh_data->skin = NULL;
+    mesh_data->morph = NULL;
+    mesh_data->impostor = NULL;
     return obj;
 }
 
@@ -929,6 +1690,8 @@ Kitty_Object* Kitty_CreateText(Kitty_Point position, float size, float rotation,
         return NULL; // Memory allocation failed
     }
     obj->type = KITTY_OBJECT_TEXT;
+    obj->priority = KITTY_PRIORITY_NORMAL;
+    obj->id = 0;
     obj->data = malloc(sizeof(Kitty_ObjText));
     if (!obj->data) {
         free(obj);
@@ -939,7 +1702,12 @@ Kitty_Object* Kitty_CreateText(Kitty_Point position, float size, float rotation,
     text_data->size = size;
     text_data->rotation = rotation;
     text_data->color = color;
-    text_data->text = strdup(text); // Duplicate the string
+    text_data->cache = NULL;
+    text_data->cache_frame = 0;
+    text_data->text = (char*)k_Alloc(strlen(text) + 1, KITTY_MEMORY_TEXT); // Duplicate the string
+    if (text_data->text) {
+        memcpy(text_data->text, text, strlen(text) + 1);
+    }
     if (!text_data->text) {
         free(text_data);
         free(obj);
@@ -948,89 +1716,842 @@ Kitty_Object* Kitty_CreateText(Kitty_Point position, float size, float rotation,
     return obj;
 }
 
-int Kitty_Transform(Kitty_Object* obj, Kitty_Point3D translation, Kitty_Vertex3D rotation) {
+Kitty_Object* Kitty_CreateTilemap(Kitty_Point position, int width, int height, int tile_width, int tile_height, Kitty_Texture* atlas) {
+    if (width <= 0 || height <= 0 || tile_width <= 0 || tile_height <= 0 || !atlas || !atlas->sdl_surface) {
+        return NULL; // Invalid dimensions or atlas
+    }
+    Kitty_Object* obj = (Kitty_Object*)malloc(sizeof(Kitty_Object));
     if (!obj) {
-        return KITTY_INVALID_OBJECT_INDEX; // Invalid object
+        return NULL; // Memory allocation failed
     }
-    if (obj->type != KITTY_OBJECT_MESH) {
-        return KITTY_INVALID_OBJECT_INDEX; // Invalid object type
+    obj->type = KITTY_OBJECT_TILEMAP;
+    obj->priority = KITTY_PRIORITY_NORMAL;
+    obj->id = 0;
+    obj->data = malloc(sizeof(Kitty_ObjTilemap));
+    if (!obj->data) {
+        free(obj);
+        return NULL; // Memory allocation failed
     }
-    Kitty_ObjMesh* mesh = (Kitty_ObjMesh*)obj->data;
+    Kitty_ObjTilemap* map_data = (Kitty_ObjTilemap*)obj->data;
+    map_data->position = position;
+    map_data->width = width;
+    map_data->height = height;
+    map_data->tile_width = tile_width;
+    map_data->tile_height = tile_height;
+    map_data->atlas = atlas;
+    map_data->chunks_x = (width + KITTY_TILEMAP_CHUNK_SIZE - 1) / KITTY_TILEMAP_CHUNK_SIZE;
+    map_data->chunks_y = (height + KITTY_TILEMAP_CHUNK_SIZE - 1) / KITTY_TILEMAP_CHUNK_SIZE;
+    map_data->cache = NULL;
+    map_data->cache_size = 0;
+    map_data->atlas_texture = NULL;
+
+    size_t tile_count = (size_t)width * (size_t)height;
+    size_t chunk_count = (size_t)map_data->chunks_x * (size_t)map_data->chunks_y;
+    map_data->tiles = (Uint16*)k_Alloc(tile_count * sizeof(Uint16), KITTY_MEMORY_SHAPES);
+    map_data->chunk_slots = (int*)k_Alloc(chunk_count * sizeof(int), KITTY_MEMORY_SHAPES);
+    if (!map_data->tiles || !map_data->chunk_slots) {
+        k_Free(map_data->tiles);
+        k_Free(map_data->chunk_slots);
+        free(map_data);
+        free(obj);
+        return NULL; // Memory allocation failed
+    }
+    for (size_t i = 0; i < tile_count; i++) {
+        map_data->tiles[i] = KITTY_TILE_EMPTY;
+    }
+    for (size_t i = 0; i < chunk_count; i++) {
+        map_data->chunk_slots[i] = -1;
+    }
+    return obj;
+}
 
-    // Apply translation
-    mesh->position.x += translation.x;
-    mesh->position.y += translation.y;
-    mesh->position.z += translation.z;
+int Kitty_SetTile(Kitty_Object* obj, int x, int y, Uint16 tile) {
+    if (!obj || obj->type != KITTY_OBJECT_TILEMAP) {
+        return KITTY_INVALID_OBJECT_INDEX; // Invalid object or not a tilemap
+    }
+    Kitty_ObjTilemap* map = (Kitty_ObjTilemap*)obj->data;
+    if (x < 0 || y < 0 || x >= map->width || y >= map->height) {
+        return KITTY_INVALID_ARGUMENT; // Tile outside of map
+    }
+    Uint16* cell = &map->tiles[(size_t)y * map->width + x];
+    if (*cell == tile) {
+        return KITTY_SUCCESS; // Nothing changed, keep the cached chunk
+    }
+    *cell = tile;
 
-    //apply rotation around origin
-    for (size_t i = 0; i < mesh->vertex_count; i++){
-        Kitty_Vertex3D v = mesh->vertices[i];
+    int chunk = (y / KITTY_TILEMAP_CHUNK_SIZE) * map->chunks_x + (x / KITTY_TILEMAP_CHUNK_SIZE);
+    int slot = map->chunk_slots[chunk];
+    if (slot >= 0) {
+        map->cache[slot].dirty = true;
+    }
+    return KITTY_SUCCESS; // Success
+}
 
-        // Translate vertex to origin
-        v.x -= mesh->origin.x;
-        v.y -= mesh->origin.y;
-        v.z -= mesh->origin.z;
+int Kitty_GetTile(Kitty_Object* obj, int x, int y, Uint16* out_tile) {
+    if (!obj || obj->type != KITTY_OBJECT_TILEMAP) {
+        return KITTY_INVALID_OBJECT_INDEX; // Invalid object or not a tilemap
+    }
+    Kitty_ObjTilemap* map = (Kitty_ObjTilemap*)obj->data;
+    if (x < 0 || y < 0 || x >= map->width || y >= map->height) {
+        return KITTY_INVALID_ARGUMENT; // Tile outside of map
+    }
+    *out_tile = map->tiles[(size_t)y * map->width + x];
+    return KITTY_SUCCESS; // Success
+}
 
-        // Rotate around X axis
-        v = KittyM_RotateVertex3D_X(v, rotation.x);
-        // Rotate around Y axis
-        v = KittyM_RotateVertex3D_Y(v, rotation.y);
-        // Rotate around Z axis
-        v = KittyM_RotateVertex3D_Z(v, rotation.z);
+Kitty_Object* Kitty_CreatePolygon(const Kitty_Point* points, size_t point_count, bool filled, enum Kitty_FillRule fill_rule, Kitty_Color color) {
+    Kitty_Object* obj = (Kitty_Object*)malloc(sizeof(Kitty_Object));
+    if (!obj) {
+        return NULL; // Memory allocation failed
+    }
+    obj->type = KITTY_OBJECT_POLYGON;
+    obj->priority = KITTY_PRIORITY_NORMAL;
+    obj->id = 0;
+    obj->data = malloc(sizeof(Kitty_ObjPolygon));
+    if (!obj->data) {
+        free(obj);
+        return NULL; // Memory allocation failed
+    }
+    Kitty_ObjPolygon* poly_data = (Kitty_ObjPolygon*)obj->data;
+    k_InitPolygon(poly_data, filled, fill_rule, color);
+    if (Kitty_AddPolygonContour(obj, points, point_count) != KITTY_SUCCESS) {
+        k_Free(poly_data->points); // the points may have grown before the contour ends failed
+        k_Free(poly_data->contour_ends);
+        free(poly_data);
+        free(obj);
+        return NULL; // Invalid contour or memory allocation failed
+    }
+    return obj;
+}
 
-        // Translate vertex back
-        v.x += mesh->origin.x;
-        v.y += mesh->origin.y;
-        v.z += mesh->origin.z;
+int Kitty_AddPolygonContour(Kitty_Object* obj, const Kitty_Point* points, size_t point_count) {
+    if (!obj || obj->type != KITTY_OBJECT_POLYGON) {
+        return KITTY_INVALID_OBJECT_INDEX; // Invalid object or not a polygon
+    }
+    if (!points || point_count < 3) {
+        return KITTY_INVALID_ARGUMENT; // A contour needs at least a triangle
+    }
+    return k_PolygonAddContour((Kitty_ObjPolygon*)obj->data, points, point_count);
+}
 
-        mesh->vertices[i] = v;
+Kitty_Object* Kitty_CreatePolyline(const Kitty_Point* points, size_t point_count, float width, enum Kitty_LineJoin join, Kitty_Color color) {
+    Kitty_Object* obj = (Kitty_Object*)malloc(sizeof(Kitty_Object));
+    if (!obj) {
+        return NULL; // Memory allocation failed
     }
+    obj->type = KITTY_OBJECT_POLYLINE;
+    obj->priority = KITTY_PRIORITY_NORMAL;
+    obj->id = 0;
+    obj->data = malloc(sizeof(Kitty_ObjPolyline));
+    if (!obj->data) {
+        free(obj);
+        return NULL; // Memory allocation failed
+    }
+    Kitty_ObjPolyline* line_data = (Kitty_ObjPolyline*)obj->data;
+    k_InitPolyline(line_data, width, join, color);
+    if (Kitty_SetPolylinePoints(obj, points, point_count) != KITTY_SUCCESS) {
+        free(line_data);
+        free(obj);
+        return NULL; // Invalid points or memory allocation failed
+    }
+    return obj;
+}
 
+int Kitty_SetPolylinePoints(Kitty_Object* obj, const Kitty_Point* points, size_t point_count) {
+    if (!obj || obj->type != KITTY_OBJECT_POLYLINE) {
+        return KITTY_INVALID_OBJECT_INDEX; // Invalid object or not a polyline
+    }
+    if (!points && point_count > 0) {
+        return KITTY_INVALID_ARGUMENT; // Missing points
+    }
+    Kitty_ObjPolyline* line = (Kitty_ObjPolyline*)obj->data;
+    if (point_count > line->point_capacity) {
+        Kitty_Point* new_points = (Kitty_Point*)k_Realloc(line->points, point_count * sizeof(Kitty_Point), KITTY_MEMORY_SHAPES);
+        if (!new_points) {
+            return KITTY_MEMORY_ALLOCATION_FAILURE; // Memory allocation failed
+        }
+        line->points = new_points;
+        line->point_capacity = point_count;
+    }
+    if (point_count > 0) {
+        memcpy(line->points, points, point_count * sizeof(Kitty_Point));
+    }
+    line->point_count = point_count;
+    line->stroke_dirty = true;
     return KITTY_SUCCESS; // Success
 }
 
-Kitty_Vertex3D KittyM_CalculateMeshCenter(Kitty_ObjMesh* mesh){
-    Kitty_Vertex3D center = {0, 0, 0};
-    for (size_t i = 0; i < mesh->vertex_count; i++){
-        center.x += mesh->vertices[i].x;
-        center.y += mesh->vertices[i].y;
-        center.z += mesh->vertices[i].z;
+Kitty_Object* Kitty_CreatePath(Kitty_Point position, float width, enum Kitty_LineJoin join, Kitty_Color color) {
+    Kitty_Object* obj = (Kitty_Object*)malloc(sizeof(Kitty_Object));
+    if (!obj) {
+        return NULL; // Memory allocation failed
     }
-    center.x /= mesh->vertex_count;
-    center.y /= mesh->vertex_count;
-    center.z /= mesh->vertex_count;
-    return center;
+    obj->type = KITTY_OBJECT_PATH;
+    obj->priority = KITTY_PRIORITY_NORMAL;
+    obj->id = 0;
+    obj->data = malloc(sizeof(Kitty_ObjPath));
+    if (!obj->data) {
+        free(obj);
+        return NULL; // Memory allocation failed
+    }
+    Kitty_ObjPath* path_data = (Kitty_ObjPath*)obj->data;
+    path_data->position = position;
+    path_data->scale = 1.0f;
+    path_data->segments = NULL;
+    path_data->segment_count = 0;
+    path_data->flat_dirty = true;
+    path_data->flat = NULL;
+    path_data->flat_count = 0;
+    path_data->flat_capacity = 0;
+    path_data->subpath_ends = NULL;
+    path_data->subpath_count = 0;
+    path_data->subpath_capacity = 0;
+    path_data->flat_scale = 0.0f;
+    path_data->flat_position = position;
+    k_InitPolyline(&path_data->line, width, join, color);
+    return obj;
 }
 
-float KittyM_DotProduct3(Kitty_Vertex3D v1, Kitty_Vertex3D v2){
-    return (v1.x * v2.x) + (v1.y * v2.y) + (v1.z * v2.z);
+///@brief Appends a segment to a path and invalidates its flattening.
+static int k_PathAddSegment(Kitty_Object* obj, Kitty_PathSegment segment) {
+    if (!obj || obj->type != KITTY_OBJECT_PATH) {
+        return KITTY_INVALID_OBJECT_INDEX; // Invalid object or not a path
+    }
+    Kitty_ObjPath* path = (Kitty_ObjPath*)obj->data;
+    size_t new_size = (path->segment_count + 1) * sizeof(Kitty_PathSegment);
+    Kitty_PathSegment* new_segments = (Kitty_PathSegment*)k_Realloc(path->segments, new_size, KITTY_MEMORY_SHAPES);
+    if (!new_segments) {
+        return KITTY_MEMORY_ALLOCATION_FAILURE; // Memory allocation failed
+    }
+    path->segments = new_segments;
+    path->segments[path->segment_count] = segment;
+    path->segment_count++;
+    path->flat_dirty = true;
+    return KITTY_SUCCESS; // Success
 }
 
-float KittyM_VectorLength3(Kitty_Vertex3D v){
-    return sqrtf((v.x * v.x) + (v.y * v.y) + (v.z * v.z));
+int Kitty_PathMoveTo(Kitty_Object* obj, Kitty_Vertex2D point) {
+    return k_PathAddSegment(obj, (Kitty_PathSegment){KITTY_PATH_MOVE, {point}});
 }
 
-Kitty_Vertex3D KittyM_CrossProduct3(Kitty_Vertex3D v1, Kitty_Vertex3D v2){
-    return (Kitty_Vertex3D){
-        .x = (v1.y * v2.z) - (v1.z * v2.y),
-        .y = (v1.z * v2.x) - (v1.x * v2.z),
-        .z = (v1.x * v2.y) - (v1.y * v2.x)
-    };
+int Kitty_PathLineTo(Kitty_Object* obj, Kitty_Vertex2D point) {
+    return k_PathAddSegment(obj, (Kitty_PathSegment){KITTY_PATH_LINE, {point}});
 }
 
-Kitty_Vertex3D KittyM_Point2PointV3(Kitty_Vertex3D from, Kitty_Vertex3D to){
-    Kitty_Vertex3D result;
-    result.x = to.x - from.x;
-    result.y = to.y - from.y;
-    result.z = to.z - from.z;
-    return result;
+int Kitty_PathQuadTo(Kitty_Object* obj, Kitty_Vertex2D control, Kitty_Vertex2D point) {
+    return k_PathAddSegment(obj, (Kitty_PathSegment){KITTY_PATH_QUAD, {control, point}});
 }
 
-Kitty_Vertex3D KittyM_VectorNormalize3(Kitty_Vertex3D v){
-    float length = KittyM_VectorLength3(v);
-    if (length == 0){
-        return (Kitty_Vertex3D){0, 0, 0}; // avoid div by zero
-    }
+int Kitty_PathCubicTo(Kitty_Object* obj, Kitty_Vertex2D control1, Kitty_Vertex2D control2, Kitty_Vertex2D point) {
+    return k_PathAddSegment(obj, (Kitty_PathSegment){KITTY_PATH_CUBIC, {control1, control2, point}});
+}
+
+Kitty_Object* Kitty_CreatePlot(Kitty_Point position, int width, int height, float min_value, float max_value, size_t window) {
+    if (width <= 0 || height <= 0 || window == 0 || max_value <= min_value) {
+        return NULL; // Invalid dimensions or value range
+    }
+    Kitty_Object* obj = (Kitty_Object*)malloc(sizeof(Kitty_Object));
+    if (!obj) {
+        return NULL; // Memory allocation failed
+    }
+    obj->type = KITTY_OBJECT_PLOT;
+    obj->priority = KITTY_PRIORITY_NORMAL;
+    obj->id = 0;
+    obj->data = malloc(sizeof(Kitty_ObjPlot));
+    if (!obj->data) {
+        free(obj);
+        return NULL; // Memory allocation failed
+    }
+    Kitty_ObjPlot* plot_data = (Kitty_ObjPlot*)obj->data;
+    plot_data->position = position;
+    plot_data->width = width;
+    plot_data->height = height;
+    plot_data->min_value = min_value;
+    plot_data->max_value = max_value;
+    plot_data->window = window;
+    plot_data->series = NULL;
+    plot_data->series_count = 0;
+    plot_data->columns_width = 0;
+    plot_data->columns_window = 0;
+    plot_data->line_points = NULL;
+    return obj;
+}
+
+int Kitty_AddPlotSeries(Kitty_Object* obj, size_t capacity, Kitty_Color color) {
+    if (!obj || obj->type != KITTY_OBJECT_PLOT) {
+        return KITTY_INVALID_OBJECT_INDEX; // Invalid object or not a plot
+    }
+    if (capacity == 0) {
+        return KITTY_INVALID_ARGUMENT; // Series needs room for samples
+    }
+    Kitty_ObjPlot* plot = (Kitty_ObjPlot*)obj->data;
+    Kitty_PlotSeries* new_series = (Kitty_PlotSeries*)k_Realloc(plot->series, (plot->series_count + 1) * sizeof(Kitty_PlotSeries), KITTY_MEMORY_SHAPES);
+    if (!new_series) {
+        return KITTY_MEMORY_ALLOCATION_FAILURE; // Memory allocation failed
+    }
+    plot->series = new_series;
+
+    Kitty_PlotSeries* series = &plot->series[plot->series_count];
+    series->samples = (float*)k_Alloc(capacity * sizeof(float), KITTY_MEMORY_SHAPES);
+    if (!series->samples) {
+        return KITTY_MEMORY_ALLOCATION_FAILURE; // Memory allocation failed
+    }
+    series->capacity = capacity;
+    series->total = 0;
+    series->folded = 0;
+    series->fold_dirty = true;
+    series->column_min = NULL;
+    series->column_max = NULL;
+    series->color = color;
+    plot->series_count++;
+    plot->columns_width = 0; // new series needs its column cache
+    return KITTY_SUCCESS; // Success
+}
+
+int Kitty_PlotAppend(Kitty_Object* obj, size_t series, float value) {
+    if (!obj || obj->type != KITTY_OBJECT_PLOT) {
+        return KITTY_INVALID_OBJECT_INDEX; // Invalid object or not a plot
+    }
+    Kitty_ObjPlot* plot = (Kitty_ObjPlot*)obj->data;
+    if (series >= plot->series_count) {
+        return KITTY_INVALID_ARGUMENT; // No such series
+    }
+    Kitty_PlotSeries* s = &plot->series[series];
+    s->samples[s->total % s->capacity] = value;
+    s->total++;
+    return KITTY_SUCCESS; // Success
+}
+
+Kitty_Object* Kitty_CreatePointCloud(const Kitty_Vertex3D* positions, const Kitty_Color* colors, size_t count, bool quantize) {
+    if (!positions || count == 0) {
+        return NULL; // Nothing to show
+    }
+    Kitty_Object* obj = (Kitty_Object*)malloc(sizeof(Kitty_Object));
+    if (!obj) {
+        return NULL; // Memory allocation failed
+    }
+    obj->type = KITTY_OBJECT_POINT_CLOUD;
+    obj->priority = KITTY_PRIORITY_NORMAL;
+    obj->id = 0;
+    obj->data = calloc(1, sizeof(Kitty_ObjPointCloud));
+    if (!obj->data) {
+        free(obj);
+        return NULL; // Memory allocation failed
+    }
+    Kitty_ObjPointCloud* cloud_data = (Kitty_ObjPointCloud*)obj->data;
+    cloud_data->position = (Kitty_Point3D){0, 0, 0};
+    cloud_data->scale = 1.0f;
+    cloud_data->splat_size = 2;
+    cloud_data->lod_bias = 1.0f;
+    cloud_data->point_count = count;
+    cloud_data->quantized = quantize;
+    if (k_BuildPointCloud(cloud_data, positions, colors) != KITTY_SUCCESS) {
+        k_FreeObjectData(obj);
+        free(obj);
+        return NULL; // Memory allocation failed
+    }
+    return obj;
+}
+
+Kitty_Object* Kitty_CreateTerrain(const Uint16* heights, int width, int depth, const Kitty_TerrainSettings* settings) {
+    if (!heights || !settings || width < 2 || depth < 2) {
+        return NULL; // Needs at least one quad
+    }
+    Kitty_Object* obj = (Kitty_Object*)malloc(sizeof(Kitty_Object));
+    if (!obj) {
+        return NULL; // Memory allocation failed
+    }
+    obj->type = KITTY_OBJECT_TERRAIN;
+    obj->priority = KITTY_PRIORITY_NORMAL;
+    obj->id = 0;
+    obj->data = calloc(1, sizeof(Kitty_ObjTerrain));
+    if (!obj->data) {
+        free(obj);
+        return NULL; // Memory allocation failed
+    }
+    Kitty_ObjTerrain* terrain_data = (Kitty_ObjTerrain*)obj->data;
+    terrain_data->position = (Kitty_Point3D){0, 0, 0};
+    terrain_data->scale = 1.0f;
+    terrain_data->settings = *settings;
+    terrain_data->width = width;
+    terrain_data->depth = depth;
+    size_t sample_count = (size_t)width * (size_t)depth;
+    terrain_data->heights = (Uint16*)k_Alloc(sample_count * sizeof(Uint16), KITTY_MEMORY_MESHES);
+    if (terrain_data->heights) {
+        memcpy(terrain_data->heights, heights, sample_count * sizeof(Uint16));
+    }
+    if (!terrain_data->heights || k_BuildTerrain(terrain_data) != KITTY_SUCCESS) {
+        k_FreeObjectData(obj);
+        free(obj);
+        return NULL; // Memory allocation failed or bad settings
+    }
+    return obj;
+}
+
+Kitty_Object* Kitty_LoadTerrain(const char* file_path, const Kitty_TerrainSettings* settings) {
+    if (!file_path) {
+        return NULL;
+    }
+    Uint16* heights = NULL;
+    int width = 0, depth = 0;
+    const char* extension = strrchr(file_path, '.');
+    if (extension && (SDL_strcasecmp(extension, ".r16") == 0 || SDL_strcasecmp(extension, ".raw") == 0)) {
+        FILE* file = fopen(file_path, "rb");
+        if (!file) {
+            return NULL; // File not found
+        }
+        long size = fseek(file, 0, SEEK_END) == 0 ? ftell(file) : -1;
+        width = depth = size > 0 ? (int)lround(sqrt((double)(size / 2))) : 0;
+        if (width < 2 || (long)width * width * 2 != size || fseek(file, 0, SEEK_SET) != 0 ||
+            !(heights = (Uint16*)k_Alloc((size_t)size, KITTY_MEMORY_MESHES)) || fread(heights, 1, (size_t)size, file) != (size_t)size) {
+            k_Free(heights);
+            fclose(file);
+            return NULL; // Not a square grid of 16 bit samples
+        }
+        fclose(file);
+        for (size_t i = 0; i < (size_t)width * (size_t)depth; i++) {
+            heights[i] = SDL_SwapLE16(heights[i]);
+        }
+    } else {
+        int bits_per_pixel = 0;
+        SDL_Surface* rgba = k_LoadSurface(file_path, KITTY_MEMORY_MESHES, &bits_per_pixel);
+        if (!rgba) {
+            return NULL; // Image loading failed
+        }
+        bool gray = bits_per_pixel == 8;
+        width = rgba->w;
+        depth = rgba->h;
+        heights = (Uint16*)k_Alloc((size_t)width * (size_t)depth * sizeof(Uint16), KITTY_MEMORY_MESHES);
+        if (!heights) {
+            k_FreeSurface(rgba);
+            return NULL; // Memory allocation failed
+        }
+        for (int y = 0; y < depth; y++) {
+            const Uint8* row = (const Uint8*)rgba->pixels + (size_t)y * rgba->pitch;
+            for (int x = 0; x < width; x++) {
+                const Uint8* texel = row + x * 4;
+                heights[(size_t)y * width + x] = gray ? (Uint16)(texel[0] * 257) : (Uint16)((texel[0] << 8) | texel[1]);
+            }
+        }
+        k_FreeSurface(rgba);
+    }
+    Kitty_Object* terrain = Kitty_CreateTerrain(heights, width, depth, settings);
+    k_Free(heights);
+    return terrain;
+}
+
+int Kitty_Transform(Kitty_Object* obj, Kitty_Point3D translation, Kitty_Vertex3D rotation) {
+    if (!obj) {
+        return KITTY_INVALID_OBJECT_INDEX; // Invalid object
+    }
+    if (obj->type != KITTY_OBJECT_MESH) {
+        return KITTY_INVALID_OBJECT_INDEX; // Invalid object type
+    }
+    Kitty_ObjMesh* mesh = (Kitty_ObjMesh*)obj->data;
+
+    // Apply translation
+    mesh->position.x += translation.x;
+    mesh->position.y += translation.y;
+    mesh->position.z += translation.z;
+
+    //apply rotation around origin
+    for (size_t i = 0; i < mesh->vertex_count; i++){
+        Kitty_Vertex3D v = mesh->vertices[i];
+
+        // Translate vertex to origin
+        v.x -= mesh->origin.x;
+        v.y -= mesh->origin.y;
+        v.z -= mesh->origin.z;
+
+        // Rotate around X axis
+        v = KittyM_RotateVertex3D_X(v, rotation.x);
+        // Rotate around Y axis
+        v = KittyM_RotateVertex3D_Y(v, rotation.y);
+        // Rotate around Z axis
+        v = KittyM_RotateVertex3D_Z(v, rotation.z);
+
+        // Translate vertex back
+        v.x += mesh->origin.x;
+        v.y += mesh->origin.y;
+        v.z += mesh->origin.z;
+
+        mesh->vertices[i] = v;
+    }
+
+    // the vertex stages read the base vertices, so their output is stale now
+    if (mesh->morph) {
+        mesh->morph->needs_reset = true;
+    }
+    if (mesh->skin) {
+        mesh->skin->dirty = true;
+    }
+    if (mesh->impostor) {
+        mesh->impostor->stale = true;
+    }
+
+    return KITTY_SUCCESS; // Success
+}
+
+Kitty_Skeleton* Kitty_CreateSkeleton(size_t joint_count, const int* parents, const Kitty_Matrix4* inverse_bind) {
+    if (joint_count == 0 || joint_count > 256 || !parents || !inverse_bind) {
+        return NULL; // Joint indices are stored in 8 bits
+    }
+    for (size_t j = 0; j < joint_count; j++) {
+        if (parents[j] >= (int)j) {
+            return NULL; // Parents must come before their children
+        }
+    }
+    Kitty_Skeleton* skeleton = (Kitty_Skeleton*)k_Alloc(sizeof(Kitty_Skeleton), KITTY_MEMORY_MESHES);
+    if (!skeleton) {
+        return NULL; // Memory allocation failed
+    }
+    skeleton->joint_count = joint_count;
+    skeleton->parents = (int*)k_Alloc(joint_count * sizeof(int), KITTY_MEMORY_MESHES);
+    skeleton->inverse_bind = (Kitty_Matrix4*)k_Alloc(joint_count * sizeof(Kitty_Matrix4), KITTY_MEMORY_MESHES);
+    if (!skeleton->parents || !skeleton->inverse_bind) {
+        Kitty_FreeSkeleton(skeleton);
+        return NULL; // Memory allocation failed
+    }
+    memcpy(skeleton->parents, parents, joint_count * sizeof(int));
+    memcpy(skeleton->inverse_bind, inverse_bind, joint_count * sizeof(Kitty_Matrix4));
+    return skeleton;
+}
+
+void Kitty_FreeSkeleton(Kitty_Skeleton* skeleton) {
+    if (!skeleton) {
+        return;
+    }
+    k_Free(skeleton->parents);
+    k_Free(skeleton->inverse_bind);
+    k_Free(skeleton);
+}
+
+Kitty_AnimationClip* Kitty_CreateAnimationClip(size_t joint_count, float duration) {
+    Kitty_AnimationClip* clip = (Kitty_AnimationClip*)k_Alloc(sizeof(Kitty_AnimationClip), KITTY_MEMORY_MESHES);
+    if (!clip) {
+        return NULL; // Memory allocation failed
+    }
+    clip->duration = duration;
+    clip->joint_count = joint_count;
+    clip->tracks = (Kitty_JointTrack*)k_Calloc(joint_count, sizeof(Kitty_JointTrack), KITTY_MEMORY_MESHES);
+    if (!clip->tracks) {
+        k_Free(clip);
+        return NULL; // Memory allocation failed
+    }
+    return clip;
+}
+
+void Kitty_FreeAnimationClip(Kitty_AnimationClip* clip) {
+    if (!clip) {
+        return;
+    }
+    for (size_t j = 0; j < clip->joint_count; j++) {
+        k_Free(clip->tracks[j].keys);
+    }
+    k_Free(clip->tracks);
+    k_Free(clip);
+}
+
+int Kitty_AddJointKeyframe(Kitty_AnimationClip* clip, size_t joint, Kitty_JointKeyframe key) {
+    if (!clip || joint >= clip->joint_count) {
+        return KITTY_INVALID_ARGUMENT; // No such joint
+    }
+    Kitty_JointTrack* track = &clip->tracks[joint];
+    if (track->key_count > 0 && key.time < track->keys[track->key_count - 1].time) {
+        return KITTY_INVALID_ARGUMENT; // Keyframes must be in time order
+    }
+    size_t new_size = (track->key_count + 1) * sizeof(Kitty_JointKeyframe);
+    Kitty_JointKeyframe* new_keys = (Kitty_JointKeyframe*)k_Realloc(track->keys, new_size, KITTY_MEMORY_MESHES);
+    if (!new_keys) {
+        return KITTY_MEMORY_ALLOCATION_FAILURE; // Memory allocation failed
+    }
+    track->keys = new_keys;
+    track->keys[track->key_count] = key;
+    track->key_count++;
+    return KITTY_SUCCESS; // Success
+}
+
+int Kitty_SetMeshSkin(Kitty_Object* obj, Kitty_Skeleton* skeleton, const Kitty_JointWeights* weights) {
+    if (!obj || obj->type != KITTY_OBJECT_MESH) {
+        return KITTY_INVALID_OBJECT_INDEX; // Invalid object or not a mesh
+    }
+    Kitty_ObjMesh* mesh = (Kitty_ObjMesh*)obj->data;
+    if (!skeleton && !weights) {
+        k_FreeSkin(mesh->skin); // unbind
+        mesh->skin = NULL;
+        return KITTY_SUCCESS;
+    }
+    if (!skeleton || !weights || mesh->vertex_count == 0) {
+        return KITTY_INVALID_ARGUMENT; // Nothing to skin
+    }
+    for (size_t v = 0; v < mesh->vertex_count; v++) {
+        for (int k = 0; k < 4; k++) {
+            if (weights[v].weights[k] != 0.0f && weights[v].joints[k] >= skeleton->joint_count) {
+                return KITTY_INVALID_ARGUMENT; // Weight references a missing joint
+            }
+        }
+    }
+
+    k_FreeSkin(mesh->skin);
+    Kitty_Skin* skin = (Kitty_Skin*)k_Alloc(sizeof(Kitty_Skin), KITTY_MEMORY_MESHES);
+    if (!skin) {
+        mesh->skin = NULL;
+        return KITTY_MEMORY_ALLOCATION_FAILURE; // Memory allocation failed
+    }
+    skin->skeleton = skeleton;
+    skin->slot_weights = (float*)k_Alloc(4 * mesh->vertex_count * sizeof(float), KITTY_MEMORY_MESHES);
+    skin->slot_joints = (Uint32*)k_Alloc(4 * mesh->vertex_count * sizeof(Uint32), KITTY_MEMORY_MESHES);
+    skin->skin_matrices = (Kitty_Matrix4*)k_Alloc(skeleton->joint_count * sizeof(Kitty_Matrix4), KITTY_MEMORY_MESHES);
+    skin->skinned_vertices = (Kitty_Vertex3D*)k_Alloc(mesh->vertex_count * sizeof(Kitty_Vertex3D), KITTY_MEMORY_MESHES);
+    mesh->skin = skin;
+    if (!skin->slot_weights || !skin->slot_joints || !skin->skin_matrices || !skin->skinned_vertices) {
+        k_FreeSkin(skin);
+        mesh->skin = NULL;
+        return KITTY_MEMORY_ALLOCATION_FAILURE; // Memory allocation failed
+    }
+    // unused slots point at joint 0, so SIMD lanes can always fetch a matrix and multiply it by zero
+    for (size_t v = 0; v < mesh->vertex_count; v++) {
+        for (int k = 0; k < 4; k++) {
+            skin->slot_weights[k * mesh->vertex_count + v] = weights[v].weights[k];
+            skin->slot_joints[k * mesh->vertex_count + v] = weights[v].weights[k] != 0.0f ? weights[v].joints[k] : 0;
+        }
+    }
+    skin->vertex_count = mesh->vertex_count;
+    for (size_t j = 0; j < skeleton->joint_count; j++) {
+        skin->skin_matrices[j] = KittyM_MatrixIdentity(); // bind pose
+    }
+    skin->dirty = true;
+    return KITTY_SUCCESS; // Success
+}
+
+int Kitty_PoseMesh(Kitty_Object* obj, const Kitty_AnimationClip* clip, float time, bool loop) {
+    if (!obj || obj->type != KITTY_OBJECT_MESH) {
+        return KITTY_INVALID_OBJECT_INDEX; // Invalid object or not a mesh
+    }
+    Kitty_ObjMesh* mesh = (Kitty_ObjMesh*)obj->data;
+    if (!mesh->skin || !clip || clip->joint_count != mesh->skin->skeleton->joint_count) {
+        return KITTY_INVALID_ARGUMENT; // Clip does not fit the skeleton
+    }
+    if (loop && clip->duration > 0.0f) {
+        time = fmodf(time, clip->duration);
+        if (time < 0.0f) time += clip->duration;
+    }
+
+    Kitty_Skeleton* skeleton = mesh->skin->skeleton;
+    Kitty_Matrix4 world[256];
+    for (size_t j = 0; j < skeleton->joint_count; j++) {
+        Kitty_Matrix4 local = k_SampleJointTrack(&clip->tracks[j], time);
+        int parent = skeleton->parents[j];
+        world[j] = parent < 0 ? local : KittyM_MatrixMultiply(world[parent], local);
+        mesh->skin->skin_matrices[j] = KittyM_MatrixMultiply(world[j], skeleton->inverse_bind[j]);
+    }
+    mesh->skin->dirty = true;
+    return KITTY_SUCCESS; // Success
+}
+
+int Kitty_SetMeshImpostor(Kitty_Object* obj, float threshold) {
+    if (!obj || obj->type != KITTY_OBJECT_MESH) {
+        return KITTY_INVALID_OBJECT_INDEX; // Invalid object or not a mesh
+    }
+    Kitty_ObjMesh* mesh = (Kitty_ObjMesh*)obj->data;
+    if (threshold <= 0.0f) {
+        k_FreeImpostor(mesh->impostor);
+        mesh->impostor = NULL;
+        return KITTY_SUCCESS; // Impostor turned off
+    }
+    if (!mesh->impostor) {
+        mesh->impostor = (Kitty_Impostor*)k_Alloc(sizeof(Kitty_Impostor), KITTY_MEMORY_MESHES);
+        if (!mesh->impostor) {
+            return KITTY_MEMORY_ALLOCATION_FAILURE; // Memory allocation failed
+        }
+        mesh->impostor->cell = -1;
+        mesh->impostor->view_bucket = -1;
+        mesh->impostor->stale = true;
+        mesh->impostor->snapshot_scale = 0.0f;
+        mesh->impostor->active = false;
+        mesh->impostor->refresh_count = 0;
+    }
+    mesh->impostor->threshold = threshold;
+    return KITTY_SUCCESS; // Success
+}
+
+int Kitty_AddMorphTarget(Kitty_Object* obj, const Uint32* indices, const Kitty_Vertex3D* deltas, size_t count) {
+    if (!obj || obj->type != KITTY_OBJECT_MESH) {
+        return KITTY_INVALID_OBJECT_INDEX; // Invalid object or not a mesh
+    }
+    Kitty_ObjMesh* mesh = (Kitty_ObjMesh*)obj->data;
+    if (count > 0 && (!indices || !deltas)) {
+        return KITTY_INVALID_ARGUMENT; // Missing data
+    }
+    for (size_t k = 0; k < count; k++) {
+        if (indices[k] >= mesh->vertex_count) {
+            return KITTY_INVALID_ARGUMENT; // Delta for a vertex the mesh does not have
+        }
+    }
+
+    if (!mesh->morph) {
+        mesh->morph = (Kitty_Morph*)k_Calloc(1, sizeof(Kitty_Morph), KITTY_MEMORY_MESHES);
+        if (!mesh->morph) {
+            return KITTY_MEMORY_ALLOCATION_FAILURE; // Memory allocation failed
+        }
+        mesh->morph->needs_reset = true;
+    }
+    Kitty_Morph* morph = mesh->morph;
+    size_t new_size = (morph->target_count + 1) * sizeof(Kitty_MorphTarget);
+    Kitty_MorphTarget* new_targets = (Kitty_MorphTarget*)k_Realloc(morph->targets, new_size, KITTY_MEMORY_MESHES);
+    if (!new_targets) {
+        return KITTY_MEMORY_ALLOCATION_FAILURE; // Memory allocation failed
+    }
+    morph->targets = new_targets;
+
+    Kitty_MorphTarget target = {NULL, NULL, count, 0.0f, 0.0f};
+    if (count > 0) {
+        target.indices = (Uint32*)k_Alloc(count * sizeof(Uint32), KITTY_MEMORY_MESHES);
+        target.deltas = (Kitty_Vertex3D*)k_Alloc(count * sizeof(Kitty_Vertex3D), KITTY_MEMORY_MESHES);
+        if (!target.indices || !target.deltas) {
+            k_Free(target.indices);
+            k_Free(target.deltas);
+            return KITTY_MEMORY_ALLOCATION_FAILURE; // Memory allocation failed
+        }
+        memcpy(target.indices, indices, count * sizeof(Uint32));
+        memcpy(target.deltas, deltas, count * sizeof(Kitty_Vertex3D));
+    }
+    morph->targets[morph->target_count] = target;
+    morph->target_count++;
+    morph->dirty = true;
+    return KITTY_SUCCESS; // Success
+}
+
+int Kitty_SetMorphWeight(Kitty_Object* obj, size_t target, float weight) {
+    if (!obj || obj->type != KITTY_OBJECT_MESH) {
+        return KITTY_INVALID_OBJECT_INDEX; // Invalid object or not a mesh
+    }
+    Kitty_Morph* morph = ((Kitty_ObjMesh*)obj->data)->morph;
+    if (!morph || target >= morph->target_count) {
+        return KITTY_INVALID_ARGUMENT; // No such target
+    }
+    if (morph->targets[target].weight != weight) {
+        morph->targets[target].weight = weight;
+        morph->dirty = true;
+    }
+    return KITTY_SUCCESS; // Success
+}
+
+int Kitty_SetMorphKeyframe(Kitty_Object* obj, size_t first_target, size_t target_count, float frame) {
+    if (!obj || obj->type != KITTY_OBJECT_MESH) {
+        return KITTY_INVALID_OBJECT_INDEX; // Invalid object or not a mesh
+    }
+    Kitty_Morph* morph = ((Kitty_ObjMesh*)obj->data)->morph;
+    if (!morph || target_count == 0 || first_target + target_count > morph->target_count) {
+        return KITTY_INVALID_ARGUMENT; // No such targets
+    }
+    float last = (float)(target_count - 1);
+    frame = frame < 0.0f ? 0.0f : (frame > last ? last : frame);
+    size_t key = (size_t)frame;
+    float t = frame - (float)key;
+    for (size_t k = 0; k < target_count; k++) {
+        float weight = k == key ? 1.0f - t : (k == key + 1 ? t : 0.0f);
+        Kitty_SetMorphWeight(obj, first_target + k, weight);
+    }
+    return KITTY_SUCCESS; // Success
+}
+
+Kitty_Matrix4 KittyM_MatrixIdentity(){
+    return (Kitty_Matrix4){{1, 0, 0, 0,  0, 1, 0, 0,  0, 0, 1, 0,  0, 0, 0, 1}};
+}
+
+Kitty_Matrix4 KittyM_MatrixMultiply(Kitty_Matrix4 a, Kitty_Matrix4 b){
+    Kitty_Matrix4 r;
+    for (int c = 0; c < 4; c++){
+        for (int row = 0; row < 4; row++){
+            r.m[c * 4 + row] = a.m[0 * 4 + row] * b.m[c * 4 + 0]
+                             + a.m[1 * 4 + row] * b.m[c * 4 + 1]
+                             + a.m[2 * 4 + row] * b.m[c * 4 + 2]
+                             + a.m[3 * 4 + row] * b.m[c * 4 + 3];
+        }
+    }
+    return r;
+}
+
+Kitty_Matrix4 KittyM_MatrixCompose(Kitty_Vertex3D translation, Kitty_Quaternion q, Kitty_Vertex3D scale){
+    float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+    float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+    float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+    return (Kitty_Matrix4){{
+        (1 - 2 * (yy + zz)) * scale.x, (2 * (xy + wz)) * scale.x,     (2 * (xz - wy)) * scale.x,     0,
+        (2 * (xy - wz)) * scale.y,     (1 - 2 * (xx + zz)) * scale.y, (2 * (yz + wx)) * scale.y,     0,
+        (2 * (xz + wy)) * scale.z,     (2 * (yz - wx)) * scale.z,     (1 - 2 * (xx + yy)) * scale.z, 0,
+        translation.x,                 translation.y,                 translation.z,                 1
+    }};
+}
+
+Kitty_Quaternion KittyM_QuaternionAxisAngle(Kitty_Vertex3D axis, float angle){
+    angle = angle * (M_PI / 180.0f); // convert to radians
+
+    axis = KittyM_VectorNormalize3(axis);
+    float s = sinf(angle * 0.5f);
+    return (Kitty_Quaternion){axis.x * s, axis.y * s, axis.z * s, cosf(angle * 0.5f)};
+}
+
+Kitty_Quaternion KittyM_QuaternionNlerp(Kitty_Quaternion a, Kitty_Quaternion b, float t){
+    // take the short way around
+    float dot = a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+    float sign = dot < 0.0f ? -1.0f : 1.0f;
+    Kitty_Quaternion r = {
+        a.x + (b.x * sign - a.x) * t,
+        a.y + (b.y * sign - a.y) * t,
+        a.z + (b.z * sign - a.z) * t,
+        a.w + (b.w * sign - a.w) * t
+    };
+    float length = sqrtf(r.x * r.x + r.y * r.y + r.z * r.z + r.w * r.w);
+    if (length == 0){
+        return (Kitty_Quaternion){0, 0, 0, 1}; // avoid div by zero
+    }
+    return (Kitty_Quaternion){r.x / length, r.y / length, r.z / length, r.w / length};
+}
+
+Kitty_Vertex3D KittyM_CalculateMeshCenter(Kitty_ObjMesh* mesh){
+    Kitty_Vertex3D center = {0, 0, 0};
+    for (size_t i = 0; i < mesh->vertex_count; i++){
+        center.x += mesh->vertices[i].x;
+        center.y += mesh->vertices[i].y;
+        center.z += mesh->vertices[i].z;
+    }
+    center.x /= mesh->vertex_count;
+    center.y /= mesh->vertex_count;
+    center.z /= mesh->vertex_count;
+    return center;
+}
+
+float KittyM_DotProduct3(Kitty_Vertex3D v1, Kitty_Vertex3D v2){
+    return (v1.x * v2.x) + (v1.y * v2.y) + (v1.z * v2.z);
+}
+
+float KittyM_VectorLength3(Kitty_Vertex3D v){
+    return sqrtf((v.x * v.x) + (v.y * v.y) + (v.z * v.z));
+}
+
+Kitty_Vertex3D KittyM_CrossProduct3(Kitty_Vertex3D v1, Kitty_Vertex3D v2){
+    return (Kitty_Vertex3D){
+        .x = (v1.y * v2.z) - (v1.z * v2.y),
+        .y = (v1.z * v2.x) - (v1.x * v2.z),
+        .z = (v1.x * v2.y) - (v1.y * v2.x)
+    };
+}
+
+Kitty_Vertex3D KittyM_Point2PointV3(Kitty_Vertex3D from, Kitty_Vertex3D to){
+    Kitty_Vertex3D result;
+    result.x = to.x - from.x;
+    result.y = to.y - from.y;
+    result.z = to.z - from.z;
+    return result;
+}
+
+Kitty_Vertex3D KittyM_VectorNormalize3(Kitty_Vertex3D v){
+    float length = KittyM_VectorLength3(v);
+    if (length == 0){
+        return (Kitty_Vertex3D){0, 0, 0}; // avoid div by zero
+    }
     return (Kitty_Vertex3D){
         .x = v.x / length,
         .y = v.y / length,
@@ -1038,107 +2559,6602 @@ Kitty_Vertex3D KittyM_VectorNormalize3(Kitty_Vertex3D v){
     };
 }
 
-Kitty_Vertex3D KittyM_RotateVertex3D_X(Kitty_Vertex3D v, float angle){
-        angle = angle * (M_PI / 180.0f); // convert to radians
-
-    float cosA = cosf(angle);
-    float sinA = sinf(angle);
-    return (Kitty_Vertex3D){
-        .x = v.x,
-        .y = v.y * cosA - v.z * sinA,
-        .z = v.y * sinA + v.z * cosA
-    };
+Kitty_Vertex3D KittyM_RotateVertex3D_X(Kitty_Vertex3D v, float angle){
+        angle = angle * (M_PI / 180.0f); // convert to radians
+
+    float cosA = cosf(angle);
+    float sinA = sinf(angle);
+    return (Kitty_Vertex3D){
+        .x = v.x,
+        .y = v.y * cosA - v.z * sinA,
+        .z = v.y * sinA + v.z * cosA
+    };
+}
+
+Kitty_Vertex3D KittyM_RotateVertex3D_Y(Kitty_Vertex3D v, float angle){
+    angle = angle * (M_PI / 180.0f); // convert to radians
+
+    float cosA = cosf(angle);
+    float sinA = sinf(angle);
+    return (Kitty_Vertex3D){
+        .x = v.x * cosA + v.z * sinA,
+        .y = v.y,
+        .z = -v.x * sinA + v.z * cosA
+    };
+}
+
+Kitty_Vertex3D KittyM_RotateVertex3D_Z(Kitty_Vertex3D v, float angle){
+    angle = angle * (M_PI / 180.0f); // convert to radians
+
+
+    float cosA = cosf(angle);
+    float sinA = sinf(angle);
+    return (Kitty_Vertex3D){
+        .x = v.x * cosA - v.y * sinA,
+        .y = v.x * sinA + v.y * cosA,
+        .z = v.z
+    };
+}
+
+
+int KittyD_DrawMeshUVMap(Kitty_Point position, int scale, Kitty_ObjMesh* mesh){
+    if (!sdl_renderer){
+        return KITTY_SDL_RENDERER_NOT_INITIALIZED; // SDL renderer not initialized
+    }
+
+    int tex_width, tex_height;
+    k_TextureExtent(mesh->texture, &tex_width, &tex_height);
+
+    // create wireframe of mesh, each vertex offset by position
+    for (size_t f = 0; f < mesh->face_count; f++){
+        Kitty_Face face = mesh->faces[f];
+        Kitty_UV uv1 = mesh->uvs[face.uv_a];
+        Kitty_UV uv2 = mesh->uvs[face.uv_b];
+        Kitty_UV uv3 = mesh->uvs[face.uv_c];
+
+        int uv1x = position.x + (int)(uv1.u * tex_width) * scale;
+        int uv1y = position.y + (int)(uv1.v * tex_height) * scale;
+        int uv2x = position.x + (int)(uv2.u * tex_width) * scale;
+        int uv2y = position.y + (int)(uv2.v * tex_height) * scale;
+        int uv3x = position.x + (int)(uv3.u * tex_width) * scale;
+        int uv3y = position.y + (int)(uv3.v * tex_height) * scale;
+
+        //set red color
+        k_SetDrawColor(255, 0, 0, 255);
+        k_DrawLine(uv1x, uv1y, uv2x, uv2y);
+        k_DrawLine(uv2x, uv2y, uv3x, uv3y);
+        k_DrawLine(uv3x, uv3y, uv1x, uv1y);
+    }
+
+    return KITTY_SUCCESS;
+}
+
+int KittyD_DrawTexture(Kitty_Point position, int scale, Kitty_Texture* texture){
+    if (!sdl_renderer){
+        return KITTY_SDL_RENDERER_NOT_INITIALIZED; // SDL renderer not initialized
+    }
+
+    int tex_width, tex_height;
+    k_TextureExtent(texture, &tex_width, &tex_height);
+    for (int y = 0; y < tex_height; y++){
+        for (int x = 0; x < tex_width; x++){
+            //enlarge 4x
+            Kitty_Color color = Kitty_SampleTexture(texture, x, y);
+            for (int py = 0; py < scale; py++){
+                for (int px = 0; px < scale; px++){
+                    k_SetDrawColor(color.r, color.g, color.b, 255);
+                    k_DrawPoint(position.x + x * scale + px, position.y + y * scale + py);
+                }
+            }
+        }
+    }
+
+    return KITTY_SUCCESS; // Success
+}
+
+// MESH STUFF
+
+static int k_RenderMesh(Kitty_ObjMesh* m_obj, Kitty_Point3D position, float scale, bool textured){
+    //turn mesh into triangles (wireframe for now)
+
+    const Kitty_Vertex3D* mesh_vertices = k_MeshVertices(m_obj);
+    if (m_obj->face_count == 0){
+        return KITTY_SUCCESS;
+    }
+
+    //sort faces by depth bubble sort
+    for (size_t j = 0; j < m_obj->face_count - 1; j++){
+        for (size_t k = 0; k < m_obj->face_count - j - 1; k++){
+            Kitty_Face face1 = m_obj->faces[k];
+            Kitty_Face face2 = m_obj->faces[k + 1];
+
+            float z1 = (mesh_vertices[face1.a].z + mesh_vertices[face1.b].z + mesh_vertices[face1.c].z) / 3.0f;
+            float z2 = (mesh_vertices[face2.a].z + mesh_vertices[face2.b].z + mesh_vertices[face2.c].z) / 3.0f;
+
+            if (z1 < z2){
+                //swap
+                Kitty_Face temp_face = m_obj->faces[k];
+                Kitty_Color temp_color = m_obj->face_colors[k];
+                m_obj->faces[k] = m_obj->faces[k + 1];
+                m_obj->face_colors[k] = m_obj->face_colors[k + 1];
+                m_obj->faces[k + 1] = temp_face;
+                m_obj->face_colors[k + 1] = temp_color;
+            }
+        }
+    }
+
+    // create wireframe of mesh, each vertex offset by position
+    for (size_t f = 0; f < m_obj->face_count; f++){
+        Kitty_Face face = m_obj->faces[f];
+        Kitty_Color face_col = m_obj->face_colors[f];
+        Kitty_Vertex3D v1 = mesh_vertices[face.a];
+        Kitty_Vertex3D v2 = mesh_vertices[face.b];
+        Kitty_Vertex3D v3 = mesh_vertices[face.c];
+        Kitty_UV uv1 = m_obj->uvs[face.uv_a];
+        Kitty_UV uv2 = m_obj->uvs[face.uv_b];
+        Kitty_UV uv3 = m_obj->uvs[face.uv_c];
+
+        //ugly but we gotta copy to modify
+        float v1x = v1.x;
+        float v1y = v1.y;
+        float v1z = v1.z;
+
+        float v2x = v2.x;
+        float v2y = v2.y;
+        float v2z = v2.z;
+
+        float v3x = v3.x;
+        float v3y = v3.y;
+        float v3z = v3.z;
+
+
+        float uv1u = uv1.u;
+        float uv1v = uv1.v;
+
+        float uv2u = uv2.u;
+        float uv2v = uv2.v;
+
+        float uv3u = uv3.u;
+        float uv3v = uv3.v;
+
+        //apply perspective
+        float distance = 100.0f; // Distance from the viewer to the projection plane
+        float persp_1 = distance / (distance + v1z - position.z);
+        float persp_2 = distance / (distance + v2z - position.z);
+        float persp_3 = distance / (distance + v3z - position.z);
+
+        v1x = v1x * persp_1;
+        v1y = v1y * persp_1;
+        v2x = v2x * persp_2;
+        v2y = v2y * persp_2;
+        v3x = v3x * persp_3;
+        v3y = v3y * persp_3;
+
+        uv1u = uv1u * persp_1;
+        uv1v = uv1v * persp_1;
+        uv2u = uv2u * persp_2;
+        uv2v = uv2v * persp_2;
+        uv3u = uv3u * persp_3;
+        uv3v = uv3v * persp_3;
+
+        //calculate face normals
+        Kitty_Vertex3D edge1 = KittyM_Point2PointV3(v2, v1);
+        Kitty_Vertex3D edge2 = KittyM_Point2PointV3(v3, v1);
+        Kitty_Vertex3D face_normal = KittyM_CrossProduct3(edge1, edge2);
+        face_normal = KittyM_VectorNormalize3(face_normal);
+
+        //backface culling
+        Kitty_Vertex3D view_vector = KittyM_Point2PointV3(k_camera_position, (Kitty_Vertex3D){m_obj->position.x, m_obj->position.y, m_obj->position.z});
+        view_vector = KittyM_VectorNormalize3(view_vector);
+        float dot_product = KittyM_DotProduct3(face_normal, view_vector);
+        if (dot_product < 0){
+            continue; //skip face
+        }
+
+        //copied vertices
+        Kitty_Point3D* vertices[3] = {
+            &(Kitty_Point3D){position.x + (v1x * scale), position.y + (v1y * scale), position.z + (v1.z * scale)},
+            &(Kitty_Point3D){position.x + (v2x * scale), position.y + (v2y * scale), position.z + (v2.z * scale)},
+            &(Kitty_Point3D){position.x + (v3x * scale), position.y + (v3y * scale), position.z + (v3.z * scale)}
+        };
+
+        if (m_obj->wire){
+            k_SetDrawColor(face_col.r, face_col.g, face_col.b, face_col.a);
+
+            k_DrawLine(
+                            position.x + (v1x * scale),
+                            position.y + (v1y * scale),
+                            position.x + (v2x * scale),
+                            position.y + (v2y * scale));
+                
+            k_DrawLine(
+                            position.x + (v2x * scale),
+                            position.y + (v2y * scale),
+                            position.x + (v3x * scale),
+                            position.y + (v3y * scale));
+
+            k_DrawLine(
+                            position.x + (v3x * scale),
+                            position.y + (v3y * scale),
+                            position.x + (v1x * scale),
+                            position.y + (v1y * scale));
+        }
+
+
+        if (!m_obj->wire && !textured && k_aa_samples > 1){
+            int aa_result = k_FillTriangleAA(position.x + v1x * scale, position.y + v1y * scale,
+                                             position.x + v2x * scale, position.y + v2y * scale,
+                                             position.x + v3x * scale, position.y + v3y * scale, face_col);
+            if (aa_result != KITTY_SUCCESS){
+                return aa_result;
+            }
+        }
+        else if (!m_obj->wire && !textured){
+            k_SetDrawColor(face_col.r, face_col.g, face_col.b, face_col.a);
+
+            //simple scanline fill
+            int minY = (position.y + (v1y * scale)) < (position.y + (v2y * scale)) ? ((position.y + (v1y * scale)) < (position.y + (v3y * scale)) ? (position.y + (v1y * scale)) : (position.y + (v3y * scale))) : ((position.y + (v2y * scale)) < (position.y + (v3y * scale)) ? (position.y + (v2y * scale)) : (position.y + (v3y * scale)));
+            int maxY = (position.y + (v1y * scale)) > (position.y + (v2y * scale)) ? ((position.y + (v1y * scale)) > (position.y + (v3y * scale)) ? (position.y + (v1y * scale)) : (position.y + (v3y * scale))) : ((position.y + (v2y * scale)) > (position.y + (v3y * scale)) ? (position.y + (v2y * scale)) : (position.y + (v3y * scale)));
+
+            for (int y = minY; y <= maxY; y++){
+                int nodes = 0;
+                int nodeX[3];
+                for (int i = 0; i < 3; i++){
+                    Kitty_Point3D* v1p = vertices[i];
+                    Kitty_Point3D* v2p = vertices[(i + 1) % 3];
+                    if ((v1p->y < y && v2p->y >= y) || (v2p->y < y && v1p->y >= y)){
+                        nodeX[nodes++] = v1p->x + (y - v1p->y) * (v2p->x - v1p->x) / (v2p->y - v1p->y);
+                    }
+                }
+                for (int i = 0; i < nodes - 1; i += 2){
+                    if (nodeX[i] > nodeX[i + 1]){
+                        int temp = nodeX[i];
+                        nodeX[i] = nodeX[i + 1];
+                        nodeX[i + 1] = temp;
+                    }
+                    k_DrawLine(nodeX[i], y, nodeX[i + 1], y);
+                }
+            }
+        } 
+        else if (textured) {
+            int minY = (position.y + (v1y * scale)) < (position.y + (v2y * scale)) ? ((position.y + (v1y * scale)) < (position.y + (v3y * scale)) ? (position.y + (v1y * scale)) : (position.y + (v3y * scale))) : ((position.y + (v2y * scale)) < (position.y + (v3y * scale)) ? (position.y + (v2y * scale)) : (position.y + (v3y * scale)));
+            int maxY = (position.y + (v1y * scale)) > (position.y + (v2y * scale)) ? ((position.y + (v1y * scale)) > (position.y + (v3y * scale)) ? (position.y + (v1y * scale)) : (position.y + (v3y * scale))) : ((position.y + (v2y * scale)) > (position.y + (v3y * scale)) ? (position.y + (v2y * scale)) : (position.y + (v3y * scale)));
+
+            // perspective-correct setup:
+            // uv1u/v, uv2u/v, uv3u/v were pre-multiplied by persp_1/2/3 earlier
+            float U_p[3] = { uv1u, uv2u, uv3u }; // u' = u * persp
+            float V_p[3] = { uv1v, uv2v, uv3v }; // v' = v * persp
+            float W_p[3] = { persp_1, persp_2, persp_3 }; // w' = persp
+
+            // virtual textures pick one mip level per face from its texel to pixel area ratio
+            int tex_level = 0;
+            if (m_obj->virtual_texture){
+                float screen_area = fabsf((float)(vertices[1]->x - vertices[0]->x) * (float)(vertices[2]->y - vertices[0]->y) -
+                                          (float)(vertices[2]->x - vertices[0]->x) * (float)(vertices[1]->y - vertices[0]->y));
+                float texel_area = fabsf((uv2.u - uv1.u) * (uv3.v - uv1.v) - (uv3.u - uv1.u) * (uv2.v - uv1.v)) *
+                                   m_obj->virtual_texture->width * m_obj->virtual_texture->height;
+                if (screen_area > 0.0f && texel_area > screen_area){
+                    tex_level = (int)(0.5f * log2f(texel_area / screen_area));
+                }
+            }
+
+            for (int y = minY; y <= maxY; y++){
+                int nodes = 0;
+                int   nodeX[3];
+                float nodeU_p[3], nodeV_p[3], nodeW_p[3];
+
+                // find edge intersections and interpolate u', v', w' at the intersections
+                for (int i = 0; i < 3; i++){
+                    int j = (i + 1) % 3;
+                    Kitty_Point3D* v1p = vertices[i];
+                    Kitty_Point3D* v2p = vertices[j];
+                    if ((v1p->y < y && v2p->y >= y) || (v2p->y < y && v1p->y >= y)){
+                        float dy = (float)v2p->y - (float)v1p->y;
+                        if (fabsf(dy) < 1e-6f) continue; // avoid div by zero
+                        float t = ((float)y - (float)v1p->y) / dy;
+
+                        nodeX[nodes]   = (int)( (float)v1p->x + t * ((float)v2p->x - (float)v1p->x) );
+                        nodeU_p[nodes] = U_p[i] + t * (U_p[j] - U_p[i]);
+                        nodeV_p[nodes] = V_p[i] + t * (V_p[j] - V_p[i]);
+                        nodeW_p[nodes] = W_p[i] + t * (W_p[j] - W_p[i]);
+                        nodes++;
+                    }
+                }
+
+                if (nodes < 2) continue;
+
+                // ensure left->right ordering; swap accompanying attributes
+                if (nodeX[0] > nodeX[1]){
+                    int   tx = nodeX[0];    nodeX[0] = nodeX[1];    nodeX[1] = tx;
+                    float tu = nodeU_p[0];  nodeU_p[0] = nodeU_p[1]; nodeU_p[1] = tu;
+                    float tv = nodeV_p[0];  nodeV_p[0] = nodeV_p[1]; nodeV_p[1] = tv;
+                    float tw = nodeW_p[0];  nodeW_p[0] = nodeW_p[1]; nodeW_p[1] = tw;
+                }
+
+                int x0 = nodeX[0];
+                int x1 = nodeX[1];
+                if (x1 == x0) continue;
+
+                for (int x = x0; x <= x1; x++){
+                    float tx = (float)(x - x0) / (float)(x1 - x0);
+                    // interpolate u', v', w' across the scanline
+                    float u_p = nodeU_p[0] + tx * (nodeU_p[1] - nodeU_p[0]);
+                    float v_p = nodeV_p[0] + tx * (nodeV_p[1] - nodeV_p[0]);
+                    float w_p = nodeW_p[0] + tx * (nodeW_p[1] - nodeW_p[0]);
+
+                    if (fabsf(w_p) < 1e-8f) continue; // avoid div by zero
+
+                    // recover perspective-correct u, v
+                    float u = u_p / w_p;
+                    float v = v_p / w_p;
+
+                    //if v, u < 0 or > 1 wrap to other side
+                    if (u < 0) u = 1.0f + fmodf(u, 1.0f);
+                    if (v < 0) v = 1.0f + fmodf(v, 1.0f);
+                    u = fmodf(u, 1.0f);
+                    v = fmodf(v, 1.0f);
+
+
+                    if (m_obj->virtual_texture){
+                        Kitty_Color texel = Kitty_SampleVirtualTexture(m_obj->virtual_texture, u, v, tex_level);
+                        k_SetDrawColor(texel.r, texel.g, texel.b, 255);
+                        k_DrawPoint(x, y);
+                        continue;
+                    }
+
+                    int tex_width, tex_height;
+                    k_TextureExtent(m_obj->texture, &tex_width, &tex_height);
+
+                    int tex_x = (int)(u * tex_width);
+                    int tex_y = (int)(v * tex_height);
+                    if ((unsigned)tex_x >= (unsigned)tex_width || (unsigned)tex_y >= (unsigned)tex_height) continue;
+
+                    Kitty_Color texel = Kitty_SampleTexture(m_obj->texture, tex_x, tex_y);
+                    k_SetDrawColor(texel.r, texel.g, texel.b, 255);
+                    k_DrawPoint(x, y);
+                }
+            }
+        }
+    }
+
+    if (textured && m_obj->virtual_texture){
+        return Kitty_UpdateVirtualTexture(m_obj->virtual_texture);
+    }
+    return KITTY_SUCCESS;
+}
+
+// ANTI-ALIASING STUFF
+
+// a * x + b * y + c >= 0 on the inner side of a triangle edge
+typedef struct {
+    float a;
+    float b;
+    float c;
+} k_EdgeFunction;
+
+///@brief Left and right end of a triangle's cross section at height y.
+static bool k_TriangleSpanAt(const float* xs, const float* ys, float y, float* left, float* right){
+    bool found = false;
+    for (int i = 0; i < 3; i++){
+        int j = (i + 1) % 3;
+        float x;
+        if (ys[i] == ys[j]){
+            if (ys[i] != y){
+                continue;
+            }
+            x = xs[i]; // horizontal edge on the line, its other end is the next edge's start
+        } else if ((ys[i] <= y && y <= ys[j]) || (ys[j] <= y && y <= ys[i])){
+            x = xs[i] + (y - ys[i]) * (xs[j] - xs[i]) / (ys[j] - ys[i]);
+        } else {
+            continue;
+        }
+        *left = found ? SDL_min(*left, x) : x;
+        *right = found ? SDL_max(*right, x) : x;
+        found = true;
+    }
+    return found;
+}
+
+///@brief Number of the pixel's samples inside all three edges, four samples per step.
+static inline int k_PixelCoverage(const k_EdgeFunction* edges, float px, float py){
+    int covered = 0;
+#ifdef __SSE2__
+    static const Uint8 bit_count[16] = {0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
+    __m128 zero = _mm_setzero_ps();
+    for (int s = 0; s < k_aa_samples; s += 4){
+        __m128 sx = _mm_add_ps(_mm_set1_ps(px), _mm_loadu_ps(&k_aa_sample_x[s]));
+        __m128 sy = _mm_add_ps(_mm_set1_ps(py), _mm_loadu_ps(&k_aa_sample_y[s]));
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int e = 0; e < 3; e++){
+            __m128 value = _mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, _mm_set1_ps(edges[e].a)), _mm_mul_ps(sy, _mm_set1_ps(edges[e].b))),
+                                      _mm_set1_ps(edges[e].c));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(value, zero));
+        }
+        covered += bit_count[_mm_movemask_ps(inside)];
+    }
+#else
+    for (int s = 0; s < k_aa_samples; s++){
+        float sx = px + k_aa_sample_x[s];
+        float sy = py + k_aa_sample_y[s];
+        bool inside = true;
+        for (int e = 0; e < 3; e++){
+            inside = inside && edges[e].a * sx + edges[e].b * sy + edges[e].c >= 0.0f;
+        }
+        covered += inside;
+    }
+#endif
+    return covered;
+}
+
+static int k_PushCoveragePoint(int coverage, int x, int y){
+    if (k_aa_point_count[coverage] == k_aa_point_capacity[coverage]){
+        size_t new_capacity = SDL_max(k_aa_point_capacity[coverage] * 2, (size_t)256);
+        SDL_Point* new_points = (SDL_Point*)k_Realloc(k_aa_points[coverage], new_capacity * sizeof(SDL_Point), KITTY_MEMORY_FRAME);
+        if (!new_points){
+            return KITTY_MEMORY_ALLOCATION_FAILURE;
+        }
+        k_aa_points[coverage] = new_points;
+        k_aa_point_capacity[coverage] = new_capacity;
+    }
+    k_aa_points[coverage][k_aa_point_count[coverage]++] = (SDL_Point){x, y};
+    return KITTY_SUCCESS;
+}
+
+static int k_FillTriangleAA(float x0, float y0, float x1, float y1, float x2, float y2, Kitty_Color color){
+    float xs[3] = {x0, x1, x2};
+    float ys[3] = {y0, y1, y2};
+    float area = (x1 - x0) * (y2 - y0) - (y1 - y0) * (x2 - x0);
+    if (fabsf(area) < 1e-6f){
+        return KITTY_SUCCESS; // degenerate, covers no sample
+    }
+    float sign = area > 0.0f ? 1.0f : -1.0f;
+    k_EdgeFunction edges[3];
+    for (int i = 0; i < 3; i++){
+        int j = (i + 1) % 3;
+        edges[i].a = -(ys[j] - ys[i]) * sign;
+        edges[i].b = (xs[j] - xs[i]) * sign;
+        edges[i].c = ((ys[j] - ys[i]) * xs[i] - (xs[j] - xs[i]) * ys[i]) * sign;
+    }
+
+    float min_y = SDL_min(SDL_min(y0, y1), y2);
+    float max_y = SDL_max(SDL_max(y0, y1), y2);
+    int row_start = SDL_max((int)floorf(min_y), 0);
+    int row_end = SDL_min((int)ceilf(max_y), window_height);
+    size_t rows = row_end > row_start ? (size_t)(row_end - row_start) : 0;
+    if (rows > k_aa_span_capacity){
+        SDL_Rect* new_spans = (SDL_Rect*)k_Realloc(k_aa_spans, rows * sizeof(SDL_Rect), KITTY_MEMORY_FRAME);
+        if (!new_spans){
+            return KITTY_MEMORY_ALLOCATION_FAILURE;
+        }
+        k_aa_spans = new_spans;
+        k_aa_span_capacity = rows;
+    }
+    int span_count = 0;
+
+    for (int row = row_start; row < row_end; row++){
+        float top = SDL_max((float)row, min_y);
+        float bottom = SDL_min((float)(row + 1), max_y);
+        float left_top, right_top, left_bottom, right_bottom;
+        if (!k_TriangleSpanAt(xs, ys, top, &left_top, &right_top) || !k_TriangleSpanAt(xs, ys, bottom, &left_bottom, &right_bottom)){
+            continue;
+        }
+        // the cross section is convex in y, so its extremes in the row are at the row bounds or at vertices
+        float left = SDL_min(left_top, left_bottom);
+        float right = SDL_max(right_top, right_bottom);
+        for (int i = 0; i < 3; i++){
+            if (ys[i] >= top && ys[i] <= bottom){
+                left = SDL_min(left, xs[i]);
+                right = SDL_max(right, xs[i]);
+            }
+        }
+        int first = SDL_max((int)floorf(left), 0);
+        int last = SDL_min((int)ceilf(right) - 1, window_width - 1);
+
+        // pixels between the inner bounds are covered by every sample, only the rest is sampled
+        int inner_first = 0, inner_last = -1;
+        if (top == (float)row && bottom == (float)(row + 1)){
+            inner_first = SDL_max((int)ceilf(SDL_max(left_top, left_bottom)), first);
+            inner_last = SDL_min((int)floorf(SDL_min(right_top, right_bottom)) - 1, last);
+        }
+        for (int x = first; x <= last; x++){
+            if (x == inner_first && inner_first <= inner_last){
+                k_aa_spans[span_count++] = (SDL_Rect){inner_first, row, inner_last - inner_first + 1, 1};
+                x = inner_last;
+                continue;
+            }
+            int coverage = k_PixelCoverage(edges, (float)x, (float)row);
+            if (coverage > 0 && k_PushCoveragePoint(coverage, x, row) != KITTY_SUCCESS){
+                memset(k_aa_point_count, 0, sizeof(k_aa_point_count));
+                return KITTY_MEMORY_ALLOCATION_FAILURE;
+            }
+        }
+    }
+
+    // resolve: interior and fully covered pixels in the current blend mode, partial ones blended by coverage
+    k_SetDrawColor(color.r, color.g, color.b, color.a);
+    if (span_count > 0){
+        k_FillRects(k_aa_spans, span_count);
+    }
+    if (k_aa_point_count[k_aa_samples] > 0){
+        k_backend->draw_points(k_backend->user_data, k_aa_points[k_aa_samples], (int)k_aa_point_count[k_aa_samples]);
+        k_aa_point_count[k_aa_samples] = 0;
+    }
+    SDL_BlendMode previous_blend = k_blend_mode;
+    k_SetBlendMode(SDL_BLENDMODE_BLEND);
+    for (int coverage = 1; coverage < k_aa_samples; coverage++){
+        if (k_aa_point_count[coverage] == 0){
+            continue;
+        }
+        k_SetDrawColor(color.r, color.g, color.b, (Uint8)(color.a * coverage / k_aa_samples));
+        k_backend->draw_points(k_backend->user_data, k_aa_points[coverage], (int)k_aa_point_count[coverage]);
+        k_aa_point_count[coverage] = 0;
+    }
+    k_SetBlendMode(previous_blend);
+    return KITTY_SUCCESS;
+}
+
+static void k_FreeAntiAliasing(){
+    k_Free(k_aa_spans);
+    k_aa_spans = NULL;
+    k_aa_span_capacity = 0;
+    for (int i = 0; i <= 16; i++){
+        k_Free(k_aa_points[i]);
+        k_aa_points[i] = NULL;
+        k_aa_point_count[i] = 0;
+        k_aa_point_capacity[i] = 0;
+    }
+}
+
+// TEXTURE STUFF
+
+static void k_TextureExtent(const Kitty_Texture* texture, int* width, int* height){
+    if (texture->format == KITTY_TEXTURE_RGBA32){
+        *width = texture->sdl_surface ? texture->sdl_surface->w : 0;
+        *height = texture->sdl_surface ? texture->sdl_surface->h : 0;
+    } else {
+        *width = texture->width;
+        *height = texture->height;
+    }
+}
+
+static inline Kitty_Color k_Expand565(Uint16 c){
+    Uint8 r = (c >> 11) & 0x1F, g = (c >> 5) & 0x3F, b = c & 0x1F;
+    return (Kitty_Color){ (Uint8)((r << 3) | (r >> 2)), (Uint8)((g << 2) | (g >> 4)), (Uint8)((b << 3) | (b >> 2)), 255 };
+}
+
+static inline Uint16 k_Pack565(int r, int g, int b){
+    return (Uint16)(((r * 31 + 127) / 255) << 11 | ((g * 63 + 127) / 255) << 5 | ((b * 31 + 127) / 255));
+}
+
+// the four colors a BC1 block can select, index 3 is transparent black in the 3 color mode
+static void k_BC1Palette(Uint16 color0, Uint16 color1, Kitty_Color palette[4]){
+    Kitty_Color c0 = k_Expand565(color0);
+    Kitty_Color c1 = k_Expand565(color1);
+    palette[0] = c0;
+    palette[1] = c1;
+    if (color0 > color1){
+        palette[2] = (Kitty_Color){ (Uint8)((2 * c0.r + c1.r) / 3), (Uint8)((2 * c0.g + c1.g) / 3), (Uint8)((2 * c0.b + c1.b) / 3), 255 };
+        palette[3] = (Kitty_Color){ (Uint8)((c0.r + 2 * c1.r) / 3), (Uint8)((c0.g + 2 * c1.g) / 3), (Uint8)((c0.b + 2 * c1.b) / 3), 255 };
+    } else {
+        palette[2] = (Kitty_Color){ (Uint8)((c0.r + c1.r) / 2), (Uint8)((c0.g + c1.g) / 2), (Uint8)((c0.b + c1.b) / 2), 255 };
+        palette[3] = (Kitty_Color){ 0, 0, 0, 0 };
+    }
+}
+
+Kitty_Color Kitty_SampleTexture(const Kitty_Texture* texture, int x, int y){
+    switch (texture->format){
+        case KITTY_TEXTURE_INDEXED8:
+            return texture->palette[texture->indices[(size_t)y * texture->width + x]];
+        case KITTY_TEXTURE_BC1: {
+            const Kitty_BC1Block* block = &texture->blocks[(size_t)(y >> 2) * ((texture->width + 3) >> 2) + (x >> 2)];
+            int weight = (block->weights >> (2 * (((y & 3) << 2) | (x & 3)))) & 3;
+            Kitty_Color c0 = k_Expand565(block->color0);
+            if (weight == 0) return c0;
+            Kitty_Color c1 = k_Expand565(block->color1);
+            if (weight == 1) return c1;
+            if (block->color0 > block->color1){
+                if (weight == 2) return (Kitty_Color){ (Uint8)((2 * c0.r + c1.r) / 3), (Uint8)((2 * c0.g + c1.g) / 3), (Uint8)((2 * c0.b + c1.b) / 3), 255 };
+                return (Kitty_Color){ (Uint8)((c0.r + 2 * c1.r) / 3), (Uint8)((c0.g + 2 * c1.g) / 3), (Uint8)((c0.b + 2 * c1.b) / 3), 255 };
+            }
+            if (weight == 2) return (Kitty_Color){ (Uint8)((c0.r + c1.r) / 2), (Uint8)((c0.g + c1.g) / 2), (Uint8)((c0.b + c1.b) / 2), 255 };
+            return (Kitty_Color){ 0, 0, 0, 0 };
+        }
+        default: {
+            const SDL_Surface* surface = texture->sdl_surface;
+            const Uint8* texel = (const Uint8*)surface->pixels + (size_t)y * surface->pitch + (size_t)x * 4;
+            Kitty_Color color;
+            if (surface->format->format == SDL_PIXELFORMAT_RGBA32){
+                // byte order r, g, b, a on every platform, same as Kitty_Color
+                memcpy(&color, texel, sizeof(color));
+            } else {
+                Uint32 pixel;
+                memcpy(&pixel, texel, sizeof(pixel));
+                SDL_GetRGBA(pixel, surface->format, &color.r, &color.g, &color.b, &color.a);
+            }
+            return color;
+        }
+    }
+}
+
+size_t Kitty_GetTextureMemory(const Kitty_Texture* texture){
+    if (!texture){
+        return 0;
+    }
+    switch (texture->format){
+        case KITTY_TEXTURE_INDEXED8:
+            return (size_t)texture->width * texture->height + 256 * sizeof(Kitty_Color);
+        case KITTY_TEXTURE_BC1:
+            return (size_t)((texture->width + 3) / 4) * ((texture->height + 3) / 4) * sizeof(Kitty_BC1Block);
+        default:
+            return texture->sdl_surface ? (size_t)texture->sdl_surface->pitch * texture->sdl_surface->h : 0;
+    }
+}
+
+typedef struct {
+    Uint32 color;               // r, g, b, a from the high byte, so sorting groups equal colors
+    Uint32 count;
+    int box;
+} k_PaletteEntry;
+
+static int k_ComparePaletteEntries(const void* a, const void* b){
+    Uint32 ca = ((const k_PaletteEntry*)a)->color, cb = ((const k_PaletteEntry*)b)->color;
+    return (ca > cb) - (ca < cb);
+}
+
+static inline Uint32 k_ColorKey(Kitty_Color c){
+    return ((Uint32)c.r << 24) | ((Uint32)c.g << 16) | ((Uint32)c.b << 8) | c.a;
+}
+
+static inline Kitty_Color k_KeyColor(Uint32 key){
+    return (Kitty_Color){ (Uint8)(key >> 24), (Uint8)(key >> 16), (Uint8)(key >> 8), (Uint8)key };
+}
+
+// widest channel of the colors in entries[start, end)
+static void k_MeasureBox(const k_PaletteEntry* entries, size_t start, size_t end, int* spread, int* channel){
+    int lo[4] = { 255, 255, 255, 255 }, hi[4] = { 0, 0, 0, 0 };
+    for (size_t i = start; i < end; i++){
+        for (int c = 0; c < 4; c++){
+            int v = (entries[i].color >> (24 - 8 * c)) & 0xFF;
+            if (v < lo[c]) lo[c] = v;
+            if (v > hi[c]) hi[c] = v;
+        }
+    }
+    *spread = -1;
+    for (int c = 0; c < 4; c++){
+        if (hi[c] - lo[c] > *spread){
+            *spread = hi[c] - lo[c];
+            *channel = c;
+        }
+    }
+}
+
+// median cut: splits the box with the widest channel at its weighted median until there are 256 boxes,
+// entries are reordered so every box is a contiguous range; channels are counting sorted through scratch
+static int k_MedianCut(k_PaletteEntry* entries, size_t count, Kitty_Color palette[256]){
+    k_PaletteEntry* scratch = (k_PaletteEntry*)k_Alloc(count * sizeof(k_PaletteEntry), KITTY_MEMORY_TEXTURES);
+    if (!scratch){
+        return KITTY_MEMORY_ALLOCATION_FAILURE;
+    }
+    size_t start[256], end[256];
+    int spread[256], channel[256];
+    int boxes = 1;
+    start[0] = 0;
+    end[0] = count;
+    k_MeasureBox(entries, 0, count, &spread[0], &channel[0]);
+    for (;;){
+        if (boxes == 256){
+            break;
+        }
+        int box = 0;
+        for (int b = 1; b < boxes; b++){
+            if (spread[b] > spread[box]) box = b;
+        }
+        if (spread[box] <= 0){
+            break;
+        }
+
+        // counting sort the box along its widest channel
+        int shift = 24 - 8 * channel[box];
+        size_t histogram[257] = { 0 };
+        Uint64 total = 0;
+        for (size_t i = start[box]; i < end[box]; i++){
+            histogram[((entries[i].color >> shift) & 0xFF) + 1]++;
+            total += entries[i].count;
+        }
+        for (int v = 0; v < 256; v++){
+            histogram[v + 1] += histogram[v];
+        }
+        for (size_t i = start[box]; i < end[box]; i++){
+            scratch[start[box] + histogram[(entries[i].color >> shift) & 0xFF]++] = entries[i];
+        }
+        memcpy(entries + start[box], scratch + start[box], (end[box] - start[box]) * sizeof(k_PaletteEntry));
+
+        // split at the weighted median, never between equal channel values so both halves shrink
+        Uint64 seen = 0;
+        size_t split = start[box];
+        while (split < end[box] - 1 && (seen + entries[split].count) * 2 <= total){
+            seen += entries[split++].count;
+        }
+        Uint32 value = (entries[split].color >> shift) & 0xFF;
+        size_t up = split, down = split;
+        while (up > start[box] && ((entries[up - 1].color >> shift) & 0xFF) == value) up--;
+        while (down < end[box] && ((entries[down].color >> shift) & 0xFF) == value) down++;
+        split = (up > start[box] && (split - up <= down - split || down == end[box])) ? up : down;
+
+        start[boxes] = split;
+        end[boxes] = end[box];
+        end[box] = split;
+        k_MeasureBox(entries, start[box], end[box], &spread[box], &channel[box]);
+        k_MeasureBox(entries, start[boxes], end[boxes], &spread[boxes], &channel[boxes]);
+        boxes++;
+    }
+    k_Free(scratch);
+
+    for (int b = 0; b < 256; b++){
+        if (b >= boxes){
+            palette[b] = (Kitty_Color){ 0, 0, 0, 0 };
+            continue;
+        }
+        Uint64 sum[4] = { 0, 0, 0, 0 }, weight = 0;
+        for (size_t i = start[b]; i < end[b]; i++){
+            Kitty_Color c = k_KeyColor(entries[i].color);
+            sum[0] += (Uint64)c.r * entries[i].count;
+            sum[1] += (Uint64)c.g * entries[i].count;
+            sum[2] += (Uint64)c.b * entries[i].count;
+            sum[3] += (Uint64)c.a * entries[i].count;
+            weight += entries[i].count;
+            entries[i].box = b;
+        }
+        palette[b] = (Kitty_Color){ (Uint8)((sum[0] + weight / 2) / weight), (Uint8)((sum[1] + weight / 2) / weight),
+                                    (Uint8)((sum[2] + weight / 2) / weight), (Uint8)((sum[3] + weight / 2) / weight) };
+    }
+    return KITTY_SUCCESS;
+}
+
+static int k_QuantizeIndexed(const Kitty_Color* texels, int width, int height, Uint8** out_indices, Kitty_Color** out_palette){
+    size_t count = (size_t)width * height;
+    k_PaletteEntry* entries = (k_PaletteEntry*)k_Alloc(count * sizeof(k_PaletteEntry), KITTY_MEMORY_TEXTURES);
+    Uint8* indices = (Uint8*)k_Alloc(count, KITTY_MEMORY_TEXTURES);
+    Kitty_Color* palette = (Kitty_Color*)k_Calloc(256, sizeof(Kitty_Color), KITTY_MEMORY_TEXTURES);
+    if (!entries || !indices || !palette){
+        k_Free(entries);
+        k_Free(indices);
+        k_Free(palette);
+        return KITTY_MEMORY_ALLOCATION_FAILURE;
+    }
+
+    // distinct colors with their texel counts
+    for (size_t i = 0; i < count; i++){
+        entries[i] = (k_PaletteEntry){ k_ColorKey(texels[i]), 1, 0 };
+    }
+    qsort(entries, count, sizeof(k_PaletteEntry), k_ComparePaletteEntries);
+    size_t unique = 0;
+    for (size_t i = 0; i < count; i++){
+        if (unique > 0 && entries[unique - 1].color == entries[i].color){
+            entries[unique - 1].count++;
+        } else {
+            entries[unique++] = entries[i];
+        }
+    }
+
+    if (unique <= 256){
+        // few enough colors to keep them exactly
+        for (size_t i = 0; i < unique; i++){
+            palette[i] = k_KeyColor(entries[i].color);
+            entries[i].box = (int)i;
+        }
+    } else {
+        int result = k_MedianCut(entries, unique, palette);
+        if (result != KITTY_SUCCESS){
+            k_Free(entries);
+            k_Free(indices);
+            k_Free(palette);
+            return result;
+        }
+        qsort(entries, unique, sizeof(k_PaletteEntry), k_ComparePaletteEntries);
+    }
+
+    for (size_t i = 0; i < count; i++){
+        k_PaletteEntry key = { k_ColorKey(texels[i]), 0, 0 };
+        const k_PaletteEntry* entry = (const k_PaletteEntry*)bsearch(&key, entries, unique, sizeof(k_PaletteEntry), k_ComparePaletteEntries);
+        indices[i] = (Uint8)entry->box;
+    }
+    k_Free(entries);
+    *out_indices = indices;
+    *out_palette = palette;
+    return KITTY_SUCCESS;
+}
+
+static inline int k_ColorDistance(Kitty_Color a, Kitty_Color b){
+    int dr = a.r - b.r, dg = a.g - b.g, db = a.b - b.b;
+    return dr * dr + dg * dg + db * db;
+}
+
+// endpoints are the extreme texels along the principal axis of the block's colors
+static Kitty_BC1Block k_EncodeBC1Block(const Kitty_Color texels[16]){
+    bool transparent = false;
+    int opaque = 0;
+    float mean[3] = { 0, 0, 0 };
+    for (int i = 0; i < 16; i++){
+        if (texels[i].a < 128){
+            transparent = true;
+            continue;
+        }
+        mean[0] += texels[i].r;
+        mean[1] += texels[i].g;
+        mean[2] += texels[i].b;
+        opaque++;
+    }
+    if (opaque == 0){
+        return (Kitty_BC1Block){ 0, 0, 0xFFFFFFFFu };
+    }
+    for (int c = 0; c < 3; c++){
+        mean[c] /= opaque;
+    }
+
+    float cov[6] = { 0, 0, 0, 0, 0, 0 };
+    for (int i = 0; i < 16; i++){
+        if (texels[i].a < 128) continue;
+        float d[3] = { texels[i].r - mean[0], texels[i].g - mean[1], texels[i].b - mean[2] };
+        cov[0] += d[0] * d[0]; cov[1] += d[0] * d[1]; cov[2] += d[0] * d[2];
+        cov[3] += d[1] * d[1]; cov[4] += d[1] * d[2]; cov[5] += d[2] * d[2];
+    }
+    float axis[3] = { 1.0f, 1.0f, 1.0f };
+    for (int iteration = 0; iteration < 8; iteration++){
+        float next[3] = {
+            cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2],
+            cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2],
+            cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2]
+        };
+        float length = fmaxf(fabsf(next[0]), fmaxf(fabsf(next[1]), fabsf(next[2])));
+        if (length < 1e-6f) break;
+        for (int c = 0; c < 3; c++){
+            axis[c] = next[c] / length;
+        }
+    }
+
+    int lo = -1, hi = -1;
+    float lo_dot = 0, hi_dot = 0;
+    for (int i = 0; i < 16; i++){
+        if (texels[i].a < 128) continue;
+        float dot = texels[i].r * axis[0] + texels[i].g * axis[1] + texels[i].b * axis[2];
+        if (lo < 0 || dot < lo_dot){ lo = i; lo_dot = dot; }
+        if (hi < 0 || dot > hi_dot){ hi = i; hi_dot = dot; }
+    }
+    Uint16 color0 = k_Pack565(texels[hi].r, texels[hi].g, texels[hi].b);
+    Uint16 color1 = k_Pack565(texels[lo].r, texels[lo].g, texels[lo].b);
+
+    // the endpoint order selects the mode: color0 > color1 is 4 colors, otherwise 3 and transparent
+    if ((transparent && color0 > color1) || (!transparent && color0 < color1)){
+        Uint16 swap = color0;
+        color0 = color1;
+        color1 = swap;
+    }
+    Kitty_BC1Block block = { color0, color1, 0 };
+    if (color0 == color1 && !transparent){
+        return block;
+    }
+
+    Kitty_Color palette[4];
+    k_BC1Palette(color0, color1, palette);
+    int choices = transparent ? 3 : 4;
+    for (int i = 0; i < 16; i++){
+        int best = 3;
+        if (texels[i].a >= 128){
+            int best_distance = 3 * 255 * 255 + 1;
+            for (int p = 0; p < choices; p++){
+                int distance = k_ColorDistance(texels[i], palette[p]);
+                if (distance < best_distance){
+                    best_distance = distance;
+                    best = p;
+                }
+            }
+        }
+        block.weights |= (Uint32)best << (2 * i);
+    }
+    return block;
+}
+
+static int k_EncodeBC1(const Kitty_Color* texels, int width, int height, Kitty_BC1Block** out_blocks){
+    int blocks_x = (width + 3) / 4, blocks_y = (height + 3) / 4;
+    Kitty_BC1Block* blocks = (Kitty_BC1Block*)k_Alloc((size_t)blocks_x * blocks_y * sizeof(Kitty_BC1Block), KITTY_MEMORY_TEXTURES);
+    if (!blocks){
+        return KITTY_MEMORY_ALLOCATION_FAILURE;
+    }
+    for (int by = 0; by < blocks_y; by++){
+        for (int bx = 0; bx < blocks_x; bx++){
+            // partial blocks on the right and bottom edge repeat the last texel
+            Kitty_Color block[16];
+            for (int i = 0; i < 16; i++){
+                int x = bx * 4 + (i & 3), y = by * 4 + (i >> 2);
+                if (x >= width) x = width - 1;
+                if (y >= height) y = height - 1;
+                block[i] = texels[(size_t)y * width + x];
+            }
+            blocks[(size_t)by * blocks_x + bx] = k_EncodeBC1Block(block);
+        }
+    }
+    *out_blocks = blocks;
+    return KITTY_SUCCESS;
+}
+
+int Kitty_ConvertTexture(Kitty_Texture* texture, enum Kitty_TextureFormat format){
+    if (!texture || texture->format != KITTY_TEXTURE_RGBA32 || !texture->sdl_surface){
+        return KITTY_INVALID_ARGUMENT;
+    }
+    if (format == KITTY_TEXTURE_RGBA32){
+        return KITTY_SUCCESS;
+    }
+    if (format != KITTY_TEXTURE_INDEXED8 && format != KITTY_TEXTURE_BC1){
+        return KITTY_INVALID_ARGUMENT;
+    }
+    int width = texture->sdl_surface->w, height = texture->sdl_surface->h;
+    if (width <= 0 || height <= 0){
+        return KITTY_INVALID_ARGUMENT;
+    }
+    Kitty_Color* texels = (Kitty_Color*)k_Alloc((size_t)width * height * sizeof(Kitty_Color), KITTY_MEMORY_TEXTURES);
+    if (!texels){
+        return KITTY_MEMORY_ALLOCATION_FAILURE;
+    }
+    for (int y = 0; y < height; y++){
+        for (int x = 0; x < width; x++){
+            texels[(size_t)y * width + x] = Kitty_SampleTexture(texture, x, y);
+        }
+    }
+
+    int result;
+    if (format == KITTY_TEXTURE_INDEXED8){
+        result = k_QuantizeIndexed(texels, width, height, &texture->indices, &texture->palette);
+    } else {
+        result = k_EncodeBC1(texels, width, height, &texture->blocks);
+    }
+    k_Free(texels);
+    if (result != KITTY_SUCCESS){
+        return result;
+    }
+    k_FreeSurface(texture->sdl_surface);
+    texture->sdl_surface = NULL;
+    texture->format = format;
+    texture->width = width;
+    texture->height = height;
+    return KITTY_SUCCESS;
+}
+
+void Kitty_FreeTexture(Kitty_Texture* texture){
+    if (!texture){
+        return;
+    }
+    k_FreeSurface(texture->sdl_surface);
+    k_Free(texture->indices);
+    k_Free(texture->palette);
+    k_Free(texture->blocks);
+    free(texture);
+}
+
+// VIRTUAL TEXTURE STUFF
+
+// page file: "KVT1", width, height, page_size as Sint32, then every page of every level, finest level first,
+// pages row major with page_size * page_size Kitty_Color texels; pages on the right and bottom edge repeat the last texel
+#define K_VT_HEADER_SIZE 16
+
+static int k_VirtualTextureLayout(int width, int height, int page_size, Kitty_VirtualTextureLevel** out_levels, int* out_level_count, size_t* out_page_count){
+    int level_count = 1;
+    while ((width >> (level_count - 1)) > page_size || (height >> (level_count - 1)) > page_size){
+        level_count++;
+    }
+    Kitty_VirtualTextureLevel* levels = (Kitty_VirtualTextureLevel*)k_Alloc(level_count * sizeof(Kitty_VirtualTextureLevel), KITTY_MEMORY_TEXTURES);
+    if (!levels){
+        return KITTY_MEMORY_ALLOCATION_FAILURE;
+    }
+    size_t page_count = 0;
+    for (int l = 0; l < level_count; l++){
+        levels[l].width = width >> l > 0 ? width >> l : 1;
+        levels[l].height = height >> l > 0 ? height >> l : 1;
+        levels[l].pages_x = (levels[l].width + page_size - 1) / page_size;
+        levels[l].pages_y = (levels[l].height + page_size - 1) / page_size;
+        levels[l].first_page = page_count;
+        page_count += (size_t)levels[l].pages_x * levels[l].pages_y;
+    }
+    *out_levels = levels;
+    *out_level_count = level_count;
+    *out_page_count = page_count;
+    return KITTY_SUCCESS;
+}
+
+int Kitty_BakeVirtualTexture(const Kitty_Texture* source, int page_size, const char* file_path){
+    int width, height;
+    if (!source || !file_path || page_size < 16 || (page_size & (page_size - 1))){
+        return KITTY_INVALID_ARGUMENT;
+    }
+    k_TextureExtent(source, &width, &height);
+    if (width <= 0 || height <= 0){
+        return KITTY_INVALID_ARGUMENT;
+    }
+    Kitty_VirtualTextureLevel* levels;
+    int level_count;
+    size_t page_count;
+    int result = k_VirtualTextureLayout(width, height, page_size, &levels, &level_count, &page_count);
+    if (result != KITTY_SUCCESS){
+        return result;
+    }
+    Kitty_Color* level = (Kitty_Color*)k_Alloc((size_t)width * height * sizeof(Kitty_Color), KITTY_MEMORY_TEXTURES);
+    Kitty_Color* page = (Kitty_Color*)k_Alloc((size_t)page_size * page_size * sizeof(Kitty_Color), KITTY_MEMORY_TEXTURES);
+    FILE* file = fopen(file_path, "wb");
+    if (!level || !page || !file){
+        result = file ? KITTY_MEMORY_ALLOCATION_FAILURE : KITTY_FILE_NOT_FOUND;
+        goto done;
+    }
+    for (int y = 0; y < height; y++){
+        for (int x = 0; x < width; x++){
+            level[(size_t)y * width + x] = Kitty_SampleTexture(source, x, y);
+        }
+    }
+
+    Sint32 header[4];
+    memcpy(header, "KVT1", 4);
+    header[1] = width;
+    header[2] = height;
+    header[3] = page_size;
+    if (fwrite(header, sizeof(header), 1, file) != 1){
+        result = KITTY_UNKNOWN_ERROR;
+        goto done;
+    }
+    for (int l = 0; l < level_count; l++){
+        const Kitty_VirtualTextureLevel* lv = &levels[l];
+        for (int py = 0; py < lv->pages_y; py++){
+            for (int px = 0; px < lv->pages_x; px++){
+                for (int y = 0; y < page_size; y++){
+                    int sy = py * page_size + y < lv->height ? py * page_size + y : lv->height - 1;
+                    for (int x = 0; x < page_size; x++){
+                        int sx = px * page_size + x < lv->width ? px * page_size + x : lv->width - 1;
+                        page[y * page_size + x] = level[(size_t)sy * lv->width + sx];
+                    }
+                }
+                if (fwrite(page, sizeof(Kitty_Color), (size_t)page_size * page_size, file) != (size_t)page_size * page_size){
+                    result = KITTY_UNKNOWN_ERROR;
+                    goto done;
+                }
+            }
+        }
+        if (l + 1 == level_count){
+            break;
+        }
+
+        // box filter down to the next level in place, odd edges fold into the last texel
+        const Kitty_VirtualTextureLevel* next = &levels[l + 1];
+        for (int y = 0; y < next->height; y++){
+            for (int x = 0; x < next->width; x++){
+                int x0 = x * 2 < lv->width ? x * 2 : lv->width - 1, x1 = x * 2 + 1 < lv->width ? x * 2 + 1 : x0;
+                int y0 = y * 2 < lv->height ? y * 2 : lv->height - 1, y1 = y * 2 + 1 < lv->height ? y * 2 + 1 : y0;
+                Kitty_Color a = level[(size_t)y0 * lv->width + x0], b = level[(size_t)y0 * lv->width + x1];
+                Kitty_Color c = level[(size_t)y1 * lv->width + x0], d = level[(size_t)y1 * lv->width + x1];
+                level[(size_t)y * next->width + x] = (Kitty_Color){ (Uint8)((a.r + b.r + c.r + d.r + 2) / 4), (Uint8)((a.g + b.g + c.g + d.g + 2) / 4),
+                                                                   (Uint8)((a.b + b.b + c.b + d.b + 2) / 4), (Uint8)((a.a + b.a + c.a + d.a + 2) / 4) };
+            }
+        }
+    }
+
+done:
+    if (file && fclose(file) != 0 && result == KITTY_SUCCESS){
+        result = KITTY_UNKNOWN_ERROR;
+    }
+    k_Free(levels);
+    k_Free(level);
+    k_Free(page);
+    return result;
+}
+
+static size_t k_PageOffset(const Kitty_VirtualTexture* texture, size_t page){
+    return K_VT_HEADER_SIZE + page * (size_t)texture->page_size * texture->page_size * sizeof(Kitty_Color);
+}
+
+static bool k_ReadPage(Kitty_VirtualTexture* texture, size_t page, int slot){
+    size_t texels = (size_t)texture->page_size * texture->page_size;
+    return fseek(texture->file, (long)k_PageOffset(texture, page), SEEK_SET) == 0 &&
+           fread(texture->cache + slot * texels, sizeof(Kitty_Color), texels, texture->file) == texels;
+}
+
+// the loader only touches the file and the slots it was handed, the page tables belong to the render thread
+static int k_VirtualTextureLoader(void* data){
+    Kitty_VirtualTexture* texture = (Kitty_VirtualTexture*)data;
+    SDL_LockMutex(texture->lock);
+    while (true){
+        while (!texture->quit && texture->load_count == 0){
+            SDL_CondWait(texture->wake, texture->lock);
+        }
+        if (texture->quit){
+            break;
+        }
+        int slot = texture->load_queue[texture->load_head];
+        texture->load_head = (texture->load_head + 1) % texture->cache_pages;
+        texture->load_count--;
+        size_t page = (size_t)texture->slot_pages[slot];
+        SDL_UnlockMutex(texture->lock);
+
+        bool loaded = k_ReadPage(texture, page, slot);
+
+        SDL_LockMutex(texture->lock);
+        texture->done_slots[texture->done_count++] = loaded ? slot : -1 - slot;
+    }
+    SDL_UnlockMutex(texture->lock);
+    return 0;
+}
+
+Kitty_VirtualTexture* Kitty_OpenVirtualTexture(const char* file_path, int cache_pages){
+    if (!file_path || cache_pages < 2){
+        return NULL;
+    }
+    FILE* file = fopen(file_path, "rb");
+    if (!file){
+        return NULL;
+    }
+    Sint32 header[4];
+    if (fread(header, sizeof(header), 1, file) != 1 || memcmp(header, "KVT1", 4) != 0 ||
+        header[1] <= 0 || header[2] <= 0 || header[3] < 16 || (header[3] & (header[3] - 1))){
+        fclose(file);
+        return NULL;
+    }
+    Kitty_VirtualTexture* texture = (Kitty_VirtualTexture*)k_Calloc(1, sizeof(Kitty_VirtualTexture), KITTY_MEMORY_TEXTURES);
+    if (!texture){
+        fclose(file);
+        return NULL;
+    }
+    texture->file = file;
+    texture->width = header[1];
+    texture->height = header[2];
+    texture->page_size = header[3];
+    texture->cache_pages = cache_pages;
+    if (k_VirtualTextureLayout(texture->width, texture->height, texture->page_size, &texture->levels, &texture->level_count, &texture->page_count) != KITTY_SUCCESS){
+        Kitty_CloseVirtualTexture(texture);
+        return NULL;
+    }
+    texture->page_slots = (int*)k_Alloc(texture->page_count * sizeof(int), KITTY_MEMORY_TEXTURES);
+    texture->page_requested = (bool*)k_Calloc(texture->page_count, sizeof(bool), KITTY_MEMORY_TEXTURES);
+    texture->page_pending = (bool*)k_Calloc(texture->page_count, sizeof(bool), KITTY_MEMORY_TEXTURES);
+    texture->cache = (Kitty_Color*)k_Alloc((size_t)cache_pages * texture->page_size * texture->page_size * sizeof(Kitty_Color), KITTY_MEMORY_TEXTURES);
+    texture->slot_pages = (int*)k_Alloc(cache_pages * sizeof(int), KITTY_MEMORY_TEXTURES);
+    texture->slot_last_used = (size_t*)k_Calloc(cache_pages, sizeof(size_t), KITTY_MEMORY_TEXTURES);
+    texture->load_queue = (int*)k_Alloc(cache_pages * sizeof(int), KITTY_MEMORY_TEXTURES);
+    texture->done_slots = (int*)k_Alloc(cache_pages * sizeof(int), KITTY_MEMORY_TEXTURES);
+    texture->lock = SDL_CreateMutex();
+    texture->wake = SDL_CreateCond();
+    if (!texture->page_slots || !texture->page_requested || !texture->page_pending || !texture->cache || !texture->slot_pages ||
+        !texture->slot_last_used || !texture->load_queue || !texture->done_slots || !texture->lock || !texture->wake){
+        Kitty_CloseVirtualTexture(texture);
+        return NULL;
+    }
+    for (size_t i = 0; i < texture->page_count; i++){
+        texture->page_slots[i] = -1;
+    }
+    for (int i = 0; i < cache_pages; i++){
+        texture->slot_pages[i] = -1;
+    }
+
+    // the coarsest level is the fallback of every sample, it goes in slot 0 and is never evicted
+    size_t last_page = texture->page_count - 1;
+    if (!k_ReadPage(texture, last_page, 0)){
+        Kitty_CloseVirtualTexture(texture);
+        return NULL;
+    }
+    texture->page_slots[last_page] = 0;
+    texture->slot_pages[0] = (int)last_page;
+    texture->slot_last_used[0] = SIZE_MAX;
+    texture->pages_loaded = 1;
+
+    texture->loader = SDL_CreateThread(k_VirtualTextureLoader, "kitty_vt_loader", texture);
+    if (!texture->loader){
+        Kitty_CloseVirtualTexture(texture);
+        return NULL;
+    }
+    return texture;
+}
+
+void Kitty_CloseVirtualTexture(Kitty_VirtualTexture* texture){
+    if (!texture){
+        return;
+    }
+    if (texture->loader){
+        SDL_LockMutex(texture->lock);
+        texture->quit = true;
+        SDL_CondSignal(texture->wake);
+        SDL_UnlockMutex(texture->lock);
+        SDL_WaitThread(texture->loader, NULL);
+    }
+    if (texture->wake){
+        SDL_DestroyCond(texture->wake);
+    }
+    if (texture->lock){
+        SDL_DestroyMutex(texture->lock);
+    }
+    if (texture->file){
+        fclose(texture->file);
+    }
+    k_Free(texture->levels);
+    k_Free(texture->page_slots);
+    k_Free(texture->page_requested);
+    k_Free(texture->page_pending);
+    k_Free(texture->cache);
+    k_Free(texture->slot_pages);
+    k_Free(texture->slot_last_used);
+    k_Free(texture->load_queue);
+    k_Free(texture->done_slots);
+    k_Free(texture);
+}
+
+Kitty_Color Kitty_SampleVirtualTexture(Kitty_VirtualTexture* texture, float u, float v, int level){
+    if (level < 0) level = 0;
+    if (level >= texture->level_count) level = texture->level_count - 1;
+    for (int l = level; l < texture->level_count; l++){
+        const Kitty_VirtualTextureLevel* lv = &texture->levels[l];
+        int x = (int)(u * lv->width), y = (int)(v * lv->height);
+        x = x < 0 ? 0 : (x >= lv->width ? lv->width - 1 : x);
+        y = y < 0 ? 0 : (y >= lv->height ? lv->height - 1 : y);
+        size_t page = lv->first_page + (size_t)(y / texture->page_size) * lv->pages_x + x / texture->page_size;
+        int slot = texture->page_slots[page];
+        if (l == level){
+            texture->page_requested[page] = true;
+            if (slot < 0){
+                texture->fallback_samples++;
+            }
+        }
+        if (slot >= 0){
+            if (texture->slot_last_used[slot] < frame_num){
+                texture->slot_last_used[slot] = frame_num;
+            }
+            return texture->cache[((size_t)slot * texture->page_size + y % texture->page_size) * texture->page_size + x % texture->page_size];
+        }
+    }
+    return (Kitty_Color){ 0, 0, 0, 0 }; // unreachable, the coarsest page is pinned
+}
+
+// a free slot, or the least recently used one not sampled this frame; -1 when every slot is busy
+static int k_ReserveSlot(Kitty_VirtualTexture* texture){
+    int best = -1;
+    for (int slot = 0; slot < texture->cache_pages; slot++){
+        int page = texture->slot_pages[slot];
+        if (page < 0){
+            return slot;
+        }
+        if (texture->page_pending[page] || texture->slot_last_used[slot] >= frame_num){
+            continue;
+        }
+        if (best < 0 || texture->slot_last_used[slot] < texture->slot_last_used[best]){
+            best = slot;
+        }
+    }
+    if (best >= 0){
+        texture->page_slots[texture->slot_pages[best]] = -1;
+        texture->slot_pages[best] = -1;
+    }
+    return best;
+}
+
+int Kitty_UpdateVirtualTexture(Kitty_VirtualTexture* texture){
+    if (!texture){
+        return KITTY_INVALID_ARGUMENT;
+    }
+    SDL_LockMutex(texture->lock);
+    for (int i = 0; i < texture->done_count; i++){
+        int slot = texture->done_slots[i] >= 0 ? texture->done_slots[i] : -1 - texture->done_slots[i];
+        int page = texture->slot_pages[slot];
+        texture->page_pending[page] = false;
+        if (texture->done_slots[i] >= 0){
+            texture->page_slots[page] = slot;
+            texture->slot_last_used[slot] = frame_num;
+            texture->pages_loaded++;
+        } else {
+            texture->slot_pages[slot] = -1; // asked for again by the next sample
+        }
+    }
+    texture->done_count = 0;
+
+    // coarse levels first so the fallbacks sharpen step by step
+    bool cache_full = false;
+    for (int l = texture->level_count - 1; l >= 0; l--){
+        const Kitty_VirtualTextureLevel* lv = &texture->levels[l];
+        size_t end = lv->first_page + (size_t)lv->pages_x * lv->pages_y;
+        for (size_t page = lv->first_page; page < end; page++){
+            if (!texture->page_requested[page]){
+                continue;
+            }
+            texture->page_requested[page] = false;
+            if (cache_full || texture->page_slots[page] >= 0 || texture->page_pending[page]){
+                continue;
+            }
+            int slot = k_ReserveSlot(texture);
+            if (slot < 0){
+                cache_full = true;
+                continue;
+            }
+            texture->slot_pages[slot] = (int)page;
+            texture->page_pending[page] = true;
+            texture->load_queue[(texture->load_head + texture->load_count) % texture->cache_pages] = slot;
+            texture->load_count++;
+        }
+    }
+    if (texture->load_count > 0){
+        SDL_CondSignal(texture->wake);
+    }
+    SDL_UnlockMutex(texture->lock);
+    return KITTY_SUCCESS;
+}
+
+int Kitty_GetVirtualTextureStats(const Kitty_VirtualTexture* texture, Kitty_VirtualTextureStats* out_stats){
+    if (!texture || !out_stats){
+        return KITTY_INVALID_ARGUMENT;
+    }
+    *out_stats = (Kitty_VirtualTextureStats){ 0, 0, texture->pages_loaded, texture->fallback_samples };
+    for (int slot = 0; slot < texture->cache_pages; slot++){
+        int page = texture->slot_pages[slot];
+        if (page >= 0 && texture->page_pending[page]){
+            out_stats->pending_pages++;
+        } else if (page >= 0){
+            out_stats->resident_pages++;
+        }
+    }
+    return KITTY_SUCCESS;
+}
+
+// IMPOSTOR STUFF
+
+static void k_UnlinkImpostorCell(int c){
+    k_ImpostorCell* cell = &k_impostor_cells[c];
+    if (cell->prev >= 0) k_impostor_cells[cell->prev].next = cell->next; else k_impostor_oldest = cell->next;
+    if (cell->next >= 0) k_impostor_cells[cell->next].prev = cell->prev; else k_impostor_newest = cell->prev;
+}
+
+static void k_AppendImpostorCell(int c){
+    k_ImpostorCell* cell = &k_impostor_cells[c];
+    cell->prev = k_impostor_newest;
+    cell->next = -1;
+    if (k_impostor_newest >= 0) k_impostor_cells[k_impostor_newest].next = c; else k_impostor_oldest = c;
+    k_impostor_newest = c;
+}
+
+///@brief Gives the cell of an impostor back to the free list.
+static void k_ReleaseImpostorCell(Kitty_Impostor* impostor){
+    int c = impostor->cell;
+    if (c >= 0 && c < k_impostor_page_count * K_IMPOSTOR_CELLS && k_impostor_cells[c].owner == impostor){
+        k_UnlinkImpostorCell(c);
+        k_impostor_cells[c].owner = NULL;
+        k_impostor_cells[c].next = k_impostor_free;
+        k_impostor_free = c;
+    }
+    impostor->cell = -1;
+    impostor->view_bucket = -1;
+}
+
+///@brief Finds a cell for an impostor: a free one, one on a new page, or the one drawn longest ago if no cell
+///was drawn this frame. Leaves impostor->cell at -1 when every cell is on screen.
+static int k_AcquireImpostorCell(Kitty_Impostor* impostor){
+    if (k_impostor_free < 0 && k_impostor_page_count < K_IMPOSTOR_MAX_PAGES){
+        SDL_Texture* page = k_CreateTexture(SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, K_IMPOSTOR_ATLAS_SIZE, K_IMPOSTOR_ATLAS_SIZE, KITTY_MEMORY_TEXTURES);
+        if (!page && k_impostor_oldest < 0){
+            return KITTY_SDL_TEXTURE_CREATION_ERROR;
+        }
+        if (page){
+            SDL_SetTextureBlendMode(page, SDL_BLENDMODE_BLEND);
+            int first = k_impostor_page_count * K_IMPOSTOR_CELLS;
+            k_impostor_pages[k_impostor_page_count++] = page;
+            for (int c = first + K_IMPOSTOR_CELLS - 1; c >= first; c--){
+                k_impostor_cells[c] = (k_ImpostorCell){NULL, 0, -1, k_impostor_free};
+                k_impostor_free = c;
+            }
+        }
+    }
+
+    int c = k_impostor_free;
+    if (c >= 0){
+        k_impostor_free = k_impostor_cells[c].next;
+    } else {
+        c = k_impostor_oldest;
+        if (c < 0 || k_impostor_cells[c].last_drawn == frame_num){
+            return KITTY_SUCCESS; // every cell is on screen, draw the faces
+        }
+        Kitty_Impostor* evicted = k_impostor_cells[c].owner;
+        k_UnlinkImpostorCell(c);
+        evicted->cell = -1;
+        evicted->view_bucket = -1;
+        evicted->active = false;
+    }
+    k_impostor_cells[c].owner = impostor;
+    k_impostor_cells[c].last_drawn = frame_num;
+    k_AppendImpostorCell(c);
+    impostor->cell = c;
+    impostor->view_bucket = -1;
+    return KITTY_SUCCESS;
+}
+
+static void k_FreeImpostor(Kitty_Impostor* impostor){
+    if (!impostor){
+        return;
+    }
+    k_ReleaseImpostorCell(impostor);
+    k_Free(impostor);
+}
+
+static void k_DestroyImpostorAtlas(){
+    for (int p = 0; p < k_impostor_page_count; p++){
+        k_DestroyTexture(k_impostor_pages[p], KITTY_MEMORY_TEXTURES);
+        k_impostor_pages[p] = NULL;
+    }
+    k_impostor_page_count = 0;
+    k_impostor_free = -1;
+    k_impostor_oldest = -1;
+    k_impostor_newest = -1;
+}
+
+///@brief Bounding sphere of the vertices the mesh currently draws.
+static void k_MeshBounds(Kitty_ObjMesh* mesh, Kitty_Vertex3D* out_center, float* out_radius){
+    const Kitty_Vertex3D* vertices = k_MeshVertices(mesh);
+    Kitty_Vertex3D min = {FLT_MAX, FLT_MAX, FLT_MAX};
+    Kitty_Vertex3D max = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    for (size_t i = 0; i < mesh->vertex_count; i++){
+        min.x = SDL_min(min.x, vertices[i].x); max.x = SDL_max(max.x, vertices[i].x);
+        min.y = SDL_min(min.y, vertices[i].y); max.y = SDL_max(max.y, vertices[i].y);
+        min.z = SDL_min(min.z, vertices[i].z); max.z = SDL_max(max.z, vertices[i].z);
+    }
+    Kitty_Vertex3D center = {(min.x + max.x) * 0.5f, (min.y + max.y) * 0.5f, (min.z + max.z) * 0.5f};
+    float radius = 0.0f;
+    for (size_t i = 0; i < mesh->vertex_count; i++){
+        radius = SDL_max(radius, KittyM_VectorLength3(KittyM_Point2PointV3(center, vertices[i])));
+    }
+    *out_center = center;
+    *out_radius = radius;
+}
+
+///@brief Quantizes the direction from the mesh to the camera into yaw and pitch buckets.
+static int k_ImpostorViewBucket(Kitty_Point3D position){
+    float dx = k_camera_position.x - position.x;
+    float dy = k_camera_position.y - position.y;
+    float dz = k_camera_position.z - position.z;
+    float yaw = atan2f(dx, dz);                         // -pi .. pi
+    float pitch = atan2f(dy, sqrtf(dx * dx + dz * dz)); // -pi/2 .. pi/2
+    int yaw_bucket = (int)((yaw + (float)M_PI) / (2.0f * (float)M_PI) * K_IMPOSTOR_YAW_BUCKETS) % K_IMPOSTOR_YAW_BUCKETS;
+    int pitch_bucket = (int)((pitch + (float)M_PI * 0.5f) / (float)M_PI * K_IMPOSTOR_PITCH_BUCKETS);
+    pitch_bucket = SDL_min(pitch_bucket, K_IMPOSTOR_PITCH_BUCKETS - 1);
+    return pitch_bucket * K_IMPOSTOR_YAW_BUCKETS + yaw_bucket;
+}
+
+static SDL_Rect k_ImpostorCellRect(int cell){
+    int columns = K_IMPOSTOR_ATLAS_SIZE / K_IMPOSTOR_CELL;
+    cell %= K_IMPOSTOR_CELLS; // the page is picked separately
+    return (SDL_Rect){(cell % columns) * K_IMPOSTOR_CELL, (cell / columns) * K_IMPOSTOR_CELL, K_IMPOSTOR_CELL, K_IMPOSTOR_CELL};
+}
+
+///@brief Rasterizes the mesh into its atlas cell with the regular mesh renderer.
+static int k_RefreshImpostor(Kitty_ObjMesh* m_obj, float persp, int bucket, bool textured){
+    Kitty_Impostor* impostor = m_obj->impostor;
+    SDL_Texture* page = k_impostor_pages[impostor->cell / K_IMPOSTOR_CELLS];
+
+    // fit the bounding sphere into the cell, leaving a pixel of border against bleeding
+    float snapshot_scale = (K_IMPOSTOR_CELL - 2) / (2.0f * impostor->radius * persp);
+    float half = K_IMPOSTOR_CELL * 0.5f;
+    Kitty_Point3D snapshot_position = {
+        half - impostor->center.x * persp * snapshot_scale,
+        half - impostor->center.y * persp * snapshot_scale,
+        m_obj->position.z
+    };
+    SDL_Rect cell = k_ImpostorCellRect(impostor->cell);
+
+    SDL_Texture* previous_target = k_render_target;
+    SDL_BlendMode previous_blend = k_blend_mode;
+    k_SetRenderTarget(page, &cell);
+    k_SetBlendMode(SDL_BLENDMODE_NONE);
+    k_SetDrawColor(0, 0, 0, 0);
+    k_FillRects(&(SDL_Rect){0, 0, K_IMPOSTOR_CELL, K_IMPOSTOR_CELL}, 1);
+    int result = k_RenderMesh(m_obj, snapshot_position, snapshot_scale, textured);
+    k_SetBlendMode(previous_blend);
+    k_SetRenderTarget(previous_target, NULL);
+
+    impostor->snapshot_scale = snapshot_scale * persp;
+    impostor->view_bucket = bucket;
+    impostor->stale = false;
+    impostor->refresh_count++;
+    return result;
+}
+
+static int k_RenderMeshImpostor(Kitty_ObjMesh* m_obj, bool textured, float lod_scale){
+    Kitty_Impostor* impostor = m_obj->impostor;
+    int scale = m_obj->scale;
+    if (impostor->stale){
+        k_MeshBounds(m_obj, &impostor->center, &impostor->radius);
+    }
+
+    float depth = K_PROJECTION_DISTANCE + impostor->center.z - m_obj->position.z;
+    float persp = depth > K_NEAR_PLANE ? K_PROJECTION_DISTANCE / depth : 0.0f;
+    float size = 2.0f * impostor->radius * scale * persp;
+    // a lower lod scale switches to the snapshot from further up close
+    float threshold = impostor->threshold / lod_scale;
+    if (persp == 0.0f || impostor->radius <= 0.0f || size >= threshold){
+        impostor->active = false;
+        k_ReleaseImpostorCell(impostor); // up close the faces are drawn, the cell can serve another mesh
+        return k_RenderMesh(m_obj, m_obj->position, scale, textured);
+    }
+    if (size >= impostor->threshold){
+        k_frame_stats.lods_dropped++;
+    }
+    if (impostor->cell < 0){
+        int acquire_result = k_AcquireImpostorCell(impostor);
+        if (acquire_result != KITTY_SUCCESS){
+            return acquire_result;
+        }
+        if (impostor->cell < 0){
+            impostor->active = false;
+            k_frame_stats.impostors_over_capacity++;
+            return k_RenderMesh(m_obj, m_obj->position, scale, textured);
+        }
+    } else {
+        k_impostor_cells[impostor->cell].last_drawn = frame_num;
+        k_UnlinkImpostorCell(impostor->cell);
+        k_AppendImpostorCell(impostor->cell);
+    }
+
+    int bucket = k_ImpostorViewBucket(m_obj->position);
+    if (bucket != impostor->view_bucket || impostor->stale){
+        int refresh_result = k_RefreshImpostor(m_obj, persp, bucket, textured);
+        if (refresh_result != KITTY_SUCCESS){
+            return refresh_result;
+        }
+    }
+
+    // one quad, scaled from the snapshot's pixels per unit to the current ones
+    float quad = K_IMPOSTOR_CELL * (scale * persp) / impostor->snapshot_scale;
+    SDL_Rect dest = {
+        (int)lroundf(m_obj->position.x + impostor->center.x * persp * scale - quad * 0.5f),
+        (int)lroundf(m_obj->position.y + impostor->center.y * persp * scale - quad * 0.5f),
+        SDL_max((int)lroundf(quad), 1),
+        SDL_max((int)lroundf(quad), 1)
+    };
+    SDL_Rect src = k_ImpostorCellRect(impostor->cell);
+    k_CopyTexture(k_impostor_pages[impostor->cell / K_IMPOSTOR_CELLS], &src, &dest);
+    impostor->active = true;
+    return KITTY_SUCCESS;
+}
+
+// TILEMAP STUFF
+
+///@brief Finds a cache slot for a chunk, evicting the least recently drawn one if needed.
+static int k_AcquireTileChunkSlot(Kitty_ObjTilemap* map, int chunk){
+    int victim = -1;
+    for (size_t i = 0; i < map->cache_size; i++){
+        Kitty_TileChunkSlot* slot = &map->cache[i];
+        if (slot->chunk < 0){
+            victim = (int)i;
+            break;
+        }
+        if (slot->last_used == frame_num){
+            continue; // drawn this frame, keep it
+        }
+        if (victim < 0 || slot->last_used < map->cache[victim].last_used){
+            victim = (int)i;
+        }
+    }
+
+    if (victim < 0){
+        // every slot is visible this frame (window grew), grow the cache
+        size_t new_size = map->cache_size ? map->cache_size * 2 : 1;
+        Kitty_TileChunkSlot* new_cache = (Kitty_TileChunkSlot*)k_Realloc(map->cache, new_size * sizeof(Kitty_TileChunkSlot), KITTY_MEMORY_SHAPES);
+        if (!new_cache){
+            return -1;
+        }
+        for (size_t i = map->cache_size; i < new_size; i++){
+            new_cache[i] = (Kitty_TileChunkSlot){NULL, -1, false, 0};
+        }
+        victim = (int)map->cache_size;
+        map->cache = new_cache;
+        map->cache_size = new_size;
+    }
+
+    Kitty_TileChunkSlot* slot = &map->cache[victim];
+    if (slot->chunk >= 0){
+        map->chunk_slots[slot->chunk] = -1;
+    }
+    if (slot->texture){
+        // chunks on the right and bottom edge may be smaller, only reuse matching textures
+        int tex_w, tex_h;
+        int cx = chunk % map->chunks_x;
+        int cy = chunk / map->chunks_x;
+        int want_w = SDL_min(KITTY_TILEMAP_CHUNK_SIZE, map->width - cx * KITTY_TILEMAP_CHUNK_SIZE) * map->tile_width;
+        int want_h = SDL_min(KITTY_TILEMAP_CHUNK_SIZE, map->height - cy * KITTY_TILEMAP_CHUNK_SIZE) * map->tile_height;
+        SDL_QueryTexture(slot->texture, NULL, NULL, &tex_w, &tex_h);
+        if (tex_w != want_w || tex_h != want_h){
+            k_DestroyTexture(slot->texture, KITTY_MEMORY_TEXTURES);
+            slot->texture = NULL;
+        }
+    }
+    slot->chunk = chunk;
+    slot->dirty = true;
+    map->chunk_slots[chunk] = victim;
+    return victim;
+}
+
+///@brief Re-rasterizes the tiles of one chunk into its cached texture.
+static int k_RasterizeTileChunk(Kitty_ObjTilemap* map, Kitty_TileChunkSlot* slot){
+    int cx = slot->chunk % map->chunks_x;
+    int cy = slot->chunk / map->chunks_x;
+    int tiles_w = SDL_min(KITTY_TILEMAP_CHUNK_SIZE, map->width - cx * KITTY_TILEMAP_CHUNK_SIZE);
+    int tiles_h = SDL_min(KITTY_TILEMAP_CHUNK_SIZE, map->height - cy * KITTY_TILEMAP_CHUNK_SIZE);
+
+    if (!slot->texture){
+        slot->texture = k_CreateTexture(SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET,
+                                        tiles_w * map->tile_width, tiles_h * map->tile_height, KITTY_MEMORY_TEXTURES);
+        if (!slot->texture){
+            return KITTY_SDL_TEXTURE_CREATION_ERROR;
+        }
+        SDL_SetTextureBlendMode(slot->texture, SDL_BLENDMODE_BLEND);
+    }
+
+    int atlas_columns = map->atlas->sdl_surface->w / map->tile_width;
+    int atlas_rows = map->atlas->sdl_surface->h / map->tile_height;
+    int atlas_tiles = atlas_columns * atlas_rows;
+
+    SDL_Texture* previous_target = k_render_target;
+    k_SetRenderTarget(slot->texture, NULL);
+    k_backend->clear(k_backend->user_data, (Kitty_Color){0, 0, 0, 0});
+
+    for (int ty = 0; ty < tiles_h; ty++){
+        const Uint16* row = &map->tiles[(size_t)(cy * KITTY_TILEMAP_CHUNK_SIZE + ty) * map->width + cx * KITTY_TILEMAP_CHUNK_SIZE];
+        for (int tx = 0; tx < tiles_w; tx++){
+            Uint16 tile = row[tx];
+            if (tile == KITTY_TILE_EMPTY || tile >= atlas_tiles){
+                continue;
+            }
+            SDL_Rect src = {(tile % atlas_columns) * map->tile_width, (tile / atlas_columns) * map->tile_height, map->tile_width, map->tile_height};
+            SDL_Rect dst = {tx * map->tile_width, ty * map->tile_height, map->tile_width, map->tile_height};
+            k_CopyTexture(map->atlas_texture, &src, &dst);
+        }
+    }
+
+    k_SetRenderTarget(previous_target, NULL);
+    slot->dirty = false;
+    return KITTY_SUCCESS;
+}
+
+static int k_RenderTilemap(Kitty_ObjTilemap* map){
+    if (!map->atlas_texture){
+        map->atlas_texture = k_CreateTextureFromSurface(map->atlas->sdl_surface, KITTY_MEMORY_TEXTURES);
+        if (!map->atlas_texture){
+            return KITTY_SDL_TEXTURE_CREATION_ERROR;
+        }
+    }
+
+    int chunk_w = KITTY_TILEMAP_CHUNK_SIZE * map->tile_width;
+    int chunk_h = KITTY_TILEMAP_CHUNK_SIZE * map->tile_height;
+
+    // chunk range covered by the window, in map space
+    int left = -map->position.x;
+    int top = -map->position.y;
+    int right = left + window_width - 1;
+    int bottom = top + window_height - 1;
+    if (right < 0 || bottom < 0 || left >= map->width * map->tile_width || top >= map->height * map->tile_height){
+        return KITTY_SUCCESS; // map is entirely off screen
+    }
+    int cx0 = SDL_max(left, 0) / chunk_w;
+    int cy0 = SDL_max(top, 0) / chunk_h;
+    int cx1 = SDL_min(right / chunk_w, map->chunks_x - 1);
+    int cy1 = SDL_min(bottom / chunk_h, map->chunks_y - 1);
+
+    if (!map->cache){
+        // enough for the visible chunks plus one ring of scrolling slack
+        size_t visible = (size_t)(window_width / chunk_w + 2) * (size_t)(window_height / chunk_h + 2);
+        size_t chunk_count = (size_t)map->chunks_x * (size_t)map->chunks_y;
+        map->cache_size = SDL_min(visible * 2, chunk_count);
+        map->cache = (Kitty_TileChunkSlot*)k_Alloc(map->cache_size * sizeof(Kitty_TileChunkSlot), KITTY_MEMORY_SHAPES);
+        if (!map->cache){
+            map->cache_size = 0;
+            return KITTY_MEMORY_ALLOCATION_FAILURE;
+        }
+        for (size_t i = 0; i < map->cache_size; i++){
+            map->cache[i] = (Kitty_TileChunkSlot){NULL, -1, false, 0};
+        }
+    }
+
+    for (int cy = cy0; cy <= cy1; cy++){
+        for (int cx = cx0; cx <= cx1; cx++){
+            int chunk = cy * map->chunks_x + cx;
+            int slot_index = map->chunk_slots[chunk];
+            if (slot_index < 0){
+                slot_index = k_AcquireTileChunkSlot(map, chunk);
+                if (slot_index < 0){
+                    return KITTY_MEMORY_ALLOCATION_FAILURE;
+                }
+            }
+            Kitty_TileChunkSlot* slot = &map->cache[slot_index];
+            if (slot->dirty){
+                int result = k_RasterizeTileChunk(map, slot);
+                if (result != KITTY_SUCCESS){
+                    return result;
+                }
+            }
+            slot->last_used = frame_num;
+
+            int tex_w, tex_h;
+            SDL_QueryTexture(slot->texture, NULL, NULL, &tex_w, &tex_h);
+            SDL_Rect dst = {map->position.x + cx * chunk_w, map->position.y + cy * chunk_h, tex_w, tex_h};
+            k_CopyTexture(slot->texture, NULL, &dst);
+        }
+    }
+
+    return KITTY_SUCCESS;
+}
+
+// POLYGON STUFF
+
+static void k_InitPolygon(Kitty_ObjPolygon* poly, bool filled, enum Kitty_FillRule fill_rule, Kitty_Color color){
+    poly->points = NULL;
+    poly->point_count = 0;
+    poly->point_capacity = 0;
+    poly->contour_ends = NULL;
+    poly->contour_count = 0;
+    poly->contour_capacity = 0;
+    poly->fill_rule = fill_rule;
+    poly->filled = filled;
+    poly->color = color;
+    poly->edges = NULL;
+    poly->edge_count = 0;
+    poly->edge_capacity = 0;
+    poly->active_edges = NULL;
+    poly->edges_dirty = true;
+}
+
+static void k_FreePolygonBuffers(Kitty_ObjPolygon* poly){
+    k_Free(poly->points);
+    k_Free(poly->contour_ends);
+    k_Free(poly->edges);
+    k_Free(poly->active_edges);
+}
+
+///@brief Drops all contours but keeps the buffers for the next rebuild.
+static void k_ResetPolygon(Kitty_ObjPolygon* poly){
+    poly->point_count = 0;
+    poly->contour_count = 0;
+    poly->edges_dirty = true;
+}
+
+///@brief Moves a polygon by whole pixels, shifting a built edge table along instead of rebuilding it.
+static void k_TranslatePolygon(Kitty_ObjPolygon* poly, int dx, int dy){
+    for (size_t i = 0; i < poly->point_count; i++){
+        poly->points[i].x += dx;
+        poly->points[i].y += dy;
+    }
+    if (poly->edges_dirty){
+        return;
+    }
+    // slopes and the scanline order do not change, x is derived from x0 when an edge activates
+    for (size_t i = 0; i < poly->edge_count; i++){
+        Kitty_PolygonEdge* edge = &poly->edges[i];
+        edge->y_top += dy;
+        edge->y_bottom += dy;
+        edge->x0 += dx;
+        edge->y0 += dy;
+    }
+}
+
+static int k_PolygonAddContour(Kitty_ObjPolygon* poly, const Kitty_Point* points, size_t point_count){
+    if (poly->point_count + point_count > poly->point_capacity){
+        size_t new_capacity = SDL_max(poly->point_capacity * 2, poly->point_count + point_count);
+        Kitty_Point* new_points = (Kitty_Point*)k_Realloc(poly->points, new_capacity * sizeof(Kitty_Point), KITTY_MEMORY_SHAPES);
+        if (!new_points){
+            return KITTY_MEMORY_ALLOCATION_FAILURE;
+        }
+        poly->points = new_points;
+        poly->point_capacity = new_capacity;
+    }
+    if (poly->contour_count + 1 > poly->contour_capacity){
+        size_t new_capacity = SDL_max(poly->contour_capacity * 2, (size_t)4);
+        size_t* new_ends = (size_t*)k_Realloc(poly->contour_ends, new_capacity * sizeof(size_t), KITTY_MEMORY_SHAPES);
+        if (!new_ends){
+            return KITTY_MEMORY_ALLOCATION_FAILURE;
+        }
+        poly->contour_ends = new_ends;
+        poly->contour_capacity = new_capacity;
+    }
+
+    memcpy(&poly->points[poly->point_count], points, point_count * sizeof(Kitty_Point));
+    poly->point_count += point_count;
+    poly->contour_ends[poly->contour_count++] = poly->point_count;
+    poly->edges_dirty = true;
+    return KITTY_SUCCESS;
+}
+
+static int k_ComparePolygonEdges(const void* a, const void* b){
+    const Kitty_PolygonEdge* ea = (const Kitty_PolygonEdge*)a;
+    const Kitty_PolygonEdge* eb = (const Kitty_PolygonEdge*)b;
+    return (ea->y_top > eb->y_top) - (ea->y_top < eb->y_top);
+}
+
+///@brief Builds the edge table sorted by first scanline, dropping horizontal edges.
+static int k_BuildPolygonEdges(Kitty_ObjPolygon* poly){
+    if (poly->point_count > poly->edge_capacity){
+        Kitty_PolygonEdge* new_edges = (Kitty_PolygonEdge*)k_Realloc(poly->edges, poly->point_count * sizeof(Kitty_PolygonEdge), KITTY_MEMORY_SHAPES);
+        if (!new_edges){
+            return KITTY_MEMORY_ALLOCATION_FAILURE;
+        }
+        poly->edges = new_edges;
+        size_t* new_active = (size_t*)k_Realloc(poly->active_edges, poly->point_count * sizeof(size_t), KITTY_MEMORY_SHAPES);
+        if (!new_active){
+            return KITTY_MEMORY_ALLOCATION_FAILURE;
+        }
+        poly->active_edges = new_active;
+        poly->edge_capacity = poly->point_count;
+    }
+
+    size_t count = 0;
+    size_t start = 0;
+    for (size_t c = 0; c < poly->contour_count; c++){
+        size_t end = poly->contour_ends[c];
+        for (size_t i = start; i < end; i++){
+            Kitty_Point a = poly->points[i];
+            Kitty_Point b = poly->points[i + 1 < end ? i + 1 : start];
+            if (a.y == b.y){
+                continue; // horizontal edges never cross a scanline center
+            }
+            Kitty_PolygonEdge* edge = &poly->edges[count++];
+            edge->winding = a.y < b.y ? 1 : -1;
+            if (a.y > b.y){
+                Kitty_Point t = a; a = b; b = t;
+            }
+            // scanline y samples at y + 0.5, so integer endpoints cover [a.y, b.y)
+            edge->y_top = a.y;
+            edge->y_bottom = b.y;
+            edge->x0 = a.x;
+            edge->y0 = a.y;
+            edge->dxdy = (Sint64)(b.x - a.x) * 65536 / (b.y - a.y);
+            edge->x = 0;
+        }
+        start = end;
+    }
+    poly->edge_count = count;
+    qsort(poly->edges, count, sizeof(Kitty_PolygonEdge), k_ComparePolygonEdges);
+    poly->edges_dirty = false;
+    return KITTY_SUCCESS;
+}
+
+static int k_RenderPolygon(Kitty_ObjPolygon* poly){
+    Kitty_Color col = poly->color;
+    k_SetDrawColor(col.r, col.g, col.b, col.a);
+
+    if (!poly->filled){
+        size_t start = 0;
+        for (size_t c = 0; c < poly->contour_count; c++){
+            size_t end = poly->contour_ends[c];
+            for (size_t i = start; i < end; i++){
+                Kitty_Point a = poly->points[i];
+                Kitty_Point b = poly->points[i + 1 < end ? i + 1 : start];
+                k_DrawLine(a.x, a.y, b.x, b.y);
+            }
+            start = end;
+        }
+        return KITTY_SUCCESS;
+    }
+
+    if (poly->edges_dirty){
+        int result = k_BuildPolygonEdges(poly);
+        if (result != KITTY_SUCCESS){
+            return result;
+        }
+    }
+    if (poly->edge_count == 0){
+        return KITTY_SUCCESS;
+    }
+
+    // spans are batched and submitted with one SDL call per batch
+    SDL_Rect spans[256];
+    int span_count = 0;
+
+    size_t* active = poly->active_edges;
+    size_t active_count = 0;
+    size_t next_edge = 0;
+    int y = SDL_max(poly->edges[0].y_top, 0);
+
+    while (y < window_height && (next_edge < poly->edge_count || active_count > 0)){
+        // retire finished edges, keep the rest in x order
+        size_t kept = 0;
+        for (size_t i = 0; i < active_count; i++){
+            if (poly->edges[active[i]].y_bottom > y){
+                active[kept++] = active[i];
+            }
+        }
+        active_count = kept;
+
+        // edges starting above the window are activated at the first visible scanline
+        while (next_edge < poly->edge_count && poly->edges[next_edge].y_top <= y){
+            Kitty_PolygonEdge* edge = &poly->edges[next_edge];
+            if (edge->y_bottom > y){
+                edge->x = (Sint64)edge->x0 * 65536 + (Sint64)(y - edge->y0) * edge->dxdy + (edge->dxdy >> 1);
+                active[active_count++] = next_edge;
+            }
+            next_edge++;
+        }
+
+        if (active_count == 0){
+            if (next_edge == poly->edge_count){
+                break; // every edge ended above the window bottom
+            }
+            y = poly->edges[next_edge].y_top; // skip the gap between contours
+            continue;
+        }
+
+        // insertion sort, the list is nearly sorted from the previous scanline
+        for (size_t i = 1; i < active_count; i++){
+            size_t e = active[i];
+            Sint64 ex = poly->edges[e].x;
+            size_t j = i;
+            while (j > 0 && poly->edges[active[j - 1]].x > ex){
+                active[j] = active[j - 1];
+                j--;
+            }
+            active[j] = e;
+        }
+
+        int winding = 0;
+        for (size_t i = 0; i + 1 < active_count; i++){
+            Kitty_PolygonEdge* edge = &poly->edges[active[i]];
+            if (poly->fill_rule == KITTY_FILL_NONZERO){
+                winding += edge->winding;
+            } else {
+                winding ^= 1;
+            }
+            if (winding == 0){
+                continue;
+            }
+
+            // pixel x is covered when its center x + 0.5 lies in [left, right)
+            // clamped to the window before narrowing, x may lie far outside it
+            Sint64 left = (poly->edges[active[i]].x - 0x8000 + 0xFFFF) >> 16;
+            Sint64 right = (poly->edges[active[i + 1]].x - 0x8000 + 0xFFFF) >> 16;
+            int x_start = (int)SDL_max(left, (Sint64)0);
+            int x_end = (int)SDL_min(right, (Sint64)window_width);
+            if (x_start >= x_end){
+                continue;
+            }
+
+            if (span_count > 0 && spans[span_count - 1].y == y && spans[span_count - 1].x + spans[span_count - 1].w == x_start){
+                spans[span_count - 1].w += x_end - x_start; // merge touching spans
+            } else {
+                if (span_count == (int)(sizeof(spans) / sizeof(spans[0]))){
+                    k_FillRects(spans, span_count);
+                    span_count = 0;
+                }
+                spans[span_count++] = (SDL_Rect){x_start, y, x_end - x_start, 1};
+            }
+        }
+
+        for (size_t i = 0; i < active_count; i++){
+            poly->edges[active[i]].x += poly->edges[active[i]].dxdy;
+        }
+        y++;
+    }
+
+    if (span_count > 0){
+        k_FillRects(spans, span_count);
+    }
+    return KITTY_SUCCESS;
+}
+
+// POLYLINE AND PATH STUFF
+
+static const float K_PATH_FLATNESS = 0.25f; // max distance (px) between a curve and its segments
+static const int K_PATH_MAX_CURVE_STEPS = 1024;
+static const float K_MITER_LIMIT = 4.0f; // miter length / half width before falling back to bevel
+
+static void k_InitPolyline(Kitty_ObjPolyline* line, float width, enum Kitty_LineJoin join, Kitty_Color color){
+    line->points = NULL;
+    line->point_count = 0;
+    line->point_capacity = 0;
+    line->width = width;
+    line->join = join;
+    line->color = color;
+    k_InitPolygon(&line->stroke, true, KITTY_FILL_NONZERO, color);
+    line->stroke_dirty = true;
+}
+
+static void k_FreePolylineBuffers(Kitty_ObjPolyline* line){
+    k_Free(line->points);
+    k_FreePolygonBuffers(&line->stroke);
+}
+
+///@brief Adds one convex piece of a stroke outline.
+///All pieces are wound the same way so the non-zero rule unions them without overdraw.
+static int k_StrokeAddPiece(Kitty_ObjPolygon* stroke, const Kitty_Vertex2D* piece, size_t count){
+    Kitty_Point points[72];
+    long area = 0;
+    for (size_t i = 0; i < count; i++){
+        points[i] = (Kitty_Point){(int)lroundf(piece[i].x), (int)lroundf(piece[i].y)};
+    }
+    for (size_t i = 0; i < count; i++){
+        Kitty_Point a = points[i];
+        Kitty_Point b = points[(i + 1) % count];
+        area += (long)a.x * b.y - (long)b.x * a.y;
+    }
+    if (area == 0){
+        return KITTY_SUCCESS; // collapsed to nothing after rounding
+    }
+    if (area > 0){
+        for (size_t i = 0; i < count / 2; i++){
+            Kitty_Point t = points[i];
+            points[i] = points[count - 1 - i];
+            points[count - 1 - i] = t;
+        }
+    }
+    return k_PolygonAddContour(stroke, points, count);
+}
+
+static int k_StrokeJoin(Kitty_ObjPolygon* stroke, Kitty_Vertex2D p, Kitty_Vertex2D d0, Kitty_Vertex2D d1, float half, enum Kitty_LineJoin join){
+    float cross = d0.x * d1.y - d0.y * d1.x;
+    float dot = d0.x * d1.x + d0.y * d1.y;
+    if (fabsf(cross) < 1e-4f && dot > 0){
+        return KITTY_SUCCESS; // straight continuation, the segment quads already meet
+    }
+
+    if (join == KITTY_JOIN_ROUND){
+        Kitty_Vertex2D circle[64];
+        int steps = SDL_min(64, SDL_max(8, (int)(half * 2.0f)));
+        for (int i = 0; i < steps; i++){
+            float a = (float)i * 2.0f * (float)M_PI / (float)steps;
+            circle[i] = (Kitty_Vertex2D){p.x + cosf(a) * half, p.y + sinf(a) * half};
+        }
+        return k_StrokeAddPiece(stroke, circle, steps);
+    }
+
+    // the gap to fill is on the outside of the turn
+    float side = cross > 0 ? -1.0f : 1.0f;
+    Kitty_Vertex2D o0 = {-d0.y * half * side, d0.x * half * side};
+    Kitty_Vertex2D o1 = {-d1.y * half * side, d1.x * half * side};
+    Kitty_Vertex2D bisector = {o0.x + o1.x, o0.y + o1.y};
+    float bisector_len = sqrtf(bisector.x * bisector.x + bisector.y * bisector.y);
+    Kitty_Vertex2D a = {p.x + o0.x, p.y + o0.y};
+    Kitty_Vertex2D b = {p.x + o1.x, p.y + o1.y};
+    if (bisector_len < 1e-6f){
+        return KITTY_SUCCESS; // the line folds back onto itself
+    }
+
+    float miter_len = half * (2.0f * half) / bisector_len; // half / cos(angle / 2)
+    if (miter_len > half * K_MITER_LIMIT){
+        Kitty_Vertex2D bevel[3] = {p, a, b};
+        return k_StrokeAddPiece(stroke, bevel, 3);
+    }
+    Kitty_Vertex2D m = {p.x + bisector.x / bisector_len * miter_len, p.y + bisector.y / bisector_len * miter_len};
+    Kitty_Vertex2D miter[4] = {p, a, m, b};
+    return k_StrokeAddPiece(stroke, miter, 4);
+}
+
+///@brief Appends the outline of one open run of points to a stroke polygon.
+static int k_StrokeRun(Kitty_ObjPolygon* stroke, const Kitty_Point* points, size_t count, float width, enum Kitty_LineJoin join){
+    float half = width * 0.5f;
+    bool has_prev = false;
+    Kitty_Vertex2D prev_dir = {0.0f, 0.0f};
+
+    for (size_t i = 0; i + 1 < count; i++){
+        Kitty_Vertex2D a = {(float)points[i].x, (float)points[i].y};
+        Kitty_Vertex2D b = {(float)points[i + 1].x, (float)points[i + 1].y};
+        float dx = b.x - a.x;
+        float dy = b.y - a.y;
+        float len = sqrtf(dx * dx + dy * dy);
+        if (len < 1e-6f){
+            continue; // repeated point
+        }
+        Kitty_Vertex2D dir = {dx / len, dy / len};
+
+        int result;
+        if (has_prev){
+            result = k_StrokeJoin(stroke, a, prev_dir, dir, half, join);
+            if (result != KITTY_SUCCESS){
+                return result;
+            }
+        }
+
+        float nx = -dir.y * half;
+        float ny = dir.x * half;
+        Kitty_Vertex2D quad[4] = {
+            {a.x + nx, a.y + ny},
+            {b.x + nx, b.y + ny},
+            {b.x - nx, b.y - ny},
+            {a.x - nx, a.y - ny}
+        };
+        result = k_StrokeAddPiece(stroke, quad, 4);
+        if (result != KITTY_SUCCESS){
+            return result;
+        }
+        prev_dir = dir;
+        has_prev = true;
+    }
+    return KITTY_SUCCESS;
+}
+
+static int k_RenderPolyline(Kitty_ObjPolyline* line, const size_t* run_ends, size_t run_count){
+    if (line->width <= 1.0f){
+        Kitty_Color col = line->color;
+        k_SetDrawColor(col.r, col.g, col.b, col.a);
+        size_t start = 0;
+        for (size_t r = 0; r < run_count; r++){
+            size_t end = run_ends[r];
+            if (end - start >= 2){
+                // Kitty_Point has the same layout as SDL_Point
+                k_DrawLines((const SDL_Point*)&line->points[start], (int)(end - start));
+            }
+            start = end;
+        }
+        return KITTY_SUCCESS;
+    }
+
+    if (line->stroke_dirty){
+        k_ResetPolygon(&line->stroke);
+        size_t start = 0;
+        for (size_t r = 0; r < run_count; r++){
+            int result = k_StrokeRun(&line->stroke, &line->points[start], run_ends[r] - start, line->width, line->join);
+            if (result != KITTY_SUCCESS){
+                return result;
+            }
+            start = run_ends[r];
+        }
+        line->stroke_dirty = false;
+    }
+    line->stroke.color = line->color;
+    return k_RenderPolygon(&line->stroke);
+}
+
+static int k_PathPushPoint(Kitty_ObjPath* path, Kitty_Vertex2D point){
+    if (path->flat_count == path->flat_capacity){
+        size_t new_capacity = SDL_max(path->flat_capacity * 2, (size_t)64);
+        Kitty_Vertex2D* new_flat = (Kitty_Vertex2D*)k_Realloc(path->flat, new_capacity * sizeof(Kitty_Vertex2D), KITTY_MEMORY_SHAPES);
+        if (!new_flat){
+            return KITTY_MEMORY_ALLOCATION_FAILURE;
+        }
+        path->flat = new_flat;
+        path->flat_capacity = new_capacity;
+    }
+    path->flat[path->flat_count++] = (Kitty_Vertex2D){point.x * path->scale, point.y * path->scale};
+    return KITTY_SUCCESS;
+}
+
+static int k_PathEndSubpath(Kitty_ObjPath* path){
+    size_t start = path->subpath_count ? path->subpath_ends[path->subpath_count - 1] : 0;
+    if (path->flat_count == start){
+        return KITTY_SUCCESS; // nothing since the last subpath
+    }
+    if (path->subpath_count == path->subpath_capacity){
+        size_t new_capacity = SDL_max(path->subpath_capacity * 2, (size_t)4);
+        size_t* new_ends = (size_t*)k_Realloc(path->subpath_ends, new_capacity * sizeof(size_t), KITTY_MEMORY_SHAPES);
+        if (!new_ends){
+            return KITTY_MEMORY_ALLOCATION_FAILURE;
+        }
+        path->subpath_ends = new_ends;
+        path->subpath_capacity = new_capacity;
+    }
+    path->subpath_ends[path->subpath_count++] = path->flat_count;
+    return KITTY_SUCCESS;
+}
+
+///@brief Number of uniform steps that keep a curve within K_PATH_FLATNESS at the current scale.
+///@param curvature Largest second difference of the control polygon.
+static int k_PathCurveSteps(float curvature, float factor, float scale){
+    float steps = ceilf(sqrtf(curvature * factor * scale / K_PATH_FLATNESS));
+    return (int)SDL_min(SDL_max(steps, 1.0f), (float)K_PATH_MAX_CURVE_STEPS);
+}
+
+static int k_FlattenPath(Kitty_ObjPath* path){
+    path->flat_count = 0;
+    path->subpath_count = 0;
+    Kitty_Vertex2D current = {0.0f, 0.0f};
+    bool started = false;
+    int result = KITTY_SUCCESS;
+
+    for (size_t i = 0; i < path->segment_count && result == KITTY_SUCCESS; i++){
+        Kitty_PathSegment* seg = &path->segments[i];
+        if (seg->command == KITTY_PATH_MOVE){
+            result = k_PathEndSubpath(path);
+            current = seg->points[0];
+            started = false;
+            continue;
+        }
+        if (!started){
+            result = k_PathPushPoint(path, current);
+            started = true;
+        }
+
+        switch (seg->command){
+            case KITTY_PATH_LINE:
+                current = seg->points[0];
+                result = k_PathPushPoint(path, current);
+                break;
+            case KITTY_PATH_QUAD: {
+                Kitty_Vertex2D p0 = current, p1 = seg->points[0], p2 = seg->points[1];
+                float ddx = p0.x - 2.0f * p1.x + p2.x;
+                float ddy = p0.y - 2.0f * p1.y + p2.y;
+                // chord error of n uniform steps is |p0 - 2p1 + p2| / (4n^2)
+                int steps = k_PathCurveSteps(sqrtf(ddx * ddx + ddy * ddy), 0.25f, path->scale);
+                for (int s = 1; s <= steps && result == KITTY_SUCCESS; s++){
+                    float t = (float)s / (float)steps;
+                    float mt = 1.0f - t;
+                    result = k_PathPushPoint(path, (Kitty_Vertex2D){
+                        mt * mt * p0.x + 2.0f * mt * t * p1.x + t * t * p2.x,
+                        mt * mt * p0.y + 2.0f * mt * t * p1.y + t * t * p2.y
+                    });
+                }
+                current = p2;
+                break;
+            }
+            case KITTY_PATH_CUBIC: {
+                Kitty_Vertex2D p0 = current, p1 = seg->points[0], p2 = seg->points[1], p3 = seg->points[2];
+                float d1x = p0.x - 2.0f * p1.x + p2.x, d1y = p0.y - 2.0f * p1.y + p2.y;
+                float d2x = p1.x - 2.0f * p2.x + p3.x, d2y = p1.y - 2.0f * p2.y + p3.y;
+                float dd = SDL_max(sqrtf(d1x * d1x + d1y * d1y), sqrtf(d2x * d2x + d2y * d2y));
+                // |B''| <= 6 * dd, chord error of n uniform steps is |B''| / (8n^2)
+                int steps = k_PathCurveSteps(dd, 0.75f, path->scale);
+                for (int s = 1; s <= steps && result == KITTY_SUCCESS; s++){
+                    float t = (float)s / (float)steps;
+                    float mt = 1.0f - t;
+                    float a = mt * mt * mt, b = 3.0f * mt * mt * t, c = 3.0f * mt * t * t, d = t * t * t;
+                    result = k_PathPushPoint(path, (Kitty_Vertex2D){
+                        a * p0.x + b * p1.x + c * p2.x + d * p3.x,
+                        a * p0.y + b * p1.y + c * p2.y + d * p3.y
+                    });
+                }
+                current = p3;
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    if (result == KITTY_SUCCESS){
+        result = k_PathEndSubpath(path);
+    }
+    return result;
+}
+
+static int k_RenderPath(Kitty_ObjPath* path){
+    Kitty_ObjPolyline* line = &path->line;
+    bool flattened = false;
+    if (path->flat_dirty || path->scale != path->flat_scale){
+        int result = k_FlattenPath(path);
+        if (result != KITTY_SUCCESS){
+            return result;
+        }
+        path->flat_dirty = false;
+        path->flat_scale = path->scale;
+        flattened = true;
+    }
+
+    // panning only re-translates the cached points and stroke outline, it never re-flattens or re-strokes
+    if (!flattened && (path->position.x != path->flat_position.x || path->position.y != path->flat_position.y)){
+        int dx = path->position.x - path->flat_position.x;
+        int dy = path->position.y - path->flat_position.y;
+        for (size_t i = 0; i < line->point_count; i++){
+            line->points[i].x += dx;
+            line->points[i].y += dy;
+        }
+        if (!line->stroke_dirty){
+            k_TranslatePolygon(&line->stroke, dx, dy);
+        }
+        path->flat_position = path->position;
+    }
+    if (flattened){
+        if (path->flat_count > line->point_capacity){
+            Kitty_Point* new_points = (Kitty_Point*)k_Realloc(line->points, path->flat_count * sizeof(Kitty_Point), KITTY_MEMORY_SHAPES);
+            if (!new_points){
+                return KITTY_MEMORY_ALLOCATION_FAILURE;
+            }
+            line->points = new_points;
+            line->point_capacity = path->flat_count;
+        }
+        for (size_t i = 0; i < path->flat_count; i++){
+            line->points[i] = (Kitty_Point){
+                path->position.x + (int)lroundf(path->flat[i].x),
+                path->position.y + (int)lroundf(path->flat[i].y)
+            };
+        }
+        line->point_count = path->flat_count;
+        line->stroke_dirty = true;
+        path->flat_position = path->position;
+    }
+
+    return k_RenderPolyline(line, path->subpath_ends, path->subpath_count);
+}
+
+// PLOT STUFF
+
+///@brief (Re)allocates the per column caches after the width, window or series changed.
+static int k_PlotPrepareColumns(Kitty_ObjPlot* plot){
+    SDL_Point* new_points = (SDL_Point*)k_Realloc(plot->line_points, (size_t)plot->width * 2 * sizeof(SDL_Point), KITTY_MEMORY_SHAPES);
+    if (!new_points){
+        return KITTY_MEMORY_ALLOCATION_FAILURE;
+    }
+    plot->line_points = new_points;
+    for (size_t i = 0; i < plot->series_count; i++){
+        Kitty_PlotSeries* series = &plot->series[i];
+        float* new_min = (float*)k_Realloc(series->column_min, (size_t)plot->width * sizeof(float), KITTY_MEMORY_SHAPES);
+        if (!new_min){
+            return KITTY_MEMORY_ALLOCATION_FAILURE;
+        }
+        series->column_min = new_min;
+        float* new_max = (float*)k_Realloc(series->column_max, (size_t)plot->width * sizeof(float), KITTY_MEMORY_SHAPES);
+        if (!new_max){
+            return KITTY_MEMORY_ALLOCATION_FAILURE;
+        }
+        series->column_max = new_max;
+        series->fold_dirty = true;
+    }
+    plot->columns_width = plot->width;
+    plot->columns_window = plot->window;
+    return KITTY_SUCCESS;
+}
+
+///@brief Folds the samples appended since the last frame into their column min/max.
+///Buckets are aligned to absolute sample numbers, so old columns never change.
+static void k_PlotFoldSeries(Kitty_ObjPlot* plot, Kitty_PlotSeries* series, Uint64 samples_per_column){
+    Uint64 total = series->total;
+    if (total == 0){
+        return;
+    }
+    Uint64 oldest = total > series->capacity ? total - series->capacity : 0;
+    Uint64 newest_bucket = (total - 1) / samples_per_column;
+    Uint64 first_bucket = newest_bucket >= (Uint64)plot->width ? newest_bucket - plot->width + 1 : 0;
+
+    Uint64 from = series->folded;
+    bool restart = series->fold_dirty || from < first_bucket * samples_per_column || from < oldest;
+    if (restart){
+        from = SDL_max(first_bucket * samples_per_column, oldest);
+    }
+
+    for (Uint64 s = from; s < total; s++){
+        float v = series->samples[s % series->capacity];
+        size_t column = (size_t)((s / samples_per_column) % (Uint64)plot->width);
+        if ((restart && s == from) || s % samples_per_column == 0){
+            series->column_min[column] = v; // first sample of a bucket
+            series->column_max[column] = v;
+        } else {
+            if (v < series->column_min[column]) series->column_min[column] = v;
+            if (v > series->column_max[column]) series->column_max[column] = v;
+        }
+    }
+    series->folded = total;
+    series->fold_dirty = false;
+}
+
+static int k_RenderPlot(Kitty_ObjPlot* plot){
+    if (plot->width <= 0 || plot->window == 0 || plot->max_value <= plot->min_value){
+        return KITTY_INVALID_ARGUMENT;
+    }
+    if (plot->columns_width != plot->width || plot->columns_window != plot->window){
+        int result = k_PlotPrepareColumns(plot);
+        if (result != KITTY_SUCCESS){
+            return result;
+        }
+    }
+
+    Uint64 samples_per_column = (plot->window + plot->width - 1) / plot->width;
+    float y_scale = (float)(plot->height - 1) / (plot->max_value - plot->min_value);
+    int bottom = plot->position.y + plot->height - 1;
+
+    for (size_t i = 0; i < plot->series_count; i++){
+        Kitty_PlotSeries* series = &plot->series[i];
+        k_PlotFoldSeries(plot, series, samples_per_column);
+        if (series->total == 0){
+            continue;
+        }
+
+        Uint64 oldest = series->total > series->capacity ? series->total - series->capacity : 0;
+        Uint64 newest_bucket = (series->total - 1) / samples_per_column;
+        Uint64 first_bucket = newest_bucket >= (Uint64)plot->width ? newest_bucket - plot->width + 1 : 0;
+        first_bucket = SDL_max(first_bucket, oldest / samples_per_column);
+
+        // zigzag through min and max of every column, one SDL call per series
+        int point_count = 0;
+        for (Uint64 b = first_bucket; b <= newest_bucket; b++){
+            size_t column = (size_t)(b % (Uint64)plot->width);
+            int x = plot->position.x + plot->width - 1 - (int)(newest_bucket - b);
+            float lo = SDL_min(SDL_max(series->column_min[column], plot->min_value), plot->max_value);
+            float hi = SDL_min(SDL_max(series->column_max[column], plot->min_value), plot->max_value);
+            int y_lo = bottom - (int)((lo - plot->min_value) * y_scale);
+            int y_hi = bottom - (int)((hi - plot->min_value) * y_scale);
+            if (point_count & 2){
+                plot->line_points[point_count++] = (SDL_Point){x, y_hi};
+                plot->line_points[point_count++] = (SDL_Point){x, y_lo};
+            } else {
+                plot->line_points[point_count++] = (SDL_Point){x, y_lo};
+                plot->line_points[point_count++] = (SDL_Point){x, y_hi};
+            }
+        }
+
+        Kitty_Color col = series->color;
+        k_SetDrawColor(col.r, col.g, col.b, col.a);
+        if (point_count == 2 && plot->line_points[0].y == plot->line_points[1].y){
+            k_DrawPoint(plot->line_points[0].x, plot->line_points[0].y);
+        } else {
+            k_DrawLines(plot->line_points, point_count);
+        }
+    }
+    return KITTY_SUCCESS;
+}
+
+// FRAME GOVERNOR STUFF
+
+///@brief Detail multiplier for LODs at a quality level: low priority drops first, high priority last.
+static float k_GovernorLodScale(enum Kitty_Priority priority, int level){
+    int steps = level - (int)priority; // low drops from level 1, normal from 2, high at 3
+    if (steps <= 0){
+        return 1.0f;
+    }
+    return 1.0f / (float)(1 << steps);
+}
+
+static void k_UpdateGovernor(double frame_ms){
+    Kitty_FrameStats* stats = &k_frame_stats;
+    stats->frame_ms = frame_ms;
+    if (!k_governor.enabled){
+        return;
+    }
+
+    // hysteresis: a few slow frames drop a level, a long calm stretch restores one
+    if (frame_ms > k_governor.budget_ms){
+        stats->frames_over_budget++;
+        stats->frames_with_headroom = 0;
+    } else if (frame_ms < k_governor.budget_ms * k_governor.headroom){
+        stats->frames_with_headroom++;
+        stats->frames_over_budget = 0;
+    } else {
+        stats->frames_over_budget = 0;
+        stats->frames_with_headroom = 0;
+    }
+
+    if (stats->frames_over_budget >= k_governor.degrade_after && stats->quality_level < KITTY_QUALITY_LEVELS - 1){
+        Kitty_SetQualityLevel(stats->quality_level + 1);
+    } else if (stats->frames_with_headroom >= k_governor.restore_after && stats->quality_level > 0){
+        Kitty_SetQualityLevel(stats->quality_level - 1);
+    }
+}
+
+static int k_RenderText(Kitty_ObjText* text_obj, bool throttled){
+    if (throttled && text_obj->cache && frame_num - text_obj->cache_frame < (size_t)k_governor.text_interval){
+        int w, h;
+        SDL_QueryTexture(text_obj->cache, NULL, NULL, &w, &h);
+        SDL_Rect text_rect = {text_obj->position.x, text_obj->position.y, w, h};
+        k_CopyTexture(text_obj->cache, NULL, &text_rect);
+        k_frame_stats.texts_cached++;
+        return KITTY_SUCCESS;
+    }
+
+    //load font here to add multiple font support
+    TTF_Font* font = TTF_OpenFont("arial.ttf", 24); // Load a font
+    if (!font) {
+        return KITTY_SDL_TTF_ERROR; // Font loading failed
+    }
+
+    SDL_Color sdl_color = {text_obj->color.r, text_obj->color.g, text_obj->color.b, text_obj->color.a};
+    SDL_Surface* text_surface = TTF_RenderText_Solid(font, text_obj->text, sdl_color);
+    if (!text_surface) {
+        TTF_CloseFont(font);
+        return KITTY_SDL_TTF_ERROR; // Text rendering failed
+    }
+    SDL_Texture* text_texture = k_CreateTextureFromSurface(text_surface, KITTY_MEMORY_TEXT);
+    if (!text_texture) {
+        SDL_FreeSurface(text_surface);
+        TTF_CloseFont(font);
+        return KITTY_SDL_TTF_ERROR; // Texture creation failed
+    }
+    SDL_Rect text_rect = {text_obj->position.x, text_obj->position.y, text_surface->w, text_surface->h};
+    k_CopyTexture(text_texture, NULL, &text_rect);
+    SDL_FreeSurface(text_surface);
+    TTF_CloseFont(font);
+
+    // keep the texture only while throttled, full quality text follows every change
+    if (text_obj->cache){
+        k_DestroyTexture(text_obj->cache, KITTY_MEMORY_TEXT);
+        text_obj->cache = NULL;
+    }
+    if (throttled){
+        text_obj->cache = text_texture;
+        text_obj->cache_frame = frame_num;
+    } else {
+        k_DestroyTexture(text_texture, KITTY_MEMORY_TEXT);
+    }
+    return KITTY_SUCCESS;
+}
+
+// RENDER BACKEND STUFF
+
+static void k_SetDrawColor(Uint8 r, Uint8 g, Uint8 b, Uint8 a){
+    k_backend->set_color(k_backend->user_data, (Kitty_Color){r, g, b, a});
+}
+
+static void k_SetBlendMode(SDL_BlendMode mode){
+    k_blend_mode = mode;
+    k_backend->set_blend_mode(k_backend->user_data, mode);
+}
+
+static void k_DrawPoint(int x, int y){
+    SDL_Point point = {x, y};
+    k_backend->draw_points(k_backend->user_data, &point, 1);
+}
+
+static void k_DrawLine(int x1, int y1, int x2, int y2){
+    SDL_Point points[2] = {{x1, y1}, {x2, y2}};
+    k_backend->draw_lines(k_backend->user_data, points, 2);
+}
+
+static void k_DrawLines(const SDL_Point* points, int count){
+    k_backend->draw_lines(k_backend->user_data, points, count);
+}
+
+static void k_DrawRect(const SDL_Rect* rect){
+    k_backend->draw_rect(k_backend->user_data, rect);
+}
+
+static void k_FillRects(const SDL_Rect* rects, int count){
+    k_backend->fill_rects(k_backend->user_data, rects, count);
+}
+
+static void k_CopyTexture(SDL_Texture* texture, const SDL_Rect* src, const SDL_Rect* dst){
+    k_backend->copy_texture(k_backend->user_data, texture, src, dst);
+}
+
+static void k_SetRenderTarget(SDL_Texture* target, const SDL_Rect* viewport){
+    k_render_target = target;
+    k_backend->set_target(k_backend->user_data, target, viewport);
+}
+
+static void k_InstallBackend(const Kitty_RenderBackend* backend){
+    if (k_backend->destroy){
+        k_backend->destroy(k_backend->user_data);
+    }
+    k_backend_slot = *backend;
+    k_render_target = NULL;
+    k_blend_mode = SDL_BLENDMODE_NONE;
+    k_backend->set_target(k_backend->user_data, NULL, NULL);
+    k_backend->set_blend_mode(k_backend->user_data, SDL_BLENDMODE_NONE);
+}
+
+// SDL backend: straight to the renderer
+
+typedef struct {
+    SDL_Texture* fb_texture;    // streaming upload of the software framebuffer
+    int fb_width;
+    int fb_height;
+} k_SdlBackend;
+
+static k_SdlBackend k_sdl_backend = {0};
+
+static int k_SdlBeginFrame(void* ctx){
+    (void)ctx;
+    return KITTY_SUCCESS;
+}
+
+static void k_SdlClear(void* ctx, Kitty_Color color){
+    (void)ctx;
+    SDL_SetRenderDrawColor(sdl_renderer, color.r, color.g, color.b, color.a);
+    SDL_RenderClear(sdl_renderer);
+}
+
+static void k_SdlSetColor(void* ctx, Kitty_Color color){
+    (void)ctx;
+    SDL_SetRenderDrawColor(sdl_renderer, color.r, color.g, color.b, color.a);
+}
+
+static void k_SdlSetBlendMode(void* ctx, SDL_BlendMode mode){
+    (void)ctx;
+    SDL_SetRenderDrawBlendMode(sdl_renderer, mode);
+}
+
+static void k_SdlDrawPoints(void* ctx, const SDL_Point* points, int count){
+    (void)ctx;
+    if (count == 1){
+        SDL_RenderDrawPoint(sdl_renderer, points[0].x, points[0].y);
+    } else {
+        SDL_RenderDrawPoints(sdl_renderer, points, count);
+    }
+}
+
+static void k_SdlDrawLines(void* ctx, const SDL_Point* points, int count){
+    (void)ctx;
+    if (count == 2){
+        SDL_RenderDrawLine(sdl_renderer, points[0].x, points[0].y, points[1].x, points[1].y);
+    } else {
+        SDL_RenderDrawLines(sdl_renderer, points, count);
+    }
+}
+
+static void k_SdlDrawRect(void* ctx, const SDL_Rect* rect){
+    (void)ctx;
+    SDL_RenderDrawRect(sdl_renderer, rect);
+}
+
+static void k_SdlFillRects(void* ctx, const SDL_Rect* rects, int count){
+    (void)ctx;
+    if (count == 1){
+        SDL_RenderFillRect(sdl_renderer, rects);
+    } else {
+        SDL_RenderFillRects(sdl_renderer, rects, count);
+    }
+}
+
+static void k_SdlCopyTexture(void* ctx, SDL_Texture* texture, const SDL_Rect* src, const SDL_Rect* dst){
+    (void)ctx;
+    SDL_RenderCopy(sdl_renderer, texture, src, dst);
+}
+
+static void k_SdlSetTarget(void* ctx, SDL_Texture* target, const SDL_Rect* viewport){
+    (void)ctx;
+    SDL_SetRenderTarget(sdl_renderer, target);
+    SDL_RenderSetViewport(sdl_renderer, viewport);
+}
+
+static int k_SdlPresentFramebuffer(void* ctx, const Uint32* pixels, int width, int height){
+    k_SdlBackend* sdl = (k_SdlBackend*)ctx;
+    if (!sdl->fb_texture || sdl->fb_width != width || sdl->fb_height != height){
+        if (sdl->fb_texture){
+            k_DestroyTexture(sdl->fb_texture, KITTY_MEMORY_TEXTURES);
+        }
+        sdl->fb_texture = k_CreateTexture(SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, width, height, KITTY_MEMORY_TEXTURES);
+        if (!sdl->fb_texture){
+            return KITTY_SDL_TEXTURE_CREATION_ERROR;
+        }
+        SDL_SetTextureBlendMode(sdl->fb_texture, SDL_BLENDMODE_BLEND);
+        sdl->fb_width = width;
+        sdl->fb_height = height;
+    }
+    if (SDL_UpdateTexture(sdl->fb_texture, NULL, pixels, width * (int)sizeof(Uint32)) != 0){
+        return KITTY_SDL_LOCK_TEXTURE_ERROR;
+    }
+    SDL_RenderCopy(sdl_renderer, sdl->fb_texture, NULL, NULL);
+    return KITTY_SUCCESS;
+}
+
+static int k_SdlPresent(void* ctx){
+    (void)ctx;
+    SDL_RenderPresent(sdl_renderer);
+    return KITTY_SUCCESS;
+}
+
+static int k_SdlReadBack(void* ctx, Uint32* pixels, int pitch){
+    (void)ctx;
+    if (SDL_RenderReadPixels(sdl_renderer, NULL, SDL_PIXELFORMAT_ARGB8888, pixels, pitch) != 0){
+        return KITTY_SDL_LOCK_TEXTURE_ERROR;
+    }
+    return KITTY_SUCCESS;
+}
+
+static void k_SdlDestroy(void* ctx){
+    k_SdlBackend* sdl = (k_SdlBackend*)ctx;
+    if (sdl->fb_texture){
+        k_DestroyTexture(sdl->fb_texture, KITTY_MEMORY_TEXTURES);
+    }
+    *sdl = (k_SdlBackend){0};
+}
+
+// Software backend: points, lines and rects are rasterized into a window sized ARGB buffer,
+// drawing into textures and texture copies still go through SDL; the buffer is flushed to SDL
+// before each texture copy so everything keeps its draw order
+
+typedef struct {
+    Uint32* pixels;             // straight alpha ARGB8888, transparent where nothing was drawn
+    int width;
+    int height;
+    Kitty_Color color;
+    SDL_BlendMode blend;
+    bool forward;               // a render target is set, draw through SDL
+    int dirty_x0;               // bounds of the pixels drawn since the last flush, empty when dirty_x0 > dirty_x1
+    int dirty_y0;
+    int dirty_x1;
+    int dirty_y1;
+    SDL_Texture* texture;       // upload of pixels on flush
+    k_SdlBackend sdl;           // SDL state for forwarded calls and the software framebuffer
+} k_SoftwareBackend;
+
+static k_SoftwareBackend k_software_backend = {0};
+
+///@brief Straight alpha source-over of color onto an ARGB8888 pixel.
+static Uint32 k_BlendPixel(Uint32 dst, Kitty_Color color){
+    Uint32 sa = color.a;
+    if (sa == 255){
+        return 0xFF000000u | ((Uint32)color.r << 16) | ((Uint32)color.g << 8) | color.b;
+    }
+    Uint32 da = (dst >> 24) * (255 - sa) / 255;
+    Uint32 out_a = sa + da;
+    if (out_a == 0){
+        return 0;
+    }
+    Uint32 r = ((Uint32)color.r * sa + ((dst >> 16) & 0xFF) * da) / out_a;
+    Uint32 g = ((Uint32)color.g * sa + ((dst >> 8) & 0xFF) * da) / out_a;
+    Uint32 b = ((Uint32)color.b * sa + (dst & 0xFF) * da) / out_a;
+    return (out_a << 24) | (r << 16) | (g << 8) | b;
+}
+
+static void k_SoftwareSpan(k_SoftwareBackend* sw, int x1, int x2, int y){
+    if (y < 0 || y >= sw->height){
+        return;
+    }
+    x1 = SDL_max(x1, 0);
+    x2 = SDL_min(x2, sw->width - 1);
+    if (x1 > x2){
+        return;
+    }
+    sw->dirty_x0 = SDL_min(sw->dirty_x0, x1);
+    sw->dirty_x1 = SDL_max(sw->dirty_x1, x2);
+    sw->dirty_y0 = SDL_min(sw->dirty_y0, y);
+    sw->dirty_y1 = SDL_max(sw->dirty_y1, y);
+    Uint32* row = sw->pixels + (size_t)y * sw->width;
+    if (sw->blend == SDL_BLENDMODE_NONE || sw->color.a == 255){
+        Uint32 value = ((Uint32)sw->color.a << 24) | ((Uint32)sw->color.r << 16) | ((Uint32)sw->color.g << 8) | sw->color.b;
+        for (int x = x1; x <= x2; x++){
+            row[x] = value;
+        }
+    } else {
+        // other blend modes are drawn as SDL_BLENDMODE_BLEND
+        for (int x = x1; x <= x2; x++){
+            row[x] = k_BlendPixel(row[x], sw->color);
+        }
+    }
+}
+
+///@brief Clears the drawn part of the buffer back to transparent.
+static void k_SoftwareDiscard(k_SoftwareBackend* sw){
+    for (int y = sw->dirty_y0; y <= sw->dirty_y1 && sw->dirty_x0 <= sw->dirty_x1; y++){
+        memset(sw->pixels + (size_t)y * sw->width + sw->dirty_x0, 0, (size_t)(sw->dirty_x1 - sw->dirty_x0 + 1) * sizeof(Uint32));
+    }
+    sw->dirty_x0 = sw->width;
+    sw->dirty_y0 = sw->height;
+    sw->dirty_x1 = -1;
+    sw->dirty_y1 = -1;
+}
+
+///@brief Draws the drawn part of the buffer through SDL and empties it, so later SDL draws land on top.
+static int k_SoftwareFlush(k_SoftwareBackend* sw){
+    if (!sw->pixels || sw->dirty_x0 > sw->dirty_x1){
+        return KITTY_SUCCESS;
+    }
+    SDL_Rect rect = {sw->dirty_x0, sw->dirty_y0, sw->dirty_x1 - sw->dirty_x0 + 1, sw->dirty_y1 - sw->dirty_y0 + 1};
+    const Uint32* first = sw->pixels + (size_t)rect.y * sw->width + rect.x;
+    if (SDL_UpdateTexture(sw->texture, &rect, first, sw->width * (int)sizeof(Uint32)) != 0){
+        return KITTY_SDL_LOCK_TEXTURE_ERROR;
+    }
+    SDL_RenderCopy(sdl_renderer, sw->texture, &rect, &rect);
+    k_SoftwareDiscard(sw);
+    return KITTY_SUCCESS;
+}
+
+static int k_SoftwareBeginFrame(void* ctx){
+    k_SoftwareBackend* sw = (k_SoftwareBackend*)ctx;
+    if (sw->pixels && sw->width == window_width && sw->height == window_height){
+        return KITTY_SUCCESS;
+    }
+    k_Free(sw->pixels);
+    if (sw->texture){
+        k_DestroyTexture(sw->texture, KITTY_MEMORY_TEXTURES);
+        sw->texture = NULL;
+    }
+    sw->pixels = (Uint32*)k_Calloc((size_t)window_width * (size_t)window_height, sizeof(Uint32), KITTY_MEMORY_FRAME);
+    if (!sw->pixels){
+        sw->width = 0;
+        sw->height = 0;
+        return KITTY_MEMORY_ALLOCATION_FAILURE;
+    }
+    sw->texture = k_CreateTexture(SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, window_width, window_height, KITTY_MEMORY_TEXTURES);
+    if (!sw->texture){
+        return KITTY_SDL_TEXTURE_CREATION_ERROR;
+    }
+    SDL_SetTextureBlendMode(sw->texture, SDL_BLENDMODE_BLEND);
+    sw->width = window_width;
+    sw->height = window_height;
+    k_SoftwareDiscard(sw); // nothing drawn yet
+    return KITTY_SUCCESS;
+}
+
+static void k_SoftwareClear(void* ctx, Kitty_Color color){
+    k_SoftwareBackend* sw = (k_SoftwareBackend*)ctx;
+    // the clear color goes to SDL so texture copies land on it, the buffer turns transparent
+    k_SdlClear(NULL, color);
+    SDL_SetRenderDrawColor(sdl_renderer, sw->color.r, sw->color.g, sw->color.b, sw->color.a);
+    if (!sw->forward && (sw->pixels || k_SoftwareBeginFrame(sw) == KITTY_SUCCESS)){
+        k_SoftwareDiscard(sw);
+    }
+}
+
+static void k_SoftwareSetColor(void* ctx, Kitty_Color color){
+    k_SoftwareBackend* sw = (k_SoftwareBackend*)ctx;
+    sw->color = color;
+    k_SdlSetColor(NULL, color);
+}
+
+static void k_SoftwareSetBlendMode(void* ctx, SDL_BlendMode mode){
+    k_SoftwareBackend* sw = (k_SoftwareBackend*)ctx;
+    sw->blend = mode;
+    k_SdlSetBlendMode(NULL, mode);
+}
+
+static void k_SoftwareDrawPoints(void* ctx, const SDL_Point* points, int count){
+    k_SoftwareBackend* sw = (k_SoftwareBackend*)ctx;
+    if (sw->forward || !sw->pixels){
+        k_SdlDrawPoints(NULL, points, count);
+        return;
+    }
+    for (int i = 0; i < count; i++){
+        if (points[i].x >= 0 && points[i].x < sw->width){
+            k_SoftwareSpan(sw, points[i].x, points[i].x, points[i].y);
+        }
+    }
+}
+
+static void k_SoftwareDrawLines(void* ctx, const SDL_Point* points, int count){
+    k_SoftwareBackend* sw = (k_SoftwareBackend*)ctx;
+    if (sw->forward || !sw->pixels){
+        k_SdlDrawLines(NULL, points, count);
+        return;
+    }
+    for (int i = 0; i + 1 < count; i++){
+        // Bresenham, the end point of inner segments is left to the next one
+        int x = points[i].x, y = points[i].y;
+        int x2 = points[i + 1].x, y2 = points[i + 1].y;
+        int dx = abs(x2 - x), sx = x < x2 ? 1 : -1;
+        int dy = -abs(y2 - y), sy = y < y2 ? 1 : -1;
+        int err = dx + dy;
+        bool last = i + 2 == count;
+        while (true){
+            if (x == x2 && y == y2){
+                if (last && x >= 0 && x < sw->width){
+                    k_SoftwareSpan(sw, x, x, y);
+                }
+                break;
+            }
+            if (x >= 0 && x < sw->width){
+                k_SoftwareSpan(sw, x, x, y);
+            }
+            int e2 = 2 * err;
+            if (e2 >= dy){
+                err += dy;
+                x += sx;
+            }
+            if (e2 <= dx){
+                err += dx;
+                y += sy;
+            }
+        }
+    }
+}
+
+static void k_SoftwareFillRects(void* ctx, const SDL_Rect* rects, int count){
+    k_SoftwareBackend* sw = (k_SoftwareBackend*)ctx;
+    if (sw->forward || !sw->pixels){
+        k_SdlFillRects(NULL, rects, count);
+        return;
+    }
+    for (int i = 0; i < count; i++){
+        if (rects[i].w <= 0 || rects[i].h <= 0){
+            continue;
+        }
+        int y_end = SDL_min(rects[i].y + rects[i].h, sw->height);
+        for (int y = SDL_max(rects[i].y, 0); y < y_end; y++){
+            k_SoftwareSpan(sw, rects[i].x, rects[i].x + rects[i].w - 1, y);
+        }
+    }
+}
+
+static void k_SoftwareDrawRect(void* ctx, const SDL_Rect* rect){
+    k_SoftwareBackend* sw = (k_SoftwareBackend*)ctx;
+    if (sw->forward || !sw->pixels){
+        k_SdlDrawRect(NULL, rect);
+        return;
+    }
+    if (rect->w <= 0 || rect->h <= 0){
+        return;
+    }
+    SDL_Rect edges[4] = {
+        {rect->x, rect->y, rect->w, 1},
+        {rect->x, rect->y + rect->h - 1, rect->w, 1},
+        {rect->x, rect->y + 1, 1, rect->h - 2},
+        {rect->x + rect->w - 1, rect->y + 1, 1, rect->h - 2},
+    };
+    k_SoftwareFillRects(sw, edges, rect->h > 1 ? 4 : 1);
+}
+
+static void k_SoftwareCopyTexture(void* ctx, SDL_Texture* texture, const SDL_Rect* src, const SDL_Rect* dst){
+    k_SoftwareBackend* sw = (k_SoftwareBackend*)ctx;
+    if (!sw->forward){
+        k_SoftwareFlush(sw); // what was drawn so far goes under the copy
+    }
+    k_SdlCopyTexture(NULL, texture, src, dst);
+}
+
+static void k_SoftwareSetTarget(void* ctx, SDL_Texture* target, const SDL_Rect* viewport){
+    k_SoftwareBackend* sw = (k_SoftwareBackend*)ctx;
+    sw->forward = target != NULL;
+    k_SdlSetTarget(NULL, target, viewport);
+}
+
+static int k_SoftwarePresentFramebuffer(void* ctx, const Uint32* pixels, int width, int height){
+    k_SoftwareBackend* sw = (k_SoftwareBackend*)ctx;
+    if (!sw->pixels || width != sw->width || height != sw->height){
+        return k_SdlPresentFramebuffer(&sw->sdl, pixels, width, height);
+    }
+    for (size_t i = 0; i < (size_t)width * (size_t)height; i++){
+        Uint32 p = pixels[i];
+        if (p >> 24){
+            sw->pixels[i] = k_BlendPixel(sw->pixels[i], (Kitty_Color){(Uint8)(p >> 16), (Uint8)(p >> 8), (Uint8)p, (Uint8)(p >> 24)});
+        }
+    }
+    sw->dirty_x0 = 0;
+    sw->dirty_y0 = 0;
+    sw->dirty_x1 = width - 1;
+    sw->dirty_y1 = height - 1;
+    return KITTY_SUCCESS;
+}
+
+static int k_SoftwarePresent(void* ctx){
+    k_SoftwareBackend* sw = (k_SoftwareBackend*)ctx;
+    if (k_SoftwareFlush(sw) != KITTY_SUCCESS){
+        return KITTY_SDL_LOCK_TEXTURE_ERROR;
+    }
+    SDL_RenderPresent(sdl_renderer);
+    return KITTY_SUCCESS;
+}
+
+static int k_SoftwareReadBack(void* ctx, Uint32* pixels, int pitch){
+    k_SoftwareBackend* sw = (k_SoftwareBackend*)ctx;
+    int result = k_SdlReadBack(NULL, pixels, pitch);
+    if (result != KITTY_SUCCESS || !sw->pixels){
+        return result;
+    }
+    for (int y = 0; y < sw->height; y++){
+        Uint32* out = (Uint32*)((Uint8*)pixels + (size_t)y * pitch);
+        const Uint32* in = sw->pixels + (size_t)y * sw->width;
+        for (int x = 0; x < sw->width; x++){
+            Uint32 p = in[x];
+            if (p >> 24){
+                out[x] = k_BlendPixel(out[x] | 0xFF000000u, (Kitty_Color){(Uint8)(p >> 16), (Uint8)(p >> 8), (Uint8)p, (Uint8)(p >> 24)});
+            }
+        }
+    }
+    return KITTY_SUCCESS;
+}
+
+static void k_SoftwareDestroy(void* ctx){
+    k_SoftwareBackend* sw = (k_SoftwareBackend*)ctx;
+    k_Free(sw->pixels);
+    if (sw->texture){
+        k_DestroyTexture(sw->texture, KITTY_MEMORY_TEXTURES);
+    }
+    k_SdlDestroy(&sw->sdl);
+    *sw = (k_SoftwareBackend){0};
+}
+
+// Null backend: accepts everything and draws nothing
+
+static int k_NullBeginFrame(void* ctx){ (void)ctx; return KITTY_SUCCESS; }
+static void k_NullClear(void* ctx, Kitty_Color color){ (void)ctx; (void)color; }
+static void k_NullSetColor(void* ctx, Kitty_Color color){ (void)ctx; (void)color; }
+static void k_NullSetBlendMode(void* ctx, SDL_BlendMode mode){ (void)ctx; (void)mode; }
+static void k_NullDrawPoints(void* ctx, const SDL_Point* points, int count){ (void)ctx; (void)points; (void)count; }
+static void k_NullDrawLines(void* ctx, const SDL_Point* points, int count){ (void)ctx; (void)points; (void)count; }
+static void k_NullDrawRect(void* ctx, const SDL_Rect* rect){ (void)ctx; (void)rect; }
+static void k_NullFillRects(void* ctx, const SDL_Rect* rects, int count){ (void)ctx; (void)rects; (void)count; }
+static void k_NullCopyTexture(void* ctx, SDL_Texture* texture, const SDL_Rect* src, const SDL_Rect* dst){
+    (void)ctx; (void)texture; (void)src; (void)dst;
+}
+static void k_NullSetTarget(void* ctx, SDL_Texture* target, const SDL_Rect* viewport){ (void)ctx; (void)target; (void)viewport; }
+static int k_NullPresentFramebuffer(void* ctx, const Uint32* pixels, int width, int height){
+    (void)ctx; (void)pixels; (void)width; (void)height;
+    return KITTY_SUCCESS;
+}
+static int k_NullPresent(void* ctx){ (void)ctx; return KITTY_SUCCESS; }
+
+static int k_NullReadBack(void* ctx, Uint32* pixels, int pitch){
+    (void)ctx;
+    for (int y = 0; y < window_height; y++){
+        memset((Uint8*)pixels + (size_t)y * pitch, 0, (size_t)window_width * sizeof(Uint32));
+    }
+    return KITTY_SUCCESS;
+}
+
+static void k_GetBuiltinBackend(enum Kitty_BackendType type, Kitty_RenderBackend* out){
+    switch (type){
+        case KITTY_BACKEND_SOFTWARE:
+            *out = (Kitty_RenderBackend){"software", &k_software_backend, k_SoftwareBeginFrame, k_SoftwareClear,
+                k_SoftwareSetColor, k_SoftwareSetBlendMode, k_SoftwareDrawPoints, k_SoftwareDrawLines,
+                k_SoftwareDrawRect, k_SoftwareFillRects, k_SoftwareCopyTexture, k_SoftwareSetTarget,
+                k_SoftwarePresentFramebuffer, k_SoftwarePresent, k_SoftwareReadBack, k_SoftwareDestroy};
+            break;
+        case KITTY_BACKEND_NULL:
+            *out = (Kitty_RenderBackend){"null", NULL, k_NullBeginFrame, k_NullClear, k_NullSetColor,
+                k_NullSetBlendMode, k_NullDrawPoints, k_NullDrawLines, k_NullDrawRect, k_NullFillRects,
+                k_NullCopyTexture, k_NullSetTarget, k_NullPresentFramebuffer, k_NullPresent, k_NullReadBack, NULL};
+            break;
+        default:
+            *out = (Kitty_RenderBackend){"sdl", &k_sdl_backend, k_SdlBeginFrame, k_SdlClear, k_SdlSetColor,
+                k_SdlSetBlendMode, k_SdlDrawPoints, k_SdlDrawLines, k_SdlDrawRect, k_SdlFillRects,
+                k_SdlCopyTexture, k_SdlSetTarget, k_SdlPresentFramebuffer, k_SdlPresent, k_SdlReadBack, k_SdlDestroy};
+            break;
+    }
+}
+
+// SOFTWARE FRAMEBUFFER STUFF
+
+static int k_PrepareFramebuffer(){
+    if (k_fb_used){
+        return KITTY_SUCCESS;
+    }
+    if (k_fb_capacity_width != window_width || k_fb_capacity_height != window_height){
+        k_WaitFramebuffers();
+        k_DestroyFramebuffer();
+        k_fb_capacity_width = window_width;
+        k_fb_capacity_height = window_height;
+    }
+    // the previous frame in this slot is presented already, see k_PresentFramebuffer
+    k_Framebuffer* fb = &k_framebuffers[k_fb_sequence % k_frames_in_flight];
+    if (!fb->color){
+        size_t pixel_count = (size_t)window_width * (size_t)window_height;
+        fb->color = (Uint32*)k_Alloc(pixel_count * sizeof(Uint32), KITTY_MEMORY_FRAME);
+        fb->depth = (float*)k_Alloc(pixel_count * sizeof(float), KITTY_MEMORY_FRAME);
+        if (!fb->color || !fb->depth){
+            k_Free(fb->color);
+            k_Free(fb->depth);
+            fb->color = NULL;
+            fb->depth = NULL;
+            return KITTY_MEMORY_ALLOCATION_FAILURE;
+        }
+    }
+    // the scale only changes between frames
+    fb->width = SDL_max((int)ceilf(window_width * k_fb_scale), 1);
+    fb->height = SDL_max((int)ceilf(window_height * k_fb_scale), 1);
+    fb->draw_count = 0;
+    fb->used = true;
+    k_fb = fb;
+    k_fb_used = true;
+    return KITTY_SUCCESS;
+}
+
+static void k_SplatPointCloud(k_Framebuffer* fb, const k_PointCloudDraw* draw);
+
+///@brief Clears a framebuffer and splats its recorded draws; runs on the raster thread when frames are in flight.
+static void k_RasterizeFramebuffer(k_Framebuffer* fb){
+    if (!fb->used){
+        return;
+    }
+    double start = k_NowMs();
+    // transparent, so whatever the renderer drew shows through
+    size_t pixel_count = (size_t)fb->width * (size_t)fb->height;
+    memset(fb->color, 0, pixel_count * sizeof(Uint32));
+    for (size_t i = 0; i < pixel_count; i++){
+        fb->depth[i] = FLT_MAX;
+    }
+    for (size_t i = 0; i < fb->draw_count; i++){
+        k_SplatPointCloud(fb, &fb->draws[i]);
+    }
+    fb->raster_ms = k_NowMs() - start;
+}
+
+static int k_RasterMain(void* data){
+    (void)data;
+    SDL_LockMutex(k_raster_mutex);
+    for (;;){
+        while (k_raster_completed == k_raster_submitted && !k_raster_quit){
+            SDL_CondWait(k_raster_cond, k_raster_mutex);
+        }
+        if (k_raster_completed == k_raster_submitted){
+            break; // quit, with nothing left to draw
+        }
+        k_Framebuffer* fb = &k_framebuffers[k_raster_completed % k_frames_in_flight];
+        SDL_UnlockMutex(k_raster_mutex);
+
+        k_frame_scope++; // the raster thread only ever draws frames
+        k_RasterizeFramebuffer(fb);
+        k_frame_scope--;
+
+        SDL_LockMutex(k_raster_mutex);
+        k_raster_completed++;
+        SDL_CondBroadcast(k_raster_done_cond);
+    }
+    SDL_UnlockMutex(k_raster_mutex);
+    return 0;
+}
+
+static bool k_StartRasterThread(){
+    k_raster_mutex = SDL_CreateMutex();
+    k_raster_cond = SDL_CreateCond();
+    k_raster_done_cond = SDL_CreateCond();
+    k_raster_quit = false;
+    if (k_raster_mutex && k_raster_cond && k_raster_done_cond){
+        k_raster_thread = SDL_CreateThread(k_RasterMain, "kitty_raster", NULL);
+    }
+    if (!k_raster_thread){
+        k_StopRasterThread();
+        return false;
+    }
+    return true;
+}
+
+static void k_StopRasterThread(){
+    if (k_raster_thread){
+        SDL_LockMutex(k_raster_mutex);
+        k_raster_quit = true;
+        SDL_CondSignal(k_raster_cond);
+        SDL_UnlockMutex(k_raster_mutex);
+        SDL_WaitThread(k_raster_thread, NULL);
+        k_raster_thread = NULL;
+    }
+    if (k_raster_done_cond){
+        SDL_DestroyCond(k_raster_done_cond);
+        k_raster_done_cond = NULL;
+    }
+    if (k_raster_cond){
+        SDL_DestroyCond(k_raster_cond);
+        k_raster_cond = NULL;
+    }
+    if (k_raster_mutex){
+        SDL_DestroyMutex(k_raster_mutex);
+        k_raster_mutex = NULL;
+    }
+    // frames that were not presented yet are dropped
+    k_fb_sequence = 0;
+    k_fb_presented = 0;
+    k_raster_submitted = 0;
+    k_raster_completed = 0;
+    k_fb_used = false;
+    k_fb = NULL;
+}
+
+static void k_WaitFramebuffers(){
+    if (!k_raster_thread){
+        return; // without frames in flight everything is rasterized before Kitty_RenderObjects returns
+    }
+    SDL_LockMutex(k_raster_mutex);
+    while (k_raster_completed != k_raster_submitted){
+        SDL_CondWait(k_raster_done_cond, k_raster_mutex);
+    }
+    SDL_UnlockMutex(k_raster_mutex);
+}
+
+///@brief Hands the point clouds recorded this frame to the raster stage, rasterizing them right away without frames in flight.
+static void k_SubmitFramebuffer(){
+    if (!k_fb_used){
+        return; // no point cloud this frame, nothing to present either
+    }
+    k_Framebuffer* fb = k_fb;
+    k_fb_used = false;
+    k_fb = NULL;
+    k_fb_sequence++;
+    if (k_frames_in_flight > 1 && (k_raster_thread || k_StartRasterThread())){
+        SDL_LockMutex(k_raster_mutex);
+        k_raster_submitted++;
+        SDL_CondSignal(k_raster_cond);
+        SDL_UnlockMutex(k_raster_mutex);
+        return;
+    }
+    k_RasterizeFramebuffer(fb);
+    k_raster_completed = ++k_raster_submitted;
+}
+
+static void* k_GrowScratch(void** buffer, size_t* capacity, size_t size){
+    if (size > *capacity || !*buffer){
+        // the old contents are not needed, so skip realloc's copy
+        k_Free(*buffer);
+        *buffer = k_Alloc(size, KITTY_MEMORY_FRAME);
+        *capacity = *buffer ? size : 0;
+    }
+    return *buffer;
+}
+
+#define K_RESAMPLE_GRAIN 16
+
+// Fixed point (7 bit) source coordinates of each destination column and row
+typedef struct {
+    const Uint32* src;
+    Uint32* dst;
+    int* x0;
+    Uint8* fx;
+    Uint16* rows;               // one blended source row per band of K_RESAMPLE_GRAIN output rows
+    size_t row_stride;
+    int src_width;
+    int src_height;
+    int dst_width;
+    int dst_height;
+    enum Kitty_UpscaleFilter filter;
+} k_ResampleJob;
+
+static void k_ResampleRows(void* ctx, size_t begin, size_t end){
+    k_ResampleJob* job = (k_ResampleJob*)ctx;
+    float step_y = (float)job->src_height / (float)job->dst_height;
+#ifdef __SSE2__
+    Uint16* row = job->rows + begin / K_RESAMPLE_GRAIN * job->row_stride; // this band's blended source row
+#endif
+    for (size_t y = begin; y < end; y++){
+        Uint32* out = job->dst + y * (size_t)job->dst_width;
+        if (job->filter == KITTY_UPSCALE_NEAREST){
+            const Uint32* in = job->src + (size_t)SDL_min((int)(y * step_y), job->src_height - 1) * job->src_width;
+            for (int x = 0; x < job->dst_width; x++){
+                out[x] = in[job->x0[x]];
+            }
+            continue;
+        }
+
+        // sample at pixel centers, clamped at the edges
+        float sy = SDL_max(((float)y + 0.5f) * step_y - 0.5f, 0.0f);
+        int y0 = SDL_min((int)sy, job->src_height - 1);
+        int y1 = SDL_min(y0 + 1, job->src_height - 1);
+        int fy = (int)((sy - (float)y0) * 128.0f);
+        const Uint32* top = job->src + (size_t)y0 * job->src_width;
+        const Uint32* bottom = job->src + (size_t)y1 * job->src_width;
+#ifdef __SSE2__
+        // blend the two source rows once into 16 bit channels, then each output pixel
+        // loads its left and right neighbour from that row in a single 128 bit load
+        __m128i zero = _mm_setzero_si128();
+        __m128i wy = _mm_set1_epi16((short)fy);
+        int sx = 0;
+        for (; sx + 2 <= job->src_width; sx += 2){
+            __m128i t = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)&top[sx]), zero);
+            __m128i b = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)&bottom[sx]), zero);
+            __m128i v = _mm_add_epi16(t, _mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(b, t), wy), 7));
+            _mm_storeu_si128((__m128i*)&row[sx * 4], v);
+        }
+        for (; sx < job->src_width; sx++){
+            __m128i t = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int)top[sx]), zero);
+            __m128i b = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int)bottom[sx]), zero);
+            __m128i v = _mm_add_epi16(t, _mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(b, t), wy), 7));
+            _mm_storel_epi64((__m128i*)&row[sx * 4], v);
+        }
+        memcpy(&row[job->src_width * 4], &row[(job->src_width - 1) * 4], 4 * sizeof(Uint16)); // clamp the right edge
+
+        for (int x = 0; x < job->dst_width; x++){
+            __m128i v = _mm_loadu_si128((const __m128i*)&row[job->x0[x] * 4]);
+            __m128i right = _mm_srli_si128(v, 8);
+            __m128i h = _mm_add_epi16(v, _mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(right, v), _mm_set1_epi16(job->fx[x])), 7));
+            out[x] = (Uint32)_mm_cvtsi128_si32(_mm_packus_epi16(h, zero));
+        }
+#else
+        for (int x = 0; x < job->dst_width; x++){
+            int sx = job->x0[x];
+            int sx1 = SDL_min(sx + 1, job->src_width - 1);
+            int fx = job->fx[x];
+            Uint32 pixel = 0;
+            for (int shift = 0; shift < 32; shift += 8){
+                int t0 = (top[sx] >> shift) & 0xFF, t1 = (top[sx1] >> shift) & 0xFF;
+                int b0 = (bottom[sx] >> shift) & 0xFF, b1 = (bottom[sx1] >> shift) & 0xFF;
+                int left = t0 + (((b0 - t0) * fy) >> 7);
+                int right = t1 + (((b1 - t1) * fy) >> 7);
+                pixel |= (Uint32)(left + (((right - left) * fx) >> 7)) << shift;
+            }
+            out[x] = pixel;
+        }
+#endif
+    }
+}
+
+///@brief Resamples an image to another size; halving with the bilinear filter is an exact 2x2 box filter.
+static int k_ResampleImage(const Uint32* src, int src_width, int src_height, Uint32* dst, int dst_width, int dst_height,
+                           enum Kitty_UpscaleFilter filter){
+    size_t row_stride = ((size_t)src_width + 1) * 4;
+    size_t bands = ((size_t)dst_height + K_RESAMPLE_GRAIN - 1) / K_RESAMPLE_GRAIN;
+#ifndef __SSE2__
+    bands = 0; // the scalar path blends straight from the source rows
+#endif
+    Uint8* scratch = (Uint8*)k_GrowScratch(&k_resample_scratch, &k_resample_scratch_capacity,
+                                           (size_t)dst_width * (sizeof(int) + 1) + bands * row_stride * sizeof(Uint16));
+    if (!scratch){
+        return KITTY_MEMORY_ALLOCATION_FAILURE;
+    }
+    int* x0 = (int*)scratch;
+    Uint16* rows = (Uint16*)(x0 + dst_width);
+    Uint8* fx = (Uint8*)(rows + bands * row_stride);
+    float step_x = (float)src_width / (float)dst_width;
+    for (int x = 0; x < dst_width; x++){
+        if (filter == KITTY_UPSCALE_NEAREST){
+            x0[x] = SDL_min((int)(x * step_x), src_width - 1);
+            fx[x] = 0;
+        } else {
+            float sx = SDL_max(((float)x + 0.5f) * step_x - 0.5f, 0.0f);
+            x0[x] = SDL_min((int)sx, src_width - 1);
+            fx[x] = (Uint8)((sx - (float)x0[x]) * 128.0f);
+        }
+    }
+    k_ResampleJob job = {src, dst, x0, fx, rows, row_stride, src_width, src_height, dst_width, dst_height, filter};
+    k_ParallelFor((size_t)dst_height, K_RESAMPLE_GRAIN, k_ResampleRows, &job);
+    return KITTY_SUCCESS;
+}
+
+///@brief Resamples a scaled framebuffer to window size into k_fb_upscaled.
+static int k_UpscaleFramebuffer(const k_Framebuffer* fb){
+    if (!k_fb_upscaled){
+        k_fb_upscaled = (Uint32*)k_Alloc((size_t)k_fb_capacity_width * (size_t)k_fb_capacity_height * sizeof(Uint32), KITTY_MEMORY_FRAME);
+        if (!k_fb_upscaled){
+            return KITTY_MEMORY_ALLOCATION_FAILURE;
+        }
+    }
+    return k_ResampleImage(fb->color, fb->width, fb->height, k_fb_upscaled, k_fb_capacity_width, k_fb_capacity_height,
+                           k_dynamic_resolution.filter);
+}
+
+///@brief Steers k_fb_scale towards the budget; cost goes with pixel count, so with scale squared.
+static void k_UpdateResolutionScale(){
+    k_fb_last_raster_ms = k_fb_raster_ms;
+    k_fb_raster_ms = 0.0;
+    Kitty_DynamicResolution* dr = &k_dynamic_resolution;
+    if (!dr->enabled || k_fb_last_raster_ms <= 0.0){
+        return;
+    }
+    double error = (k_fb_last_raster_ms - dr->budget_ms) / dr->budget_ms;
+    if (fabs(error) <= dr->deadband){
+        return;
+    }
+    float target = k_fb_scale * sqrtf(dr->budget_ms / (float)k_fb_last_raster_ms);
+    float scale = k_fb_scale + (target - k_fb_scale) * dr->smoothing;
+    k_fb_scale = SDL_min(SDL_max(scale, dr->min_scale), dr->max_scale);
+}
+
+static int k_PresentFramebuffer(){
+    // fence: this frame's point clouds must be rasterized before they are shown with the rest of it
+    k_Framebuffer* fb = &k_framebuffers[k_fb_presented % k_frames_in_flight];
+    if (k_raster_thread){
+        double wait_start = k_NowMs();
+        SDL_LockMutex(k_raster_mutex);
+        while (k_raster_completed <= k_fb_presented){
+            SDL_CondWait(k_raster_done_cond, k_raster_mutex);
+        }
+        SDL_UnlockMutex(k_raster_mutex);
+        k_frame_stats.fence_wait_ms += k_NowMs() - wait_start;
+    }
+    k_fb_presented++;
+    if (!fb->used){
+        return KITTY_SUCCESS;
+    }
+    if (k_post_count > 0){
+        int post_result = k_RunPostChain(fb);
+        if (post_result != KITTY_SUCCESS){
+            return post_result;
+        }
+    }
+
+    const Uint32* pixels = fb->color;
+    if (fb->width != k_fb_capacity_width || fb->height != k_fb_capacity_height){
+        int upscale_result = k_UpscaleFramebuffer(fb);
+        if (upscale_result != KITTY_SUCCESS){
+            return upscale_result;
+        }
+        pixels = k_fb_upscaled;
+    }
+    k_fb_raster_ms += fb->raster_ms;
+    k_UpdateResolutionScale();
+    return k_backend->present_framebuffer(k_backend->user_data, pixels, k_fb_capacity_width, k_fb_capacity_height);
+}
+
+static void k_DestroyFramebuffer(){
+    for (int i = 0; i < KITTY_MAX_FRAMES_IN_FLIGHT; i++){
+        k_Free(k_framebuffers[i].color);
+        k_Free(k_framebuffers[i].depth);
+        k_Free(k_framebuffers[i].draws);
+        k_framebuffers[i] = (k_Framebuffer){0};
+    }
+    k_Free(k_fb_upscaled);
+    k_fb_upscaled = NULL;
+    for (int i = 0; i < K_POST_MAX_LEVELS; i++){
+        k_Free(k_post_levels[i]);
+        k_post_levels[i] = NULL;
+        k_post_level_capacity[i] = 0;
+    }
+    k_Free(k_post_scratch);
+    k_post_scratch = NULL;
+    k_post_scratch_capacity = 0;
+    k_Free(k_post_column_sums);
+    k_post_column_sums = NULL;
+    k_post_column_sums_capacity = 0;
+    k_Free(k_resample_scratch);
+    k_resample_scratch = NULL;
+    k_resample_scratch_capacity = 0;
+    k_fb_capacity_width = 0;
+    k_fb_capacity_height = 0;
+    k_fb_used = false;
+    k_fb = NULL;
+}
+
+static double k_NowMs(){
+    return (double)SDL_GetPerformanceCounter() * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+///@brief Maps a window position into a framebuffer rendered at scale.
+static inline Kitty_Point3D k_FramebufferPosition(Kitty_Point3D position, float scale){
+    return (Kitty_Point3D){(int)lroundf(position.x * scale), (int)lroundf(position.y * scale), position.z};
+}
+
+static inline Uint32 k_PackColor(Kitty_Color color){
+    return ((Uint32)color.a << 24) | ((Uint32)color.r << 16) | ((Uint32)color.g << 8) | (Uint32)color.b;
+}
+
+///@brief Vertex stage for SoA positions: perspective projects n points to screen space.
+///@param out_depth View depth of each point; points closer than K_NEAR_PLANE must be skipped.
+static void k_ProjectPointsSoA(const float* restrict x, const float* restrict y, const float* restrict z, size_t n,
+                               Kitty_Point3D position, float scale,
+                               float* restrict out_x, float* restrict out_y, float* restrict out_depth){
+    size_t i = 0;
+#ifdef __SSE2__
+    __m128 dist_scale = _mm_set1_ps(K_PROJECTION_DISTANCE * scale);
+    __m128 offset_z = _mm_set1_ps(K_PROJECTION_DISTANCE - (float)position.z);
+    __m128 pos_x = _mm_set1_ps((float)position.x);
+    __m128 pos_y = _mm_set1_ps((float)position.y);
+    for (; i + 4 <= n; i += 4){
+        __m128 depth = _mm_add_ps(_mm_loadu_ps(&z[i]), offset_z);
+        __m128 persp = _mm_div_ps(dist_scale, depth);
+        _mm_storeu_ps(&out_x[i], _mm_add_ps(pos_x, _mm_mul_ps(_mm_loadu_ps(&x[i]), persp)));
+        _mm_storeu_ps(&out_y[i], _mm_add_ps(pos_y, _mm_mul_ps(_mm_loadu_ps(&y[i]), persp)));
+        _mm_storeu_ps(&out_depth[i], depth);
+    }
+#endif
+    for (; i < n; i++){
+        float depth = z[i] + K_PROJECTION_DISTANCE - (float)position.z;
+        float persp = K_PROJECTION_DISTANCE * scale / depth;
+        out_x[i] = (float)position.x + x[i] * persp;
+        out_y[i] = (float)position.y + y[i] * persp;
+        out_depth[i] = depth;
+    }
+}
+
+// POST PROCESSING STUFF
+
+typedef struct {
+    Uint32* pixels;
+    int width;
+    int height;
+} k_PostImage;
+
+typedef struct {
+    const Uint32* src;
+    Uint32* dst;
+    int width;
+    int height;
+    int radius;
+    const Kitty_ColorLUT* lut;
+    void* column_sums;          // k_ChannelSum rows for the vertical blur, one per band of K_BLUR_GRAIN rows
+} k_PostJob;
+
+#define K_BLUR_GRAIN 32
+
+// Running per channel sums of ARGB8888 pixels for the sliding window blurs
+#ifdef __SSE2__
+typedef __m128i k_ChannelSum;
+
+static inline k_ChannelSum k_SumZero(){
+    return _mm_setzero_si128();
+}
+
+static inline k_ChannelSum k_SumAdd(k_ChannelSum sum, Uint32 pixel){
+    __m128i zero = _mm_setzero_si128();
+    return _mm_add_epi32(sum, _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128((int)pixel), zero), zero));
+}
+
+static inline k_ChannelSum k_SumSub(k_ChannelSum sum, Uint32 pixel){
+    __m128i zero = _mm_setzero_si128();
+    return _mm_sub_epi32(sum, _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128((int)pixel), zero), zero));
+}
+
+static inline Uint32 k_SumAverage(k_ChannelSum sum, float inv){
+    __m128i average = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(sum), _mm_set1_ps(inv)));
+    average = _mm_packs_epi32(average, average);
+    return (Uint32)_mm_cvtsi128_si32(_mm_packus_epi16(average, average));
+}
+#else
+typedef struct {
+    int c[4];
+} k_ChannelSum;
+
+static inline k_ChannelSum k_SumZero(){
+    return (k_ChannelSum){{0, 0, 0, 0}};
+}
+
+static inline k_ChannelSum k_SumAdd(k_ChannelSum sum, Uint32 pixel){
+    for (int i = 0; i < 4; i++){
+        sum.c[i] += (pixel >> (i * 8)) & 0xFF;
+    }
+    return sum;
+}
+
+static inline k_ChannelSum k_SumSub(k_ChannelSum sum, Uint32 pixel){
+    for (int i = 0; i < 4; i++){
+        sum.c[i] -= (pixel >> (i * 8)) & 0xFF;
+    }
+    return sum;
+}
+
+static inline Uint32 k_SumAverage(k_ChannelSum sum, float inv){
+    Uint32 pixel = 0;
+    for (int i = 0; i < 4; i++){
+        pixel |= (Uint32)SDL_min(lroundf((float)sum.c[i] * inv), 255) << (i * 8);
+    }
+    return pixel;
+}
+#endif
+
+///@brief Horizontal box pass: one add and one subtract per pixel whatever the radius, edges clamped.
+static void k_BoxBlurRows(void* ctx, size_t begin, size_t end){
+    k_PostJob* job = (k_PostJob*)ctx;
+    int w = job->width;
+    int r = job->radius;
+    float inv = 1.0f / (float)(2 * r + 1);
+    for (size_t y = begin; y < end; y++){
+        const Uint32* in = job->src + y * (size_t)w;
+        Uint32* out = job->dst + y * (size_t)w;
+        k_ChannelSum sum = k_SumZero();
+        for (int k = -r; k <= r; k++){
+            sum = k_SumAdd(sum, in[SDL_min(SDL_max(k, 0), w - 1)]);
+        }
+        for (int x = 0; x < w; x++){
+            out[x] = k_SumAverage(sum, inv);
+            sum = k_SumAdd(sum, in[SDL_min(x + r + 1, w - 1)]);
+            sum = k_SumSub(sum, in[SDL_max(x - r, 0)]);
+        }
+    }
+}
+
+///@brief Vertical box pass over a band of rows, keeping a running sum per column so memory is read row by row.
+static void k_BoxBlurColumns(void* ctx, size_t begin, size_t end){
+    k_PostJob* job = (k_PostJob*)ctx;
+    int w = job->width;
+    int h = job->height;
+    int r = job->radius;
+    float inv = 1.0f / (float)(2 * r + 1);
+    k_ChannelSum* sums = (k_ChannelSum*)job->column_sums + begin / K_BLUR_GRAIN * (size_t)w;
+    for (int x = 0; x < w; x++){
+        sums[x] = k_SumZero();
+    }
+    for (int k = -r; k <= r; k++){
+        const Uint32* row = job->src + (size_t)SDL_min(SDL_max((int)begin + k, 0), h - 1) * w;
+        for (int x = 0; x < w; x++){
+            sums[x] = k_SumAdd(sums[x], row[x]);
+        }
+    }
+    for (size_t y = begin; y < end; y++){
+        Uint32* out = job->dst + y * (size_t)w;
+        const Uint32* add = job->src + (size_t)SDL_min((int)y + r + 1, h - 1) * w;
+        const Uint32* sub = job->src + (size_t)SDL_max((int)y - r, 0) * w;
+        for (int x = 0; x < w; x++){
+            out[x] = k_SumAverage(sums[x], inv);
+            sums[x] = k_SumSub(k_SumAdd(sums[x], add[x]), sub[x]);
+        }
+    }
+}
+
+static int k_BoxBlur(k_PostImage* image, int radius){
+    size_t bands = ((size_t)image->height + K_BLUR_GRAIN - 1) / K_BLUR_GRAIN;
+    void* sums = k_GrowScratch(&k_post_column_sums, &k_post_column_sums_capacity, bands * (size_t)image->width * sizeof(k_ChannelSum));
+    if (!sums){
+        return KITTY_MEMORY_ALLOCATION_FAILURE;
+    }
+    k_PostJob job = {image->pixels, k_post_scratch, image->width, image->height, radius, NULL, sums};
+    k_ParallelFor((size_t)image->height, 16, k_BoxBlurRows, &job);
+    job.src = k_post_scratch;
+    job.dst = image->pixels;
+    k_ParallelFor((size_t)image->height, K_BLUR_GRAIN, k_BoxBlurColumns, &job);
+    return KITTY_SUCCESS;
+}
+
+///@brief Three box blurs whose variances add up to sigma squared.
+static int k_GaussianBlur(k_PostImage* image, int sigma){
+    float ideal = sqrtf(12.0f * sigma * sigma / 3.0f + 1.0f);
+    int lower = (int)ideal;
+    if (lower % 2 == 0){
+        lower--;
+    }
+    int upper = lower + 2;
+    int lower_count = (int)lroundf((12.0f * sigma * sigma - 3.0f * lower * lower - 12.0f * lower - 9.0f) / (-4.0f * lower - 4.0f));
+    for (int i = 0; i < 3; i++){
+        int size = i < lower_count ? lower : upper;
+        int result = size > 1 ? k_BoxBlur(image, size / 2) : KITTY_SUCCESS;
+        if (result != KITTY_SUCCESS){
+            return result;
+        }
+    }
+    return KITTY_SUCCESS;
+}
+
+static inline Uint32 k_Premultiply(Uint32 p){
+    Uint32 a = p >> 24;
+    if (a == 255){
+        return p;
+    }
+    Uint32 r = ((p >> 16) & 0xFF) * a / 255;
+    Uint32 g = ((p >> 8) & 0xFF) * a / 255;
+    Uint32 b = (p & 0xFF) * a / 255;
+    return (a << 24) | (r << 16) | (g << 8) | b;
+}
+
+///@brief Blurs and resamples work on premultiplied colors, so transparent pixels do not darken the edges.
+static void k_PremultiplyRows(void* ctx, size_t begin, size_t end){
+    k_PostJob* job = (k_PostJob*)ctx;
+    for (size_t i = begin * job->width; i < end * job->width; i++){
+        job->dst[i] = k_Premultiply(job->dst[i]);
+    }
+}
+
+static inline Uint32 k_Unpremultiply(Uint32 p){
+    Uint32 a = p >> 24;
+    if (a == 255 || a == 0){
+        return a ? p : 0;
+    }
+    Uint32 r = SDL_min(((p >> 16) & 0xFF) * 255 / a, 255u);
+    Uint32 g = SDL_min(((p >> 8) & 0xFF) * 255 / a, 255u);
+    Uint32 b = SDL_min((p & 0xFF) * 255 / a, 255u);
+    return (a << 24) | (r << 16) | (g << 8) | b;
+}
+
+static void k_UnpremultiplyRows(void* ctx, size_t begin, size_t end){
+    k_PostJob* job = (k_PostJob*)ctx;
+    for (size_t i = begin * job->width; i < end * job->width; i++){
+        job->dst[i] = k_Unpremultiply(job->dst[i]);
+    }
+}
+
+///@brief Trilinear lookup of an opaque color, alpha is passed through.
+static inline Uint32 k_LookupColor(const Kitty_ColorLUT* lut, Uint32 p){
+    int n = lut->size - 1;
+    int pr = (int)((p >> 16) & 0xFF) * n;
+    int pg = (int)((p >> 8) & 0xFF) * n;
+    int pb = (int)(p & 0xFF) * n;
+    int r0 = pr / 255, g0 = pg / 255, b0 = pb / 255;
+    int fr = (pr - r0 * 255) * 128 / 255;
+    int fg = (pg - g0 * 255) * 128 / 255;
+    int fb = (pb - b0 * 255) * 128 / 255;
+    int r1 = SDL_min(r0 + 1, n);
+    size_t g0o = (size_t)g0 * lut->size, g1o = (size_t)SDL_min(g0 + 1, n) * lut->size;
+    size_t b0o = (size_t)b0 * lut->size * lut->size, b1o = (size_t)SDL_min(b0 + 1, n) * lut->size * lut->size;
+    const Uint32* e = lut->entries;
+#ifdef __SSE2__
+    // the four green/blue corners at r0 and at r1, two pixels per register in 16 bit lanes
+    __m128i zero = _mm_setzero_si128();
+    __m128i lo = _mm_set_epi32((int)e[r0 + g1o + b1o], (int)e[r0 + g0o + b1o], (int)e[r0 + g1o + b0o], (int)e[r0 + g0o + b0o]);
+    __m128i hi = _mm_set_epi32((int)e[r1 + g1o + b1o], (int)e[r1 + g0o + b1o], (int)e[r1 + g1o + b0o], (int)e[r1 + g0o + b0o]);
+    __m128i wr = _mm_set1_epi16((short)fr);
+    __m128i l01 = _mm_unpacklo_epi8(lo, zero), l23 = _mm_unpackhi_epi8(lo, zero);
+    __m128i h01 = _mm_unpacklo_epi8(hi, zero), h23 = _mm_unpackhi_epi8(hi, zero);
+    __m128i x01 = _mm_add_epi16(l01, _mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(h01, l01), wr), 7));
+    __m128i x23 = _mm_add_epi16(l23, _mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(h23, l23), wr), 7));
+    __m128i yb = _mm_add_epi16(x01, _mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(x23, x01), _mm_set1_epi16((short)fb)), 7));
+    __m128i zg = _mm_add_epi16(yb, _mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(_mm_srli_si128(yb, 8), yb), _mm_set1_epi16((short)fg)), 7));
+    Uint32 color = (Uint32)_mm_cvtsi128_si32(_mm_packus_epi16(zg, zero));
+#else
+    Uint32 corners[8] = {
+        e[r0 + g0o + b0o], e[r1 + g0o + b0o], e[r0 + g1o + b0o], e[r1 + g1o + b0o],
+        e[r0 + g0o + b1o], e[r1 + g0o + b1o], e[r0 + g1o + b1o], e[r1 + g1o + b1o]
+    };
+    Uint32 color = 0;
+    for (int shift = 0; shift < 24; shift += 8){
+        int c[8];
+        for (int i = 0; i < 8; i++){
+            c[i] = (corners[i] >> shift) & 0xFF;
+        }
+        int x0 = c[0] + (((c[1] - c[0]) * fr) >> 7), x1 = c[2] + (((c[3] - c[2]) * fr) >> 7);
+        int x2 = c[4] + (((c[5] - c[4]) * fr) >> 7), x3 = c[6] + (((c[7] - c[6]) * fr) >> 7);
+        int y0 = x0 + (((x2 - x0) * fb) >> 7), y1 = x1 + (((x3 - x1) * fb) >> 7);
+        color |= (Uint32)(y0 + (((y1 - y0) * fg) >> 7)) << shift;
+    }
+#endif
+    return (color & 0x00FFFFFFu) | (p & 0xFF000000u);
+}
+
+static void k_ColorLUTRows(void* ctx, size_t begin, size_t end){
+    k_PostJob* job = (k_PostJob*)ctx;
+    for (size_t i = begin * job->width; i < end * job->width; i++){
+        Uint32 p = job->dst[i];
+        Uint32 a = p >> 24;
+        if (a == 255){
+            job->dst[i] = k_LookupColor(job->lut, p);
+        } else if (a != 0){
+            // graded as straight color, the chain stays premultiplied
+            job->dst[i] = k_Premultiply(k_LookupColor(job->lut, k_Unpremultiply(p)));
+        }
+    }
+}
+
+static int k_RunPostChain(k_Framebuffer* fb){
+    double start = k_NowMs();
+
+    // every buffer is allocated up front, a failure leaves the frame untouched
+    size_t pixel_count = (size_t)fb->width * (size_t)fb->height;
+    if (k_post_scratch_capacity < pixel_count){
+        Uint32* scratch = (Uint32*)k_Realloc(k_post_scratch, pixel_count * sizeof(Uint32), KITTY_MEMORY_FRAME);
+        if (!scratch){
+            return KITTY_MEMORY_ALLOCATION_FAILURE;
+        }
+        k_post_scratch = scratch;
+        k_post_scratch_capacity = pixel_count;
+    }
+    k_PostImage levels[K_POST_MAX_LEVELS + 1];
+    levels[0] = (k_PostImage){fb->color, fb->width, fb->height};
+    int depth = 0;
+    for (size_t i = 0; i < k_post_count; i++){
+        if (k_post_chain[i].type == KITTY_POST_UPSAMPLE){
+            depth--;
+        } else if (k_post_chain[i].type == KITTY_POST_DOWNSAMPLE){
+            k_PostImage* above = &levels[depth++];
+            levels[depth] = (k_PostImage){NULL, SDL_max((above->width + 1) / 2, 1), SDL_max((above->height + 1) / 2, 1)};
+            size_t count = (size_t)levels[depth].width * (size_t)levels[depth].height;
+            if (k_post_level_capacity[depth - 1] < count){
+                Uint32* level = (Uint32*)k_Realloc(k_post_levels[depth - 1], count * sizeof(Uint32), KITTY_MEMORY_FRAME);
+                if (!level){
+                    return KITTY_MEMORY_ALLOCATION_FAILURE;
+                }
+                k_post_levels[depth - 1] = level;
+                k_post_level_capacity[depth - 1] = count;
+            }
+        }
+    }
+    for (int i = 1; i <= K_POST_MAX_LEVELS; i++){
+        levels[i].pixels = k_post_levels[i - 1];
+    }
+
+    k_PostJob job = {NULL, fb->color, fb->width, fb->height, 0, NULL, NULL};
+    k_ParallelFor((size_t)fb->height, 64, k_PremultiplyRows, &job);
+    int result = KITTY_SUCCESS;
+    depth = 0;
+    for (size_t i = 0; i < k_post_count && result == KITTY_SUCCESS; i++){
+        const Kitty_PostEffect* effect = &k_post_chain[i];
+        k_PostImage* image = &levels[depth];
+        switch (effect->type){
+            case KITTY_POST_BOX_BLUR:
+                result = k_BoxBlur(image, effect->radius);
+                break;
+            case KITTY_POST_GAUSSIAN_BLUR:
+                result = k_GaussianBlur(image, effect->radius);
+                break;
+            case KITTY_POST_COLOR_LUT:
+                job = (k_PostJob){NULL, image->pixels, image->width, image->height, 0, effect->lut, NULL};
+                k_ParallelFor((size_t)image->height, 32, k_ColorLUTRows, &job);
+                break;
+            case KITTY_POST_DOWNSAMPLE:
+                depth++;
+                result = k_ResampleImage(image->pixels, image->width, image->height,
+                                         levels[depth].pixels, levels[depth].width, levels[depth].height, KITTY_UPSCALE_BILINEAR);
+                break;
+            case KITTY_POST_UPSAMPLE:
+                depth--;
+                result = k_ResampleImage(image->pixels, image->width, image->height,
+                                         levels[depth].pixels, levels[depth].width, levels[depth].height, KITTY_UPSCALE_BILINEAR);
+                break;
+        }
+    }
+    for (; depth > 0 && result == KITTY_SUCCESS; depth--){
+        result = k_ResampleImage(levels[depth].pixels, levels[depth].width, levels[depth].height,
+                                 levels[depth - 1].pixels, levels[depth - 1].width, levels[depth - 1].height, KITTY_UPSCALE_BILINEAR);
+    }
+    job = (k_PostJob){NULL, fb->color, fb->width, fb->height, 0, NULL, NULL};
+    k_ParallelFor((size_t)fb->height, 64, k_UnpremultiplyRows, &job);
+    k_frame_stats.post_ms += k_NowMs() - start;
+    return result;
+}
+
+// POINT CLOUD STUFF
+
+static const size_t K_POINT_CLOUD_LEAF_SIZE = 2048;
+static const int K_POINT_CLOUD_MAX_DEPTH = 12;
+#define K_POINT_BATCH 256
+
+static int k_PointCloudPushNode(Kitty_ObjPointCloud* cloud, size_t* capacity){
+    if (cloud->node_count == *capacity){
+        size_t new_capacity = SDL_max(*capacity * 2, (size_t)64);
+        Kitty_PointCloudNode* new_nodes = (Kitty_PointCloudNode*)k_Realloc(cloud->nodes, new_capacity * sizeof(Kitty_PointCloudNode), KITTY_MEMORY_POINT_CLOUDS);
+        if (!new_nodes){
+            return -1;
+        }
+        cloud->nodes = new_nodes;
+        *capacity = new_capacity;
+    }
+    return (int)cloud->node_count++;
+}
+
+///@brief Recursively partitions order[first, first + count) by octant and emits the nodes.
+static int k_BuildPointCloudNode(Kitty_ObjPointCloud* cloud, size_t* node_capacity, const Kitty_Vertex3D* positions,
+                                 size_t* order, size_t* scratch, size_t first, size_t count,
+                                 Kitty_Vertex3D min, Kitty_Vertex3D max, int depth, Uint32* rng){
+    int index = k_PointCloudPushNode(cloud, node_capacity);
+    if (index < 0){
+        return -1;
+    }
+    Kitty_PointCloudNode* node = &cloud->nodes[index];
+    node->min = min;
+    node->max = max;
+    node->first = first;
+    node->count = count;
+    node->leaf = count <= K_POINT_CLOUD_LEAF_SIZE || depth >= K_POINT_CLOUD_MAX_DEPTH;
+    for (int c = 0; c < 8; c++){
+        node->children[c] = -1;
+    }
+
+    if (node->leaf){
+        // shuffle so any stride through the leaf is an even subsample for LOD; xorshift32 keeps rand() untouched
+        for (size_t i = count; i > 1; i--){
+            *rng ^= *rng << 13;
+            *rng ^= *rng >> 17;
+            *rng ^= *rng << 5;
+            size_t j = (size_t)*rng % i;
+            size_t t = order[first + i - 1];
+            order[first + i - 1] = order[first + j];
+            order[first + j] = t;
+        }
+        return index;
+    }
+
+    Kitty_Vertex3D center = {(min.x + max.x) * 0.5f, (min.y + max.y) * 0.5f, (min.z + max.z) * 0.5f};
+    size_t counts[8] = {0};
+    for (size_t i = first; i < first + count; i++){
+        Kitty_Vertex3D p = positions[order[i]];
+        counts[(p.x >= center.x) | ((p.y >= center.y) << 1) | ((p.z >= center.z) << 2)]++;
+    }
+    size_t offsets[8];
+    size_t running = first;
+    for (int c = 0; c < 8; c++){
+        offsets[c] = running;
+        running += counts[c];
+    }
+    size_t starts[8];
+    memcpy(starts, offsets, sizeof(starts));
+    for (size_t i = first; i < first + count; i++){
+        Kitty_Vertex3D p = positions[order[i]];
+        scratch[offsets[(p.x >= center.x) | ((p.y >= center.y) << 1) | ((p.z >= center.z) << 2)]++] = order[i];
+    }
+    memcpy(&order[first], &scratch[first], count * sizeof(size_t));
+
+    for (int c = 0; c < 8; c++){
+        if (counts[c] == 0){
+            continue;
+        }
+        Kitty_Vertex3D child_min = {(c & 1) ? center.x : min.x, (c & 2) ? center.y : min.y, (c & 4) ? center.z : min.z};
+        Kitty_Vertex3D child_max = {(c & 1) ? max.x : center.x, (c & 2) ? max.y : center.y, (c & 4) ? max.z : center.z};
+        int child = k_BuildPointCloudNode(cloud, node_capacity, positions, order, scratch, starts[c], counts[c], child_min, child_max, depth + 1, rng);
+        if (child < 0){
+            return -1;
+        }
+        cloud->nodes[index].children[c] = child; // nodes may have moved, index again
+    }
+    return index;
+}
+
+///@brief Builds the octree and fills the SoA arrays in octree order.
+static int k_BuildPointCloud(Kitty_ObjPointCloud* cloud, const Kitty_Vertex3D* positions, const Kitty_Color* colors){
+    size_t count = cloud->point_count;
+    Kitty_Vertex3D min = positions[0];
+    Kitty_Vertex3D max = positions[0];
+    for (size_t i = 1; i < count; i++){
+        min.x = SDL_min(min.x, positions[i].x); max.x = SDL_max(max.x, positions[i].x);
+        min.y = SDL_min(min.y, positions[i].y); max.y = SDL_max(max.y, positions[i].y);
+        min.z = SDL_min(min.z, positions[i].z); max.z = SDL_max(max.z, positions[i].z);
+    }
+    cloud->bounds_min = min;
+    cloud->bounds_max = max;
+
+    size_t* order = (size_t*)k_Alloc(count * sizeof(size_t), KITTY_MEMORY_POINT_CLOUDS);
+    size_t* scratch = (size_t*)k_Alloc(count * sizeof(size_t), KITTY_MEMORY_POINT_CLOUDS);
+    if (!order || !scratch){
+        k_Free(order);
+        k_Free(scratch);
+        return KITTY_MEMORY_ALLOCATION_FAILURE;
+    }
+    for (size_t i = 0; i < count; i++){
+        order[i] = i;
+    }
+    size_t node_capacity = 0;
+    Uint32 rng = 0x9E3779B9u; // fixed seed, the same points always build the same cloud
+    int root = k_BuildPointCloudNode(cloud, &node_capacity, positions, order, scratch, 0, count, min, max, 0, &rng);
+    k_Free(scratch);
+    if (root < 0){
+        k_Free(order);
+        return KITTY_MEMORY_ALLOCATION_FAILURE;
+    }
+
+    cloud->colors = (Uint32*)k_Alloc(count * sizeof(Uint32), KITTY_MEMORY_POINT_CLOUDS);
+    if (cloud->quantized){
+        cloud->qx = (Uint16*)k_Alloc(count * sizeof(Uint16), KITTY_MEMORY_POINT_CLOUDS);
+        cloud->qy = (Uint16*)k_Alloc(count * sizeof(Uint16), KITTY_MEMORY_POINT_CLOUDS);
+        cloud->qz = (Uint16*)k_Alloc(count * sizeof(Uint16), KITTY_MEMORY_POINT_CLOUDS);
+    } else {
+        cloud->x = (float*)k_Alloc(count * sizeof(float), KITTY_MEMORY_POINT_CLOUDS);
+        cloud->y = (float*)k_Alloc(count * sizeof(float), KITTY_MEMORY_POINT_CLOUDS);
+        cloud->z = (float*)k_Alloc(count * sizeof(float), KITTY_MEMORY_POINT_CLOUDS);
+    }
+    if (!cloud->colors || (cloud->quantized ? (!cloud->qx || !cloud->qy || !cloud->qz) : (!cloud->x || !cloud->y || !cloud->z))){
+        k_Free(order);
+        return KITTY_MEMORY_ALLOCATION_FAILURE;
+    }
+
+    Kitty_Vertex3D extent = {max.x - min.x, max.y - min.y, max.z - min.z};
+    Kitty_Vertex3D inv = {
+        extent.x > 0 ? 65535.0f / extent.x : 0.0f,
+        extent.y > 0 ? 65535.0f / extent.y : 0.0f,
+        extent.z > 0 ? 65535.0f / extent.z : 0.0f
+    };
+    for (size_t i = 0; i < count; i++){
+        Kitty_Vertex3D p = positions[order[i]];
+        cloud->colors[i] = k_PackColor(colors ? colors[order[i]] : (Kitty_Color){255, 255, 255, 255});
+        if (cloud->quantized){
+            cloud->qx[i] = (Uint16)lroundf((p.x - min.x) * inv.x);
+            cloud->qy[i] = (Uint16)lroundf((p.y - min.y) * inv.y);
+            cloud->qz[i] = (Uint16)lroundf((p.z - min.z) * inv.z);
+        } else {
+            cloud->x[i] = p.x;
+            cloud->y[i] = p.y;
+            cloud->z[i] = p.z;
+        }
+    }
+    k_Free(order);
+    return KITTY_SUCCESS;
+}
+
+///@brief Projects and splats every stride-th point of [first, first + count) with a depth test.
+static void k_SplatPointRange(k_Framebuffer* fb, const k_PointCloudDraw* draw, size_t first, size_t count, size_t stride){
+    Kitty_ObjPointCloud* cloud = draw->cloud;
+    float bx[K_POINT_BATCH], by[K_POINT_BATCH], bz[K_POINT_BATCH];
+    float sx[K_POINT_BATCH], sy[K_POINT_BATCH], sd[K_POINT_BATCH];
+    Uint32 bc[K_POINT_BATCH];
+    Kitty_Vertex3D step = {
+        (cloud->bounds_max.x - cloud->bounds_min.x) / 65535.0f,
+        (cloud->bounds_max.y - cloud->bounds_min.y) / 65535.0f,
+        (cloud->bounds_max.z - cloud->bounds_min.z) / 65535.0f
+    };
+    int size = SDL_max((int)lroundf(draw->splat), 1);
+    int half = size / 2;
+
+    size_t i = first;
+    size_t end = first + count;
+    while (i < end){
+        // gather a batch into SoA scratch (dequantizing if needed)
+        size_t n = 0;
+        for (; n < K_POINT_BATCH && i < end; n++, i += stride){
+            if (cloud->quantized){
+                bx[n] = cloud->bounds_min.x + cloud->qx[i] * step.x;
+                by[n] = cloud->bounds_min.y + cloud->qy[i] * step.y;
+                bz[n] = cloud->bounds_min.z + cloud->qz[i] * step.z;
+            } else {
+                bx[n] = cloud->x[i];
+                by[n] = cloud->y[i];
+                bz[n] = cloud->z[i];
+            }
+            bc[n] = cloud->colors[i];
+        }
+
+        k_ProjectPointsSoA(bx, by, bz, n, draw->position, draw->scale, sx, sy, sd);
+
+        for (size_t p = 0; p < n; p++){
+            float depth = sd[p];
+            if (depth < K_NEAR_PLANE){
+                continue;
+            }
+            // far points can project outside the int range, reject them before converting
+            if (!(sx[p] > -size && sx[p] < fb->width + size && sy[p] > -size && sy[p] < fb->height + size)){
+                continue;
+            }
+            int x0 = (int)sx[p] - half;
+            int y0 = (int)sy[p] - half;
+            int x1 = SDL_min(x0 + size, fb->width);
+            int y1 = SDL_min(y0 + size, fb->height);
+            x0 = SDL_max(x0, 0);
+            y0 = SDL_max(y0, 0);
+            for (int y = y0; y < y1; y++){
+                size_t row = (size_t)y * fb->width;
+                for (int x = x0; x < x1; x++){
+                    if (depth < fb->depth[row + x]){
+                        fb->depth[row + x] = depth;
+                        fb->color[row + x] = bc[p];
+                    }
+                }
+            }
+        }
+        cloud->points_drawn += n;
+    }
+}
+
+static void k_RenderPointCloudNode(k_Framebuffer* fb, const k_PointCloudDraw* draw, int index, float lod_bias){
+    Kitty_ObjPointCloud* cloud = draw->cloud;
+    Kitty_PointCloudNode* node = &cloud->nodes[index];
+
+    // screen bounds of the node's box; the projection is monotonic per axis so corners suffice
+    float corners_x[8], corners_y[8], corners_z[8];
+    float px[8], py[8], pd[8];
+    for (int c = 0; c < 8; c++){
+        corners_x[c] = (c & 1) ? node->max.x : node->min.x;
+        corners_y[c] = (c & 2) ? node->max.y : node->min.y;
+        corners_z[c] = (c & 4) ? node->max.z : node->min.z;
+    }
+    k_ProjectPointsSoA(corners_x, corners_y, corners_z, 8, draw->position, draw->scale, px, py, pd);
+
+    int behind = 0;
+    float min_x = FLT_MAX, min_y = FLT_MAX, max_x = -FLT_MAX, max_y = -FLT_MAX;
+    for (int c = 0; c < 8; c++){
+        if (pd[c] < K_NEAR_PLANE){
+            behind++;
+            continue;
+        }
+        min_x = SDL_min(min_x, px[c]); max_x = SDL_max(max_x, px[c]);
+        min_y = SDL_min(min_y, py[c]); max_y = SDL_max(max_y, py[c]);
+    }
+    if (behind == 8){
+        return; // entirely behind the viewer
+    }
+    if (behind == 0){
+        float splat = SDL_max(draw->splat, 1.0f);
+        float pad = splat;
+        if (max_x + pad < 0 || max_y + pad < 0 || min_x - pad >= fb->width || min_y - pad >= fb->height){
+            return; // outside the view
+        }
+
+        // LOD: no point in drawing more points than splats fit into the node's screen area
+        float area = (max_x - min_x + 1.0f) * (max_y - min_y + 1.0f);
+        float budget = SDL_max(area / (splat * splat) * lod_bias, 1.0f);
+        if ((float)node->count > budget && (node->leaf || budget < (float)K_POINT_CLOUD_LEAF_SIZE)){
+            size_t stride = (size_t)ceilf((float)node->count / budget);
+            k_SplatPointRange(fb, draw, node->first, node->count, stride);
+            return;
+        }
+    }
+
+    if (node->leaf){
+        k_SplatPointRange(fb, draw, node->first, node->count, 1);
+        return;
+    }
+    for (int c = 0; c < 8; c++){
+        if (node->children[c] >= 0){
+            k_RenderPointCloudNode(fb, draw, node->children[c], lod_bias);
+        }
+    }
+}
+
+static void k_SplatPointCloud(k_Framebuffer* fb, const k_PointCloudDraw* draw){
+    draw->cloud->points_drawn = 0;
+    if (draw->cloud->node_count > 0){
+        k_RenderPointCloudNode(fb, draw, 0, draw->lod_bias);
+    }
+}
+
+static int k_RenderPointCloud(Kitty_ObjPointCloud* cloud, float lod_scale){
+    int result = k_PrepareFramebuffer();
+    if (result != KITTY_SUCCESS){
+        return result;
+    }
+    if (lod_scale < 1.0f){
+        k_frame_stats.lods_dropped++;
+    }
+    if (k_fb->draw_count == k_fb->draw_capacity){
+        size_t new_capacity = SDL_max(k_fb->draw_capacity * 2, (size_t)16);
+        k_PointCloudDraw* new_draws = (k_PointCloudDraw*)k_Realloc(k_fb->draws, new_capacity * sizeof(k_PointCloudDraw), KITTY_MEMORY_FRAME);
+        if (!new_draws){
+            return KITTY_MEMORY_ALLOCATION_FAILURE;
+        }
+        k_fb->draws = new_draws;
+        k_fb->draw_capacity = new_capacity;
+    }
+    // everything the raster stage reads from the object is copied, it may change before the frame is drawn
+    k_fb->draws[k_fb->draw_count++] = (k_PointCloudDraw){
+        cloud,
+        k_FramebufferPosition(cloud->position, k_fb_scale),
+        cloud->scale * k_fb_scale,
+        cloud->splat_size * k_fb_scale,
+        cloud->lod_bias * lod_scale
+    };
+    return KITTY_SUCCESS;
+}
+
+// TERRAIN STUFF
+
+// A chunk of n quads owns (n + 1)^2 grid vertices, row by row along z, followed by a copy of each of its four edges
+// hanging skirt_depth lower. LOD l walks the same vertices with a stride of 2^l, so one index list per LOD serves
+// every chunk. Chunks are drawn far to near and each chunk's rows far to near, the painter's order of a heightfield.
+#define K_TERRAIN_KEEP_FRAMES 120  // frames out of view before a chunk gives its vertices back
+
+typedef struct {
+    int chunk;
+    int lod;
+    float order;                // view depth of the chunk center
+} k_TerrainVisible;
+
+static size_t k_TerrainChunkVertices(int n){
+    return (size_t)(n + 1) * (size_t)(n + 1) + 4 * (size_t)(n + 1);
+}
+
+///@brief Grid vertex i along edge 0 (near row), 1 (far row), 2 (left column) or 3 (right column).
+static Uint32 k_TerrainEdgeVertex(int n, int edge, int i){
+    switch (edge){
+        case 0: return (Uint32)i;
+        case 1: return (Uint32)(n * (n + 1) + i);
+        case 2: return (Uint32)(i * (n + 1));
+        default: return (Uint32)(i * (n + 1) + n);
+    }
+}
+
+static float k_TerrainSampleY(const Kitty_ObjTerrain* terrain, int sx, int sz){
+    sx = SDL_clamp(sx, 0, terrain->width - 1);
+    sz = SDL_clamp(sz, 0, terrain->depth - 1);
+    return terrain->settings.origin.y - terrain->heights[(size_t)sz * terrain->width + sx] * terrain->settings.height_scale / 65535.0f;
+}
+
+static int k_BuildTerrainLods(Kitty_ObjTerrain* terrain){
+    int n = terrain->settings.chunk_size;
+    int grid = n + 1;
+    Uint32 skirt_base = (Uint32)(grid * grid);
+    static const int edge_order[4] = {1, 2, 3, 0}; // the far skirt first, the near one last
+    terrain->lod_count = 0;
+    for (int stride = 1; stride <= n && terrain->lod_count < KITTY_TERRAIN_MAX_LODS; stride *= 2){
+        size_t m = (size_t)(n / stride);
+        Uint32* indices = (Uint32*)k_Alloc((6 * m * m + 24 * m) * sizeof(Uint32), KITTY_MEMORY_MESHES);
+        if (!indices){
+            return KITTY_MEMORY_ALLOCATION_FAILURE; // Memory allocation failed
+        }
+        size_t k = 0;
+        for (int e = 0; e < 4; e++){
+            int edge = edge_order[e];
+            for (int i = 0; i < n; i += stride){
+                Uint32 g0 = k_TerrainEdgeVertex(n, edge, i);
+                Uint32 g1 = k_TerrainEdgeVertex(n, edge, i + stride);
+                Uint32 s0 = skirt_base + (Uint32)(edge * grid + i);
+                Uint32 s1 = s0 + (Uint32)stride;
+                indices[k++] = g0; indices[k++] = g1; indices[k++] = s1;
+                indices[k++] = g0; indices[k++] = s1; indices[k++] = s0;
+            }
+        }
+        size_t skirt_count = k;
+        for (int r = n - stride; r >= 0; r -= stride){
+            for (int c = 0; c < n; c += stride){
+                Uint32 a = (Uint32)(r * grid + c);
+                Uint32 b = a + (Uint32)stride;
+                Uint32 d = a + (Uint32)(stride * grid);
+                Uint32 e = d + (Uint32)stride;
+                indices[k++] = a; indices[k++] = b; indices[k++] = d;
+                indices[k++] = b; indices[k++] = e; indices[k++] = d;
+            }
+        }
+        terrain->lods[terrain->lod_count++] = (Kitty_TerrainLod){ indices, skirt_count, k };
+    }
+    return KITTY_SUCCESS;
+}
+
+static int k_BuildTerrain(Kitty_ObjTerrain* terrain){
+    const Kitty_TerrainSettings* settings = &terrain->settings;
+    int n = settings->chunk_size;
+    if (terrain->width < 2 || terrain->depth < 2 || !(settings->spacing > 0.0f) || !(settings->lod_distance > 0.0f) ||
+        !(settings->height_scale >= 0.0f) || !(settings->skirt_depth >= 0.0f) || n < 2 || n > 256 || (n & (n - 1)) != 0){
+        return KITTY_INVALID_ARGUMENT; // Chunk size must be a power of two, distances positive
+    }
+    terrain->chunks_x = (terrain->width - 2) / n + 1;
+    terrain->chunks_z = (terrain->depth - 2) / n + 1;
+    terrain->chunks = (Kitty_TerrainChunk*)k_Calloc((size_t)terrain->chunks_x * terrain->chunks_z, sizeof(Kitty_TerrainChunk), KITTY_MEMORY_MESHES);
+    if (!terrain->chunks){
+        return KITTY_MEMORY_ALLOCATION_FAILURE; // Memory allocation failed
+    }
+    // bounds from the samples, so culling works before a chunk has vertices
+    for (int cz = 0; cz < terrain->chunks_z; cz++){
+        for (int cx = 0; cx < terrain->chunks_x; cx++){
+            Kitty_TerrainChunk* chunk = &terrain->chunks[cz * terrain->chunks_x + cx];
+            int x0 = cx * n, z0 = cz * n;
+            int x1 = SDL_min(x0 + n, terrain->width - 1), z1 = SDL_min(z0 + n, terrain->depth - 1);
+            float top = FLT_MAX, bottom = -FLT_MAX;
+            for (int sz = z0; sz <= z1; sz++){
+                for (int sx = x0; sx <= x1; sx++){
+                    float y = k_TerrainSampleY(terrain, sx, sz);
+                    top = SDL_min(top, y);
+                    bottom = SDL_max(bottom, y);
+                }
+            }
+            chunk->min = (Kitty_Vertex3D){ settings->origin.x + x0 * settings->spacing, top, settings->origin.z + z0 * settings->spacing };
+            chunk->max = (Kitty_Vertex3D){ settings->origin.x + x1 * settings->spacing, bottom + settings->skirt_depth,
+                                           settings->origin.z + z1 * settings->spacing };
+        }
+    }
+    return k_BuildTerrainLods(terrain);
+}
+
+static void k_DropTerrainChunk(Kitty_ObjTerrain* terrain, Kitty_TerrainChunk* chunk){
+    k_Free(chunk->x);
+    k_Free(chunk->y);
+    k_Free(chunk->z);
+    chunk->x = chunk->y = chunk->z = NULL;
+    terrain->chunks_resident--;
+}
+
+static int k_GenerateTerrainChunk(Kitty_ObjTerrain* terrain, int index){
+    Kitty_TerrainChunk* chunk = &terrain->chunks[index];
+    const Kitty_TerrainSettings* settings = &terrain->settings;
+    int n = settings->chunk_size;
+    size_t count = k_TerrainChunkVertices(n);
+    chunk->x = (float*)k_Alloc(count * sizeof(float), KITTY_MEMORY_MESHES);
+    chunk->y = (float*)k_Alloc(count * sizeof(float), KITTY_MEMORY_MESHES);
+    chunk->z = (float*)k_Alloc(count * sizeof(float), KITTY_MEMORY_MESHES);
+    terrain->chunks_resident++;
+    if (!chunk->x || !chunk->y || !chunk->z){
+        k_DropTerrainChunk(terrain, chunk);
+        return KITTY_MEMORY_ALLOCATION_FAILURE; // Memory allocation failed
+    }
+    // samples past the last row or column repeat it, which flattens those quads to nothing
+    int x0 = (index % terrain->chunks_x) * n, z0 = (index / terrain->chunks_x) * n;
+    for (int r = 0; r <= n; r++){
+        int sz = SDL_min(z0 + r, terrain->depth - 1);
+        for (int c = 0; c <= n; c++){
+            int sx = SDL_min(x0 + c, terrain->width - 1);
+            size_t v = (size_t)r * (n + 1) + c;
+            chunk->x[v] = settings->origin.x + sx * settings->spacing;
+            chunk->y[v] = k_TerrainSampleY(terrain, sx, sz);
+            chunk->z[v] = settings->origin.z + sz * settings->spacing;
+        }
+    }
+    size_t skirt = (size_t)(n + 1) * (n + 1);
+    for (int edge = 0; edge < 4; edge++){
+        for (int i = 0; i <= n; i++){
+            Uint32 g = k_TerrainEdgeVertex(n, edge, i);
+            chunk->x[skirt] = chunk->x[g];
+            chunk->y[skirt] = chunk->y[g] + settings->skirt_depth;
+            chunk->z[skirt] = chunk->z[g];
+            skirt++;
+        }
+    }
+    return KITTY_SUCCESS;
+}
+
+static int k_CompareTerrainOrder(const void* a, const void* b){
+    float oa = ((const k_TerrainVisible*)a)->order;
+    float ob = ((const k_TerrainVisible*)b)->order;
+    return (oa < ob) - (oa > ob); // far first
+}
+
+///@brief Shades a triangle by its height and its slope towards a light above and to the left of the viewer.
+static Kitty_Color k_TerrainShade(const Kitty_ObjTerrain* terrain, const Kitty_TerrainChunk* chunk, Uint32 a, Uint32 b, Uint32 c){
+    const Kitty_TerrainSettings* settings = &terrain->settings;
+    Kitty_Vertex3D e1 = { chunk->x[b] - chunk->x[a], chunk->y[b] - chunk->y[a], chunk->z[b] - chunk->z[a] };
+    Kitty_Vertex3D e2 = { chunk->x[c] - chunk->x[a], chunk->y[c] - chunk->y[a], chunk->z[c] - chunk->z[a] };
+    Kitty_Vertex3D normal = KittyM_VectorNormalize3(KittyM_CrossProduct3(e1, e2));
+    static const Kitty_Vertex3D light = { -0.3939f, -0.9191f, 0.0f }; // normalized, -y is up
+    float light_amount = 0.35f + 0.65f * fabsf(KittyM_DotProduct3(normal, light));
+    float height = (settings->origin.y - (chunk->y[a] + chunk->y[b] + chunk->y[c]) / 3.0f) /
+                   (settings->height_scale > 0.0f ? settings->height_scale : 1.0f);
+    height = SDL_clamp(height, 0.0f, 1.0f);
+    Kitty_Color low = settings->low_color, high = settings->high_color;
+    return (Kitty_Color){
+        (Uint8)((low.r + (high.r - low.r) * height) * light_amount),
+        (Uint8)((low.g + (high.g - low.g) * height) * light_amount),
+        (Uint8)((low.b + (high.b - low.b) * height) * light_amount),
+        (Uint8)(low.a + (high.a - low.a) * height)
+    };
+}
+
+///@brief Fills a screen space triangle, all its spans in one fill_rects call. Pixel centers inside are covered,
+///so triangles that share an edge neither overlap nor leave a gap.
+static int k_FillTerrainTriangle(Kitty_ObjTerrain* terrain, float x0, float y0, float x1, float y1, float x2, float y2, Kitty_Color color){
+    if (k_aa_samples > 1){
+        return k_FillTriangleAA(x0, y0, x1, y1, x2, y2, color);
+    }
+    // sort by y
+    if (y1 < y0){ float t = x0; x0 = x1; x1 = t; t = y0; y0 = y1; y1 = t; }
+    if (y2 < y0){ float t = x0; x0 = x2; x2 = t; t = y0; y0 = y2; y2 = t; }
+    if (y2 < y1){ float t = x1; x1 = x2; x2 = t; t = y1; y1 = y2; y2 = t; }
+    int first = SDL_max((int)ceilf(y0 - 0.5f), 0);
+    int last = SDL_min((int)ceilf(y2 - 0.5f), window_height); // exclusive
+    if (first >= last){
+        return KITTY_SUCCESS;
+    }
+    SDL_Rect* spans = (SDL_Rect*)k_GrowScratch((void**)&terrain->spans, &terrain->spans_capacity, (size_t)window_height * sizeof(SDL_Rect));
+    if (!spans){
+        return KITTY_MEMORY_ALLOCATION_FAILURE;
+    }
+    int count = 0;
+    for (int y = first; y < last; y++){
+        float center = (float)y + 0.5f;
+        float long_x = x0 + (center - y0) * (x2 - x0) / (y2 - y0);
+        float short_x = center < y1 ? x0 + (center - y0) * (x1 - x0) / (y1 - y0)
+                                    : x1 + (center - y1) * (x2 - x1) / (y2 - y1);
+        float left = SDL_min(long_x, short_x), right = SDL_max(long_x, short_x);
+        int from = SDL_max((int)ceilf(left - 0.5f), 0);
+        int to = SDL_min((int)ceilf(right - 0.5f), window_width); // exclusive
+        if (from < to){
+            spans[count++] = (SDL_Rect){ from, y, to - from, 1 };
+        }
+    }
+    if (count > 0){
+        k_SetDrawColor(color.r, color.g, color.b, color.a);
+        k_FillRects(spans, count);
+    }
+    return KITTY_SUCCESS;
+}
+
+static int k_DrawTerrainChunk(Kitty_ObjTerrain* terrain, int index, int lod){
+    Kitty_TerrainChunk* chunk = &terrain->chunks[index];
+    size_t count = k_TerrainChunkVertices(terrain->settings.chunk_size);
+    float* projected = (float*)k_GrowScratch((void**)&terrain->projected, &terrain->projected_capacity, 3 * count * sizeof(float));
+    if (!projected){
+        return KITTY_MEMORY_ALLOCATION_FAILURE;
+    }
+    float* sx = projected;
+    float* sy = projected + count;
+    float* sd = projected + 2 * count;
+    k_ProjectPointsSoA(chunk->x, chunk->y, chunk->z, count, terrain->position, terrain->scale, sx, sy, sd);
+
+    const Kitty_TerrainLod* list = &terrain->lods[lod];
+    for (size_t i = 0; i < list->index_count; i += 3){
+        Uint32 a = list->indices[i], b = list->indices[i + 1], c = list->indices[i + 2];
+        if (sd[a] < K_NEAR_PLANE || sd[b] < K_NEAR_PLANE || sd[c] < K_NEAR_PLANE){
+            continue;
+        }
+        // the grid winds so that the top of the terrain has a negative screen area; skirts show from both sides
+        float area = (sx[b] - sx[a]) * (sy[c] - sy[a]) - (sy[b] - sy[a]) * (sx[c] - sx[a]);
+        if (area == 0.0f || (i >= list->skirt_count && area > 0.0f)){
+            continue;
+        }
+        int result = k_FillTerrainTriangle(terrain, sx[a], sy[a], sx[b], sy[b], sx[c], sy[c], k_TerrainShade(terrain, chunk, a, b, c));
+        if (result != KITTY_SUCCESS){
+            return result;
+        }
+        terrain->triangles_drawn++;
+    }
+    return KITTY_SUCCESS;
+}
+
+static int k_RenderTerrain(Kitty_ObjTerrain* terrain, float lod_scale){
+    terrain->chunks_drawn = 0;
+    terrain->chunks_culled = 0;
+    terrain->triangles_drawn = 0;
+    if (lod_scale < 1.0f){
+        k_frame_stats.lods_dropped++;
+    }
+    size_t chunk_count = (size_t)terrain->chunks_x * terrain->chunks_z;
+    k_TerrainVisible* visible = (k_TerrainVisible*)k_GrowScratch(&terrain->visible, &terrain->visible_capacity, chunk_count * sizeof(k_TerrainVisible));
+    if (!visible){
+        return KITTY_MEMORY_ALLOCATION_FAILURE;
+    }
+
+    // cull each chunk's box against the view and pick its LOD from the nearest corner's depth
+    float lod_distance = terrain->settings.lod_distance * lod_scale;
+    size_t visible_count = 0;
+    for (size_t i = 0; i < chunk_count; i++){
+        const Kitty_TerrainChunk* chunk = &terrain->chunks[i];
+        float corners_x[8], corners_y[8], corners_z[8];
+        float px[8], py[8], pd[8];
+        for (int c = 0; c < 8; c++){
+            corners_x[c] = (c & 1) ? chunk->max.x : chunk->min.x;
+            corners_y[c] = (c & 2) ? chunk->max.y : chunk->min.y;
+            corners_z[c] = (c & 4) ? chunk->max.z : chunk->min.z;
+        }
+        k_ProjectPointsSoA(corners_x, corners_y, corners_z, 8, terrain->position, terrain->scale, px, py, pd);
+        int behind = 0;
+        float min_x = FLT_MAX, min_y = FLT_MAX, max_x = -FLT_MAX, max_y = -FLT_MAX, nearest = FLT_MAX;
+        for (int c = 0; c < 8; c++){
+            if (pd[c] < K_NEAR_PLANE){
+                behind++;
+                continue;
+            }
+            min_x = SDL_min(min_x, px[c]); max_x = SDL_max(max_x, px[c]);
+            min_y = SDL_min(min_y, py[c]); max_y = SDL_max(max_y, py[c]);
+            nearest = SDL_min(nearest, pd[c]);
+        }
+        if (behind == 8 || (behind == 0 && (max_x < 0 || max_y < 0 || min_x >= window_width || min_y >= window_height))){
+            terrain->chunks_culled++;
+            continue;
+        }
+        nearest = behind > 0 ? K_NEAR_PLANE : nearest;
+        int lod = 0;
+        while (lod + 1 < terrain->lod_count && nearest >= lod_distance * (float)(1 << lod)){
+            lod++;
+        }
+        visible[visible_count++] = (k_TerrainVisible){ (int)i, lod, (pd[0] + pd[7]) * 0.5f };
+    }
+    qsort(visible, visible_count, sizeof(k_TerrainVisible), k_CompareTerrainOrder);
+
+    for (size_t v = 0; v < visible_count; v++){
+        Kitty_TerrainChunk* chunk = &terrain->chunks[visible[v].chunk];
+        if (!chunk->x){
+            int result = k_GenerateTerrainChunk(terrain, visible[v].chunk);
+            if (result != KITTY_SUCCESS){
+                return result;
+            }
+        }
+        chunk->last_frame = frame_num;
+        int result = k_DrawTerrainChunk(terrain, visible[v].chunk, visible[v].lod);
+        if (result != KITTY_SUCCESS){
+            return result;
+        }
+        terrain->chunks_drawn++;
+    }
+
+    // chunks that stayed out of view give their vertices back
+    for (size_t i = 0; i < chunk_count; i++){
+        Kitty_TerrainChunk* chunk = &terrain->chunks[i];
+        if (chunk->x && frame_num - chunk->last_frame > K_TERRAIN_KEEP_FRAMES){
+            k_DropTerrainChunk(terrain, chunk);
+        }
+    }
+    return KITTY_SUCCESS;
+}
+
+static void k_FreeTerrain(Kitty_ObjTerrain* terrain){
+    if (terrain->chunks){
+        for (size_t i = 0; i < (size_t)terrain->chunks_x * terrain->chunks_z; i++){
+            if (terrain->chunks[i].x || terrain->chunks[i].y || terrain->chunks[i].z){
+                k_DropTerrainChunk(terrain, &terrain->chunks[i]);
+            }
+        }
+    }
+    for (int l = 0; l < terrain->lod_count; l++){
+        k_Free(terrain->lods[l].indices);
+    }
+    k_Free(terrain->chunks);
+    k_Free(terrain->heights);
+    k_Free(terrain->projected);
+    k_Free(terrain->visible);
+    k_Free(terrain->spans);
+}
+
+// JOB STUFF
+
+static void k_RunJobChunks(){
+    size_t begin;
+    while ((begin = (size_t)SDL_AtomicAdd(&k_job.next, (int)k_job.grain)) < k_job.count){
+        k_job.fn(k_job.ctx, begin, SDL_min(begin + k_job.grain, k_job.count));
+    }
+}
+
+static int k_WorkerMain(void* data){
+    (void)data;
+    Uint64 seen = 0;
+    SDL_LockMutex(k_job_mutex);
+    for (;;){
+        while (k_job.generation == seen && !k_job.quit){
+            SDL_CondWait(k_job_cond, k_job_mutex);
+        }
+        if (k_job.quit){
+            break;
+        }
+        seen = k_job.generation;
+        int frame = k_job.frame;
+        SDL_UnlockMutex(k_job_mutex);
+
+        k_frame_scope += frame;
+        k_RunJobChunks();
+        k_frame_scope -= frame;
+
+        SDL_LockMutex(k_job_mutex);
+        if (--k_job.active == 0){
+            SDL_CondSignal(k_job_done_cond);
+        }
+    }
+    SDL_UnlockMutex(k_job_mutex);
+    return 0;
+}
+
+static void k_StartWorkers(){
+    k_workers_started = true;
+    int count = SDL_min(SDL_GetCPUCount() - 1, K_MAX_WORKERS);
+    if (count <= 0){
+        return; // single core, everything runs on the caller
+    }
+    k_job_mutex = SDL_CreateMutex();
+    k_job_cond = SDL_CreateCond();
+    k_job_done_cond = SDL_CreateCond();
+    if (!k_job_mutex || !k_job_cond || !k_job_done_cond){
+        k_StopWorkers();
+        return;
+    }
+    k_job.generation = 0;
+    k_job.quit = false;
+    for (int i = 0; i < count; i++){
+        k_workers[k_worker_count] = SDL_CreateThread(k_WorkerMain, "kitty_worker", NULL);
+        if (!k_workers[k_worker_count]){
+            break;
+        }
+        k_worker_count++;
+    }
+}
+
+static void k_StopWorkers(){
+    if (k_job_mutex){
+        SDL_LockMutex(k_job_mutex);
+        k_job.quit = true;
+        SDL_CondBroadcast(k_job_cond);
+        SDL_UnlockMutex(k_job_mutex);
+    }
+    for (int i = 0; i < k_worker_count; i++){
+        SDL_WaitThread(k_workers[i], NULL);
+    }
+    k_worker_count = 0;
+    if (k_job_done_cond){
+        SDL_DestroyCond(k_job_done_cond);
+        k_job_done_cond = NULL;
+    }
+    if (k_job_cond){
+        SDL_DestroyCond(k_job_cond);
+        k_job_cond = NULL;
+    }
+    if (k_job_mutex){
+        SDL_DestroyMutex(k_job_mutex);
+        k_job_mutex = NULL;
+    }
+    k_workers_started = false;
+}
+
+static void k_ParallelFor(size_t count, size_t grain, k_JobFunc fn, void* ctx){
+    if (count == 0){
+        return;
+    }
+    if (!k_workers_started){
+        k_StartWorkers();
+    }
+    grain = SDL_max(grain, (size_t)1);
+    if (k_worker_count == 0 || count <= grain){
+        fn(ctx, 0, count);
+        return;
+    }
+
+    SDL_LockMutex(k_job_mutex);
+    k_job.fn = fn;
+    k_job.ctx = ctx;
+    k_job.count = count;
+    k_job.grain = grain;
+    k_job.frame = k_frame_scope > 0;
+    SDL_AtomicSet(&k_job.next, 0);
+    k_job.active = k_worker_count;
+    k_job.generation++;
+    SDL_CondBroadcast(k_job_cond);
+    SDL_UnlockMutex(k_job_mutex);
+
+    k_RunJobChunks();
+
+    SDL_LockMutex(k_job_mutex);
+    while (k_job.active > 0){
+        SDL_CondWait(k_job_done_cond, k_job_mutex);
+    }
+    SDL_UnlockMutex(k_job_mutex);
+}
+
+// SKELETAL ANIMATION STUFF
+
+static void k_FreeSkin(Kitty_Skin* skin){
+    if (!skin){
+        return;
+    }
+    k_Free(skin->slot_weights);
+    k_Free(skin->slot_joints);
+    k_Free(skin->skin_matrices);
+    k_Free(skin->skinned_vertices);
+    k_Free(skin);
+}
+
+///@brief Samples a joint track at time into a local joint matrix.
+static Kitty_Matrix4 k_SampleJointTrack(const Kitty_JointTrack* track, float time){
+    if (track->key_count == 0){
+        return KittyM_MatrixIdentity();
+    }
+    const Kitty_JointKeyframe* keys = track->keys;
+    if (track->key_count == 1 || time <= keys[0].time){
+        return KittyM_MatrixCompose(keys[0].translation, keys[0].rotation, keys[0].scale);
+    }
+    if (time >= keys[track->key_count - 1].time){
+        const Kitty_JointKeyframe* last = &keys[track->key_count - 1];
+        return KittyM_MatrixCompose(last->translation, last->rotation, last->scale);
+    }
+
+    // binary search for the last key at or before time
+    size_t lo = 0, hi = track->key_count - 1;
+    while (hi - lo > 1){
+        size_t mid = (lo + hi) / 2;
+        if (keys[mid].time <= time) lo = mid; else hi = mid;
+    }
+    const Kitty_JointKeyframe* a = &keys[lo];
+    const Kitty_JointKeyframe* b = &keys[hi];
+    float span = b->time - a->time;
+    float t = span > 0.0f ? (time - a->time) / span : 0.0f;
+    Kitty_Vertex3D translation = {
+        a->translation.x + (b->translation.x - a->translation.x) * t,
+        a->translation.y + (b->translation.y - a->translation.y) * t,
+        a->translation.z + (b->translation.z - a->translation.z) * t
+    };
+    Kitty_Vertex3D scale = {
+        a->scale.x + (b->scale.x - a->scale.x) * t,
+        a->scale.y + (b->scale.y - a->scale.y) * t,
+        a->scale.z + (b->scale.z - a->scale.z) * t
+    };
+    return KittyM_MatrixCompose(translation, KittyM_QuaternionNlerp(a->rotation, b->rotation, t), scale);
+}
+
+#ifdef __SSE2__
+// one output row for four vertices: m[r] x + m[4 + r] y + m[8 + r] z + m[12 + r], element(i) holds each lane's m[i]
+#define K_SKIN_ROW(out, element, r) \
+    out = _mm_add_ps(_mm_add_ps(_mm_mul_ps(element(r), x), _mm_mul_ps(element(4 + r), y)), \
+                     _mm_add_ps(_mm_mul_ps(element(8 + r), z), element(12 + r)))
+#define K_SKIN_SHARED(i) _mm_set1_ps(m0[i])
+#define K_SKIN_GATHER(i) _mm_setr_ps(m0[i], m1[i], m2[i], m3[i])
+#endif
+
+///@brief Linear blend skinning of vertices [begin, end) of one mesh: v' = sum(w_i * M_i * v).
+static void k_SkinVertices(Kitty_ObjMesh* mesh, size_t begin, size_t end){
+    Kitty_Skin* skin = mesh->skin;
+    const Kitty_Matrix4* matrices = skin->skin_matrices;
+    size_t count = mesh->vertex_count;
+    const float* in = (const float*)(mesh->morph ? mesh->morph->morphed_vertices : mesh->vertices);
+    float* out = (float*)skin->skinned_vertices;
+    size_t v = begin;
+
+#ifdef __SSE2__
+    // SoA: each lane is one vertex, four vertices per step, one influence slot at a time
+    for (; v + 4 <= end; v += 4){
+        // x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3 to four lanes of x, y and z
+        __m128 a = _mm_loadu_ps(&in[v * 3]);
+        __m128 b = _mm_loadu_ps(&in[v * 3 + 4]);
+        __m128 c = _mm_loadu_ps(&in[v * 3 + 8]);
+        __m128 x = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+        __m128 y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 rx = _mm_setzero_ps(), ry = _mm_setzero_ps(), rz = _mm_setzero_ps();
+        for (int k = 0; k < 4; k++){
+            __m128 w = _mm_loadu_ps(&skin->slot_weights[k * count + v]);
+            if (_mm_movemask_ps(_mm_cmpneq_ps(w, _mm_setzero_ps())) == 0){
+                continue; // the slot is unused by all four vertices
+            }
+            const Uint32* joints = &skin->slot_joints[k * count + v];
+            const float* m0 = matrices[joints[0]].m, *m1 = matrices[joints[1]].m;
+            const float* m2 = matrices[joints[2]].m, *m3 = matrices[joints[3]].m;
+            __m128 px, py, pz;
+            if (m0 == m1 && m1 == m2 && m2 == m3){
+                // neighbouring vertices usually share their joints, a broadcast beats a gather
+                K_SKIN_ROW(px, K_SKIN_SHARED, 0);
+                K_SKIN_ROW(py, K_SKIN_SHARED, 1);
+                K_SKIN_ROW(pz, K_SKIN_SHARED, 2);
+            } else {
+                K_SKIN_ROW(px, K_SKIN_GATHER, 0);
+                K_SKIN_ROW(py, K_SKIN_GATHER, 1);
+                K_SKIN_ROW(pz, K_SKIN_GATHER, 2);
+            }
+            rx = _mm_add_ps(rx, _mm_mul_ps(w, px));
+            ry = _mm_add_ps(ry, _mm_mul_ps(w, py));
+            rz = _mm_add_ps(rz, _mm_mul_ps(w, pz));
+        }
+        // and back to xyz triples
+        __m128 xy01 = _mm_unpacklo_ps(rx, ry);
+        __m128 xy23 = _mm_unpackhi_ps(rx, ry);
+        _mm_storeu_ps(&out[v * 3], _mm_shuffle_ps(xy01, _mm_shuffle_ps(rz, xy01, _MM_SHUFFLE(2, 2, 0, 0)), _MM_SHUFFLE(2, 0, 1, 0)));
+        _mm_storeu_ps(&out[v * 3 + 4], _mm_shuffle_ps(_mm_shuffle_ps(xy01, rz, _MM_SHUFFLE(1, 1, 3, 3)), xy23, _MM_SHUFFLE(1, 0, 2, 0)));
+        _mm_storeu_ps(&out[v * 3 + 8], _mm_shuffle_ps(_mm_shuffle_ps(rz, xy23, _MM_SHUFFLE(2, 2, 2, 2)),
+                                                      _mm_shuffle_ps(xy23, rz, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0)));
+    }
+#endif
+    for (; v < end; v++){
+        float r[3] = {0.0f, 0.0f, 0.0f};
+        for (int k = 0; k < 4; k++){
+            float w = skin->slot_weights[k * count + v];
+            if (w == 0.0f){
+                continue;
+            }
+            const float* m = matrices[skin->slot_joints[k * count + v]].m;
+            for (int row = 0; row < 3; row++){
+                r[row] += w * (m[row] * in[v * 3] + m[4 + row] * in[v * 3 + 1] + m[8 + row] * in[v * 3 + 2] + m[12 + row]);
+            }
+        }
+        out[v * 3] = r[0];
+        out[v * 3 + 1] = r[1];
+        out[v * 3 + 2] = r[2];
+    }
+}
+
+static void k_MorphStageJob(void* ctx, size_t begin, size_t end){
+    Kitty_ObjMesh** meshes = (Kitty_ObjMesh**)ctx;
+    for (size_t i = begin; i < end; i++){
+        Kitty_ObjMesh* mesh = meshes[i];
+        if (mesh->morph && (mesh->morph->dirty || mesh->morph->needs_reset)){
+            if (!k_BlendMorphTargets(mesh)){
+                meshes[i] = NULL; // out of memory, keep drawing the previous result
+                continue;
+            }
+            if (mesh->skin){
+                mesh->skin->dirty = true; // skinning reads the morphed vertices
+            }
+        }
+    }
+}
+
+static void k_SkinStageJob(void* ctx, size_t begin, size_t end){
+    k_SkinRange* ranges = (k_SkinRange*)ctx;
+    for (size_t i = begin; i < end; i++){
+        k_SkinVertices(ranges[i].mesh, ranges[i].begin, ranges[i].end);
+    }
+}
+
+static int k_RunVertexStages(){
+    size_t count = 0;
+    for (size_t i = 0; i < object_mspace->allocation_count; i++){
+        Kitty_Object* obj = &object_mspace->objects[i];
+        if (obj->type != KITTY_OBJECT_MESH){
+            continue;
+        }
+        Kitty_ObjMesh* mesh = (Kitty_ObjMesh*)obj->data;
+        bool morph_dirty = mesh->morph && (mesh->morph->dirty || mesh->morph->needs_reset);
+        bool skin_dirty = mesh->skin && mesh->skin->dirty;
+        if (!morph_dirty && !skin_dirty){
+            continue;
+        }
+        if (count == k_vertex_stage_queue_capacity){
+            size_t new_capacity = SDL_max(k_vertex_stage_queue_capacity * 2, (size_t)64);
+            Kitty_ObjMesh** new_queue = (Kitty_ObjMesh**)k_Realloc(k_vertex_stage_queue, new_capacity * sizeof(Kitty_ObjMesh*), KITTY_MEMORY_MESHES);
+            if (!new_queue){
+                return KITTY_MEMORY_ALLOCATION_FAILURE;
+            }
+            k_vertex_stage_queue = new_queue;
+            k_vertex_stage_queue_capacity = new_capacity;
+        }
+        k_vertex_stage_queue[count++] = mesh;
+    }
+    k_ParallelFor(count, 1, k_MorphStageJob, k_vertex_stage_queue);
+
+    // skinning goes out in vertex ranges rather than whole meshes, so a crowd keeps every worker busy
+    // however its vertices are split between meshes
+    size_t range_count = 0;
+    for (size_t i = 0; i < count; i++){
+        Kitty_ObjMesh* mesh = k_vertex_stage_queue[i];
+        if (!mesh || !mesh->skin || !mesh->skin->dirty || mesh->skin->vertex_count != mesh->vertex_count){
+            continue;
+        }
+        for (size_t begin = 0; begin < mesh->vertex_count; begin += K_SKIN_RANGE){
+            if (range_count == k_skin_range_capacity){
+                size_t new_capacity = SDL_max(k_skin_range_capacity * 2, (size_t)64);
+                k_SkinRange* new_ranges = (k_SkinRange*)k_Realloc(k_skin_ranges, new_capacity * sizeof(k_SkinRange), KITTY_MEMORY_MESHES);
+                if (!new_ranges){
+                    return KITTY_MEMORY_ALLOCATION_FAILURE;
+                }
+                k_skin_ranges = new_ranges;
+                k_skin_range_capacity = new_capacity;
+            }
+            k_skin_ranges[range_count++] = (k_SkinRange){mesh, begin, SDL_min(begin + K_SKIN_RANGE, mesh->vertex_count)};
+        }
+    }
+    k_ParallelFor(range_count, 1, k_SkinStageJob, k_skin_ranges);
+
+    for (size_t i = 0; i < count; i++){
+        Kitty_ObjMesh* mesh = k_vertex_stage_queue[i];
+        if (!mesh){
+            continue;
+        }
+        if (mesh->skin && mesh->skin->vertex_count == mesh->vertex_count){
+            mesh->skin->dirty = false;
+        }
+        if (mesh->impostor){
+            mesh->impostor->stale = true;
+        }
+    }
+    return KITTY_SUCCESS;
+}
+
+static const Kitty_Vertex3D* k_MeshVertices(Kitty_ObjMesh* mesh){
+    // a skin or morph built for another vertex count is too short to draw from
+    if (mesh->skin && mesh->skin->vertex_count == mesh->vertex_count){
+        return mesh->skin->skinned_vertices;
+    }
+    if (mesh->morph && mesh->morph->vertex_count == mesh->vertex_count){
+        return mesh->morph->morphed_vertices;
+    }
+    return mesh->vertices;
+}
+
+// MORPH TARGET STUFF
+
+static void k_FreeMorph(Kitty_Morph* morph){
+    if (!morph){
+        return;
+    }
+    for (size_t t = 0; t < morph->target_count; t++){
+        k_Free(morph->targets[t].indices);
+        k_Free(morph->targets[t].deltas);
+    }
+    k_Free(morph->targets);
+    k_Free(morph->morphed_vertices);
+    k_Free(morph->stamps);
+    k_Free(morph);
+}
+
+static inline void k_ApplyMorphDelta(Kitty_Vertex3D* v, Kitty_Vertex3D delta, float weight){
+    v->x += delta.x * weight;
+    v->y += delta.y * weight;
+    v->z += delta.z * weight;
+}
+
+///@brief Brings morphed_vertices up to date with the target weights, touching only affected vertices.
+///@return Returns false if the output buffers could not be allocated.
+static bool k_BlendMorphTargets(Kitty_ObjMesh* mesh){
+    Kitty_Morph* morph = mesh->morph;
+    if (morph->needs_reset || morph->vertex_count != mesh->vertex_count){
+        // rebuild from the base mesh, every target gets blended in again below
+        Kitty_Vertex3D* new_vertices = (Kitty_Vertex3D*)k_Realloc(morph->morphed_vertices, mesh->vertex_count * sizeof(Kitty_Vertex3D), KITTY_MEMORY_MESHES);
+        if (!new_vertices){
+            return false;
+        }
+        morph->morphed_vertices = new_vertices;
+        Uint32* new_stamps = (Uint32*)k_Realloc(morph->stamps, mesh->vertex_count * sizeof(Uint32), KITTY_MEMORY_MESHES);
+        if (!new_stamps){
+            return false;
+        }
+        morph->stamps = new_stamps;
+        memcpy(morph->morphed_vertices, mesh->vertices, mesh->vertex_count * sizeof(Kitty_Vertex3D));
+        memset(morph->stamps, 0, mesh->vertex_count * sizeof(Uint32));
+        morph->epoch = 0;
+        morph->vertex_count = mesh->vertex_count;
+        for (size_t t = 0; t < morph->target_count; t++){
+            morph->targets[t].applied_weight = 0.0f;
+        }
+        morph->needs_reset = false;
+    }
+
+    if (++morph->epoch == 0){
+        memset(morph->stamps, 0, morph->vertex_count * sizeof(Uint32));
+        morph->epoch = 1;
+    }
+    Uint32 epoch = morph->epoch;
+    Kitty_Vertex3D* out = morph->morphed_vertices;
+
+    // restore the vertices of every target whose weight changed; summing the
+    // difference instead would let float error creep in over many frames
+    for (size_t t = 0; t < morph->target_count; t++){
+        Kitty_MorphTarget* target = &morph->targets[t];
+        if (target->weight == target->applied_weight || target->applied_weight == 0.0f){
+            continue;
+        }
+        for (size_t k = 0; k < target->count; k++){
+            Uint32 v = target->indices[k];
+            out[v] = mesh->vertices[v];
+            morph->stamps[v] = epoch;
+        }
+    }
+    // targets that changed are blended in fully, the rest only where a vertex was restored
+    for (size_t t = 0; t < morph->target_count; t++){
+        Kitty_MorphTarget* target = &morph->targets[t];
+        if (target->weight == 0.0f){
+            target->applied_weight = 0.0f;
+            continue;
+        }
+        if (target->weight != target->applied_weight){
+            for (size_t k = 0; k < target->count; k++){
+                k_ApplyMorphDelta(&out[target->indices[k]], target->deltas[k], target->weight);
+            }
+            target->applied_weight = target->weight;
+        }
+        else {
+            for (size_t k = 0; k < target->count; k++){
+                Uint32 v = target->indices[k];
+                if (morph->stamps[v] == epoch){
+                    k_ApplyMorphDelta(&out[v], target->deltas[k], target->weight);
+                }
+            }
+        }
+    }
+    morph->dirty = false;
+    return true;
+}
+
+// SCENE SNAPSHOT STUFF
+
+// A snapshot is a header, a section table, one section per object type holding that type's fixed size records
+// back to back, an order section that interleaves them again and a blob section with every variable sized array.
+// Records refer to arrays by byte offset into the blob. The layout is native (byte order and size_t width are
+// checked on load), so loading maps the file once and copies each array straight into its object.
+#define K_SCENE_VERSION 1
+#define K_SCENE_BYTE_ORDER 0x01020304u
+#define K_SCENE_TYPE_COUNT (KITTY_OBJECT_TERRAIN + 1)
+#define K_SCENE_SECTION_ORDER 100
+#define K_SCENE_SECTION_BLOB 101    // object sections use their Kitty_ObjType as kind
+
+typedef struct {
+    char magic[4];
+    Uint32 version;
+    Uint32 byte_order;
+    Uint32 size_width;          // sizeof(size_t) of the writer
+    Uint32 section_count;
+    Uint32 reserved;
+    Uint64 object_count;
+    Kitty_Vertex3D camera_position;
+    Kitty_Point3D camera_origin;
+} k_SceneHeader;
+
+typedef struct {
+    Uint32 kind;
+    Uint32 record_size;
+    Uint64 offset;              // from the start of the file
+    Uint64 count;
+} k_SceneSection;
+
+typedef struct {
+    Uint64 id;
+    Uint32 type;
+    Uint32 priority;
+} k_SceneOrder;
+
+// circles, rectangles, lines, triangles and pixels are stored as their object data
+typedef struct {
+    Kitty_Point position;
+    float size;
+    float rotation;
+    Kitty_Color color;
+    Uint64 text;                // length + 1 bytes, NUL terminated
+    Uint64 length;
+} k_SceneText;
+
+typedef struct {
+    Kitty_Point3D position;
+    Kitty_Vertex3D origin;
+    float scale;
+    Uint32 wrap;
+    Uint32 wire;
+    float impostor_threshold;   // 0 without impostor
+    Sint32 texture;             // index into the texture table, -1 for none
+    Uint64 vertices;
+    Uint64 vertex_count;
+    Uint64 faces;
+    Uint64 face_colors;
+    Uint64 face_count;
+    Uint64 uvs;
+    Uint64 uv_count;
+} k_SceneMesh;
+
+typedef struct {
+    Kitty_Point position;
+    int width;
+    int height;
+    int tile_width;
+    int tile_height;
+    Sint32 atlas;               // index into the texture table
+    Uint64 tiles;
+} k_SceneTilemap;
+
+typedef struct {
+    Uint32 filled;
+    Sint32 fill_rule;
+    Kitty_Color color;
+    Uint32 reserved;
+    Uint64 points;
+    Uint64 point_count;
+    Uint64 contour_ends;
+    Uint64 contour_count;
+} k_ScenePolygon;
+
+typedef struct {
+    float width;
+    Sint32 join;
+    Kitty_Color color;
+    Uint32 reserved;
+    Uint64 points;
+    Uint64 point_count;
+} k_ScenePolyline;
+
+typedef struct {
+    Kitty_Point position;
+    float scale;
+    float width;
+    Sint32 join;
+    Kitty_Color color;
+    Uint64 segments;
+    Uint64 segment_count;
+} k_ScenePath;
+
+typedef struct {
+    Kitty_Point position;
+    int width;
+    int height;
+    float min_value;
+    float max_value;
+    Uint64 window;
+    Uint64 series;              // k_ScenePlotSeries records
+    Uint64 series_count;
+} k_ScenePlot;
+
+typedef struct {
+    Uint64 capacity;
+    Uint64 total;
+    Kitty_Color color;
+    Uint32 reserved;
+    Uint64 samples;             // the whole ring buffer
+} k_ScenePlotSeries;
+
+typedef struct {
+    Kitty_Point3D position;
+    float scale;
+    int splat_size;
+    float lod_bias;
+    Uint32 quantized;
+    Kitty_Vertex3D bounds_min;
+    Kitty_Vertex3D bounds_max;
+    Uint64 point_count;
+    Uint64 x;                   // floats, or Uint16 offsets when quantized
+    Uint64 y;
+    Uint64 z;
+    Uint64 colors;
+    Uint64 nodes;
+    Uint64 node_count;
+} k_ScenePointCloud;
+
+typedef struct {
+    Kitty_Point3D position;
+    float scale;
+    Kitty_TerrainSettings settings;
+    Sint32 width;
+    Sint32 depth;
+    Uint64 heights;             // chunks and LOD lists are rebuilt from these
+} k_SceneTerrain;
+
+static const size_t k_scene_record_sizes[K_SCENE_TYPE_COUNT] = {
+    [KITTY_OBJECT_CIRCLE] = sizeof(Kitty_ObjCircle),
+    [KITTY_OBJECT_RECTANGLE] = sizeof(Kitty_ObjRectangle),
+    [KITTY_OBJECT_LINE] = sizeof(Kitty_ObjLine),
+    [KITTY_OBJECT_TRIANGLE] = sizeof(Kitty_ObjTriangle),
+    [KITTY_OBJECT_PIXEL] = sizeof(Kitty_ObjPixel),
+    [KITTY_OBJECT_MESH] = sizeof(k_SceneMesh),
+    [KITTY_OBJECT_TEXT] = sizeof(k_SceneText),
+    [KITTY_OBJECT_TILEMAP] = sizeof(k_SceneTilemap),
+    [KITTY_OBJECT_POLYGON] = sizeof(k_ScenePolygon),
+    [KITTY_OBJECT_POLYLINE] = sizeof(k_ScenePolyline),
+    [KITTY_OBJECT_PATH] = sizeof(k_ScenePath),
+    [KITTY_OBJECT_PLOT] = sizeof(k_ScenePlot),
+    [KITTY_OBJECT_POINT_CLOUD] = sizeof(k_ScenePointCloud),
+    [KITTY_OBJECT_TERRAIN] = sizeof(k_SceneTerrain)
+};
+
+typedef struct {
+    Uint8* data;
+    size_t size;
+    size_t capacity;
+} k_SceneBuffer;
+
+///@brief Appends size bytes at the next multiple of align, growing the buffer geometrically.
+static int k_SceneAppend(k_SceneBuffer* buffer, const void* data, size_t size, size_t align, Uint64* out_offset){
+    size_t offset = (buffer->size + align - 1) / align * align;
+    if (offset + size > buffer->capacity){
+        size_t capacity = SDL_max(buffer->capacity * 2, offset + size);
+        capacity = SDL_max(capacity, (size_t)4096);
+        Uint8* new_data = (Uint8*)k_Realloc(buffer->data, capacity, KITTY_MEMORY_OBJECTS);
+        if (!new_data){
+            return KITTY_MEMORY_ALLOCATION_FAILURE;
+        }
+        buffer->data = new_data;
+        buffer->capacity = capacity;
+    }
+    memset(buffer->data + buffer->size, 0, offset - buffer->size);
+    if (size > 0){
+        memcpy(buffer->data + offset, data, size);
+    }
+    buffer->size = offset + size;
+    if (out_offset){
+        *out_offset = offset;
+    }
+    return KITTY_SUCCESS;
+}
+
+static int k_SceneBlob(k_SceneBuffer* blob, const void* data, size_t count, size_t element_size, Uint64* out_offset){
+    return k_SceneAppend(blob, data, count * element_size, 8, out_offset);
+}
+
+static int k_SceneTextureIndex(const Kitty_Texture* texture, Kitty_Texture* const* textures, size_t texture_count, Sint32* out_index){
+    *out_index = -1;
+    if (!texture){
+        return KITTY_SUCCESS;
+    }
+    for (size_t i = 0; i < texture_count; i++){
+        if (textures[i] == texture){
+            *out_index = (Sint32)i;
+            return KITTY_SUCCESS;
+        }
+    }
+    return KITTY_INVALID_ARGUMENT; // The texture table has to name every texture in use
+}
+
+///@brief Appends one object's record to its section and its arrays to the blob.
+static int k_SceneWriteObject(const Kitty_Object* obj, k_SceneBuffer* section, k_SceneBuffer* blob, Kitty_Texture* const* textures, size_t texture_count){
+    int result = KITTY_SUCCESS;
+    switch (obj->type){
+        case KITTY_OBJECT_CIRCLE:
+        case KITTY_OBJECT_RECTANGLE:
+        case KITTY_OBJECT_LINE:
+        case KITTY_OBJECT_TRIANGLE:
+        case KITTY_OBJECT_PIXEL:
+            return k_SceneAppend(section, obj->data, k_scene_record_sizes[obj->type], 1, NULL);
+        case KITTY_OBJECT_TEXT: {
+            const Kitty_ObjText* text = (const Kitty_ObjText*)obj->data;
+            k_SceneText record = { text->position, text->size, text->rotation, text->color, 0, strlen(text->text) };
+            result = k_SceneBlob(blob, text->text, record.length + 1, 1, &record.text);
+            return result == KITTY_SUCCESS ? k_SceneAppend(section, &record, sizeof(record), 1, NULL) : result;
+        }
+        case KITTY_OBJECT_MESH: {
+            const Kitty_ObjMesh* mesh = (const Kitty_ObjMesh*)obj->data;
+            k_SceneMesh record = { mesh->position, mesh->origin, mesh->scale, mesh->wrap, mesh->wire,
+                                   mesh->impostor ? mesh->impostor->threshold : 0.0f, -1,
+                                   0, mesh->vertex_count, 0, 0, mesh->face_count, 0, mesh->uv_count };
+            result = k_SceneTextureIndex(mesh->texture, textures, texture_count, &record.texture);
+            if (result == KITTY_SUCCESS) result = k_SceneBlob(blob, mesh->vertices, mesh->vertex_count, sizeof(Kitty_Vertex3D), &record.vertices);
+            if (result == KITTY_SUCCESS) result = k_SceneBlob(blob, mesh->faces, mesh->face_count, sizeof(Kitty_Face), &record.faces);
+            if (result == KITTY_SUCCESS) result = k_SceneBlob(blob, mesh->face_colors, mesh->face_count, sizeof(Kitty_Color), &record.face_colors);
+            if (result == KITTY_SUCCESS) result = k_SceneBlob(blob, mesh->uvs, mesh->uv_count, sizeof(Kitty_UV), &record.uvs);
+            return result == KITTY_SUCCESS ? k_SceneAppend(section, &record, sizeof(record), 1, NULL) : result;
+        }
+        case KITTY_OBJECT_TILEMAP: {
+            const Kitty_ObjTilemap* map = (const Kitty_ObjTilemap*)obj->data;
+            k_SceneTilemap record = { map->position, map->width, map->height, map->tile_width, map->tile_height, -1, 0 };
+            result = k_SceneTextureIndex(map->atlas, textures, texture_count, &record.atlas);
+            if (result == KITTY_SUCCESS) result = k_SceneBlob(blob, map->tiles, (size_t)map->width * map->height, sizeof(Uint16), &record.tiles);
+            return result == KITTY_SUCCESS ? k_SceneAppend(section, &record, sizeof(record), 1, NULL) : result;
+        }
+        case KITTY_OBJECT_POLYGON: {
+            const Kitty_ObjPolygon* poly = (const Kitty_ObjPolygon*)obj->data;
+            k_ScenePolygon record = { poly->filled, poly->fill_rule, poly->color, 0, 0, poly->point_count, 0, poly->contour_count };
+            result = k_SceneBlob(blob, poly->points, poly->point_count, sizeof(Kitty_Point), &record.points);
+            if (result == KITTY_SUCCESS) result = k_SceneBlob(blob, poly->contour_ends, poly->contour_count, sizeof(size_t), &record.contour_ends);
+            return result == KITTY_SUCCESS ? k_SceneAppend(section, &record, sizeof(record), 1, NULL) : result;
+        }
+        case KITTY_OBJECT_POLYLINE: {
+            const Kitty_ObjPolyline* line = (const Kitty_ObjPolyline*)obj->data;
+            k_ScenePolyline record = { line->width, line->join, line->color, 0, 0, line->point_count };
+            result = k_SceneBlob(blob, line->points, line->point_count, sizeof(Kitty_Point), &record.points);
+            return result == KITTY_SUCCESS ? k_SceneAppend(section, &record, sizeof(record), 1, NULL) : result;
+        }
+        case KITTY_OBJECT_PATH: {
+            const Kitty_ObjPath* path = (const Kitty_ObjPath*)obj->data;
+            k_ScenePath record = { path->position, path->scale, path->line.width, path->line.join, path->line.color, 0, path->segment_count };
+            result = k_SceneBlob(blob, path->segments, path->segment_count, sizeof(Kitty_PathSegment), &record.segments);
+            return result == KITTY_SUCCESS ? k_SceneAppend(section, &record, sizeof(record), 1, NULL) : result;
+        }
+        case KITTY_OBJECT_PLOT: {
+            const Kitty_ObjPlot* plot = (const Kitty_ObjPlot*)obj->data;
+            k_ScenePlot record = { plot->position, plot->width, plot->height, plot->min_value, plot->max_value, plot->window, 0, plot->series_count };
+            // series records first so they stay contiguous, then the sample rings they point at
+            k_ScenePlotSeries* series = (k_ScenePlotSeries*)k_Calloc(plot->series_count ? plot->series_count : 1, sizeof(k_ScenePlotSeries), KITTY_MEMORY_OBJECTS);
+            if (!series){
+                return KITTY_MEMORY_ALLOCATION_FAILURE;
+            }
+            for (size_t i = 0; i < plot->series_count && result == KITTY_SUCCESS; i++){
+                const Kitty_PlotSeries* s = &plot->series[i];
+                series[i] = (k_ScenePlotSeries){ s->capacity, s->total, s->color, 0, 0 };
+                result = k_SceneBlob(blob, s->samples, s->capacity, sizeof(float), &series[i].samples);
+            }
+            if (result == KITTY_SUCCESS) result = k_SceneBlob(blob, series, plot->series_count, sizeof(k_ScenePlotSeries), &record.series);
+            k_Free(series);
+            return result == KITTY_SUCCESS ? k_SceneAppend(section, &record, sizeof(record), 1, NULL) : result;
+        }
+        case KITTY_OBJECT_POINT_CLOUD: {
+            const Kitty_ObjPointCloud* cloud = (const Kitty_ObjPointCloud*)obj->data;
+            k_ScenePointCloud record = { cloud->position, cloud->scale, cloud->splat_size, cloud->lod_bias, cloud->quantized,
+                                         cloud->bounds_min, cloud->bounds_max, cloud->point_count, 0, 0, 0, 0, 0, cloud->node_count };
+            const void* axes[3] = { cloud->quantized ? (const void*)cloud->qx : cloud->x, cloud->quantized ? (const void*)cloud->qy : cloud->y,
+                                    cloud->quantized ? (const void*)cloud->qz : cloud->z };
+            Uint64* offsets[3] = { &record.x, &record.y, &record.z };
+            size_t axis_size = cloud->quantized ? sizeof(Uint16) : sizeof(float);
+            for (int a = 0; a < 3 && result == KITTY_SUCCESS; a++){
+                result = k_SceneBlob(blob, axes[a], cloud->point_count, axis_size, offsets[a]);
+            }
+            if (result == KITTY_SUCCESS) result = k_SceneBlob(blob, cloud->colors, cloud->point_count, sizeof(Uint32), &record.colors);
+            if (result == KITTY_SUCCESS) result = k_SceneBlob(blob, cloud->nodes, cloud->node_count, sizeof(Kitty_PointCloudNode), &record.nodes);
+            return result == KITTY_SUCCESS ? k_SceneAppend(section, &record, sizeof(record), 1, NULL) : result;
+        }
+        case KITTY_OBJECT_TERRAIN: {
+            const Kitty_ObjTerrain* terrain = (const Kitty_ObjTerrain*)obj->data;
+            k_SceneTerrain record = { terrain->position, terrain->scale, terrain->settings, terrain->width, terrain->depth, 0 };
+            result = k_SceneBlob(blob, terrain->heights, (size_t)terrain->width * terrain->depth, sizeof(Uint16), &record.heights);
+            return result == KITTY_SUCCESS ? k_SceneAppend(section, &record, sizeof(record), 1, NULL) : result;
+        }
+        default:
+            return KITTY_INVALID_ARGUMENT; // Unknown object type
+    }
+}
+
+static int k_WriteScenePadding(FILE* file, Uint64* position){
+    static const Uint8 zeros[8] = {0};
+    size_t padding = (size_t)((8 - *position % 8) % 8);
+    *position += padding;
+    return padding == 0 || fwrite(zeros, 1, padding, file) == padding ? KITTY_SUCCESS : KITTY_UNKNOWN_ERROR;
+}
+
+///@brief Writes a snapshot of the given objects and the current camera.
+static int k_WriteScene(const char* file_path, const Kitty_Object* objects, size_t object_count, Kitty_Texture* const* textures, size_t texture_count){
+    k_SceneBuffer sections[K_SCENE_TYPE_COUNT] = {0};
+    k_SceneBuffer order = {0};
+    k_SceneBuffer blob = {0};
+    int result = KITTY_SUCCESS;
+    for (size_t i = 0; i < object_count && result == KITTY_SUCCESS; i++){
+        const Kitty_Object* obj = &objects[i];
+        if ((unsigned)obj->type >= K_SCENE_TYPE_COUNT || !obj->data){
+            result = KITTY_INVALID_ARGUMENT; // Unknown object type
+            break;
+        }
+        k_SceneOrder entry = { obj->id, obj->type, obj->priority };
+        result = k_SceneAppend(&order, &entry, sizeof(entry), 1, NULL);
+        if (result == KITTY_SUCCESS){
+            result = k_SceneWriteObject(obj, &sections[obj->type], &blob, textures, texture_count);
+        }
+    }
+
+    // table: order, the object types in use, blob; every section starts 8 byte aligned
+    k_SceneSection table[K_SCENE_TYPE_COUNT + 2];
+    const k_SceneBuffer* contents[K_SCENE_TYPE_COUNT + 2];
+    Uint32 section_count = 0;
+    table[section_count] = (k_SceneSection){ K_SCENE_SECTION_ORDER, sizeof(k_SceneOrder), 0, object_count };
+    contents[section_count++] = &order;
+    for (Uint32 t = 0; t < K_SCENE_TYPE_COUNT; t++){
+        if (sections[t].size > 0){
+            table[section_count] = (k_SceneSection){ t, (Uint32)k_scene_record_sizes[t], 0, sections[t].size / k_scene_record_sizes[t] };
+            contents[section_count++] = &sections[t];
+        }
+    }
+    table[section_count] = (k_SceneSection){ K_SCENE_SECTION_BLOB, 1, 0, blob.size };
+    contents[section_count++] = &blob;
+    Uint64 position = sizeof(k_SceneHeader) + section_count * sizeof(k_SceneSection);
+    for (Uint32 s = 0; s < section_count; s++){
+        position = (position + 7) / 8 * 8;
+        table[s].offset = position;
+        position += contents[s]->size;
+    }
+
+    k_SceneHeader header = { {'K', 'S', 'N', '1'}, K_SCENE_VERSION, K_SCENE_BYTE_ORDER, sizeof(size_t), section_count, 0,
+                             object_count, k_camera_position, k_camera_origin };
+    FILE* file = result == KITTY_SUCCESS ? fopen(file_path, "wb") : NULL;
+    if (result == KITTY_SUCCESS && !file){
+        result = KITTY_FILE_NOT_FOUND;
+    }
+    if (file){
+        position = sizeof(header) + section_count * sizeof(k_SceneSection);
+        if (fwrite(&header, sizeof(header), 1, file) != 1 || fwrite(table, sizeof(k_SceneSection), section_count, file) != section_count){
+            result = KITTY_UNKNOWN_ERROR;
+        }
+        for (Uint32 s = 0; s < section_count && result == KITTY_SUCCESS; s++){
+            result = k_WriteScenePadding(file, &position);
+            if (result == KITTY_SUCCESS && contents[s]->size > 0 && fwrite(contents[s]->data, contents[s]->size, 1, file) != 1){
+                result = KITTY_UNKNOWN_ERROR;
+            }
+            position += contents[s]->size;
+        }
+        if (fclose(file) != 0 && result == KITTY_SUCCESS){
+            result = KITTY_UNKNOWN_ERROR;
+        }
+    }
+    for (int t = 0; t < K_SCENE_TYPE_COUNT; t++){
+        k_Free(sections[t].data);
+    }
+    k_Free(order.data);
+    k_Free(blob.data);
+    return result;
+}
+
+int Kitty_SaveScene(const char* file_path, Kitty_Texture* const* textures, size_t texture_count){
+    if (!object_mspace){
+        return KITTY_MEMORYSPACE_NOT_INITIALIZED; // Memory space not initialized
+    }
+    if (!file_path || (!textures && texture_count > 0)){
+        return KITTY_INVALID_ARGUMENT;
+    }
+    return k_WriteScene(file_path, object_mspace->objects, object_mspace->allocation_count, textures, texture_count);
+}
+
+typedef struct {
+    const Uint8* blob;
+    Uint64 blob_size;
+    Kitty_Texture* const* textures;
+    size_t texture_count;
+} k_SceneReader;
+
+///@brief Copies count elements at a blob offset into a new engine block; empty arrays come back as NULL.
+static int k_SceneCopy(const k_SceneReader* reader, Uint64 offset, Uint64 count, size_t element_size, enum Kitty_MemoryTag tag, void** out){
+    *out = NULL;
+    if (count == 0){
+        return KITTY_SUCCESS;
+    }
+    if (offset > reader->blob_size || count > (reader->blob_size - offset) / element_size || count > SIZE_MAX / element_size){
+        return KITTY_INVALID_FILE; // Array outside the blob
+    }
+    *out = k_Alloc((size_t)count * element_size, tag);
+    if (!*out){
+        return KITTY_MEMORY_ALLOCATION_FAILURE;
+    }
+    memcpy(*out, reader->blob + offset, (size_t)count * element_size);
+    return KITTY_SUCCESS;
+}
+
+static int k_SceneTexture(const k_SceneReader* reader, Sint32 index, Kitty_Texture** out){
+    *out = NULL;
+    if (index < 0){
+        return KITTY_SUCCESS;
+    }
+    if ((size_t)index >= reader->texture_count){
+        return KITTY_INVALID_ARGUMENT; // The snapshot was saved with a larger texture table
+    }
+    *out = reader->textures[index];
+    return KITTY_SUCCESS;
+}
+
+///@brief Checks that every face of a loaded mesh indexes its vertices and UVs.
+static bool k_SceneFacesValid(const Kitty_ObjMesh* mesh){
+    for (size_t f = 0; f < mesh->face_count; f++){
+        const Kitty_Face* face = &mesh->faces[f];
+        int vertices[3] = { face->a, face->b, face->c };
+        int uvs[3] = { face->uv_a, face->uv_b, face->uv_c };
+        for (int k = 0; k < 3; k++){
+            if (vertices[k] < 0 || (size_t)vertices[k] >= mesh->vertex_count || uvs[k] < 0 || (size_t)uvs[k] >= mesh->uv_count){
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+///@brief Checks the octree of a loaded point cloud: point ranges inside the cloud, and children after their parent
+///and no deeper than the builder goes, so drawing neither reads past the points nor recurses without end.
+static int k_SceneCheckPointCloudNodes(const Kitty_ObjPointCloud* cloud){
+    Uint8* depths = (Uint8*)k_Calloc(cloud->node_count, sizeof(Uint8), KITTY_MEMORY_POINT_CLOUDS);
+    if (!depths){
+        return KITTY_MEMORY_ALLOCATION_FAILURE;
+    }
+    int result = KITTY_SUCCESS;
+    for (size_t i = 0; i < cloud->node_count && result == KITTY_SUCCESS; i++){
+        const Kitty_PointCloudNode* node = &cloud->nodes[i];
+        if (node->first > cloud->point_count || node->count > cloud->point_count - node->first){
+            result = KITTY_INVALID_FILE; // Points outside the cloud
+        }
+        for (int c = 0; c < 8 && result == KITTY_SUCCESS; c++){
+            int child = node->children[c];
+            if (child == -1){
+                continue;
+            }
+            if (child <= (int)i || (size_t)child >= cloud->node_count || depths[i] >= K_POINT_CLOUD_MAX_DEPTH){
+                result = KITTY_INVALID_FILE; // Child missing, out of order or too deep
+                break;
+            }
+            depths[child] = (Uint8)SDL_max(depths[child], depths[i] + 1);
+        }
+    }
+    k_Free(depths);
+    return result;
+}
+
+///@brief Rebuilds one object's data from its record; on failure obj->data holds what was built so far.
+static int k_SceneReadObject(const k_SceneReader* reader, const void* record, Kitty_Object* obj){
+    if (obj->type <= KITTY_OBJECT_PIXEL){
+        obj->data = malloc(k_scene_record_sizes[obj->type]);
+        if (!obj->data){
+            return KITTY_MEMORY_ALLOCATION_FAILURE;
+        }
+        memcpy(obj->data, record, k_scene_record_sizes[obj->type]);
+        return KITTY_SUCCESS;
+    }
+    // zeroed so k_FreeObjectData can tear down a half built object
+    size_t data_sizes[K_SCENE_TYPE_COUNT] = {
+        [KITTY_OBJECT_MESH] = sizeof(Kitty_ObjMesh), [KITTY_OBJECT_TEXT] = sizeof(Kitty_ObjText),
+        [KITTY_OBJECT_TILEMAP] = sizeof(Kitty_ObjTilemap), [KITTY_OBJECT_POLYGON] = sizeof(Kitty_ObjPolygon),
+        [KITTY_OBJECT_POLYLINE] = sizeof(Kitty_ObjPolyline), [KITTY_OBJECT_PATH] = sizeof(Kitty_ObjPath),
+        [KITTY_OBJECT_PLOT] = sizeof(Kitty_ObjPlot), [KITTY_OBJECT_POINT_CLOUD] = sizeof(Kitty_ObjPointCloud),
+        [KITTY_OBJECT_TERRAIN] = sizeof(Kitty_ObjTerrain)
+    };
+    obj->data = calloc(1, data_sizes[obj->type]);
+    if (!obj->data){
+        return KITTY_MEMORY_ALLOCATION_FAILURE;
+    }
+    int result = KITTY_SUCCESS;
+    switch (obj->type){
+        case KITTY_OBJECT_TEXT: {
+            k_SceneText r;
+            memcpy(&r, record, sizeof(r));
+            Kitty_ObjText* text = (Kitty_ObjText*)obj->data;
+            text->position = r.position;
+            text->size = r.size;
+            text->rotation = r.rotation;
+            text->color = r.color;
+            if (r.length >= reader->blob_size){
+                return KITTY_INVALID_FILE;
+            }
+            result = k_SceneCopy(reader, r.text, r.length + 1, 1, KITTY_MEMORY_TEXT, (void**)&text->text);
+            if (result == KITTY_SUCCESS && text->text[r.length] != '\0'){
+                result = KITTY_INVALID_FILE; // Unterminated string
+            }
+            return result;
+        }
+        case KITTY_OBJECT_MESH: {
+            k_SceneMesh r;
+            memcpy(&r, record, sizeof(r));
+            Kitty_ObjMesh* mesh = (Kitty_ObjMesh*)obj->data;
+            mesh->position = r.position;
+            mesh->origin = r.origin;
+            mesh->scale = r.scale;
+            mesh->wrap = r.wrap != 0;
+            mesh->wire = r.wire != 0;
+            mesh->vertex_count = r.vertex_count;
+            mesh->face_count = r.face_count;
+            mesh->uv_count = r.uv_count;
+            result = k_SceneTexture(reader, r.texture, &mesh->texture);
+            if (result == KITTY_SUCCESS) result = k_SceneCopy(reader, r.vertices, r.vertex_count, sizeof(Kitty_Vertex3D), KITTY_MEMORY_MESHES, (void**)&mesh->vertices);
+            if (result == KITTY_SUCCESS) result = k_SceneCopy(reader, r.faces, r.face_count, sizeof(Kitty_Face), KITTY_MEMORY_MESHES, (void**)&mesh->faces);
+            if (result == KITTY_SUCCESS) result = k_SceneCopy(reader, r.face_colors, r.face_count, sizeof(Kitty_Color), KITTY_MEMORY_MESHES, (void**)&mesh->face_colors);
+            if (result == KITTY_SUCCESS) result = k_SceneCopy(reader, r.uvs, r.uv_count, sizeof(Kitty_UV), KITTY_MEMORY_MESHES, (void**)&mesh->uvs);
+            if (result == KITTY_SUCCESS && !k_SceneFacesValid(mesh)){
+                result = KITTY_INVALID_FILE; // Faces must index the mesh's vertices and UVs
+            }
+            if (result == KITTY_SUCCESS && r.impostor_threshold > 0.0f){
+                result = Kitty_SetMeshImpostor(obj, r.impostor_threshold);
+            }
+            return result;
+        }
+        case KITTY_OBJECT_TILEMAP: {
+            k_SceneTilemap r;
+            memcpy(&r, record, sizeof(r));
+            Kitty_ObjTilemap* map = (Kitty_ObjTilemap*)obj->data;
+            if (r.width <= 0 || r.height <= 0 || r.tile_width <= 0 || r.tile_height <= 0){
+                return KITTY_INVALID_FILE;
+            }
+            map->position = r.position;
+            map->width = r.width;
+            map->height = r.height;
+            map->tile_width = r.tile_width;
+            map->tile_height = r.tile_height;
+            map->chunks_x = (r.width + KITTY_TILEMAP_CHUNK_SIZE - 1) / KITTY_TILEMAP_CHUNK_SIZE;
+            map->chunks_y = (r.height + KITTY_TILEMAP_CHUNK_SIZE - 1) / KITTY_TILEMAP_CHUNK_SIZE;
+            result = k_SceneTexture(reader, r.atlas, &map->atlas);
+            if (result == KITTY_SUCCESS && (!map->atlas || !map->atlas->sdl_surface)){
+                result = KITTY_INVALID_ARGUMENT; // Tilemaps need an RGBA32 atlas
+            }
+            if (result == KITTY_SUCCESS) result = k_SceneCopy(reader, r.tiles, (Uint64)r.width * r.height, sizeof(Uint16), KITTY_MEMORY_SHAPES, (void**)&map->tiles);
+            if (result != KITTY_SUCCESS){
+                return result;
+            }
+            size_t chunk_count = (size_t)map->chunks_x * map->chunks_y;
+            map->chunk_slots = (int*)k_Alloc(chunk_count * sizeof(int), KITTY_MEMORY_SHAPES);
+            if (!map->chunk_slots){
+                return KITTY_MEMORY_ALLOCATION_FAILURE;
+            }
+            for (size_t i = 0; i < chunk_count; i++){
+                map->chunk_slots[i] = -1;
+            }
+            return KITTY_SUCCESS;
+        }
+        case KITTY_OBJECT_POLYGON: {
+            k_ScenePolygon r;
+            memcpy(&r, record, sizeof(r));
+            Kitty_ObjPolygon* poly = (Kitty_ObjPolygon*)obj->data;
+            k_InitPolygon(poly, r.filled != 0, (enum Kitty_FillRule)r.fill_rule, r.color);
+            result = k_SceneCopy(reader, r.points, r.point_count, sizeof(Kitty_Point), KITTY_MEMORY_SHAPES, (void**)&poly->points);
+            if (result == KITTY_SUCCESS) result = k_SceneCopy(reader, r.contour_ends, r.contour_count, sizeof(size_t), KITTY_MEMORY_SHAPES, (void**)&poly->contour_ends);
+            for (size_t c = 1; c < r.contour_count && result == KITTY_SUCCESS; c++){
+                if (poly->contour_ends[c] < poly->contour_ends[c - 1]){
+                    result = KITTY_INVALID_FILE; // Contours must follow each other
+                }
+            }
+            if (result == KITTY_SUCCESS && r.contour_count > 0 && poly->contour_ends[r.contour_count - 1] != r.point_count){
+                result = KITTY_INVALID_FILE; // Contours must cover the points
+            }
+            poly->point_count = poly->point_capacity = r.point_count;
+            poly->contour_count = poly->contour_capacity = r.contour_count;
+            return result;
+        }
+        case KITTY_OBJECT_POLYLINE: {
+            k_ScenePolyline r;
+            memcpy(&r, record, sizeof(r));
+            Kitty_ObjPolyline* line = (Kitty_ObjPolyline*)obj->data;
+            k_InitPolyline(line, r.width, (enum Kitty_LineJoin)r.join, r.color);
+            result = k_SceneCopy(reader, r.points, r.point_count, sizeof(Kitty_Point), KITTY_MEMORY_SHAPES, (void**)&line->points);
+            line->point_count = line->point_capacity = r.point_count;
+            return result;
+        }
+        case KITTY_OBJECT_PATH: {
+            k_ScenePath r;
+            memcpy(&r, record, sizeof(r));
+            Kitty_ObjPath* path = (Kitty_ObjPath*)obj->data;
+            path->position = r.position;
+            path->scale = r.scale;
+            path->flat_dirty = true;
+            path->flat_position = r.position;
+            k_InitPolyline(&path->line, r.width, (enum Kitty_LineJoin)r.join, r.color);
+            result = k_SceneCopy(reader, r.segments, r.segment_count, sizeof(Kitty_PathSegment), KITTY_MEMORY_SHAPES, (void**)&path->segments);
+            path->segment_count = r.segment_count;
+            return result;
+        }
+        case KITTY_OBJECT_PLOT: {
+            k_ScenePlot r;
+            memcpy(&r, record, sizeof(r));
+            Kitty_ObjPlot* plot = (Kitty_ObjPlot*)obj->data;
+            if (r.width <= 0 || r.height <= 0 || r.window == 0 || !(r.max_value > r.min_value)){
+                return KITTY_INVALID_FILE;
+            }
+            plot->position = r.position;
+            plot->width = r.width;
+            plot->height = r.height;
+            plot->min_value = r.min_value;
+            plot->max_value = r.max_value;
+            plot->window = r.window;
+            k_ScenePlotSeries* series = NULL;
+            result = k_SceneCopy(reader, r.series, r.series_count, sizeof(k_ScenePlotSeries), KITTY_MEMORY_OBJECTS, (void**)&series);
+            if (result == KITTY_SUCCESS && r.series_count > 0){
+                plot->series = (Kitty_PlotSeries*)k_Calloc(r.series_count, sizeof(Kitty_PlotSeries), KITTY_MEMORY_SHAPES);
+                result = plot->series ? KITTY_SUCCESS : KITTY_MEMORY_ALLOCATION_FAILURE;
+            }
+            if (result == KITTY_SUCCESS){
+                plot->series_count = r.series_count;
+            }
+            for (size_t i = 0; i < plot->series_count && result == KITTY_SUCCESS; i++){
+                Kitty_PlotSeries* s = &plot->series[i];
+                if (series[i].capacity == 0){
+                    result = KITTY_INVALID_FILE;
+                    break;
+                }
+                result = k_SceneCopy(reader, series[i].samples, series[i].capacity, sizeof(float), KITTY_MEMORY_SHAPES, (void**)&s->samples);
+                s->capacity = series[i].capacity;
+                s->total = series[i].total;
+                s->fold_dirty = true;
+                s->color = series[i].color;
+            }
+            k_Free(series);
+            return result;
+        }
+        case KITTY_OBJECT_POINT_CLOUD: {
+            k_ScenePointCloud r;
+            memcpy(&r, record, sizeof(r));
+            Kitty_ObjPointCloud* cloud = (Kitty_ObjPointCloud*)obj->data;
+            if (r.point_count == 0 || r.node_count == 0){
+                return KITTY_INVALID_FILE;
+            }
+            cloud->position = r.position;
+            cloud->scale = r.scale;
+            cloud->splat_size = r.splat_size;
+            cloud->lod_bias = r.lod_bias;
+            cloud->quantized = r.quantized != 0;
+            cloud->bounds_min = r.bounds_min;
+            cloud->bounds_max = r.bounds_max;
+            cloud->point_count = r.point_count;
+            cloud->node_count = r.node_count;
+            void** axes[3] = { cloud->quantized ? (void**)&cloud->qx : (void**)&cloud->x, cloud->quantized ? (void**)&cloud->qy : (void**)&cloud->y,
+                               cloud->quantized ? (void**)&cloud->qz : (void**)&cloud->z };
+            Uint64 offsets[3] = { r.x, r.y, r.z };
+            size_t axis_size = cloud->quantized ? sizeof(Uint16) : sizeof(float);
+            for (int a = 0; a < 3 && result == KITTY_SUCCESS; a++){
+                result = k_SceneCopy(reader, offsets[a], r.point_count, axis_size, KITTY_MEMORY_POINT_CLOUDS, axes[a]);
+            }
+            if (result == KITTY_SUCCESS) result = k_SceneCopy(reader, r.colors, r.point_count, sizeof(Uint32), KITTY_MEMORY_POINT_CLOUDS, (void**)&cloud->colors);
+            if (result == KITTY_SUCCESS) result = k_SceneCopy(reader, r.nodes, r.node_count, sizeof(Kitty_PointCloudNode), KITTY_MEMORY_POINT_CLOUDS, (void**)&cloud->nodes);
+            if (result == KITTY_SUCCESS) result = k_SceneCheckPointCloudNodes(cloud);
+            return result;
+        }
+        case KITTY_OBJECT_TERRAIN: {
+            k_SceneTerrain r;
+            memcpy(&r, record, sizeof(r));
+            Kitty_ObjTerrain* terrain = (Kitty_ObjTerrain*)obj->data;
+            if (r.width < 2 || r.depth < 2){
+                return KITTY_INVALID_FILE;
+            }
+            terrain->position = r.position;
+            terrain->scale = r.scale;
+            terrain->settings = r.settings;
+            terrain->width = r.width;
+            terrain->depth = r.depth;
+            result = k_SceneCopy(reader, r.heights, (size_t)r.width * r.depth, sizeof(Uint16), KITTY_MEMORY_MESHES, (void**)&terrain->heights);
+            if (result == KITTY_SUCCESS) result = k_BuildTerrain(terrain);
+            return result == KITTY_INVALID_ARGUMENT ? KITTY_INVALID_FILE : result;
+        }
+        default:
+            return KITTY_INVALID_FILE;
+    }
+}
+
+///@brief Maps a whole file read only, or reads it into one block where mmap is missing.
+static int k_MapFile(const char* file_path, const Uint8** out_data, size_t* out_size){
+#ifdef K_HAS_MMAP
+    int fd = open(file_path, O_RDONLY);
+    if (fd < 0){
+        return KITTY_FILE_NOT_FOUND;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0){
+        close(fd);
+        return KITTY_INVALID_FILE;
+    }
+    void* data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED){
+        return KITTY_MEMORY_ALLOCATION_FAILURE;
+    }
+    *out_data = (const Uint8*)data;
+    *out_size = (size_t)info.st_size;
+    return KITTY_SUCCESS;
+#else
+    FILE* file = fopen(file_path, "rb");
+    if (!file){
+        return KITTY_FILE_NOT_FOUND;
+    }
+    long size = fseek(file, 0, SEEK_END) == 0 ? ftell(file) : -1;
+    if (size <= 0 || fseek(file, 0, SEEK_SET) != 0){
+        fclose(file);
+        return KITTY_INVALID_FILE;
+    }
+    Uint8* data = (Uint8*)k_Alloc((size_t)size, KITTY_MEMORY_OBJECTS);
+    if (!data){
+        fclose(file);
+        return KITTY_MEMORY_ALLOCATION_FAILURE;
+    }
+    if (fread(data, 1, (size_t)size, file) != (size_t)size){
+        k_Free(data);
+        fclose(file);
+        return KITTY_INVALID_FILE;
+    }
+    fclose(file);
+    *out_data = data;
+    *out_size = (size_t)size;
+    return KITTY_SUCCESS;
+#endif
+}
+
+static void k_UnmapFile(const Uint8* data, size_t size){
+#ifdef K_HAS_MMAP
+    munmap((void*)data, size);
+#else
+    (void)size;
+    k_Free((void*)data);
+#endif
+}
+
+///@brief Builds the objects of a snapshot without touching the store; the caller owns them and their data.
+///Safe to call from a loader thread.
+static int k_ReadScene(const char* file_path, Kitty_Texture* const* textures, size_t texture_count,
+                       Kitty_Object** out_objects, size_t* out_count, k_SceneHeader* out_header, size_t* out_bytes){
+    *out_objects = NULL;
+    *out_count = 0;
+    const Uint8* file;
+    size_t file_size;
+    int result = k_MapFile(file_path, &file, &file_size);
+    if (result != KITTY_SUCCESS){
+        return result;
+    }
+    if (out_bytes){
+        *out_bytes = file_size;
+    }
+
+    k_SceneHeader header;
+    const k_SceneSection* table = NULL;
+    if (file_size < sizeof(header)){
+        result = KITTY_INVALID_FILE;
+    } else {
+        memcpy(&header, file, sizeof(header));
+        table = (const k_SceneSection*)(file + sizeof(header));
+        if (memcmp(header.magic, "KSN1", 4) != 0 || header.version != K_SCENE_VERSION || header.byte_order != K_SCENE_BYTE_ORDER ||
+            header.size_width != sizeof(size_t) || header.section_count > (file_size - sizeof(header)) / sizeof(k_SceneSection)){
+            result = KITTY_INVALID_FILE; // Not a snapshot, or one written by another version or platform
+        }
+    }
+
+    // every section has to lie inside the file and hold records of the size this build expects
+    const Uint8* sections[K_SCENE_TYPE_COUNT] = {0};
+    Uint64 section_counts[K_SCENE_TYPE_COUNT] = {0};
+    Uint64 cursors[K_SCENE_TYPE_COUNT] = {0};
+    const k_SceneOrder* order = NULL;
+    k_SceneReader reader = { NULL, 0, textures, texture_count };
+    for (Uint32 s = 0; result == KITTY_SUCCESS && s < header.section_count; s++){
+        k_SceneSection section = table[s];
+        size_t expected = section.kind == K_SCENE_SECTION_ORDER ? sizeof(k_SceneOrder) : section.kind == K_SCENE_SECTION_BLOB ? 1 :
+                          section.kind < K_SCENE_TYPE_COUNT ? k_scene_record_sizes[section.kind] : 0;
+        if (expected == 0 || section.record_size != expected || section.offset % 8 != 0 || section.offset > file_size ||
+            section.count > (file_size - section.offset) / expected){
+            result = KITTY_INVALID_FILE;
+            break;
+        }
+        const Uint8* data = file + section.offset;
+        if (section.kind == K_SCENE_SECTION_ORDER){
+            order = (const k_SceneOrder*)data;
+            if (section.count != header.object_count){
+                result = KITTY_INVALID_FILE;
+            }
+        } else if (section.kind == K_SCENE_SECTION_BLOB){
+            reader.blob = data;
+            reader.blob_size = section.count;
+        } else {
+            sections[section.kind] = data;
+            section_counts[section.kind] = section.count;
+        }
+    }
+    if (result == KITTY_SUCCESS && ((!order && header.object_count > 0) || !reader.blob)){
+        result = KITTY_INVALID_FILE;
+    }
+
+    Kitty_Object* objects = NULL;
+    size_t built = 0;
+    if (result == KITTY_SUCCESS && header.object_count > 0){
+        objects = (Kitty_Object*)k_Calloc((size_t)header.object_count, sizeof(Kitty_Object), KITTY_MEMORY_OBJECTS);
+        result = objects ? KITTY_SUCCESS : KITTY_MEMORY_ALLOCATION_FAILURE;
+    }
+    for (; result == KITTY_SUCCESS && built < header.object_count; built++){
+        k_SceneOrder entry;
+        memcpy(&entry, &order[built], sizeof(entry));
+        if (entry.type >= K_SCENE_TYPE_COUNT || cursors[entry.type] >= section_counts[entry.type] ||
+            entry.priority > KITTY_PRIORITY_HIGH){
+            result = KITTY_INVALID_FILE;
+            break;
+        }
+        Kitty_Object* obj = &objects[built];
+        obj->type = (enum Kitty_ObjType)entry.type;
+        obj->priority = (enum Kitty_Priority)entry.priority;
+        obj->id = entry.id;
+        result = k_SceneReadObject(&reader, sections[entry.type] + cursors[entry.type]++ * k_scene_record_sizes[entry.type], obj);
+        if (result != KITTY_SUCCESS){
+            k_FreeObjectData(obj);
+            break;
+        }
+    }
+    k_UnmapFile(file, file_size);
+
+    if (result != KITTY_SUCCESS){
+        for (size_t i = 0; i < built; i++){
+            k_FreeObjectData(&objects[i]);
+        }
+        k_Free(objects);
+        return result;
+    }
+    *out_objects = objects;
+    *out_count = built;
+    *out_header = header;
+    return KITTY_SUCCESS;
+}
+
+int Kitty_LoadScene(const char* file_path, Kitty_Texture* const* textures, size_t texture_count){
+    if (!object_mspace){
+        return KITTY_MEMORYSPACE_NOT_INITIALIZED; // Memory space not initialized
+    }
+    if (!file_path || (!textures && texture_count > 0)){
+        return KITTY_INVALID_ARGUMENT;
+    }
+    Kitty_Object* objects;
+    size_t count;
+    k_SceneHeader header;
+    int result = k_ReadScene(file_path, textures, texture_count, &objects, &count, &header, NULL);
+    if (result != KITTY_SUCCESS){
+        return result;
+    }
+    Kitty_ClearObjects();
+    result = Kitty_AddObjects(objects, count);
+    if (result == KITTY_SUCCESS){
+        k_camera_position = header.camera_position;
+        k_camera_origin = header.camera_origin;
+    } else {
+        for (size_t i = 0; i < count; i++){
+            k_FreeObjectData(&objects[i]);
+        }
+    }
+    k_Free(objects);
+    return result;
+}
+
+// WORLD PARTITION STUFF
+
+static int k_WorldCellPath(const char* directory, int x, int y, char* path, size_t size){
+    int length = snprintf(path, size, "%s/cell_%d_%d.ksn", directory, x, y);
+    return length > 0 && (size_t)length < size ? KITTY_SUCCESS : KITTY_INVALID_ARGUMENT;
+}
+
+int Kitty_SaveWorldCell(const char* directory, int x, int y, const Kitty_Object* objects, size_t count, Kitty_Texture* const* textures, size_t texture_count){
+    if (!directory || (!objects && count > 0) || (!textures && texture_count > 0)){
+        return KITTY_INVALID_ARGUMENT;
+    }
+    char path[1024];
+    int result = k_WorldCellPath(directory, x, y, path, sizeof(path));
+    return result == KITTY_SUCCESS ? k_WriteScene(path, objects, count, textures, texture_count) : result;
+}
+
+static float k_WorldCellDistance(const Kitty_World* world, int x, int y, Kitty_Vertex3D camera){
+    float dx = ((float)x + 0.5f) * world->settings.cell_size - camera.x;
+    float dz = ((float)y + 0.5f) * world->settings.cell_size - camera.z;
+    return sqrtf(dx * dx + dz * dz);
+}
+
+///@brief Nearest queued cell, called by the loader with the lock held.
+static Kitty_WorldCell* k_NextQueuedCell(Kitty_World* world){
+    Kitty_WorldCell* next = NULL;
+    for (size_t i = 0; i < world->cell_count; i++){
+        Kitty_WorldCell* cell = world->cells[i];
+        if (cell->state == KITTY_CELL_QUEUED && (!next || cell->distance < next->distance)){
+            next = cell;
+        }
+    }
+    return next;
+}
+
+// the loader owns a cell only while it is READING; the render thread never frees a cell in that state
+static int k_WorldLoader(void* data){
+    Kitty_World* world = (Kitty_World*)data;
+    SDL_LockMutex(world->lock);
+    while (true){
+        Kitty_WorldCell* cell = NULL;
+        while (!world->quit && !(cell = k_NextQueuedCell(world))){
+            SDL_CondWait(world->wake, world->lock);
+        }
+        if (world->quit){
+            break;
+        }
+        cell->state = KITTY_CELL_READING;
+        char path[1024];
+        int result = k_WorldCellPath(world->directory, cell->x, cell->y, path, sizeof(path));
+        SDL_UnlockMutex(world->lock);
+
+        double start = k_NowMs();
+        Kitty_Object* objects = NULL;
+        size_t count = 0;
+        size_t bytes = 0;
+        k_SceneHeader header;
+        if (result == KITTY_SUCCESS){
+            result = k_ReadScene(path, world->settings.textures, world->settings.texture_count, &objects, &count, &header, &bytes);
+        }
+        if (result == KITTY_FILE_NOT_FOUND){
+            result = KITTY_SUCCESS; // cells without content have no snapshot
+        }
+        void** members = count > 0 ? (void**)k_Alloc(count * sizeof(void*), KITTY_MEMORY_OBJECTS) : NULL;
+        if (count > 0 && !members){
+            for (size_t i = 0; i < count; i++){
+                k_FreeObjectData(&objects[i]);
+            }
+            k_Free(objects);
+            objects = NULL;
+            count = 0;
+            result = KITTY_MEMORY_ALLOCATION_FAILURE;
+        }
+        double elapsed = k_NowMs() - start;
+
+        SDL_LockMutex(world->lock);
+        cell->result = result;
+        cell->objects = objects;
+        cell->object_count = count;
+        cell->members = members;
+        cell->state = KITTY_CELL_INTEGRATING;
+        world->stats.bytes_read += bytes;
+        world->stats.read_ms += elapsed;
+    }
+    SDL_UnlockMutex(world->lock);
+    return 0;
+}
+
+Kitty_World* Kitty_OpenWorld(const Kitty_WorldSettings* settings){
+    if (!settings || !settings->directory || !(settings->cell_size > 0.0f) || !(settings->load_radius > 0.0f) ||
+        settings->unload_radius < settings->load_radius || (!settings->textures && settings->texture_count > 0)){
+        return NULL;
+    }
+    Kitty_World* world = (Kitty_World*)k_Calloc(1, sizeof(Kitty_World), KITTY_MEMORY_OBJECTS);
+    if (!world){
+        return NULL;
+    }
+    world->settings = *settings;
+    size_t length = strlen(settings->directory);
+    world->directory = (char*)k_Alloc(length + 1, KITTY_MEMORY_OBJECTS);
+    world->lock = SDL_CreateMutex();
+    world->wake = SDL_CreateCond();
+    if (!world->directory || !world->lock || !world->wake){
+        Kitty_CloseWorld(world);
+        return NULL;
+    }
+    memcpy(world->directory, settings->directory, length + 1);
+    world->settings.directory = world->directory;
+    world->loader = SDL_CreateThread(k_WorldLoader, "kitty_world_loader", world);
+    if (!world->loader){
+        Kitty_CloseWorld(world);
+        return NULL;
+    }
+    return world;
+}
+
+static void k_FreeWorldCell(Kitty_WorldCell* cell){
+    for (size_t i = cell->integrated; i < cell->object_count; i++){
+        k_FreeObjectData(&cell->objects[i]);
+    }
+    k_Free(cell->objects);
+    k_Free(cell->members);
+    k_Free(cell);
+}
+
+static int k_ComparePointers(const void* a, const void* b){
+    uintptr_t pa = (uintptr_t)*(void* const*)a;
+    uintptr_t pb = (uintptr_t)*(void* const*)b;
+    return (pa > pb) - (pa < pb);
+}
+
+static bool k_WorldObjectDoomed(const Kitty_Object* obj, void* user_data){
+    Kitty_World* world = (Kitty_World*)user_data;
+    if (!bsearch(&obj->data, world->doomed, world->doomed_count, sizeof(void*), k_ComparePointers)){
+        return false;
+    }
+    k_FreeObjectData((Kitty_Object*)obj); // the slot is compacted away right after
+    return true;
+}
+
+///@brief Removes the integrated objects of the given cells from the store in one pass and frees the cells.
+///Without memory for the pass the objects stay in the store as ordinary objects.
+static int k_DropWorldCells(Kitty_World* world, Kitty_WorldCell** cells, size_t count){
+    size_t doomed = 0;
+    for (size_t i = 0; i < count; i++){
+        doomed += cells[i]->integrated;
+    }
+    int result = KITTY_SUCCESS;
+    if (doomed > 0 && object_mspace && !k_GrowScratch((void**)&world->doomed, &world->doomed_capacity, doomed * sizeof(void*))){
+        result = KITTY_MEMORY_ALLOCATION_FAILURE;
+    } else if (doomed > 0 && object_mspace){
+        doomed = 0;
+        for (size_t i = 0; i < count; i++){
+            if (cells[i]->integrated == 0){
+                continue;
+            }
+            memcpy(world->doomed + doomed, cells[i]->members, cells[i]->integrated * sizeof(void*));
+            doomed += cells[i]->integrated;
+        }
+        qsort(world->doomed, doomed, sizeof(void*), k_ComparePointers);
+        world->doomed_count = doomed;
+        size_t removed = 0;
+        result = Kitty_RemoveIf(k_WorldObjectDoomed, world, &removed);
+        world->stats.objects_removed += removed;
+    }
+    for (size_t i = 0; i < count; i++){
+        k_FreeWorldCell(cells[i]);
+    }
+    return result;
+}
+
+static int k_CompareCellDistance(const void* a, const void* b){
+    float da = (*(Kitty_WorldCell* const*)a)->distance;
+    float db = (*(Kitty_WorldCell* const*)b)->distance;
+    return (da > db) - (da < db);
+}
+
+int Kitty_UpdateWorld(Kitty_World* world){
+    if (!world){
+        return KITTY_INVALID_ARGUMENT;
+    }
+    if (!object_mspace){
+        return KITTY_MEMORYSPACE_NOT_INITIALIZED; // Memory space not initialized
+    }
+    const Kitty_WorldSettings* settings = &world->settings;
+    Kitty_Vertex3D camera = k_camera_position;
+
+    // cells beyond the unload radius leave; one the loader is reading waits for the next update
+    SDL_LockMutex(world->lock);
+    size_t leaving = 0;
+    if (!k_GrowScratch((void**)&world->ready, &world->ready_capacity, SDL_max(world->cell_count, (size_t)1) * sizeof(Kitty_WorldCell*))){
+        SDL_UnlockMutex(world->lock);
+        return KITTY_MEMORY_ALLOCATION_FAILURE;
+    }
+    size_t kept = 0;
+    for (size_t i = 0; i < world->cell_count; i++){
+        Kitty_WorldCell* cell = world->cells[i];
+        cell->distance = k_WorldCellDistance(world, cell->x, cell->y, camera);
+        if (cell->distance > settings->unload_radius && cell->state != KITTY_CELL_READING){
+            if (cell->state == KITTY_CELL_RESIDENT || cell->integrated > 0){
+                world->stats.cells_unloaded++;
+                k_Log(KITTY_EVENT_WORLD_CELL_UNLOADED, NULL, -1, cell->x, cell->y, 0);
+            }
+            world->ready[leaving++] = cell;
+        } else {
+            world->cells[kept++] = cell;
+        }
+    }
+    world->cell_count = kept;
+    SDL_UnlockMutex(world->lock);
+    int result = k_DropWorldCells(world, world->ready, leaving);
+
+    // new cells within the load radius, on a square around the camera cell
+    SDL_LockMutex(world->lock);
+    int reach = (int)ceilf(settings->load_radius / settings->cell_size);
+    int camera_x = (int)floorf(camera.x / settings->cell_size);
+    int camera_y = (int)floorf(camera.z / settings->cell_size);
+    bool queued = false;
+    for (int y = camera_y - reach; y <= camera_y + reach && result == KITTY_SUCCESS; y++){
+        for (int x = camera_x - reach; x <= camera_x + reach; x++){
+            float distance = k_WorldCellDistance(world, x, y, camera);
+            if (distance > settings->load_radius){
+                continue;
+            }
+            bool known = false;
+            for (size_t i = 0; i < world->cell_count && !known; i++){
+                known = world->cells[i]->x == x && world->cells[i]->y == y;
+            }
+            if (known){
+                continue;
+            }
+            if (world->cell_count == world->cell_capacity){
+                size_t capacity = SDL_max(world->cell_capacity * 2, (size_t)16);
+                Kitty_WorldCell** cells = (Kitty_WorldCell**)k_Realloc(world->cells, capacity * sizeof(Kitty_WorldCell*), KITTY_MEMORY_OBJECTS);
+                if (!cells){
+                    result = KITTY_MEMORY_ALLOCATION_FAILURE;
+                    break;
+                }
+                world->cells = cells;
+                world->cell_capacity = capacity;
+            }
+            Kitty_WorldCell* cell = (Kitty_WorldCell*)k_Calloc(1, sizeof(Kitty_WorldCell), KITTY_MEMORY_OBJECTS);
+            if (!cell){
+                result = KITTY_MEMORY_ALLOCATION_FAILURE;
+                break;
+            }
+            cell->x = x;
+            cell->y = y;
+            cell->state = KITTY_CELL_QUEUED;
+            cell->distance = distance;
+            world->cells[world->cell_count++] = cell;
+            queued = true;
+        }
+    }
+    if (queued){
+        SDL_CondSignal(world->wake);
+    }
+
+    // integrating cells, nearest first
+    size_t ready = 0;
+    if (k_GrowScratch((void**)&world->ready, &world->ready_capacity, SDL_max(world->cell_count, (size_t)1) * sizeof(Kitty_WorldCell*))){
+        for (size_t i = 0; i < world->cell_count; i++){
+            if (world->cells[i]->state == KITTY_CELL_INTEGRATING){
+                world->ready[ready++] = world->cells[i];
+            }
+        }
+    }
+    SDL_UnlockMutex(world->lock);
+
+    // the loader no longer touches integrating cells, so they move into the store without the lock
+    qsort(world->ready, ready, sizeof(Kitty_WorldCell*), k_CompareCellDistance);
+    size_t budget = settings->integrate_budget ? settings->integrate_budget : SIZE_MAX;
+    for (size_t i = 0; i < ready && budget > 0; i++){
+        Kitty_WorldCell* cell = world->ready[i];
+        size_t count = SDL_min(cell->object_count - cell->integrated, budget);
+        int add_result = cell->result;
+        if (add_result == KITTY_SUCCESS && count > 0){
+            add_result = Kitty_AddObjects(cell->objects + cell->integrated, count);
+        }
+        if (add_result == KITTY_SUCCESS){
+            for (size_t j = 0; j < count; j++){
+                cell->members[cell->integrated + j] = cell->objects[cell->integrated + j].data;
+            }
+            cell->integrated += count;
+            budget -= count;
+            world->stats.objects_integrated += count;
+        } else {
+            // keep what made it in, the rest of the cell is given up until it streams in again
+            for (size_t j = cell->integrated; j < cell->object_count; j++){
+                k_FreeObjectData(&cell->objects[j]);
+            }
+            cell->object_count = cell->integrated;
+            world->stats.cells_failed++;
+            k_Log(add_result, NULL, -1, cell->x, cell->y, 0);
+        }
+        if (cell->integrated == cell->object_count){
+            k_Free(cell->objects);
+            cell->objects = NULL;
+            SDL_LockMutex(world->lock);
+            cell->state = KITTY_CELL_RESIDENT;
+            SDL_UnlockMutex(world->lock);
+            if (add_result == KITTY_SUCCESS){
+                world->stats.cells_loaded++;
+                k_Log(KITTY_EVENT_WORLD_CELL_LOADED, NULL, -1, cell->x, cell->y, (Sint64)cell->object_count);
+            }
+        }
+    }
+    return result;
+}
+
+void Kitty_CloseWorld(Kitty_World* world){
+    if (!world){
+        return;
+    }
+    if (world->loader){
+        SDL_LockMutex(world->lock);
+        world->quit = true;
+        SDL_CondSignal(world->wake);
+        SDL_UnlockMutex(world->lock);
+        SDL_WaitThread(world->loader, NULL);
+    }
+    k_DropWorldCells(world, world->cells, world->cell_count);
+    if (world->wake){
+        SDL_DestroyCond(world->wake);
+    }
+    if (world->lock){
+        SDL_DestroyMutex(world->lock);
+    }
+    k_Free(world->cells);
+    k_Free(world->doomed);
+    k_Free(world->ready);
+    k_Free(world->directory);
+    k_Free(world);
+}
+
+int Kitty_GetWorldStats(Kitty_World* world, Kitty_WorldStats* out_stats){
+    if (!world || !out_stats){
+        return KITTY_INVALID_ARGUMENT;
+    }
+    SDL_LockMutex(world->lock);
+    *out_stats = world->stats;
+    out_stats->resident_cells = out_stats->loading_cells = out_stats->integrating_cells = 0;
+    for (size_t i = 0; i < world->cell_count; i++){
+        switch (world->cells[i]->state){
+            case KITTY_CELL_QUEUED:
+            case KITTY_CELL_READING:
+                out_stats->loading_cells++;
+                break;
+            case KITTY_CELL_INTEGRATING:
+                out_stats->integrating_cells++;
+                break;
+            case KITTY_CELL_RESIDENT:
+                out_stats->resident_cells++;
+                break;
+        }
+    }
+    SDL_UnlockMutex(world->lock);
+    return KITTY_SUCCESS;
+}
+
+// TIMER WHEEL STUFF
+
+// K_TIMER_LEVELS levels of 64 slots on a 1 ms tick, each level 64 times coarser than the one below. A timer sits in
+// the slot of the coarsest level it fits and moves down a level every time the wheel reaches that slot, so it is
+// touched at most once per level before it fires. The levels span 2^30 ms, timers beyond wait in the top level.
+#define K_TIMER_SLOT_BITS 6
+#define K_TIMER_SLOTS (1 << K_TIMER_SLOT_BITS)
+#define K_TIMER_LEVELS 5
+#define K_TIMER_SPAN ((Uint64)1 << (K_TIMER_SLOT_BITS * K_TIMER_LEVELS))
+#define K_TIMER_FIRING (K_TIMER_LEVELS * K_TIMER_SLOTS) // list of the timers being dispatched
+#define K_TIMER_FREE (K_TIMER_FIRING + 1)
+#define K_TIMER_NONE UINT32_MAX
+
+typedef struct {
+    Uint64 expiry;              // tick it fires on
+    Uint32 period;              // 0 for a one-shot timer
+    Uint32 generation;          // bumped on release so stale ids miss
+    Uint32 prev;
+    Uint32 next;
+    Uint32 list;                // wheel slot, K_TIMER_FIRING or K_TIMER_FREE
+    Kitty_TimerCallback callback;
+    void* user_data;
+} k_TimerNode;
+
+typedef struct {
+    k_TimerNode* nodes;
+    Uint32 capacity;
+    Uint32 free_head;
+    Uint32 active;
+    Uint32 heads[K_TIMER_FIRING + 1];
+    Uint64 occupied[K_TIMER_LEVELS];    // bit per slot with a non-empty list
+    Uint64 now;                         // last tick dispatched
+    bool started;
+} k_TimerWheel;
+
+static k_TimerWheel k_timers = {0};
+
+static Uint64 k_TimerTick(){
+    return (Uint64)k_NowMs();
+}
+
+static Kitty_TimerID k_TimerID(Uint32 index){
+    return ((Uint64)k_timers.nodes[index].generation << 32) | ((Uint64)index + 1);
+}
+
+static void k_LinkTimer(Uint32 index, Uint32 list){
+    k_TimerNode* node = &k_timers.nodes[index];
+    node->list = list;
+    node->prev = K_TIMER_NONE;
+    node->next = k_timers.heads[list];
+    if (node->next != K_TIMER_NONE){
+        k_timers.nodes[node->next].prev = index;
+    }
+    k_timers.heads[list] = index;
+    if (list < K_TIMER_FIRING){
+        k_timers.occupied[list / K_TIMER_SLOTS] |= (Uint64)1 << (list % K_TIMER_SLOTS);
+    }
+}
+
+static void k_UnlinkTimer(Uint32 index){
+    k_TimerNode* node = &k_timers.nodes[index];
+    if (node->prev != K_TIMER_NONE){
+        k_timers.nodes[node->prev].next = node->next;
+    } else {
+        k_timers.heads[node->list] = node->next;
+    }
+    if (node->next != K_TIMER_NONE){
+        k_timers.nodes[node->next].prev = node->prev;
+    }
+    if (node->list < K_TIMER_FIRING && k_timers.heads[node->list] == K_TIMER_NONE){
+        k_timers.occupied[node->list / K_TIMER_SLOTS] &= ~((Uint64)1 << (node->list % K_TIMER_SLOTS));
+    }
+}
+
+///@brief Puts a timer into the slot of the coarsest level its expiry fits, relative to the last dispatched tick.
+static void k_ScheduleTimer(Uint32 index){
+    Uint64 expiry = k_timers.nodes[index].expiry;
+    if (expiry <= k_timers.now){
+        expiry = k_timers.now + 1; // due already, fires on the next tick
+    }
+    if (expiry - k_timers.now > K_TIMER_SPAN){
+        expiry = k_timers.now + K_TIMER_SPAN; // parked in the top level, rescheduled when it comes down
+    }
+    // level 0 holds the next 64 ticks, the slot of now is done; a cascade must never refill the slot it empties
+    Uint64 delta = expiry - k_timers.now;
+    int level = 0;
+    while (delta > (Uint64)1 << (K_TIMER_SLOT_BITS * (level + 1))){
+        level++;
+    }
+    Uint32 slot = (Uint32)(expiry >> (K_TIMER_SLOT_BITS * level)) & (K_TIMER_SLOTS - 1);
+    k_LinkTimer(index, (Uint32)level * K_TIMER_SLOTS + slot);
+}
+
+static void k_ReleaseTimer(Uint32 index){
+    k_TimerNode* node = &k_timers.nodes[index];
+    node->generation++;
+    node->callback = NULL;
+    node->list = K_TIMER_FREE;
+    node->next = k_timers.free_head;
+    k_timers.free_head = index;
+    k_timers.active--;
+}
+
+static void k_StartTimerWheel(){
+    for (int i = 0; i <= K_TIMER_FIRING; i++){
+        k_timers.heads[i] = K_TIMER_NONE;
+    }
+    memset(k_timers.occupied, 0, sizeof(k_timers.occupied));
+    k_timers.free_head = K_TIMER_NONE;
+    k_timers.now = k_TimerTick();
+    k_timers.started = true;
+}
+
+int Kitty_StartTimer(Uint32 delay_ms, Uint32 period_ms, Kitty_TimerCallback callback, void* user_data, Kitty_TimerID* out_timer){
+    if (!callback){
+        return KITTY_INVALID_ARGUMENT;
+    }
+    if (!k_timers.started){
+        k_StartTimerWheel();
+    }
+    if (k_timers.free_head == K_TIMER_NONE){
+        if (k_timers.capacity >= K_TIMER_NONE / 2){
+            return KITTY_MEMORY_ALLOCATION_FAILURE;
+        }
+        Uint32 capacity = k_timers.capacity ? k_timers.capacity * 2 : 64;
+        k_TimerNode* nodes = (k_TimerNode*)k_Realloc(k_timers.nodes, capacity * sizeof(k_TimerNode), KITTY_MEMORY_OBJECTS);
+        if (!nodes){
+            return KITTY_MEMORY_ALLOCATION_FAILURE; // Memory allocation failed
+        }
+        k_timers.nodes = nodes;
+        for (Uint32 i = capacity; i-- > k_timers.capacity; ){
+            nodes[i] = (k_TimerNode){0};
+            nodes[i].list = K_TIMER_FREE;
+            nodes[i].next = k_timers.free_head;
+            k_timers.free_head = i;
+        }
+        k_timers.capacity = capacity;
+    }
+    Uint32 index = k_timers.free_head;
+    k_TimerNode* node = &k_timers.nodes[index];
+    k_timers.free_head = node->next;
+    k_timers.active++;
+    node->expiry = k_TimerTick() + delay_ms;
+    node->period = period_ms;
+    node->callback = callback;
+    node->user_data = user_data;
+    k_ScheduleTimer(index);
+    if (out_timer){
+        *out_timer = k_TimerID(index);
+    }
+    return KITTY_SUCCESS;
+}
+
+int Kitty_CancelTimer(Kitty_TimerID timer){
+    Uint64 slot = timer & 0xFFFFFFFFu;
+    if (slot == 0 || slot > k_timers.capacity){
+        return KITTY_OBJECT_NOT_FOUND;
+    }
+    Uint32 index = (Uint32)slot - 1;
+    if (k_timers.nodes[index].list == K_TIMER_FREE || k_TimerID(index) != timer){
+        return KITTY_OBJECT_NOT_FOUND; // Fired or cancelled already
+    }
+    k_UnlinkTimer(index);
+    k_ReleaseTimer(index);
+    return KITTY_SUCCESS;
+}
+
+size_t Kitty_GetTimerCount(){
+    return k_timers.active;
+}
+
+///@brief Moves the timers of a slot one level down, or into level 0, relative to the tick before this one.
+static void k_CascadeTimers(Uint32 list){
+    Uint32 index = k_timers.heads[list];
+    k_timers.heads[list] = K_TIMER_NONE;
+    k_timers.occupied[list / K_TIMER_SLOTS] &= ~((Uint64)1 << (list % K_TIMER_SLOTS));
+    while (index != K_TIMER_NONE){
+        Uint32 next = k_timers.nodes[index].next;
+        k_ScheduleTimer(index);
+        index = next;
+    }
+}
+
+///@brief Runs the callbacks of the level 0 slot of tick, which is k_timers.now.
+static size_t k_FireTimers(Uint32 list){
+    // the slot moves to the firing list first so callbacks can start and cancel timers, the firing ones too
+    Uint32 index = k_timers.heads[list];
+    k_timers.heads[list] = K_TIMER_NONE;
+    k_timers.occupied[0] &= ~((Uint64)1 << list);
+    k_timers.heads[K_TIMER_FIRING] = index;
+    for (; index != K_TIMER_NONE; index = k_timers.nodes[index].next){
+        k_timers.nodes[index].list = K_TIMER_FIRING;
+    }
+    size_t fired = 0;
+    while ((index = k_timers.heads[K_TIMER_FIRING]) != K_TIMER_NONE){
+        k_UnlinkTimer(index);
+        k_TimerNode* node = &k_timers.nodes[index];
+        Kitty_TimerID id = k_TimerID(index);
+        Kitty_TimerCallback callback = node->callback;
+        void* user_data = node->user_data;
+        if (node->period){
+            // skip the periods that were missed, the timer keeps its phase
+            node->expiry += (Uint64)node->period * ((k_timers.now - node->expiry) / node->period + 1);
+            k_ScheduleTimer(index);
+        } else {
+            k_ReleaseTimer(index);
+        }
+        callback(id, user_data); // may grow k_timers.nodes, node is stale after this
+        fired++;
+    }
+    return fired;
+}
+
+static void k_RunTimers(){
+    k_frame_stats.timers_fired = 0;
+    k_frame_stats.timer_ms = 0.0;
+    if (!k_timers.started){
+        return;
+    }
+    double start = k_NowMs();
+    Uint64 target = k_TimerTick();
+    while (k_timers.now < target){
+        if (k_timers.active == 0){
+            k_timers.now = target; // every list is empty
+            break;
+        }
+        Uint64 tick = k_timers.now + 1;
+        Uint32 offset = (Uint32)(tick & (K_TIMER_SLOTS - 1));
+        if (offset != 0){
+            // jump to the next occupied level 0 slot, or to the next cascade
+            Uint64 pending = k_timers.occupied[0] >> offset;
+            if (pending){
+                while (!(pending & 1)){
+                    pending >>= 1;
+                    tick++;
+                }
+            } else {
+                tick = (tick | (K_TIMER_SLOTS - 1)) + 1;
+            }
+            if (tick > target){
+                k_timers.now = target;
+                break;
+            }
+        }
+        k_timers.now = tick - 1; // cascades schedule relative to the tick before
+        if ((tick & (K_TIMER_SLOTS - 1)) == 0){
+            // coarsest level first, what it drops into a finer slot that is due now still gets cascaded
+            int level = 1;
+            while (level < K_TIMER_LEVELS - 1 && ((tick >> (K_TIMER_SLOT_BITS * level)) & (K_TIMER_SLOTS - 1)) == 0){
+                level++;
+            }
+            for (; level >= 1; level--){
+                Uint32 slot = (Uint32)(tick >> (K_TIMER_SLOT_BITS * level)) & (K_TIMER_SLOTS - 1);
+                if (k_timers.heads[level * K_TIMER_SLOTS + slot] != K_TIMER_NONE){
+                    k_CascadeTimers((Uint32)level * K_TIMER_SLOTS + slot);
+                }
+            }
+        }
+        k_timers.now = tick;
+        Uint32 slot = (Uint32)(tick & (K_TIMER_SLOTS - 1));
+        if (k_timers.heads[slot] != K_TIMER_NONE){
+            k_frame_stats.timers_fired += k_FireTimers(slot);
+        }
+    }
+    k_frame_stats.timer_ms = k_NowMs() - start;
+}
+
+static void k_FreeTimers(){
+    k_Free(k_timers.nodes);
+    k_timers = (k_TimerWheel){0};
 }
 
-Kitty_Vertex3D KittyM_RotateVertex3D_Y(Kitty_Vertex3D v, float angle){
-    angle = angle * (M_PI / 180.0f); // convert to radians
+// DIAGNOSTIC LOG STUFF
 
-    float cosA = cosf(angle);
-    float sinA = sinf(angle);
-    return (Kitty_Vertex3D){
-        .x = v.x * cosA + v.z * sinA,
-        .y = v.y,
-        .z = -v.x * sinA + v.z * cosA
-    };
-}
+// Every thread that logs owns a ring and is its only writer: a record is copied into the slot after head, then
+// head moves on. Readers copy a ring without stopping the writer and check head again afterwards, records the
+// writer lapped in the meantime are dropped. Rings come from malloc, k_Alloc logs its own failures.
+#define K_LOG_RING_RECORDS 4096     // power of two, so head can wrap
+#define K_LOG_MAX_THREADS 64        // threads beyond this are not logged
 
-Kitty_Vertex3D KittyM_RotateVertex3D_Z(Kitty_Vertex3D v, float angle){
-    angle = angle * (M_PI / 180.0f); // convert to radians
+typedef struct {
+    SDL_threadID owner;
+    Uint32 index;
+    SDL_atomic_t head;              // records ever written, wraps
+    Kitty_LogRecord records[K_LOG_RING_RECORDS];
+} k_LogRing;
+
+static k_LogRing* k_log_rings[K_LOG_MAX_THREADS];
+static SDL_atomic_t k_log_ring_count = {0};
+static SDL_SpinLock k_log_lock = 0;     // only taken to add a ring
+static SDL_atomic_t k_log_disabled = {0};
+
+static k_LogRing* k_LogRingOfThread(){
+    SDL_threadID self = SDL_ThreadID();
+    int count = SDL_AtomicGet(&k_log_ring_count);
+    for (int i = 0; i < count; i++){
+        if (k_log_rings[i]->owner == self){
+            return k_log_rings[i];
+        }
+    }
+    // first record of this thread
+    k_LogRing* ring = NULL;
+    SDL_AtomicLock(&k_log_lock);
+    count = SDL_AtomicGet(&k_log_ring_count);
+    if (count < K_LOG_MAX_THREADS && (ring = (k_LogRing*)calloc(1, sizeof(k_LogRing)))){
+        ring->owner = self;
+        ring->index = (Uint32)count;
+        k_log_rings[count] = ring;
+        SDL_AtomicSet(&k_log_ring_count, count + 1);
+    }
+    SDL_AtomicUnlock(&k_log_lock);
+    return ring;
+}
 
+static void k_AppendLog(const Kitty_LogRecord* record){
+    if (SDL_AtomicGet(&k_log_disabled)){
+        return;
+    }
+    k_LogRing* ring = k_LogRingOfThread();
+    if (!ring){
+        return;
+    }
+    Uint32 head = (Uint32)SDL_AtomicGet(&ring->head);
+    Kitty_LogRecord* slot = &ring->records[head & (K_LOG_RING_RECORDS - 1)];
+    *slot = *record;
+    slot->time_ms = k_NowMs();
+    slot->thread = ring->index;
+    SDL_AtomicSet(&ring->head, (int)(head + 1)); // publishes the record
+}
 
-    float cosA = cosf(angle);
-    float sinA = sinf(angle);
-    return (Kitty_Vertex3D){
-        .x = v.x * cosA - v.y * sinA,
-        .y = v.x * sinA + v.y * cosA,
-        .z = v.z
-    };
+static void k_Log(int code, const Kitty_Object* obj, Sint64 index, Sint64 arg0, Sint64 arg1, Sint64 arg2){
+    Kitty_LogRecord record = { 0.0, code, 0, obj ? obj->id : 0, index, { arg0, arg1, arg2, 0 } };
+    k_AppendLog(&record);
 }
 
+void Kitty_SetLogEnabled(bool enabled){
+    SDL_AtomicSet(&k_log_disabled, !enabled);
+}
 
-int KittyD_DrawMeshUVMap(Kitty_Point position, int scale, Kitty_ObjMesh* mesh){
-    if (!sdl_renderer){
-        return KITTY_SDL_RENDERER_NOT_INITIALIZED; // SDL renderer not initialized
+void Kitty_LogEvent(const Kitty_LogRecord* record){
+    if (record){
+        k_AppendLog(record);
     }
+}
 
-    // create wireframe of mesh, each vertex offset by position
-    for (size_t f = 0; f < mesh->face_count; f++){
-        Kitty_Face face = mesh->faces[f];
-        Kitty_UV uv1 = mesh->uvs[face.uv_a];
-        Kitty_UV uv2 = mesh->uvs[face.uv_b];
-        Kitty_UV uv3 = mesh->uvs[face.uv_c];
+static int k_CompareLogTime(const void* a, const void* b){
+    const Kitty_LogRecord* ra = (const Kitty_LogRecord*)a;
+    const Kitty_LogRecord* rb = (const Kitty_LogRecord*)b;
+    if (ra->time_ms != rb->time_ms){
+        return ra->time_ms < rb->time_ms ? -1 : 1;
+    }
+    return (ra->thread > rb->thread) - (ra->thread < rb->thread);
+}
 
-        int uv1x = position.x + (int)(uv1.u * mesh->texture->sdl_surface->w) * scale;
-        int uv1y = position.y + (int)(uv1.v * mesh->texture->sdl_surface->h) * scale;
-        int uv2x = position.x + (int)(uv2.u * mesh->texture->sdl_surface->w) * scale;
-        int uv2y = position.y + (int)(uv2.v * mesh->texture->sdl_surface->h) * scale;
-        int uv3x = position.x + (int)(uv3.u * mesh->texture->sdl_surface->w) * scale;
-        int uv3y = position.y + (int)(uv3.v * mesh->texture->sdl_surface->h) * scale;
+///@brief Copies the intact records of the last seconds from every ring into a malloc'd array, sorted by time.
+static Kitty_LogRecord* k_CollectLog(double seconds, size_t* out_count){
+    *out_count = 0;
+    int rings = SDL_AtomicGet(&k_log_ring_count);
+    if (rings == 0){
+        return NULL;
+    }
+    Kitty_LogRecord* records = (Kitty_LogRecord*)malloc((size_t)rings * K_LOG_RING_RECORDS * sizeof(Kitty_LogRecord));
+    if (!records){
+        return NULL;
+    }
+    double since = k_NowMs() - seconds * 1000.0;
+    size_t count = 0;
+    for (int r = 0; r < rings; r++){
+        k_LogRing* ring = k_log_rings[r];
+        // the oldest slot may be the one being overwritten right now
+        Uint32 head = (Uint32)SDL_AtomicGet(&ring->head);
+        Uint32 available = head < K_LOG_RING_RECORDS ? head : K_LOG_RING_RECORDS - 1;
+        Uint32 first = head - available;
+        Kitty_LogRecord* copied = records + count;
+        for (Uint32 n = 0; n < available; n++){
+            copied[n] = ring->records[(first + n) & (K_LOG_RING_RECORDS - 1)];
+        }
+        SDL_MemoryBarrierAcquire();
+        Uint32 after = (Uint32)SDL_AtomicGet(&ring->head);
+        for (Uint32 n = 0; n < available; n++){
+            if ((Uint32)(after - (first + n)) < K_LOG_RING_RECORDS && copied[n].time_ms >= since){
+                records[count++] = copied[n];
+            }
+        }
+    }
+    qsort(records, count, sizeof(Kitty_LogRecord), k_CompareLogTime);
+    *out_count = count;
+    return records;
+}
 
-        //set red color
-        SDL_SetRenderDrawColor(sdl_renderer, 255, 0, 0, 255);
-        SDL_RenderDrawLine(sdl_renderer, uv1x, uv1y, uv2x, uv2y);
-        SDL_RenderDrawLine(sdl_renderer, uv2x, uv2y, uv3x, uv3y);
-        SDL_RenderDrawLine(sdl_renderer, uv3x, uv3y, uv1x, uv1y);
+size_t Kitty_ReadLog(double seconds, Kitty_LogRecord* out_records, size_t capacity){
+    if (!out_records || capacity == 0){
+        return 0;
+    }
+    size_t count;
+    Kitty_LogRecord* records = k_CollectLog(seconds, &count);
+    size_t kept = count < capacity ? count : capacity;
+    if (kept > 0){
+        memcpy(out_records, records + (count - kept), kept * sizeof(Kitty_LogRecord));
     }
+    free(records);
+    return kept;
+}
 
-    return KITTY_SUCCESS;
+static const char* k_LogCodeName(int code){
+    switch (code){
+        case KITTY_SUCCESS: return "KITTY_SUCCESS";
+        case KITTY_INIT_FAILURE: return "KITTY_INIT_FAILURE";
+        case KITTY_SDL_WINDOW_NOT_INITIALIZED: return "KITTY_SDL_WINDOW_NOT_INITIALIZED";
+        case KITTY_SDL_RENDERER_NOT_INITIALIZED: return "KITTY_SDL_RENDERER_NOT_INITIALIZED";
+        case KITTY_SDL_LOCK_TEXTURE_ERROR: return "KITTY_SDL_LOCK_TEXTURE_ERROR";
+        case KITTY_FILE_NOT_FOUND: return "KITTY_FILE_NOT_FOUND";
+        case KITTY_INVALID_ARGUMENT: return "KITTY_INVALID_ARGUMENT";
+        case KITTY_INVALID_FILE: return "KITTY_INVALID_FILE";
+        case KITTY_MEMORY_ALLOCATION_FAILURE: return "KITTY_MEMORY_ALLOCATION_FAILURE";
+        case KITTY_MEMORYSPACE_NOT_INITIALIZED: return "KITTY_MEMORYSPACE_NOT_INITIALIZED";
+        case KITTY_MEMORYSPACE_DATA_NOT_FREED: return "KITTY_MEMORYSPACE_DATA_NOT_FREED";
+        case KITTY_INVALID_OBJECT_INDEX: return "KITTY_INVALID_OBJECT_INDEX";
+        case KITTY_OBJECT_NOT_FOUND: return "KITTY_OBJECT_NOT_FOUND";
+        case KITTY_DUPLICATE_OBJECT_ID: return "KITTY_DUPLICATE_OBJECT_ID";
+        case KITTY_SDL_INIT_ERROR: return "KITTY_SDL_INIT_ERROR";
+        case KITTY_SDL_WINDOW_CREATION_ERROR: return "KITTY_SDL_WINDOW_CREATION_ERROR";
+        case KITTY_SDL_RENDERER_CREATION_ERROR: return "KITTY_SDL_RENDERER_CREATION_ERROR";
+        case KITTY_SDL_TTF_ERROR: return "KITTY_SDL_TTF_ERROR";
+        case KITTY_SDL_TEXTURE_CREATION_ERROR: return "KITTY_SDL_TEXTURE_CREATION_ERROR";
+        case KITTY_UNKNOWN_ERROR: return "KITTY_UNKNOWN_ERROR";
+        case KITTY_EVENT_QUALITY_CHANGED: return "KITTY_EVENT_QUALITY_CHANGED";
+        case KITTY_EVENT_WORLD_CELL_LOADED: return "KITTY_EVENT_WORLD_CELL_LOADED";
+        case KITTY_EVENT_WORLD_CELL_UNLOADED: return "KITTY_EVENT_WORLD_CELL_UNLOADED";
+        default: return NULL;
+    }
 }
 
-int KittyD_DrawTexture(Kitty_Point position, int scale, Kitty_Texture* texture){
-    if (!sdl_renderer){
-        return KITTY_SDL_RENDERER_NOT_INITIALIZED; // SDL renderer not initialized
+int Kitty_FormatLogRecord(const Kitty_LogRecord* record, char* buffer, size_t size){
+    if (!record){
+        return 0;
+    }
+    char code[24];
+    const char* name = k_LogCodeName(record->code);
+    if (!name){
+        snprintf(code, sizeof(code), "code %d", record->code);
+        name = code;
+    }
+    char object[64] = "";
+    if (record->object_index >= 0 || record->object_id != 0){
+        snprintf(object, sizeof(object), " object %lld id %llu", (long long)record->object_index, (unsigned long long)record->object_id);
     }
+    return snprintf(buffer, size, "%12.3f ms thread %u %s%s args %lld %lld %lld %lld", record->time_ms, record->thread, name, object,
+                    (long long)record->args[0], (long long)record->args[1], (long long)record->args[2], (long long)record->args[3]);
+}
 
-    Uint32* pixels = (Uint32*)texture->sdl_surface->pixels;
-    for (int y = 0; y < texture->sdl_surface->h; y++){
-        for (int x = 0; x < texture->sdl_surface->w; x++){
-            //enlarge 4x
-            Uint32 color = pixels[y * (texture->sdl_surface->pitch / 4) + x];
-            Uint8 r, g, b, a;
-            SDL_GetRGBA(color, texture->sdl_surface->format, &r, &g, &b, &a);
-            for (int py = 0; py < scale; py++){
-                for (int px = 0; px < scale; px++){
-                    SDL_SetRenderDrawColor(sdl_renderer, r, g, b, 255);
-                    SDL_RenderDrawPoint(sdl_renderer, position.x + x * scale + px, position.y + y * scale + py);
-                }
-            }
-        }
+int Kitty_DumpLog(FILE* file, double seconds){
+    if (!file){
+        return KITTY_INVALID_ARGUMENT;
+    }
+    size_t count;
+    Kitty_LogRecord* records = k_CollectLog(seconds, &count);
+    if (!records && SDL_AtomicGet(&k_log_ring_count) > 0){
+        return KITTY_MEMORY_ALLOCATION_FAILURE; // Memory allocation failed
+    }
+    char line[256];
+    for (size_t i = 0; i < count; i++){
+        Kitty_FormatLogRecord(&records[i], line, sizeof(line));
+        fprintf(file, "%s\n", line);
     }
+    free(records);
+    return KITTY_SUCCESS;
+}
 
-    return KITTY_SUCCESS; // Success
+static void k_FreeLog(){
+    int rings = SDL_AtomicGet(&k_log_ring_count);
+    SDL_AtomicSet(&k_log_ring_count, 0);
+    for (int i = 0; i < rings; i++){
+        free(k_log_rings[i]);
+        k_log_rings[i] = NULL;
+    }
 }
 
 // MEMORY STUFF
 
 static int k_CreateObjectMSpace(){
-    object_mspace = (k_ObjectMSpace*)malloc(sizeof(k_ObjectMSpace));
+    object_mspace = (k_ObjectMSpace*)k_Alloc(sizeof(k_ObjectMSpace), KITTY_MEMORY_OBJECTS);
     if (!object_mspace){
         return KITTY_MEMORY_ALLOCATION_FAILURE; // Memory allocation failed
     }
     object_mspace->total_allocated = 0;
     object_mspace->allocation_count = 0;
     object_mspace->objects = NULL;
+    object_mspace->ids = NULL;
+    object_mspace->id_capacity = 0;
+    object_mspace->id_count = 0;
+    object_mspace->removed = NULL;
+    object_mspace->removed_capacity = 0;
     return KITTY_SUCCESS; // Success
 }
 
@@ -1147,7 +9163,7 @@ static int k_AllocObjectMSpace(){
         return KITTY_MEMORYSPACE_NOT_INITIALIZED; // Memory space not initialized
     }
     size_t new_size = object_mspace->total_allocated + K_DEFAULT_OBJECT_MSPACE_SIZE;
-    Kitty_Object* new_objects = (Kitty_Object*)realloc(object_mspace->objects, new_size);
+    Kitty_Object* new_objects = (Kitty_Object*)k_Realloc(object_mspace->objects, new_size, KITTY_MEMORY_OBJECTS);
     if(!new_objects){
         return KITTY_MEMORY_ALLOCATION_FAILURE; // Memory allocation failed
     }
@@ -1162,7 +9178,7 @@ static int k_UnallocObjectMSpace(){
     }
     // subtract allocation count and realloc
     size_t new_size = object_mspace->total_allocated - K_DEFAULT_OBJECT_MSPACE_SIZE;
-    Kitty_Object* new_objects = (Kitty_Object*)realloc(object_mspace->objects, new_size);
+    Kitty_Object* new_objects = (Kitty_Object*)k_Realloc(object_mspace->objects, new_size, KITTY_MEMORY_OBJECTS);
     if(!new_objects){
         return KITTY_MEMORY_ALLOCATION_FAILURE; // Memory allocation failed
     }
@@ -1175,7 +9191,8 @@ static int k_ReallocObjectMSpace(){
     if (!object_mspace){
         return KITTY_MEMORYSPACE_NOT_INITIALIZED; // Memory space not initialized
     }
-    if (object_mspace->allocation_count * sizeof(Kitty_Object) >= object_mspace->total_allocated){
+    // room for one more object; the space grows in fixed byte steps that need not hold whole objects
+    if ((object_mspace->allocation_count + 1) * sizeof(Kitty_Object) > object_mspace->total_allocated){
         return k_AllocObjectMSpace(); // Allocate more space
     } else if (object_mspace->allocation_count * sizeof(Kitty_Object) < object_mspace->total_allocated / 4 && object_mspace->total_allocated > K_DEFAULT_OBJECT_MSPACE_SIZE){
         return k_UnallocObjectMSpace(); // Deallocate space
@@ -1183,6 +9200,147 @@ static int k_ReallocObjectMSpace(){
     return KITTY_SUCCESS; // Success
 }
 
+static int k_FitObjectMSpace(size_t count){
+    if (!object_mspace){
+        return KITTY_MEMORYSPACE_NOT_INITIALIZED; // Memory space not initialized
+    }
+    // same policy as k_ReallocObjectMSpace, but jumps straight to the final size instead of stepping
+    size_t used = count * sizeof(Kitty_Object);
+    size_t new_size = object_mspace->total_allocated;
+    if (used + sizeof(Kitty_Object) > new_size){
+        new_size = (used + sizeof(Kitty_Object) + K_DEFAULT_OBJECT_MSPACE_SIZE - 1) / K_DEFAULT_OBJECT_MSPACE_SIZE * K_DEFAULT_OBJECT_MSPACE_SIZE;
+    } else if (used < new_size / 4 && new_size > K_DEFAULT_OBJECT_MSPACE_SIZE){
+        // keep twice the survivors so churn right after the removal does not grow it again
+        new_size = (2 * used + K_DEFAULT_OBJECT_MSPACE_SIZE - 1) / K_DEFAULT_OBJECT_MSPACE_SIZE * K_DEFAULT_OBJECT_MSPACE_SIZE;
+        if (new_size < K_DEFAULT_OBJECT_MSPACE_SIZE){
+            new_size = K_DEFAULT_OBJECT_MSPACE_SIZE;
+        }
+    }
+    if (new_size == object_mspace->total_allocated){
+        return KITTY_SUCCESS; // Already fits
+    }
+    Kitty_Object* new_objects = (Kitty_Object*)k_Realloc(object_mspace->objects, new_size, KITTY_MEMORY_OBJECTS);
+    if (!new_objects){
+        return KITTY_MEMORY_ALLOCATION_FAILURE; // Memory allocation failed
+    }
+    object_mspace->objects = new_objects;
+    object_mspace->total_allocated = new_size;
+    return KITTY_SUCCESS; // Success
+}
+
+// ID MAP STUFF
+
+// ids are user chosen and often sequential, so they are mixed (splitmix64 finalizer) before masking
+static size_t k_ObjectIdHome(Uint64 id, size_t mask){
+    id ^= id >> 30;
+    id *= 0xbf58476d1ce4e5b9ULL;
+    id ^= id >> 27;
+    id *= 0x94d049bb133111ebULL;
+    id ^= id >> 31;
+    return (size_t)id & mask;
+}
+
+static int k_ReserveObjectIds(size_t count){
+    if (count * 8 <= object_mspace->id_capacity * 7){
+        return KITTY_SUCCESS; // Fits already
+    }
+    size_t capacity = object_mspace->id_capacity ? object_mspace->id_capacity : 64;
+    while (count * 8 > capacity * 7){
+        capacity *= 2;
+    }
+    k_IdSlot* slots = (k_IdSlot*)k_Calloc(capacity, sizeof(k_IdSlot), KITTY_MEMORY_OBJECTS);
+    if (!slots){
+        return KITTY_MEMORY_ALLOCATION_FAILURE; // Memory allocation failed
+    }
+    k_IdSlot* old_slots = object_mspace->ids;
+    size_t old_capacity = object_mspace->id_capacity;
+    object_mspace->ids = slots;
+    object_mspace->id_capacity = capacity;
+    object_mspace->id_count = 0;
+    for (size_t i = 0; i < old_capacity; i++){
+        if (old_slots[i].id != 0){
+            k_InsertObjectId(old_slots[i].id, old_slots[i].index);
+        }
+    }
+    k_Free(old_slots);
+    return KITTY_SUCCESS; // Success
+}
+
+static void k_InsertObjectId(Uint64 id, size_t index){
+    size_t mask = object_mspace->id_capacity - 1;
+    k_IdSlot slot = {id, index};
+    size_t pos = k_ObjectIdHome(id, mask);
+    size_t distance = 0;
+    for (;;){
+        k_IdSlot* here = &object_mspace->ids[pos];
+        if (here->id == 0){
+            *here = slot;
+            object_mspace->id_count++;
+            return;
+        }
+        // robin hood: the entry further from its home keeps the slot, which bounds probe lengths
+        size_t here_distance = (pos - k_ObjectIdHome(here->id, mask)) & mask;
+        if (here_distance < distance){
+            k_IdSlot displaced = *here;
+            *here = slot;
+            slot = displaced;
+            distance = here_distance;
+        }
+        pos = (pos + 1) & mask;
+        distance++;
+    }
+}
+
+static k_IdSlot* k_FindObjectId(Uint64 id){
+    if (id == 0 || object_mspace->id_count == 0){
+        return NULL;
+    }
+    size_t mask = object_mspace->id_capacity - 1;
+    size_t pos = k_ObjectIdHome(id, mask);
+    for (size_t distance = 0;; distance++){
+        k_IdSlot* here = &object_mspace->ids[pos];
+        if (here->id == id){
+            return here;
+        }
+        // an empty slot or an entry closer to its home ends the probe, the id would have displaced it
+        if (here->id == 0 || ((pos - k_ObjectIdHome(here->id, mask)) & mask) < distance){
+            return NULL;
+        }
+        pos = (pos + 1) & mask;
+    }
+}
+
+static void k_EraseObjectId(Uint64 id){
+    k_IdSlot* slot = k_FindObjectId(id);
+    if (!slot){
+        return;
+    }
+    // backward shift deletion keeps the probe sequences intact without tombstones
+    size_t mask = object_mspace->id_capacity - 1;
+    size_t pos = (size_t)(slot - object_mspace->ids);
+    for (;;){
+        size_t next = (pos + 1) & mask;
+        k_IdSlot* after = &object_mspace->ids[next];
+        if (after->id == 0 || k_ObjectIdHome(after->id, mask) == next){
+            break;
+        }
+        object_mspace->ids[pos] = *after;
+        pos = next;
+    }
+    object_mspace->ids[pos].id = 0;
+    object_mspace->id_count--;
+}
+
+static void k_MoveObjectId(const Kitty_Object* obj, size_t index){
+    if (obj->id == 0){
+        return;
+    }
+    k_IdSlot* slot = k_FindObjectId(obj->id);
+    if (slot){
+        slot->index = index;
+    }
+}
+
 static int k_FreeObjectMSpace(){
     if(!object_mspace){
         return KITTY_MEMORYSPACE_NOT_INITIALIZED; // Memory space not initialized
@@ -1190,14 +9348,20 @@ static int k_FreeObjectMSpace(){
 
     // Loop thru objects and free their data
     for (size_t i = 0; i < object_mspace->allocation_count; i++){
-        free(object_mspace->objects[i].data);
-        object_mspace->objects[i].data = NULL;
+        k_FreeObjectData(&object_mspace->objects[i]);
     }
 
-    free(object_mspace->objects);
+    k_Free(object_mspace->objects);
     object_mspace->objects = NULL;
     object_mspace->total_allocated = 0;
     object_mspace->allocation_count = 0;
+    k_Free(object_mspace->ids);
+    object_mspace->ids = NULL;
+    object_mspace->id_capacity = 0;
+    object_mspace->id_count = 0;
+    k_Free(object_mspace->removed);
+    object_mspace->removed = NULL;
+    object_mspace->removed_capacity = 0;
     return KITTY_SUCCESS; // Success
 }
 
@@ -1208,5 +9372,470 @@ static int k_DestroyObjectMSpace(){
     if (object_mspace->allocation_count > 0 || object_mspace->total_allocated > 0 || object_mspace->objects != NULL){ 
         return KITTY_MEMORYSPACE_DATA_NOT_FREED; // Data not freed
     }
+    k_Free(object_mspace);
+    object_mspace = NULL;
     return KITTY_SUCCESS; // Success
-}
\ No newline at end of file
+}
+
+static void k_FreeObjectData(Kitty_Object* obj){
+    if (!obj->data){
+        return;
+    }
+    switch (obj->type){
+        case KITTY_OBJECT_TILEMAP:
+            Kitty_ObjTilemap* map = (Kitty_ObjTilemap*)obj->data;
+            for (size_t i = 0; i < map->cache_size; i++){
+                if (map->cache[i].texture){
+                    k_DestroyTexture(map->cache[i].texture, KITTY_MEMORY_TEXTURES);
+                }
+            }
+            if (map->atlas_texture){
+                k_DestroyTexture(map->atlas_texture, KITTY_MEMORY_TEXTURES);
+            }
+            k_Free(map->cache);
+            k_Free(map->chunk_slots);
+            k_Free(map->tiles);
+            break;
+        case KITTY_OBJECT_POLYGON:
+            k_FreePolygonBuffers((Kitty_ObjPolygon*)obj->data);
+            break;
+        case KITTY_OBJECT_POLYLINE:
+            k_FreePolylineBuffers((Kitty_ObjPolyline*)obj->data);
+            break;
+        case KITTY_OBJECT_PATH:
+            Kitty_ObjPath* path = (Kitty_ObjPath*)obj->data;
+            k_FreePolylineBuffers(&path->line);
+            k_Free(path->segments);
+            k_Free(path->flat);
+            k_Free(path->subpath_ends);
+            break;
+        case KITTY_OBJECT_PLOT:
+            Kitty_ObjPlot* plot = (Kitty_ObjPlot*)obj->data;
+            for (size_t i = 0; i < plot->series_count; i++){
+                k_Free(plot->series[i].samples);
+                k_Free(plot->series[i].column_min);
+                k_Free(plot->series[i].column_max);
+            }
+            k_Free(plot->series);
+            k_Free(plot->line_points);
+            break;
+        case KITTY_OBJECT_TEXT:
+            Kitty_ObjText* text = (Kitty_ObjText*)obj->data;
+            if (text->cache){
+                k_DestroyTexture(text->cache, KITTY_MEMORY_TEXT);
+            }
+            k_Free(text->text);
+            break;
+        case KITTY_OBJECT_MESH:
+            Kitty_ObjMesh* mesh = (Kitty_ObjMesh*)obj->data;
+            k_Free(mesh->vertices);
+            k_Free(mesh->faces);
+            k_Free(mesh->face_colors);
+            k_Free(mesh->uvs);
+            k_FreeSkin(mesh->skin);
+            k_FreeMorph(mesh->morph);
+            k_FreeImpostor(mesh->impostor);
+            break;
+        case KITTY_OBJECT_POINT_CLOUD:
+            Kitty_ObjPointCloud* cloud = (Kitty_ObjPointCloud*)obj->data;
+            k_WaitFramebuffers(); // frames in flight may still be splatting it
+            k_Free(cloud->x);
+            k_Free(cloud->y);
+            k_Free(cloud->z);
+            k_Free(cloud->qx);
+            k_Free(cloud->qy);
+            k_Free(cloud->qz);
+            k_Free(cloud->colors);
+            k_Free(cloud->nodes);
+            break;
+        case KITTY_OBJECT_TERRAIN:
+            k_FreeTerrain((Kitty_ObjTerrain*)obj->data);
+            break;
+        default:
+            break;
+    }
+    free(obj->data);
+    obj->data = NULL;
+}
+
+// callers hold k_memory_lock
+static void k_CountMemory(enum Kitty_MemoryTag tag, size_t old_size, size_t new_size, int live_change, int allocation_change){
+    Kitty_MemoryTagStats* counters[2] = { &k_memory_stats.tags[tag], &k_memory_stats.total };
+    for (int i = 0; i < 2; i++){
+        counters[i]->current_bytes = counters[i]->current_bytes - old_size + new_size;
+        if (counters[i]->current_bytes > counters[i]->peak_bytes){
+            counters[i]->peak_bytes = counters[i]->current_bytes;
+        }
+        counters[i]->live_allocations += live_change;
+        counters[i]->total_allocations += allocation_change;
+    }
+}
+
+static void k_AccountMemory(enum Kitty_MemoryTag tag, size_t old_size, size_t new_size, int live_change, int allocation_change){
+    SDL_AtomicLock(&k_memory_lock);
+    k_CountMemory(tag, old_size, new_size, live_change, allocation_change);
+    SDL_AtomicUnlock(&k_memory_lock);
+}
+
+// BLOCK TABLE STUFF, callers hold k_memory_lock
+
+static size_t k_BlockHome(const void* block, size_t mask){
+    return k_ObjectIdHome((Uint64)(uintptr_t)block, mask);
+}
+
+static k_BlockSlot* k_FindBlock(const void* block){
+    if (k_block_count == 0){
+        return NULL;
+    }
+    size_t mask = k_block_capacity - 1;
+    size_t pos = k_BlockHome(block, mask);
+    for (size_t distance = 0;; distance++){
+        k_BlockSlot* here = &k_blocks[pos];
+        if (here->block == block){
+            return here;
+        }
+        if (!here->block || ((pos - k_BlockHome(here->block, mask)) & mask) < distance){
+            return NULL;
+        }
+        pos = (pos + 1) & mask;
+    }
+}
+
+static void k_PlaceBlock(k_BlockSlot slot){
+    size_t mask = k_block_capacity - 1;
+    size_t pos = k_BlockHome(slot.block, mask);
+    size_t distance = 0;
+    for (;;){
+        k_BlockSlot* here = &k_blocks[pos];
+        if (!here->block){
+            *here = slot;
+            k_block_count++;
+            return;
+        }
+        size_t here_distance = (pos - k_BlockHome(here->block, mask)) & mask;
+        if (here_distance < distance){
+            k_BlockSlot displaced = *here;
+            *here = slot;
+            slot = displaced;
+            distance = here_distance;
+        }
+        pos = (pos + 1) & mask;
+        distance++;
+    }
+}
+
+static bool k_ReserveBlocks(size_t count){
+    if (count * 8 <= k_block_capacity * 7){
+        return true;
+    }
+    size_t capacity = k_block_capacity ? k_block_capacity * 2 : 256;
+    while (count * 8 > capacity * 7){
+        capacity *= 2;
+    }
+    k_BlockSlot* slots = (k_BlockSlot*)calloc(capacity, sizeof(k_BlockSlot));
+    if (!slots){
+        return false;
+    }
+    k_BlockSlot* old_slots = k_blocks;
+    size_t old_capacity = k_block_capacity;
+    k_blocks = slots;
+    k_block_capacity = capacity;
+    k_block_count = 0;
+    for (size_t i = 0; i < old_capacity; i++){
+        if (old_slots[i].block){
+            k_PlaceBlock(old_slots[i]);
+        }
+    }
+    free(old_slots);
+    return true;
+}
+
+///@brief Records a new block, room for it must be reserved.
+static void k_InsertBlock(k_BlockSlot slot){
+    // a block the caller released outside the engine leaves its slot behind, and the heap can hand the address out again
+    k_BlockSlot* stale = k_FindBlock(slot.block);
+    if (stale){
+        k_CountMemory(stale->tag, stale->size, 0, stale->heap ? -1 : 0, 0);
+        *stale = slot;
+        return;
+    }
+    k_PlaceBlock(slot);
+}
+
+static void k_EraseBlock(k_BlockSlot* slot){
+    size_t mask = k_block_capacity - 1;
+    size_t pos = (size_t)(slot - k_blocks);
+    for (;;){
+        size_t next = (pos + 1) & mask;
+        k_BlockSlot* after = &k_blocks[next];
+        if (!after->block || k_BlockHome(after->block, mask) == next){
+            break;
+        }
+        k_blocks[pos] = *after;
+        pos = next;
+    }
+    k_blocks[pos].block = NULL;
+    k_block_count--;
+}
+
+static void k_TrimBlocks(){
+    if (k_block_count == 0 && k_blocks){
+        free(k_blocks);
+        k_blocks = NULL;
+        k_block_capacity = 0;
+    }
+}
+
+static void k_CheckFrameAllocation(enum Kitty_MemoryTag tag, size_t size){
+    if (k_frame_scope == 0){
+        return;
+    }
+    SDL_AtomicAdd(&k_frame_allocations, 1);
+    if (!SDL_AtomicGet(&k_allocation_check)){
+        return;
+    }
+    Kitty_AllocationReport report = { frame_num, tag, size, 0, {0} };
+#ifdef K_HAS_BACKTRACE
+    report.backtrace_depth = backtrace(report.backtrace, KITTY_MAX_BACKTRACE);
+#endif
+    SDL_AtomicLock(&k_memory_lock);
+    size_t violation = k_allocation_violations++;
+    if (violation < K_MAX_ALLOCATION_REPORTS){
+        k_allocation_reports[violation] = report;
+    }
+    SDL_AtomicUnlock(&k_memory_lock);
+    if (violation < K_MAX_ALLOCATION_REPORTS){
+        fprintf(stderr, "Kitty: %zu byte allocation (tag %d) in frame %zu during steady state\n", size, (int)tag, report.frame);
+#ifdef K_HAS_BACKTRACE
+        backtrace_symbols_fd(report.backtrace, report.backtrace_depth, fileno(stderr));
+#endif
+    }
+}
+
+static void* k_Alloc(size_t size, enum Kitty_MemoryTag tag){
+    size_t request = size ? size : 1; // a unique address even for empty blocks
+    void* block = k_allocator.allocate ? k_allocator.allocate(k_allocator.user_data, request, tag) : malloc(request);
+    if (!block){
+        k_Log(KITTY_MEMORY_ALLOCATION_FAILURE, NULL, -1, (Sint64)size, tag, 0);
+        return NULL;
+    }
+    SDL_AtomicLock(&k_memory_lock);
+    bool tracked = k_ReserveBlocks(k_block_count + 1);
+    if (tracked){
+        k_InsertBlock((k_BlockSlot){block, size, tag, true});
+        k_CountMemory(tag, 0, size, 1, 1);
+    }
+    SDL_AtomicUnlock(&k_memory_lock);
+    if (!tracked){
+        if (k_allocator.allocate){
+            k_allocator.release(k_allocator.user_data, block, tag);
+        } else {
+            free(block);
+        }
+        k_Log(KITTY_MEMORY_ALLOCATION_FAILURE, NULL, -1, (Sint64)size, tag, 0);
+        return NULL;
+    }
+    k_CheckFrameAllocation(tag, size);
+    return block;
+}
+
+static void* k_Calloc(size_t count, size_t size, enum Kitty_MemoryTag tag){
+    if (size != 0 && count > SIZE_MAX / size){
+        return NULL;
+    }
+    void* block = k_Alloc(count * size, tag);
+    if (block){
+        memset(block, 0, count * size);
+    }
+    return block;
+}
+
+static void* k_Realloc(void* block, size_t size, enum Kitty_MemoryTag tag){
+    if (!block){
+        return k_Alloc(size, tag);
+    }
+    size_t request = size ? size : 1;
+    // the lock is held across the move, so no other thread can be handed the old address and record it first
+    SDL_AtomicLock(&k_memory_lock);
+    k_BlockSlot* slot = k_FindBlock(block);
+    if (!slot || !slot->heap){
+        SDL_AtomicUnlock(&k_memory_lock);
+        void* moved = realloc(block, request); // a block the caller put in a public field, it stays theirs and uncounted
+        if (!moved){
+            k_Log(KITTY_MEMORY_ALLOCATION_FAILURE, NULL, -1, (Sint64)size, tag, 0);
+        }
+        return moved;
+    }
+    size_t old_size = slot->size;
+    tag = slot->tag;
+    void* moved = NULL;
+    if (k_ReserveBlocks(k_block_count + 1)){
+        if (!k_allocator.allocate){
+            moved = realloc(block, request);
+        } else if (k_allocator.reallocate){
+            moved = k_allocator.reallocate(k_allocator.user_data, block, request, tag);
+        } else {
+            moved = k_allocator.allocate(k_allocator.user_data, request, tag);
+            if (moved){
+                memcpy(moved, block, old_size < size ? old_size : size);
+                k_allocator.release(k_allocator.user_data, block, tag);
+            }
+        }
+    }
+    if (moved){
+        k_EraseBlock(k_FindBlock(block));
+        k_InsertBlock((k_BlockSlot){moved, size, tag, true});
+        k_CountMemory(tag, old_size, size, 0, 1);
+    }
+    SDL_AtomicUnlock(&k_memory_lock);
+    if (!moved){
+        k_Log(KITTY_MEMORY_ALLOCATION_FAILURE, NULL, -1, (Sint64)size, tag, 0);
+        return NULL; // the old block is untouched, as with realloc
+    }
+    k_CheckFrameAllocation(tag, size);
+    return moved;
+}
+
+static void k_Free(void* block){
+    if (!block){
+        return;
+    }
+    SDL_AtomicLock(&k_memory_lock);
+    k_BlockSlot* slot = k_FindBlock(block);
+    bool engine = slot && slot->heap;
+    enum Kitty_MemoryTag tag = engine ? slot->tag : KITTY_MEMORY_OBJECTS;
+    if (engine){
+        k_CountMemory(tag, slot->size, 0, -1, 0);
+        k_EraseBlock(slot);
+        k_TrimBlocks();
+    }
+    SDL_AtomicUnlock(&k_memory_lock);
+    if (engine && k_allocator.allocate){
+        k_allocator.release(k_allocator.user_data, block, tag);
+    } else {
+        free(block); // blocks the engine did not allocate came from the caller's C library heap
+    }
+}
+
+static SDL_Surface* k_LoadSurface(const char* file_path, enum Kitty_MemoryTag tag, int* bits_per_pixel){
+    SDL_Surface* loaded = IMG_Load(file_path);
+    if (!loaded){
+        return NULL;
+    }
+    if (bits_per_pixel){
+        *bits_per_pixel = loaded->format->BitsPerPixel;
+    }
+    SDL_Surface* surface = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+    SDL_FreeSurface(loaded);
+    if (!surface){
+        return NULL;
+    }
+    size_t bytes = (size_t)surface->pitch * (size_t)surface->h;
+    SDL_AtomicLock(&k_memory_lock);
+    if (k_ReserveBlocks(k_block_count + 1)){
+        k_InsertBlock((k_BlockSlot){surface, bytes, tag, false});
+        k_CountMemory(tag, 0, bytes, 0, 1);
+    }
+    SDL_AtomicUnlock(&k_memory_lock);
+    return surface;
+}
+
+static void k_FreeSurface(SDL_Surface* surface){
+    if (!surface){
+        return;
+    }
+    SDL_AtomicLock(&k_memory_lock);
+    k_BlockSlot* slot = k_FindBlock(surface);
+    if (slot){
+        k_CountMemory(slot->tag, slot->size, 0, 0, 0);
+        k_EraseBlock(slot);
+        k_TrimBlocks();
+    }
+    SDL_AtomicUnlock(&k_memory_lock);
+    SDL_FreeSurface(surface);
+}
+
+///@brief Estimated size of a texture, the driver may keep more.
+static size_t k_TextureBytes(SDL_Texture* texture){
+    Uint32 format;
+    int width, height;
+    if (SDL_QueryTexture(texture, &format, NULL, &width, &height) != 0){
+        return 0;
+    }
+    return (size_t)width * (size_t)height * SDL_BYTESPERPIXEL(format);
+}
+
+static SDL_Texture* k_CreateTexture(Uint32 format, int access, int width, int height, enum Kitty_MemoryTag tag){
+    SDL_Texture* texture = SDL_CreateTexture(sdl_renderer, format, access, width, height);
+    if (texture){
+        k_AccountMemory(tag, 0, k_TextureBytes(texture), 0, 1);
+    }
+    return texture;
+}
+
+static SDL_Texture* k_CreateTextureFromSurface(SDL_Surface* surface, enum Kitty_MemoryTag tag){
+    SDL_Texture* texture = SDL_CreateTextureFromSurface(sdl_renderer, surface);
+    if (texture){
+        k_AccountMemory(tag, 0, k_TextureBytes(texture), 0, 1);
+    }
+    return texture;
+}
+
+static void k_DestroyTexture(SDL_Texture* texture, enum Kitty_MemoryTag tag){
+    k_AccountMemory(tag, k_TextureBytes(texture), 0, 0, 0);
+    SDL_DestroyTexture(texture);
+}
+
+int Kitty_GetMemoryStats(Kitty_MemoryStats* out_stats){
+    if (!out_stats){
+        return KITTY_INVALID_ARGUMENT;
+    }
+    SDL_AtomicLock(&k_memory_lock);
+    *out_stats = k_memory_stats;
+    SDL_AtomicUnlock(&k_memory_lock);
+    return KITTY_SUCCESS;
+}
+
+void Kitty_ResetMemoryStats(){
+    SDL_AtomicLock(&k_memory_lock);
+    for (int i = 0; i <= KITTY_MEMORY_TAG_COUNT; i++){
+        Kitty_MemoryTagStats* counters = i < KITTY_MEMORY_TAG_COUNT ? &k_memory_stats.tags[i] : &k_memory_stats.total;
+        counters->peak_bytes = counters->current_bytes;
+        counters->total_allocations = 0;
+    }
+    SDL_AtomicUnlock(&k_memory_lock);
+}
+
+int Kitty_SetAllocator(const Kitty_Allocator* allocator){
+    if (allocator && (!allocator->allocate || !allocator->release)){
+        return KITTY_INVALID_ARGUMENT;
+    }
+    SDL_AtomicLock(&k_memory_lock);
+    size_t live = k_memory_stats.total.live_allocations;
+    SDL_AtomicUnlock(&k_memory_lock);
+    if (live > 0){
+        return KITTY_MEMORYSPACE_DATA_NOT_FREED; // blocks from the old heap would be released to the new one
+    }
+    k_allocator = allocator ? *allocator : (Kitty_Allocator){0};
+    return KITTY_SUCCESS;
+}
+
+void Kitty_SetAllocationCheck(bool enabled){
+    SDL_AtomicLock(&k_memory_lock);
+    if (enabled && !SDL_AtomicGet(&k_allocation_check)){
+        k_allocation_violations = 0;
+    }
+    SDL_AtomicSet(&k_allocation_check, enabled);
+    SDL_AtomicUnlock(&k_memory_lock);
+}
+
+size_t Kitty_GetAllocationReports(Kitty_AllocationReport* out_reports, size_t capacity){
+    SDL_AtomicLock(&k_memory_lock);
+    size_t violations = k_allocation_violations;
+    size_t kept = violations < K_MAX_ALLOCATION_REPORTS ? violations : K_MAX_ALLOCATION_REPORTS;
+    for (size_t i = 0; out_reports && i < kept && i < capacity; i++){
+        out_reports[i] = k_allocation_reports[i];
+    }
+    SDL_AtomicUnlock(&k_memory_lock);
+    return violations;
+}
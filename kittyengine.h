@@ -1,6 +1,7 @@
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL_ttf.h>
+#include <stdio.h>
 #include <string.h>
 #include <stddef.h>
 #include <time.h>
@@ -29,16 +30,21 @@ enum Kitty_ErrorCodes {
     KITTY_SDL_RENDERER_NOT_INITIALIZED = 3,
     KITTY_SDL_LOCK_TEXTURE_ERROR = 4,
     KITTY_FILE_NOT_FOUND = 5,
+    KITTY_INVALID_ARGUMENT = 6,
+    KITTY_INVALID_FILE = 7,
 
     KITTY_MEMORY_ALLOCATION_FAILURE = 100,
     KITTY_MEMORYSPACE_NOT_INITIALIZED = 101,
     KITTY_MEMORYSPACE_DATA_NOT_FREED = 102,
     KITTY_INVALID_OBJECT_INDEX = 103,
+    KITTY_OBJECT_NOT_FOUND = 104,
+    KITTY_DUPLICATE_OBJECT_ID = 105,
 
     KITTY_SDL_INIT_ERROR = 1000,
     KITTY_SDL_WINDOW_CREATION_ERROR = 1001,
     KITTY_SDL_RENDERER_CREATION_ERROR = 1002,
     KITTY_SDL_TTF_ERROR = 1003,
+    KITTY_SDL_TEXTURE_CREATION_ERROR = 1004,
 
     KITTY_UNKNOWN_ERROR = 9999
 };
@@ -50,20 +56,153 @@ enum Kitty_ObjType {
     KITTY_OBJECT_TRIANGLE,
     KITTY_OBJECT_PIXEL,
     KITTY_OBJECT_MESH,
-    KITTY_OBJECT_TEXT
+    KITTY_OBJECT_TEXT,
+    KITTY_OBJECT_TILEMAP,
+    KITTY_OBJECT_POLYGON,
+    KITTY_OBJECT_POLYLINE,
+    KITTY_OBJECT_PATH,
+    KITTY_OBJECT_PLOT,
+    KITTY_OBJECT_POINT_CLOUD,
+    KITTY_OBJECT_TERRAIN
 };
 
+enum Kitty_FillRule {
+    KITTY_FILL_EVEN_ODD,
+    KITTY_FILL_NONZERO
+};
+
+enum Kitty_LineJoin {
+    KITTY_JOIN_MITER,
+    KITTY_JOIN_ROUND
+};
+
+enum Kitty_Priority {
+    KITTY_PRIORITY_LOW,
+    KITTY_PRIORITY_NORMAL,
+    KITTY_PRIORITY_HIGH
+};
+
+///@brief Number of quality levels the frame governor steps through (0 = full quality).
+#define KITTY_QUALITY_LEVELS 4
+
+///@brief Most software framebuffers the raster stage cycles through.
+#define KITTY_MAX_FRAMES_IN_FLIGHT 3
+
+enum Kitty_UpscaleFilter {
+    KITTY_UPSCALE_NEAREST,
+    KITTY_UPSCALE_BILINEAR
+};
+
+enum Kitty_BackendType {
+    KITTY_BACKEND_SDL,          // SDL_Renderer, the default
+    KITTY_BACKEND_SOFTWARE,     // primitives rasterized on the CPU, composited over SDL on present
+    KITTY_BACKEND_NULL          // accepts and drops everything, for headless runs and benchmarks
+};
+
+///@brief Coverage samples per pixel on the edges of filled triangles and flat mesh faces.
+enum Kitty_AntiAliasing {
+    KITTY_AA_OFF = 1,
+    KITTY_AA_4X = 4,            // rotated grid
+    KITTY_AA_8X = 8,
+    KITTY_AA_16X = 16
+};
+
+///@brief What engine memory is used for, see Kitty_GetMemoryStats.
+enum Kitty_MemoryTag {
+    KITTY_MEMORY_OBJECTS,       // the object store
+    KITTY_MEMORY_MESHES,        // mesh attributes, skins, skeletons, clips, morph targets, impostors and terrain
+    KITTY_MEMORY_TEXTURES,      // compact texels, virtual texture pages and the SDL textures of tilemaps, impostors and framebuffer uploads
+    KITTY_MEMORY_TEXT,          // text strings and rendered text textures
+    KITTY_MEMORY_SHAPES,        // tilemaps, polygons, polylines, paths and plots
+    KITTY_MEMORY_POINT_CLOUDS,
+    KITTY_MEMORY_FRAME,         // framebuffers, post-processing, anti-aliasing and other per-frame scratch
+    KITTY_MEMORY_TAG_COUNT
+};
+
+///@brief Storage of a Kitty_Texture; the compact formats trade some color accuracy for a quarter or an eighth of the memory.
+enum Kitty_TextureFormat {
+    KITTY_TEXTURE_RGBA32,       // 32 bits per texel in sdl_surface
+    KITTY_TEXTURE_INDEXED8,     // 8 bit indices into a 256 color palette
+    KITTY_TEXTURE_BC1           // 4x4 blocks of two RGB565 endpoints and 2 bit weights, 4 bits per texel
+};
+
+enum Kitty_PostEffectType {
+    KITTY_POST_BOX_BLUR,        // separable box blur of the given radius
+    KITTY_POST_GAUSSIAN_BLUR,   // three box blurs approximating a gaussian, radius is the standard deviation
+    KITTY_POST_COLOR_LUT,       // color grading through a 3D lookup table
+    KITTY_POST_DOWNSAMPLE,      // halves the working image, following effects run at the lower resolution
+    KITTY_POST_UPSAMPLE         // back to the resolution before the matching downsample
+};
+
+///@brief Most effects in a post-processing chain.
+#define KITTY_MAX_POST_EFFECTS 16
+
+enum Kitty_PathCommand {
+    KITTY_PATH_MOVE,
+    KITTY_PATH_LINE,
+    KITTY_PATH_QUAD,
+    KITTY_PATH_CUBIC
+};
+
+///@brief Side length (in tiles) of a tilemap chunk.
+#define KITTY_TILEMAP_CHUNK_SIZE 32
+///@brief Tile id that leaves a tilemap cell transparent.
+#define KITTY_TILE_EMPTY 0xFFFF
+
 typedef struct {
     int x;
     int y;
 } Kitty_Point;
 
+typedef struct {
+    bool enabled;               // let the controller pick the scale every frame
+    float budget_ms;            // target software rasterization time per frame
+    float min_scale;            // scale range, relative to the window size
+    float max_scale;
+    float smoothing;            // fraction of the correction applied per frame (0..1)
+    float deadband;             // relative budget error that is ignored, against jitter
+    enum Kitty_UpscaleFilter filter;
+} Kitty_DynamicResolution;
+
+typedef struct {
+    bool enabled;               // let the governor change the quality level
+    float budget_ms;            // target wall time of Kitty_RenderObjects
+    int degrade_after;          // consecutive frames over budget before dropping a level
+    int restore_after;          // consecutive frames with headroom before restoring a level
+    float headroom;             // a frame has headroom below budget_ms * headroom
+    int text_interval;          // frames between re-rasterizing throttled text
+} Kitty_FrameGovernor;
+
+typedef struct {
+    double frame_ms;            // wall time of the last Kitty_RenderObjects
+    int quality_level;          // 0 = full quality, up to KITTY_QUALITY_LEVELS - 1
+    size_t level_changes;       // since Kitty_Init
+    int frames_over_budget;     // consecutive, reset on every level change
+    int frames_with_headroom;   // consecutive, reset on every level change
+    size_t meshes_flattened;    // textured meshes drawn flat last frame
+    size_t lods_dropped;        // point clouds and impostors drawn at reduced detail last frame
+    size_t texts_skipped;       // text objects not drawn last frame
+    size_t texts_cached;        // text objects drawn from an older rasterization last frame
+    size_t impostors_over_capacity; // meshes drawn face by face last frame because every impostor cell was on screen
+    double fence_wait_ms;       // time the last frame waited for the raster thread
+    double post_ms;             // time the post-processing chain took last frame
+    double vertex_stage_ms;     // time the morph and skinning stages took last frame
+    size_t allocations;         // engine heap allocations in the last frame, up to its Kitty_FlipBuffers, see Kitty_SetAllocationCheck
+    size_t timers_fired;        // timer callbacks run by the last Kitty_UpdateObjectState
+    double timer_ms;            // time the last Kitty_UpdateObjectState spent on timers
+} Kitty_FrameStats;
+
 typedef struct {
     int x;
     int y;
     int z;
 } Kitty_Point3D;
 
+typedef struct {
+    float x;
+    float y;
+} Kitty_Vertex2D;
+
 typedef struct {
     float x;
     float y;
@@ -75,6 +214,91 @@ typedef struct{
     float v;
 } Kitty_UV;
 
+typedef struct {
+    float x;
+    float y;
+    float z;
+    float w;
+} Kitty_Quaternion;
+
+///@brief 4x4 matrix, column major (m[column * 4 + row]).
+typedef struct {
+    float m[16];
+} Kitty_Matrix4;
+
+///@brief Up to four joint influences of one vertex; weights should sum to 1.
+typedef struct {
+    Uint8 joints[4];
+    float weights[4];
+} Kitty_JointWeights;
+
+///@brief Joint hierarchy; parents[j] < j so poses resolve in one pass, -1 marks a root.
+typedef struct {
+    size_t joint_count;
+    int* parents;
+    Kitty_Matrix4* inverse_bind;
+} Kitty_Skeleton;
+
+typedef struct {
+    float time;
+    Kitty_Vertex3D translation;
+    Kitty_Quaternion rotation;
+    Kitty_Vertex3D scale;
+} Kitty_JointKeyframe;
+
+typedef struct {
+    Kitty_JointKeyframe* keys;  // sorted by time
+    size_t key_count;
+} Kitty_JointTrack;
+
+typedef struct {
+    float duration;
+    size_t joint_count;
+    Kitty_JointTrack* tracks;   // one per joint, empty tracks keep the identity pose
+} Kitty_AnimationClip;
+
+///@brief Skinning data of one mesh instance.
+typedef struct {
+    Kitty_Skeleton* skeleton;
+    float* slot_weights;                // SoA, influence slot k of vertex v at [k * vertex_count + v]
+    Uint32* slot_joints;                // same layout, unused slots name joint 0
+    Kitty_Matrix4* skin_matrices;       // per joint, world * inverse bind of the current pose
+    Kitty_Vertex3D* skinned_vertices;   // per frame output of the skinning stage
+    size_t vertex_count;                // vertex count weights and skinned_vertices were sized for
+    bool dirty;                         // pose changed since the last skinning
+} Kitty_Skin;
+
+typedef struct {
+    Uint32* indices;                    // affected vertices
+    Kitty_Vertex3D* deltas;             // offset of each affected vertex at weight 1
+    size_t count;
+    float weight;
+    float applied_weight;               // weight currently blended into morphed_vertices
+} Kitty_MorphTarget;
+
+typedef struct {
+    Kitty_MorphTarget* targets;
+    size_t target_count;
+    Kitty_Vertex3D* morphed_vertices;   // base vertices plus weighted deltas
+    Uint32* stamps;                     // per vertex, epoch it was last restored in
+    Uint32 epoch;
+    size_t vertex_count;                // vertex count morphed_vertices was built for
+    bool dirty;                         // a weight changed since the last blend
+    bool needs_reset;                   // base vertices changed, rebuild from scratch
+} Kitty_Morph;
+
+typedef struct {
+    float threshold;            // projected size in pixels below which the snapshot is drawn
+    int cell;                   // impostor atlas cell, -1 while the faces are drawn
+    int view_bucket;            // quantized view angle of the snapshot, -1 before the first one
+    bool stale;                 // mesh vertices changed since the snapshot
+    Kitty_Vertex3D center;      // bounding sphere of the vertices
+    float radius;
+    float snapshot_scale;       // pixels per mesh unit the snapshot was rasterized at
+    bool active;                // last frame drew the snapshot instead of the faces
+    size_t refresh_count;
+} Kitty_Impostor;
+
 typedef struct {
     int a;
     int b;
@@ -91,15 +315,155 @@ typedef struct {
     Uint8 a;
 } Kitty_Color;
 
+///@brief Everything the engine draws goes through one of these.
+///Colors are straight alpha; the blend mode applies to points, lines and rects.
+typedef struct {
+    const char* name;
+    void* user_data;                            // passed as ctx to every call
+    int (*begin_frame)(void* ctx);
+    void (*clear)(void* ctx, Kitty_Color color);
+    void (*set_color)(void* ctx, Kitty_Color color);
+    void (*set_blend_mode)(void* ctx, SDL_BlendMode mode);
+    void (*draw_points)(void* ctx, const SDL_Point* points, int count);
+    void (*draw_lines)(void* ctx, const SDL_Point* points, int count);    // connected, count - 1 segments
+    void (*draw_rect)(void* ctx, const SDL_Rect* rect);
+    void (*fill_rects)(void* ctx, const SDL_Rect* rects, int count);
+    void (*copy_texture)(void* ctx, SDL_Texture* texture, const SDL_Rect* src, const SDL_Rect* dst);
+    void (*set_target)(void* ctx, SDL_Texture* target, const SDL_Rect* viewport);  // NULL target is the window
+    int (*present_framebuffer)(void* ctx, const Uint32* pixels, int width, int height);   // ARGB8888 over the frame
+    int (*present)(void* ctx);
+    int (*read_back)(void* ctx, Uint32* pixels, int pitch);    // ARGB8888, window sized
+    void (*destroy)(void* ctx);                 // optional, called when the backend is replaced
+} Kitty_RenderBackend;
+
+///@brief 3D color lookup table, trilinearly interpolated.
+typedef struct {
+    int size;                   // entries per axis, 2 to 64
+    Uint32* entries;            // size^3 ARGB8888 colors (alpha ignored), red varies fastest, then green, then blue
+} Kitty_ColorLUT;
+
+typedef struct {
+    enum Kitty_PostEffectType type;
+    int radius;                 // blurs, in pixels of the current resolution
+    const Kitty_ColorLUT* lut;  // KITTY_POST_COLOR_LUT, must stay alive while the chain is set
+} Kitty_PostEffect;
+
+typedef struct {
+    size_t current_bytes;       // heap blocks plus the estimated size (width * height * bytes per pixel) of engine SDL textures
+    size_t peak_bytes;
+    size_t live_allocations;    // heap blocks only
+    size_t total_allocations;   // allocations and reallocations since the last Kitty_ResetMemoryStats
+} Kitty_MemoryTagStats;
+
+typedef struct {
+    Kitty_MemoryTagStats tags[KITTY_MEMORY_TAG_COUNT];
+    Kitty_MemoryTagStats total;
+} Kitty_MemoryStats;
+
+#define KITTY_MAX_BACKTRACE 16
+
+///@brief An engine heap allocation made inside a frame function while the allocation check was on.
+typedef struct {
+    size_t frame;
+    enum Kitty_MemoryTag tag;
+    size_t size;
+    int backtrace_depth;        // 0 on platforms without backtraces
+    void* backtrace[KITTY_MAX_BACKTRACE];
+} Kitty_AllocationReport;
+
+///@brief Codes of diagnostic log records that are not errors; errors are logged with their Kitty_ErrorCodes value.
+enum Kitty_LogEvent {
+    KITTY_EVENT_QUALITY_CHANGED = 2000, // args: old level, new level
+    KITTY_EVENT_WORLD_CELL_LOADED,      // args: cell x, cell y, objects
+    KITTY_EVENT_WORLD_CELL_UNLOADED,    // args: cell x, cell y
+    KITTY_EVENT_USER = 3000             // first code free for Kitty_LogEvent callers
+};
+
+///@brief One entry of the diagnostic log. Records are written as they are and only formatted when read.
+typedef struct {
+    double time_ms;             // engine clock, filled in when the record is logged
+    int code;                   // a Kitty_ErrorCodes value or a Kitty_LogEvent
+    Uint32 thread;              // log ring it was written to, in order of each thread's first record
+    Uint64 object_id;           // Kitty_Object.id of the object involved, 0 for none
+    Sint64 object_index;        // position in the object store, -1 for none
+    Sint64 args[4];             // meaning depends on code
+} Kitty_LogRecord;
+
+///@brief Heap the engine allocates from. Blocks must be aligned for any type, like malloc; reallocate may be NULL.
+typedef struct {
+    void* (*allocate)(void* user_data, size_t size, enum Kitty_MemoryTag tag);
+    void* (*reallocate)(void* user_data, void* block, size_t size, enum Kitty_MemoryTag tag);
+    void (*release)(void* user_data, void* block, enum Kitty_MemoryTag tag);
+    void* user_data;
+} Kitty_Allocator;
+
 typedef struct {
     Kitty_Color startColor;
     Kitty_Color endColor;
 } Kitty_ColorGradient;
 
 typedef struct {
-    SDL_Surface* sdl_surface;
+    Uint16 color0;              // RGB565 endpoints; color0 <= color1 selects the 3 color mode with transparent black
+    Uint16 color1;
+    Uint32 weights;             // 2 bits per texel, row major from the low bits
+} Kitty_BC1Block;
+
+typedef struct {
+    SDL_Surface* sdl_surface;   // RGBA32 texels, NULL once the texture is converted to a compact format
+    enum Kitty_TextureFormat format;
+    int width;                  // compact formats only, RGBA32 textures use the surface size
+    int height;
+    Uint8* indices;             // KITTY_TEXTURE_INDEXED8, width * height
+    Kitty_Color* palette;       // KITTY_TEXTURE_INDEXED8, 256 entries
+    Kitty_BC1Block* blocks;     // KITTY_TEXTURE_BC1, ((width + 3) / 4) * ((height + 3) / 4) row major
 } Kitty_Texture;
 
+typedef struct {
+    int width;
+    int height;
+    int pages_x;
+    int pages_y;
+    size_t first_page;          // index of the level's first page in the page file and page tables
+} Kitty_VirtualTextureLevel;
+
+///@brief A texture too large to keep in memory, split into square pages per mip level in a page file.
+///@brief Samples record which pages they wanted, a loader thread streams those into an LRU page cache
+///@brief and coarser levels stand in until they arrive. The coarsest level is one page and always resident.
+typedef struct {
+    FILE* file;
+    int width;                  // texels of level 0
+    int height;
+    int page_size;              // texels per page side
+    int level_count;
+    Kitty_VirtualTextureLevel* levels;
+    size_t page_count;
+    int* page_slots;            // cache slot of every page, -1 while not resident
+    bool* page_requested;       // feedback, sampled since the last update
+    bool* page_pending;         // queued for or being read by the loader
+    Kitty_Color* cache;         // cache_pages pages of page_size * page_size texels
+    int cache_pages;
+    int* slot_pages;            // page held or being loaded by each slot, -1 when free
+    size_t* slot_last_used;     // frame number of the last sample, the pinned coarsest page never ages
+    int* load_queue;            // slots for the loader, a ring of cache_pages entries
+    int load_head;
+    int load_count;
+    int* done_slots;            // slots the loader finished, negative when the read failed
+    int done_count;
+    SDL_Thread* loader;
+    SDL_mutex* lock;
+    SDL_cond* wake;
+    bool quit;
+    size_t pages_loaded;
+    size_t fallback_samples;    // samples served by a coarser level than they asked for
+} Kitty_VirtualTexture;
+
+typedef struct {
+    int resident_pages;
+    int pending_pages;
+    size_t pages_loaded;
+    size_t fallback_samples;
+} Kitty_VirtualTextureStats;
+
 typedef struct {
     Kitty_Point position;
     float radius;
@@ -145,9 +509,13 @@ typedef struct {
     Kitty_Color* face_colors;
     Kitty_UV* uvs;
     Kitty_Texture* texture;
+    Kitty_VirtualTexture* virtual_texture;  // sampled instead of texture when set
     size_t uv_count;
     size_t vertex_count;
     size_t face_count;
+    Kitty_Skin* skin;           // NULL for static meshes
+    Kitty_Morph* morph;         // NULL without morph targets
+    Kitty_Impostor* impostor;   // NULL draws every face at any distance
 } Kitty_ObjMesh;
 
 typedef struct {
@@ -156,14 +524,286 @@ typedef struct {
     float rotation;
     Kitty_Color color;
     char* text;
+    SDL_Texture* cache;         // last rasterization, kept while the governor throttles the text
+    size_t cache_frame;
 } Kitty_ObjText;
 
+///@brief Cached raster of one tilemap chunk.
+typedef struct {
+    SDL_Texture* texture;
+    int chunk;          // chunk index held by this slot, -1 when free
+    bool dirty;         // a tile changed since the chunk was rasterized
+    size_t last_used;   // frame number of the last draw (for LRU eviction)
+} Kitty_TileChunkSlot;
+
+typedef struct {
+    Kitty_Point position;   // screen position of tile (0, 0); scroll by moving it
+    int width;              // in tiles
+    int height;             // in tiles
+    int tile_width;         // in pixels
+    int tile_height;        // in pixels
+    Kitty_Texture* atlas;
+    Uint16* tiles;          // width * height tile ids, row major
+    int chunks_x;
+    int chunks_y;
+    int* chunk_slots;       // per chunk index into cache, -1 when not cached
+    Kitty_TileChunkSlot* cache;
+    size_t cache_size;
+    SDL_Texture* atlas_texture;
+} Kitty_ObjTilemap;
+
+///@brief Polygon edge prepared for the scanline sweep (16.16 fixed point x).
+typedef struct {
+    int y_top;          // first scanline the edge covers
+    int y_bottom;       // one past the last scanline the edge covers
+    int x0;             // start vertex x
+    int y0;             // start vertex y
+    Sint64 dxdy;        // x step per scanline, 64 bit so far away vertices cannot overflow
+    Sint64 x;           // x on the current scanline
+    int winding;        // +1 downwards, -1 upwards
+} Kitty_PolygonEdge;
+
+typedef struct {
+    Kitty_Point* points;        // all contours back to back
+    size_t point_count;
+    size_t point_capacity;
+    size_t* contour_ends;       // per contour, index one past its last point
+    size_t contour_count;
+    size_t contour_capacity;
+    enum Kitty_FillRule fill_rule;
+    bool filled;
+    Kitty_Color color;
+    Kitty_PolygonEdge* edges;   // edge table sorted by y_top, rebuilt when dirty
+    size_t edge_count;
+    size_t edge_capacity;
+    size_t* active_edges;       // scratch for the active edge list
+    bool edges_dirty;
+} Kitty_ObjPolygon;
+
+typedef struct {
+    Kitty_Point* points;        // one allocation, drawn as a single batch
+    size_t point_count;
+    size_t point_capacity;
+    float width;                // stroke width in pixels, <= 1 draws hairlines
+    enum Kitty_LineJoin join;
+    Kitty_Color color;
+    Kitty_ObjPolygon stroke;    // cached outline of wide strokes
+    bool stroke_dirty;          // set after editing points, width or join directly
+} Kitty_ObjPolyline;
+
+typedef struct {
+    enum Kitty_PathCommand command;
+    Kitty_Vertex2D points[3];   // control points followed by the end point
+} Kitty_PathSegment;
+
+typedef struct {
+    Kitty_Point position;       // screen position of the path origin
+    float scale;                // zoom, flattening is redone when it changes
+    Kitty_PathSegment* segments;
+    size_t segment_count;
+    bool flat_dirty;            // set after editing segments directly
+    Kitty_Vertex2D* flat;       // cached flattening, scaled but not translated
+    size_t flat_count;
+    size_t flat_capacity;
+    size_t* subpath_ends;       // per subpath, index one past its last flat point
+    size_t subpath_count;
+    size_t subpath_capacity;
+    float flat_scale;
+    Kitty_Point flat_position;
+    Kitty_ObjPolyline line;     // flattened points in screen space and stroke
+} Kitty_ObjPath;
+
+///@brief One plot series: a ring buffer of samples plus its per column min/max cache.
+typedef struct {
+    float* samples;             // ring buffer, sample n lives at n % capacity
+    size_t capacity;
+    Uint64 total;               // samples appended so far
+    Uint64 folded;              // samples already folded into the column cache
+    bool fold_dirty;
+    float* column_min;          // per pixel column, indexed by bucket % width
+    float* column_max;
+    Kitty_Color color;
+} Kitty_PlotSeries;
+
+typedef struct {
+    Kitty_Point position;
+    int width;                  // in pixels, one min/max bucket per column
+    int height;
+    float min_value;            // value drawn at the bottom edge
+    float max_value;            // value drawn at the top edge
+    size_t window;              // most recent samples spread across the width
+    Kitty_PlotSeries* series;
+    size_t series_count;
+    int columns_width;          // width the column caches were built for
+    size_t columns_window;      // window the column caches were built for
+    SDL_Point* line_points;     // scratch for the batched line of one series
+} Kitty_ObjPlot;
+
+///@brief Octree node of a point cloud; a subtree's points are contiguous.
+typedef struct {
+    Kitty_Vertex3D min;
+    Kitty_Vertex3D max;
+    size_t first;
+    size_t count;
+    int children[8];            // node indices, -1 when absent
+    bool leaf;
+} Kitty_PointCloudNode;
+
+typedef struct {
+    Kitty_Point3D position;
+    float scale;
+    int splat_size;             // splat edge length in pixels
+    float lod_bias;             // points drawn per splat sized area of a node, lower is coarser
+    size_t point_count;
+    bool quantized;             // positions stored as 16 bit offsets inside the bounds
+    float* x;                   // SoA positions when not quantized
+    float* y;
+    float* z;
+    Uint16* qx;                 // SoA positions when quantized
+    Uint16* qy;
+    Uint16* qz;
+    Uint32* colors;             // packed ARGB8888
+    Kitty_Vertex3D bounds_min;
+    Kitty_Vertex3D bounds_max;
+    Kitty_PointCloudNode* nodes;
+    size_t node_count;
+    size_t points_drawn;        // points splatted in the last frame
+} Kitty_ObjPointCloud;
+
+#define KITTY_TERRAIN_MAX_LODS 9    // enough for chunks of 256 quads
+
+///@brief How a heightmap becomes terrain.
+typedef struct {
+    Kitty_Vertex3D origin;      // object space position of the first height sample at height 0
+    float spacing;              // distance between neighbouring samples along x and z
+    float height_scale;         // height of the full 16 bit range, rising towards -y
+    int chunk_size;             // quads along a chunk edge, a power of two from 2 to 256
+    float lod_distance;         // view depth where chunks drop to LOD 1, every doubling of it drops another level
+    float skirt_depth;          // how far skirts hang below the chunk edges, they hide cracks between LODs
+    Kitty_Color low_color;      // at height 0, blended towards high_color at the top of the range
+    Kitty_Color high_color;
+} Kitty_TerrainSettings;
+
+///@brief Triangles of a chunk at one LOD; every chunk indexes its own vertices with the same list.
+typedef struct {
+    Uint32* indices;            // skirts first, then the grid from the far row to the near one
+    size_t skirt_count;         // indices that belong to skirts
+    size_t index_count;
+} Kitty_TerrainLod;
+
+typedef struct {
+    float* x;                   // SoA vertices, the grid then the skirts; NULL until the chunk is in view
+    float* y;
+    float* z;
+    Kitty_Vertex3D min;         // bounds, skirts included
+    Kitty_Vertex3D max;
+    size_t last_frame;          // frame the chunk was last drawn
+} Kitty_TerrainChunk;
+
+typedef struct {
+    Kitty_Point3D position;
+    float scale;
+    Kitty_TerrainSettings settings;
+    int width;                  // height samples along x
+    int depth;                  // height samples along z
+    Uint16* heights;
+    int chunks_x;
+    int chunks_z;
+    Kitty_TerrainChunk* chunks;
+    Kitty_TerrainLod lods[KITTY_TERRAIN_MAX_LODS];
+    int lod_count;
+    size_t chunks_drawn;        // in the last frame
+    size_t chunks_culled;       // outside the view in the last frame
+    size_t triangles_drawn;     // in the last frame
+    size_t chunks_resident;     // chunks holding vertices
+    float* projected;           // scratch: screen x, y and view depth of one chunk
+    size_t projected_capacity;
+    void* visible;              // scratch: chunks in view, far to near
+    size_t visible_capacity;
+    SDL_Rect* spans;            // scratch: scanline spans of one triangle
+    size_t spans_capacity;
+} Kitty_ObjTerrain;
+
 typedef struct {
     enum Kitty_ObjType type;
     void* data;
+    enum Kitty_Priority priority;   // what the frame governor degrades last
+    Uint64 id;                      // user id for Kitty_FindObject, 0 for none
 
 } Kitty_Object;
 
+///@brief Selects objects for Kitty_RemoveIf.
+typedef bool (*Kitty_ObjectPredicate)(const Kitty_Object* obj, void* user_data);
+
+///@brief Handle of an engine timer, never 0.
+typedef Uint64 Kitty_TimerID;
+///@brief Called when a timer fires, from Kitty_UpdateObjectState.
+typedef void (*Kitty_TimerCallback)(Kitty_TimerID timer, void* user_data);
+
+///@brief Where a streamed world lives on disk and how much of it stays resident around the camera.
+typedef struct {
+    const char* directory;      // one snapshot per cell, written by Kitty_SaveWorldCell
+    float cell_size;            // world units per cell side, cells tile the camera's x/z plane
+    float load_radius;          // cells whose center comes this close to the camera are loaded
+    float unload_radius;        // and dropped beyond this distance, at least load_radius so cells near the edge do not thrash
+    size_t integrate_budget;    // most objects moved into the store per Kitty_UpdateWorld, 0 for no limit
+    Kitty_Texture* const* textures;     // the texture table the cells were saved with
+    size_t texture_count;
+} Kitty_WorldSettings;
+
+enum Kitty_WorldCellState {
+    KITTY_CELL_QUEUED,          // waiting for the loader
+    KITTY_CELL_READING,         // the loader is reading and decoding its snapshot
+    KITTY_CELL_INTEGRATING,     // read, its objects move into the store within the per frame budget
+    KITTY_CELL_RESIDENT         // every object is in the store; a missing snapshot is an empty resident cell
+};
+
+typedef struct {
+    int x;                      // cell coordinates along the camera's x and z
+    int y;
+    enum Kitty_WorldCellState state;
+    float distance;             // from the camera at the last update, nearer cells load and integrate first
+    int result;                 // outcome of the read
+    Kitty_Object* objects;      // read but not yet integrated, owned by the cell
+    size_t object_count;
+    size_t integrated;          // leading objects already in the store
+    void** members;             // data of the integrated objects, which is how the cell finds them in the store
+} Kitty_WorldCell;
+
+typedef struct {
+    int resident_cells;
+    int loading_cells;          // queued or being read
+    int integrating_cells;
+    size_t cells_loaded;        // cells that became resident
+    size_t cells_unloaded;
+    size_t cells_failed;        // damaged snapshots, or objects rejected by the store such as duplicate ids
+    size_t bytes_read;
+    double read_ms;             // loader time spent reading and decoding snapshots
+    size_t objects_integrated;
+    size_t objects_removed;
+} Kitty_WorldStats;
+
+///@brief A world larger than memory, split into grid cells that stream in and out of the object store around the camera.
+///@brief A loader thread reads cell snapshots, Kitty_UpdateWorld moves them into the store and drops distant ones.
+///@brief The objects of a cell belong to the world: do not remove them from the store yourself.
+typedef struct {
+    Kitty_WorldSettings settings;
+    char* directory;            // copy of settings.directory
+    Kitty_WorldCell** cells;    // every cell that is loaded or on its way
+    size_t cell_count;
+    size_t cell_capacity;
+    void** doomed;              // scratch, sorted data of the objects removed this update
+    size_t doomed_count;
+    size_t doomed_capacity;
+    Kitty_WorldCell** ready;    // scratch, leaving cells and then integrating cells nearest first
+    size_t ready_capacity;
+    Kitty_WorldStats stats;
+    SDL_Thread* loader;
+    SDL_mutex* lock;            // guards cell states, the cell list and the loader's stats
+    SDL_cond* wake;
+    bool quit;
+} Kitty_World;
+
 /*
  * Kitty Engine API Functions
  */
@@ -191,9 +831,11 @@ int Kitty_ClearScreen(Kitty_Color color);
 ///@return Returns 0 on success, or an error code on failure.
 int Kitty_FlipBuffers();
 
-///@brief Updates the engine state. Should be called once per frame.
+///@brief Updates the engine state and fires the timers that are due. Should be called once per frame.
 ///@return Returns 0 on success, or an error code on failure.
 int Kitty_UpdateObjectState();
+///@brief Draws every object. An object that fails to draw is logged and skipped, the rest of the frame still renders.
+///@return Returns 0 on success, or the first error of the frame.
 int Kitty_RenderObjects();
 int Kitty_ClearObjects();
 
@@ -203,21 +845,245 @@ int Kitty_AddObject(Kitty_Object obj);
 
 int Kitty_RemoveObject(size_t index);
 
+///@brief Appends count objects, growing the object store once.
+///@return Returns 0 on success, or an error code on failure; on failure no object is added.
+int Kitty_AddObjects(const Kitty_Object* objects, size_t count);
+
+///@brief Removes the objects at the given indices in one compacting pass, keeping the order of the rest.
+///Indices refer to the store before the call and may repeat. Like Kitty_RemoveObject, object data is not freed:
+///it stays with the caller, who kept a copy of the object. Objects a world streamed in are the exception, dropping
+///their cell frees their data.
+///@return Returns 0 on success, or an error code on failure; on failure no object is removed.
+int Kitty_RemoveObjects(const size_t* indices, size_t count);
+
+///@brief Removes every object the predicate returns true for in one compacting pass, keeping the order of the rest.
+///Object data is not freed, the predicate sees each object once and may take ownership of it.
+///@param out_removed Number of removed objects, may be NULL.
+///@return Returns 0 on success, or an error code on failure.
+int Kitty_RemoveIf(Kitty_ObjectPredicate predicate, void* user_data, size_t* out_removed);
+
 int Kitty_GetObject(size_t index, Kitty_Object* out_obj);
+size_t Kitty_GetObjectCount();
+
+///@brief Gives a stored object a user id, or clears it with 0; ids must be unique among stored objects.
+///Objects added with a non-zero id are registered the same way.
+///@return Returns 0 on success, KITTY_DUPLICATE_OBJECT_ID if another object has the id, or another error code on failure.
+int Kitty_SetObjectID(size_t index, Uint64 id);
+
+///@brief Finds the current index of the object with the given id in O(1), following adds and removals.
+///@return Returns 0 on success, KITTY_OBJECT_NOT_FOUND if no stored object has the id, or another error code on failure.
+int Kitty_FindObject(Uint64 id, size_t* out_index);
+
+///@brief Turns a name into an object id (64-bit FNV-1a, never 0), so objects can be looked up by name.
+Uint64 Kitty_ObjectIDFromName(const char* name);
+
+///@brief Writes every stored object with its id and priority, and the camera, to a binary scene snapshot.
+///Textures are not written; meshes and tilemaps refer to theirs by index into textures, which must list every texture in use.
+///Skins, morph targets and virtual textures are left out, meshes are saved in their bind pose.
+///@return Returns 0 on success, KITTY_INVALID_ARGUMENT if an object uses a texture missing from textures, or another error code on failure.
+int Kitty_SaveScene(const char* file_path, Kitty_Texture* const* textures, size_t texture_count);
+
+///@brief Replaces the stored objects and the camera with a snapshot written by Kitty_SaveScene.
+///@param textures The texture table the snapshot was saved with, in the same order.
+///@return Returns 0 on success, KITTY_INVALID_FILE for a damaged snapshot or one from another version or platform,
+///or another error code on failure; the store is unchanged when the snapshot cannot be read.
+int Kitty_LoadScene(const char* file_path, Kitty_Texture* const* textures, size_t texture_count);
+
+///@brief Writes objects as the snapshot of world cell (x, y) in directory; the objects are not stored or freed.
+///@return Returns 0 on success, or an error code on failure.
+int Kitty_SaveWorldCell(const char* directory, int x, int y, const Kitty_Object* objects, size_t count, Kitty_Texture* const* textures, size_t texture_count);
+
+///@brief Starts streaming a world; nothing is loaded before the first Kitty_UpdateWorld.
+///@return Returns the world, or NULL for invalid settings or when the loader cannot start.
+Kitty_World* Kitty_OpenWorld(const Kitty_WorldSettings* settings);
+
+///@brief Queues cells that came within the load radius, drops cells beyond the unload radius
+///and moves loaded cells into the store within the budget. Call once per frame before Kitty_UpdateObjectState.
+///@return Returns 0 on success, or an error code on failure.
+int Kitty_UpdateWorld(Kitty_World* world);
+
+///@brief Stops the loader and removes the world's objects from the store; call it before Kitty_Quit.
+void Kitty_CloseWorld(Kitty_World* world);
+
+int Kitty_GetWorldStats(Kitty_World* world, Kitty_WorldStats* out_stats);
+
+///@brief Sets the priority of a stored object; low priority objects lose quality first under load.
+///Removals shift the indices of later objects, so resolve the index again after removing objects,
+///or use Kitty_SetObjectPriorityByID.
+///@return Returns 0 on success, or an error code on failure.
+int Kitty_SetObjectPriority(size_t index, enum Kitty_Priority priority);
+
+///@brief Sets the priority of the stored object with the given id, wherever adds and removals moved it.
+///@return Returns 0 on success, KITTY_OBJECT_NOT_FOUND if no stored object has the id, or another error code on failure.
+int Kitty_SetObjectPriorityByID(Uint64 id, enum Kitty_Priority priority);
 
 int Kitty_AddVertexToObjMesh(Kitty_Object* obj, Kitty_Vertex3D vertex);
 int Kitty_AddFaceToObjMesh(Kitty_Object* obj, Kitty_Face face, Kitty_Color face_color);
 int Kitty_AddUVToObjMesh(Kitty_Object* obj, Kitty_UV uv);
 
 Kitty_Texture* Kitty_LoadTexture(const char* file_path);
+
+///@brief Loads an image and converts it to the given format, see Kitty_ConvertTexture.
+///@return Returns the texture, or NULL on failure.
+Kitty_Texture* Kitty_LoadTextureAs(const char* file_path, enum Kitty_TextureFormat format);
+
+///@brief Converts an RGBA32 texture in place to a compact format and frees its surface.
+///@brief Indexed textures keep their colors exactly when there are at most 256, otherwise the palette comes from median cut.
+///@return Returns 0 on success, or an error code on failure.
+int Kitty_ConvertTexture(Kitty_Texture* texture, enum Kitty_TextureFormat format);
+
+///@brief Returns the texel at x, y of a texture in any format, coordinates must be inside the texture.
+Kitty_Color Kitty_SampleTexture(const Kitty_Texture* texture, int x, int y);
+
+///@brief Returns the bytes used by the texels of a texture.
+size_t Kitty_GetTextureMemory(const Kitty_Texture* texture);
+
+///@brief Frees a texture returned by Kitty_LoadTexture or Kitty_LoadTextureAs.
+void Kitty_FreeTexture(Kitty_Texture* texture);
+
+///@brief Writes a texture and its mip chain as a page file for Kitty_OpenVirtualTexture; an offline step that needs the whole source in memory.
+///@param page_size Texels per page side, a power of two of at least 16.
+///@return Returns 0 on success, or an error code on failure.
+int Kitty_BakeVirtualTexture(const Kitty_Texture* source, int page_size, const char* file_path);
+
+///@brief Opens a page file and starts streaming it, only the coarsest level is read up front.
+///@param cache_pages Pages kept in memory, at least 2.
+///@return Returns the virtual texture, or NULL on failure.
+Kitty_VirtualTexture* Kitty_OpenVirtualTexture(const char* file_path, int cache_pages);
+
+///@brief Stops the loader and frees a virtual texture; meshes must no longer reference it.
+void Kitty_CloseVirtualTexture(Kitty_VirtualTexture* texture);
+
+///@brief Returns the texel at u, v in [0, 1) from mip level, or from the finest coarser level that is resident.
+///@brief Marks the page at the wanted level for streaming; Kitty_UpdateVirtualTexture issues the loads.
+Kitty_Color Kitty_SampleVirtualTexture(Kitty_VirtualTexture* texture, float u, float v, int level);
+
+///@brief Publishes pages the loader finished and queues the pages sampled since the last update, coarse levels first.
+///@brief Meshes call this after every textured draw, call it yourself when sampling directly.
+///@return Returns 0 on success, or an error code on failure.
+int Kitty_UpdateVirtualTexture(Kitty_VirtualTexture* texture);
+
+int Kitty_GetVirtualTextureStats(const Kitty_VirtualTexture* texture, Kitty_VirtualTextureStats* out_stats);
 int Kitty_LoadDotObj(FILE* file, Kitty_Object* mesh);
 
 size_t Kitty_GetFrameNumber();
 clock_t Kitty_GetDeltaTime();
 double Kitty_GetFrameTime();
 
+///@brief Sets how the software framebuffer resolution follows the frame-time budget.
+///@return Returns 0 on success, or an error code on failure.
+int Kitty_SetDynamicResolution(Kitty_DynamicResolution settings);
+Kitty_DynamicResolution Kitty_GetDynamicResolution();
+///@brief Fixes the software framebuffer scale; the controller overrides it while enabled.
+///@return Returns 0 on success, or an error code on failure.
+int Kitty_SetResolutionScale(float scale);
+///@brief Returns the scale the software framebuffer is rendered at (1 = window size).
+float Kitty_GetResolutionScale();
+///@brief Returns the software rasterization time of the last frame in milliseconds.
+double Kitty_GetRasterTime();
+
+///@brief Sets coverage anti-aliasing for filled triangles and flat shaded mesh faces.
+///Only pixels on triangle edges are sampled, interior spans are drawn as before.
+///@return Returns 0 on success, or an error code on failure.
+int Kitty_SetAntiAliasing(enum Kitty_AntiAliasing level);
+enum Kitty_AntiAliasing Kitty_GetAntiAliasing();
+
+///@brief Sets the post-processing chain run over the software framebuffer before it is composited.
+///Downsamples that are not matched by an upsample are undone at the end of the chain.
+///@param count Number of effects, 0 turns post-processing off.
+///@return Returns 0 on success, or an error code on failure.
+int Kitty_SetPostChain(const Kitty_PostEffect* effects, size_t count);
+///@brief Creates an identity color lookup table with size entries per axis.
+///@return Returns the table, or NULL on failure.
+Kitty_ColorLUT* Kitty_CreateColorLUT(int size);
+void Kitty_FreeColorLUT(Kitty_ColorLUT* lut);
+///@brief Sets the color a lookup table maps the grid point (r, g, b) to, each in 0 to size - 1.
+///@return Returns 0 on success, or an error code on failure.
+int Kitty_SetColorLUTEntry(Kitty_ColorLUT* lut, int r, int g, int b, Kitty_Color color);
+
+///@brief Sets how many software framebuffers are in flight (1 to KITTY_MAX_FRAMES_IN_FLIGHT).
+///Only point clouds are drawn through the software framebuffer. With more than one, a raster thread splats
+///them while the main thread draws the other objects, and the framebuffer is composited once that is done,
+///so point clouds are shown in the same frame as everything else.
+///@return Returns 0 on success, or an error code on failure.
+int Kitty_SetFramesInFlight(int count);
+int Kitty_GetFramesInFlight();
+
+///@brief Sets the frame budget governor, which trades quality for frame time by priority.
+///@return Returns 0 on success, or an error code on failure.
+int Kitty_SetFrameGovernor(Kitty_FrameGovernor settings);
+Kitty_FrameGovernor Kitty_GetFrameGovernor();
+///@brief Forces a quality level; the governor moves on from it while enabled.
+///@return Returns 0 on success, or an error code on failure.
+int Kitty_SetQualityLevel(int level);
+///@brief Returns the governor's decisions and timings for the last frame.
+Kitty_FrameStats Kitty_GetFrameStats();
+
+///@brief Switches to one of the built in render backends.
+///@return Returns 0 on success, or an error code on failure.
+int Kitty_SetRenderBackend(enum Kitty_BackendType type);
+///@brief Installs a user backend; the struct is copied and every function pointer must be set (destroy may be NULL).
+///@return Returns 0 on success, or an error code on failure.
+int Kitty_SetCustomRenderBackend(const Kitty_RenderBackend* backend);
+const Kitty_RenderBackend* Kitty_GetRenderBackend();
+///@brief Reads the presented frame back as window sized ARGB8888 pixels, pitch in bytes.
+///@return Returns 0 on success, or an error code on failure.
+int Kitty_ReadPixels(Uint32* pixels, int pitch);
+
+///@brief Returns current and peak bytes and allocation counts of the engine heap, per tag and in total.
+///Objects returned by the Kitty_Create functions, their data and Kitty_Texture structs are freed by the caller and stay
+///on the C library heap. Blocks in public fields (mesh vertices, text strings and so on) are plain heap blocks: while no
+///allocator is set a caller may free, realloc or replace them, a block the engine did not allocate is released with
+///free() and not counted, and an engine block released outside the engine stays counted.
+///SDL textures the engine creates and surfaces it loads count by their size under their tag, not as live blocks;
+///user surfaces and SDL's own memory are not counted.
+///@return Returns 0 on success, or an error code on failure.
+int Kitty_GetMemoryStats(Kitty_MemoryStats* out_stats);
+///@brief Sets every peak to the current usage and zeroes the total allocation counts.
+void Kitty_ResetMemoryStats();
+///@brief Routes engine allocations to a user heap, NULL returns to malloc. Only possible while the engine holds no memory.
+///Engine blocks in public fields then come from that heap, so release them through the engine rather than with free().
+///@return Returns 0 on success, or an error code on failure.
+int Kitty_SetAllocator(const Kitty_Allocator* allocator);
+///@brief Debug mode for a zero allocation steady state, turn it on once warm-up is done. From then on every engine
+///heap allocation inside Kitty_ClearScreen, Kitty_UpdateObjectState, Kitty_RenderObjects or Kitty_FlipBuffers,
+///or on a worker or the raster thread while it runs their work, is reported on stderr with its backtrace;
+///the first ones are kept for Kitty_GetAllocationReports. Allocations on other threads, like the world loader, are not.
+///Enabling clears the reports. Kitty_FrameStats.allocations counts these allocations whether the check is on or not.
+void Kitty_SetAllocationCheck(bool enabled);
+///@brief Copies up to capacity of the kept reports, oldest first.
+///@return Returns how many allocations the check caught since it was enabled, which can exceed the kept reports.
+size_t Kitty_GetAllocationReports(Kitty_AllocationReport* out_reports, size_t capacity);
+
+///@brief Turns the diagnostic log on or off, it starts on. Every thread that logs gets its own ring of the last
+///few thousand records and appends to it without locks, so the log can stay on in production.
+void Kitty_SetLogEnabled(bool enabled);
+///@brief Appends a record from the calling thread; time_ms and thread are filled in.
+void Kitty_LogEvent(const Kitty_LogRecord* record);
+///@brief Copies the records of the last seconds from every thread, oldest first, keeping the newest when more
+///than capacity match. Safe while other threads keep logging.
+///@return Returns the number of records copied.
+size_t Kitty_ReadLog(double seconds, Kitty_LogRecord* out_records, size_t capacity);
+///@brief Writes one record as a line of text, like snprintf.
+///@return Returns the length of the full line.
+int Kitty_FormatLogRecord(const Kitty_LogRecord* record, char* buffer, size_t size);
+///@brief Writes the records of the last seconds to file as text, for example to stderr on a fault.
+///@return Returns 0 on success, or an error code on failure.
+int Kitty_DumpLog(FILE* file, double seconds);
+
 void Kitty_SetTimer1();
 bool Kitty_Timer1Trip(long miliseconds);
+///@brief Schedules callback to run delay_ms from now, then every period_ms unless period_ms is 0.
+///Timers live on a hierarchical wheel with a 1 ms tick, so starting and cancelling cost the same for any number
+///of outstanding timers and an update only pays for the timers that fire. They fire from Kitty_UpdateObjectState,
+///before anything else in the frame; a periodic timer that fell behind fires once and keeps its phase.
+///@return Returns 0 on success, or an error code on failure.
+int Kitty_StartTimer(Uint32 delay_ms, Uint32 period_ms, Kitty_TimerCallback callback, void* user_data, Kitty_TimerID* out_timer);
+///@brief Stops a timer, also from inside a callback and also the timer that is firing.
+///@return Returns 0 on success, KITTY_OBJECT_NOT_FOUND if the one-shot timer already fired or the timer was stopped.
+int Kitty_CancelTimer(Kitty_TimerID timer);
+///@brief Number of timers waiting to fire.
+size_t Kitty_GetTimerCount();
 
 void Kitty_RotateCamera(float angle_x, float angle_y, float angle_z);
 Kitty_Vertex3D Kitty_GetCameraPosition();
@@ -232,6 +1098,76 @@ Kitty_Object* Kitty_CreatePixel(Kitty_Point position, Kitty_Color color);
 Kitty_Object* Kitty_CreateMesh();
 Kitty_Object* Kitty_CreateText(Kitty_Point position, float rotation, float size, Kitty_Color color, const char* text);
 
+///@brief Creates a tilemap of width x height tiles, all set to KITTY_TILE_EMPTY.
+///@param atlas Texture holding the tiles in a grid; tile ids count left to right, top to bottom.
+///@return Returns the tilemap object, or NULL on failure.
+Kitty_Object* Kitty_CreateTilemap(Kitty_Point position, int width, int height, int tile_width, int tile_height, Kitty_Texture* atlas);
+
+///@brief Sets a tile and marks its chunk for re-rasterization.
+///@return Returns 0 on success, or an error code on failure.
+int Kitty_SetTile(Kitty_Object* obj, int x, int y, Uint16 tile);
+
+///@brief Reads a tile id from a tilemap.
+///@return Returns 0 on success, or an error code on failure.
+int Kitty_GetTile(Kitty_Object* obj, int x, int y, Uint16* out_tile);
+
+///@brief Creates a polygon from one closed contour, which may be concave.
+///@param fill_rule Rule deciding which regions are inside when contours overlap.
+///@return Returns the polygon object, or NULL on failure.
+Kitty_Object* Kitty_CreatePolygon(const Kitty_Point* points, size_t point_count, bool filled, enum Kitty_FillRule fill_rule, Kitty_Color color);
+
+///@brief Adds another closed contour to a polygon, e.g. a hole.
+///@return Returns 0 on success, or an error code on failure.
+int Kitty_AddPolygonContour(Kitty_Object* obj, const Kitty_Point* points, size_t point_count);
+
+///@brief Creates a polyline through the given points.
+///@param width Stroke width in pixels; widths above 1 are stroked with the given join.
+///@return Returns the polyline object, or NULL on failure.
+Kitty_Object* Kitty_CreatePolyline(const Kitty_Point* points, size_t point_count, float width, enum Kitty_LineJoin join, Kitty_Color color);
+
+///@brief Replaces the points of a polyline, reusing its allocation when it fits.
+///@return Returns 0 on success, or an error code on failure.
+int Kitty_SetPolylinePoints(Kitty_Object* obj, const Kitty_Point* points, size_t point_count);
+
+///@brief Creates an empty path; build it with the Kitty_Path* functions.
+///@return Returns the path object, or NULL on failure.
+Kitty_Object* Kitty_CreatePath(Kitty_Point position, float width, enum Kitty_LineJoin join, Kitty_Color color);
+
+int Kitty_PathMoveTo(Kitty_Object* obj, Kitty_Vertex2D point);
+int Kitty_PathLineTo(Kitty_Object* obj, Kitty_Vertex2D point);
+int Kitty_PathQuadTo(Kitty_Object* obj, Kitty_Vertex2D control, Kitty_Vertex2D point);
+int Kitty_PathCubicTo(Kitty_Object* obj, Kitty_Vertex2D control1, Kitty_Vertex2D control2, Kitty_Vertex2D point);
+
+///@brief Creates a time-series plot showing the latest window samples of each series.
+///@return Returns the plot object, or NULL on failure.
+Kitty_Object* Kitty_CreatePlot(Kitty_Point position, int width, int height, float min_value, float max_value, size_t window);
+
+///@brief Adds a series that keeps the last capacity samples; its index is series_count - 1.
+///@return Returns 0 on success, or an error code on failure.
+int Kitty_AddPlotSeries(Kitty_Object* obj, size_t capacity, Kitty_Color color);
+
+///@brief Appends a sample to a series in O(1) without allocating.
+///@return Returns 0 on success, or an error code on failure.
+int Kitty_PlotAppend(Kitty_Object* obj, size_t series, float value);
+
+///@brief Creates a point cloud, copying the points into SoA arrays sorted by an octree.
+///Point clouds are splatted into the software framebuffer with a depth test.
+///@param colors Per point colors, or NULL for white.
+///@param quantize Store positions as 16 bit offsets inside the bounding box.
+///@return Returns the point cloud object, or NULL on failure.
+Kitty_Object* Kitty_CreatePointCloud(const Kitty_Vertex3D* positions, const Kitty_Color* colors, size_t count, bool quantize);
+///@brief Creates a terrain from a width by depth grid of 16 bit heights, row by row along z.
+///The grid is split into chunks that get their vertices when they first come into view and drop them after a
+///while out of it. Each chunk picks a LOD from its view depth and is culled against the view on its own;
+///all chunks of a LOD share one index list, and skirts along the chunk edges hide the cracks between LODs.
+///@return Returns the terrain object, or NULL on failure.
+Kitty_Object* Kitty_CreateTerrain(const Uint16* heights, int width, int depth, const Kitty_TerrainSettings* settings);
+///@brief Loads a terrain heightmap. .r16 and .raw files are square grids of little endian 16 bit heights; other
+///images go through SDL_image, which decodes 8 bits per channel: grayscale images are stretched to 16 bits and
+///color images carry the high byte in red and the low byte in green.
+///@return Returns the terrain object, or NULL on failure.
+Kitty_Object* Kitty_LoadTerrain(const char* file_path, const Kitty_TerrainSettings* settings);
+
 int Kitty_Transform(Kitty_Object* obj, Kitty_Point3D translation, Kitty_Vertex3D rotation);
 
 Kitty_Vertex3D KittyM_CalculateMeshCenter(Kitty_ObjMesh* mesh);
@@ -244,6 +1180,63 @@ Kitty_Vertex3D KittyM_RotateVertex3D_X(Kitty_Vertex3D v, float angle);
 Kitty_Vertex3D KittyM_RotateVertex3D_Y(Kitty_Vertex3D v, float angle);
 Kitty_Vertex3D KittyM_RotateVertex3D_Z(Kitty_Vertex3D v, float angle);
 
+///@brief Creates a skeleton; parents[j] must be lower than j (or -1 for roots).
+///@return Returns the skeleton, or NULL on failure.
+Kitty_Skeleton* Kitty_CreateSkeleton(size_t joint_count, const int* parents, const Kitty_Matrix4* inverse_bind);
+void Kitty_FreeSkeleton(Kitty_Skeleton* skeleton);
+
+///@brief Creates an animation clip with an empty track per joint.
+///@return Returns the clip, or NULL on failure.
+Kitty_AnimationClip* Kitty_CreateAnimationClip(size_t joint_count, float duration);
+void Kitty_FreeAnimationClip(Kitty_AnimationClip* clip);
+
+///@brief Appends a keyframe to a joint track; keyframes must be added in time order.
+///@return Returns 0 on success, or an error code on failure.
+int Kitty_AddJointKeyframe(Kitty_AnimationClip* clip, size_t joint, Kitty_JointKeyframe key);
+
+///@brief Binds a mesh to a skeleton with per vertex joint weights (vertex_count entries).
+///A NULL skeleton and weights unbind the skin. A skinned mesh rejects new vertices: unbind, add them and bind again.
+///@return Returns 0 on success, or an error code on failure.
+int Kitty_SetMeshSkin(Kitty_Object* obj, Kitty_Skeleton* skeleton, const Kitty_JointWeights* weights);
+
+///@brief Samples a clip at time and poses the mesh's skeleton; vertices are skinned during rendering.
+///@return Returns 0 on success, or an error code on failure.
+int Kitty_PoseMesh(Kitty_Object* obj, const Kitty_AnimationClip* clip, float time, bool loop);
+
+///@brief Draws the mesh as a cached snapshot quad while its projected size is below threshold pixels.
+///Snapshots share up to 4096 atlas cells on pages added as needed. A mesh drawn face by face gives its cell back, and
+///when every cell is taken the one drawn longest ago is reused; only when all are on screen are faces drawn instead
+///(see impostors_over_capacity in Kitty_FrameStats).
+///@param threshold Size in pixels, 0 turns impostors off again.
+///@return Returns 0 on success, or an error code on failure.
+int Kitty_SetMeshImpostor(Kitty_Object* obj, float threshold);
+
+///@brief Adds a morph target of count (vertex index, delta) pairs; its index is target_count - 1.
+///@return Returns 0 on success, or an error code on failure.
+int Kitty_AddMorphTarget(Kitty_Object* obj, const Uint32* indices, const Kitty_Vertex3D* deltas, size_t count);
+
+///@brief Sets a morph target weight; deltas are blended in during rendering, the base mesh is left alone.
+///@return Returns 0 on success, or an error code on failure.
+int Kitty_SetMorphWeight(Kitty_Object* obj, size_t target, float weight);
+
+///@brief Plays target_count consecutive targets as vertex keyframes, frame 1.5 blends halfway between the second and third.
+///@return Returns 0 on success, or an error code on failure.
+int Kitty_SetMorphKeyframe(Kitty_Object* obj, size_t first_target, size_t target_count, float frame);
+
+///@brief Reads an OBJ with the same vertices as the mesh and adds the moved vertices as a morph target.
+///@return Returns 0 on success, or an error code on failure.
+int Kitty_LoadDotObjMorphTarget(FILE* file, Kitty_Object* mesh);
+
+///@brief Loads an OBJ sequence, one file per keyframe, as consecutive morph targets.
+///@return Returns 0 on success, or an error code on failure.
+int Kitty_LoadDotObjSequence(FILE** files, size_t file_count, Kitty_Object* mesh);
+
+Kitty_Matrix4 KittyM_MatrixIdentity();
+Kitty_Matrix4 KittyM_MatrixMultiply(Kitty_Matrix4 a, Kitty_Matrix4 b);
+Kitty_Matrix4 KittyM_MatrixCompose(Kitty_Vertex3D translation, Kitty_Quaternion rotation, Kitty_Vertex3D scale);
+Kitty_Quaternion KittyM_QuaternionAxisAngle(Kitty_Vertex3D axis, float angle);
+Kitty_Quaternion KittyM_QuaternionNlerp(Kitty_Quaternion a, Kitty_Quaternion b, float t);
+
 int KittyD_DrawMeshUVMap(Kitty_Point position, int scale, Kitty_ObjMesh* mesh);
 int KittyD_DrawTexture(Kitty_Point position, int scale, Kitty_Texture* texture);
 
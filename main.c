@@ -2,6 +2,8 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
+#include <math.h>
 
 
 #include "kittyengine.h"
@@ -299,6 +301,2532 @@ int test_memory_stress_100000(){
     return 0;
 }
 
+int test_object_store_growth(){
+    int result = Kitty_Init("Kitty Engine Object Store Growth Test", 800, 600);
+    if (result != KITTY_SUCCESS){
+        printf("Kitty_Init failed with error code: %d\n", result);
+        return 1;
+    }
+
+    // the store grows in 1 MB steps, which need not hold a whole number of objects
+    for (int i = 0; i < 100000; i++){
+        Kitty_Object* pixel = Kitty_CreatePixel((Kitty_Point){i % 800, i % 600}, (Kitty_Color){255, 255, 255, 255});
+        if (!pixel){
+            printf("Kitty_CreatePixel failed during object store growth test.\n");
+            Kitty_Quit();
+            return 1;
+        }
+        pixel->priority = (enum Kitty_Priority)(i % 3);
+        if ((result = Kitty_AddObject(*pixel))) {
+            printf("Kitty_AddObject failed with error code: %d\n", result);
+            free(pixel->data);
+            free(pixel);
+            Kitty_Quit();
+            return 1;
+        }
+        free(pixel);
+    }
+
+    // every object survives the steps, including the one that straddled a step boundary
+    for (int i = 0; i < 100000; i++){
+        Kitty_Object stored;
+        if (Kitty_GetObject(i, &stored) || stored.type != KITTY_OBJECT_PIXEL || stored.priority != (enum Kitty_Priority)(i % 3)){
+            printf("Object %d changed while the store grew.\n", i);
+            Kitty_Quit();
+            return 1;
+        }
+    }
+
+    result = Kitty_Quit();
+    if (result != KITTY_SUCCESS){
+        printf("Kitty_Quit failed with error code: %d\n", result);
+        return 1;
+    }
+
+    printf("Object store growth test passed successfully.\n");
+    return 0;
+}
+
+int test_tilemap(){
+    int result = Kitty_Init("Kitty Engine Tilemap Test", 800, 600);
+    if (result != KITTY_SUCCESS){
+        printf("Kitty_Init failed with error code: %d\n", result);
+        return 1;
+    }
+
+    // 4x4 tiles of 16x16 pixels
+    Kitty_Texture atlas = { .sdl_surface = SDL_CreateRGBSurfaceWithFormat(0, 64, 64, 32, SDL_PIXELFORMAT_RGBA32) };
+    Kitty_Object* map = Kitty_CreateTilemap((Kitty_Point){0, 0}, 4096, 4096, 16, 16, &atlas);
+    if (!map){
+        printf("Kitty_CreateTilemap failed.\n");
+        Kitty_Quit();
+        return 1;
+    }
+
+    for (int y = 0; y < 4096; y += 7){
+        for (int x = 0; x < 4096; x += 3){
+            Kitty_SetTile(map, x, y, (x + y) % 16);
+        }
+    }
+    Uint16 tile;
+    if (Kitty_GetTile(map, 3, 7, &tile) || tile != 10 || Kitty_SetTile(map, 4096, 0, 1) != KITTY_INVALID_ARGUMENT){
+        printf("Kitty_SetTile/Kitty_GetTile returned wrong data.\n");
+        Kitty_Quit();
+        return 1;
+    }
+
+    if ((result = Kitty_AddObject(*map))) {
+        printf("Kitty_AddObject (tilemap) failed with error code: %d\n", result);
+        Kitty_Quit();
+        return 1;
+    }
+
+    Kitty_ObjTilemap* map_data = (Kitty_ObjTilemap*)map->data;
+    for (int i = 0; i < 200; i++){
+        Kitty_ClearScreen((Kitty_Color){0, 0, 0, 255});
+        map_data->position.x -= 37;
+        map_data->position.y -= 23;
+        Kitty_SetTile(map, -map_data->position.x / 16, -map_data->position.y / 16, i % 16);
+        if ((result = Kitty_RenderObjects())){
+            printf("Kitty_RenderObjects (tilemap) failed with error code: %d\n", result);
+            Kitty_Quit();
+            return 1;
+        }
+        Kitty_FlipBuffers();
+    }
+
+    // the chunk cache stays bounded by the window, not by the map
+    if (map_data->cache_size > 64){
+        printf("Tilemap chunk cache grew to %zu slots.\n", map_data->cache_size);
+        Kitty_Quit();
+        return 1;
+    }
+
+    free(map);
+    result = Kitty_Quit();
+    SDL_FreeSurface(atlas.sdl_surface);
+    if (result != KITTY_SUCCESS){
+        printf("Kitty_Quit failed with error code: %d\n", result);
+        return 1;
+    }
+
+    printf("Tilemap test passed successfully.\n");
+    return 0;
+}
+
+int test_polygon(){
+    int result = Kitty_Init("Kitty Engine Polygon Test", 800, 600);
+    if (result != KITTY_SUCCESS){
+        printf("Kitty_Init failed with error code: %d\n", result);
+        return 1;
+    }
+
+    // concave outline with a square hole, filled with both rules
+    Kitty_Point outline[] = {{100, 100}, {400, 80}, {250, 250}, {420, 500}, {90, 450}};
+    Kitty_Point hole[] = {{150, 300}, {250, 300}, {250, 400}, {150, 400}};
+    Kitty_Object* even_odd = Kitty_CreatePolygon(outline, 5, true, KITTY_FILL_EVEN_ODD, (Kitty_Color){255, 255, 0, 255});
+    Kitty_Object* nonzero = Kitty_CreatePolygon(outline, 5, true, KITTY_FILL_NONZERO, (Kitty_Color){0, 255, 255, 255});
+    if (!even_odd || !nonzero){
+        printf("Kitty_CreatePolygon failed.\n");
+        Kitty_Quit();
+        return 1;
+    }
+    if (Kitty_AddPolygonContour(even_odd, hole, 4) || Kitty_AddPolygonContour(nonzero, hole, 4)){
+        printf("Kitty_AddPolygonContour failed.\n");
+        Kitty_Quit();
+        return 1;
+    }
+    if (Kitty_AddPolygonContour(nonzero, hole, 2) != KITTY_INVALID_ARGUMENT){
+        printf("Kitty_AddPolygonContour accepted a degenerate contour.\n");
+        Kitty_Quit();
+        return 1;
+    }
+
+    if ((result = Kitty_AddObject(*even_odd)) || (result = Kitty_AddObject(*nonzero))) {
+        printf("Kitty_AddObject (polygon) failed with error code: %d\n", result);
+        Kitty_Quit();
+        return 1;
+    }
+    Kitty_ClearScreen((Kitty_Color){0, 0, 0, 255});
+    if ((result = Kitty_RenderObjects())){
+        printf("Kitty_RenderObjects (polygon) failed with error code: %d\n", result);
+        Kitty_Quit();
+        return 1;
+    }
+    Kitty_FlipBuffers();
+
+    // a vertex far past the 16.16 range still sets up its edges without overflowing
+    Kitty_ClearObjects();
+    Kitty_Point wide[] = {{0, 100}, {100000, 100}, {0, 500}};
+    Kitty_Object* far = Kitty_CreatePolygon(wide, 3, true, KITTY_FILL_NONZERO, (Kitty_Color){255, 0, 0, 255});
+    Kitty_AddObject(*far);
+    free(far);
+    Kitty_ClearScreen((Kitty_Color){0, 0, 0, 255});
+    if ((result = Kitty_RenderObjects())) {
+        printf("Polygon with a far away vertex failed to render with error code: %d\n", result);
+        Kitty_Quit();
+        return 1;
+    }
+    Kitty_FlipBuffers();
+
+    free(even_odd);
+    free(nonzero);
+    if ((result = Kitty_Quit())) {
+        printf("Kitty_Quit failed with error code: %d\n", result);
+        return 1;
+    }
+
+    printf("Polygon test passed successfully.\n");
+    return 0;
+}
+
+int test_polyline_and_path(){
+    int result = Kitty_Init("Kitty Engine Polyline Test", 800, 600);
+    if (result != KITTY_SUCCESS){
+        printf("Kitty_Init failed with error code: %d\n", result);
+        return 1;
+    }
+
+    Kitty_Point chart[800];
+    for (int i = 0; i < 800; i++){
+        chart[i] = (Kitty_Point){i, 300 + rand() % 100};
+    }
+    Kitty_Object* hairline = Kitty_CreatePolyline(chart, 800, 1.0f, KITTY_JOIN_MITER, (Kitty_Color){255, 255, 255, 255});
+    Kitty_Object* thick = Kitty_CreatePolyline(chart, 100, 8.0f, KITTY_JOIN_ROUND, (Kitty_Color){255, 0, 255, 255});
+    Kitty_Object* path = Kitty_CreatePath((Kitty_Point){100, 100}, 3.0f, KITTY_JOIN_MITER, (Kitty_Color){0, 255, 0, 255});
+    if (!hairline || !thick || !path){
+        printf("Kitty_CreatePolyline/Kitty_CreatePath failed.\n");
+        Kitty_Quit();
+        return 1;
+    }
+    Kitty_PathMoveTo(path, (Kitty_Vertex2D){0.0f, 0.0f});
+    Kitty_PathQuadTo(path, (Kitty_Vertex2D){50.0f, 100.0f}, (Kitty_Vertex2D){100.0f, 0.0f});
+    Kitty_PathCubicTo(path, (Kitty_Vertex2D){150.0f, 80.0f}, (Kitty_Vertex2D){200.0f, -80.0f}, (Kitty_Vertex2D){250.0f, 0.0f});
+    Kitty_PathLineTo(path, (Kitty_Vertex2D){250.0f, 100.0f});
+
+    if ((result = Kitty_AddObject(*hairline)) || (result = Kitty_AddObject(*thick)) || (result = Kitty_AddObject(*path))) {
+        printf("Kitty_AddObject (polyline) failed with error code: %d\n", result);
+        Kitty_Quit();
+        return 1;
+    }
+
+    Kitty_ObjPath* path_data = (Kitty_ObjPath*)path->data;
+    size_t flat_count = 0;
+    for (int i = 0; i < 3; i++){
+        Kitty_ClearScreen((Kitty_Color){0, 0, 0, 255});
+        if ((result = Kitty_RenderObjects())){
+            printf("Kitty_RenderObjects (polyline) failed with error code: %d\n", result);
+            Kitty_Quit();
+            return 1;
+        }
+        Kitty_FlipBuffers();
+        flat_count = path_data->flat_count;
+        path_data->scale = 3.0f; // zooming in refines the flattening
+    }
+    Kitty_RenderObjects();
+    if (path_data->flat_count <= 4 || path_data->flat_count != flat_count){
+        printf("Path flattening was not cached per zoom level.\n");
+        Kitty_Quit();
+        return 1;
+    }
+
+    // a pan moves the cached stroke outline; the nudged first point would be lost if the stroke were rebuilt
+    Kitty_ObjPolygon* stroke = &path_data->line.stroke;
+    Kitty_Point marked = {stroke->points[0].x + 7, stroke->points[0].y};
+    stroke->points[0] = marked;
+    path_data->position.x += 40;
+    path_data->position.y -= 15;
+    Kitty_RenderObjects();
+    if (path_data->line.stroke_dirty || stroke->points[0].x != marked.x + 40 || stroke->points[0].y != marked.y - 15 ||
+        path_data->line.points[0].x != path_data->position.x){
+        printf("Panning a path rebuilt its stroke.\n");
+        Kitty_Quit();
+        return 1;
+    }
+
+    free(hairline);
+    free(thick);
+    free(path);
+    if ((result = Kitty_Quit())) {
+        printf("Kitty_Quit failed with error code: %d\n", result);
+        return 1;
+    }
+
+    printf("Polyline and path test passed successfully.\n");
+    return 0;
+}
+
+int test_plot(){
+    int result = Kitty_Init("Kitty Engine Plot Test", 800, 600);
+    if (result != KITTY_SUCCESS){
+        printf("Kitty_Init failed with error code: %d\n", result);
+        return 1;
+    }
+
+    Kitty_Object* plot = Kitty_CreatePlot((Kitty_Point){0, 100}, 800, 400, -1.0f, 1.0f, 10000);
+    if (!plot){
+        printf("Kitty_CreatePlot failed.\n");
+        Kitty_Quit();
+        return 1;
+    }
+    for (int i = 0; i < 20; i++){
+        if ((result = Kitty_AddPlotSeries(plot, 10000, (Kitty_Color){rand() % 256, rand() % 256, rand() % 256, 255}))){
+            printf("Kitty_AddPlotSeries failed with error code: %d\n", result);
+            Kitty_Quit();
+            return 1;
+        }
+    }
+    if (Kitty_PlotAppend(plot, 20, 0.0f) != KITTY_INVALID_ARGUMENT){
+        printf("Kitty_PlotAppend accepted an unknown series.\n");
+        Kitty_Quit();
+        return 1;
+    }
+    if ((result = Kitty_AddObject(*plot))) {
+        printf("Kitty_AddObject (plot) failed with error code: %d\n", result);
+        Kitty_Quit();
+        return 1;
+    }
+
+    for (int frame = 0; frame < 50; frame++){
+        for (size_t s = 0; s < 20; s++){
+            for (int i = 0; i < 500; i++){
+                Kitty_PlotAppend(plot, s, sinf((frame * 500 + i) * 0.001f * (s + 1)));
+            }
+        }
+        Kitty_ClearScreen((Kitty_Color){0, 0, 0, 255});
+        if ((result = Kitty_RenderObjects())){
+            printf("Kitty_RenderObjects (plot) failed with error code: %d\n", result);
+            Kitty_Quit();
+            return 1;
+        }
+        Kitty_FlipBuffers();
+    }
+
+    free(plot);
+    if ((result = Kitty_Quit())) {
+        printf("Kitty_Quit failed with error code: %d\n", result);
+        return 1;
+    }
+
+    printf("Plot test passed successfully.\n");
+    return 0;
+}
+
+int test_point_cloud(){
+    int result = Kitty_Init("Kitty Engine Point Cloud Test", 800, 600);
+    if (result != KITTY_SUCCESS){
+        printf("Kitty_Init failed with error code: %d\n", result);
+        return 1;
+    }
+
+    size_t count = 200000;
+    Kitty_Vertex3D* positions = malloc(count * sizeof(Kitty_Vertex3D));
+    Kitty_Color* colors = malloc(count * sizeof(Kitty_Color));
+    for (size_t i = 0; i < count; i++){
+        positions[i] = (Kitty_Vertex3D){(rand() % 4000 - 2000) / 10.0f, (rand() % 4000 - 2000) / 10.0f, (rand() % 4000) / 10.0f};
+        colors[i] = (Kitty_Color){rand() % 256, rand() % 256, rand() % 256, 255};
+    }
+    Kitty_Object* cloud = Kitty_CreatePointCloud(positions, colors, count, false);
+    Kitty_Object* quantized = Kitty_CreatePointCloud(positions, NULL, count, true);
+    free(positions);
+    free(colors);
+    if (!cloud || !quantized){
+        printf("Kitty_CreatePointCloud failed.\n");
+        Kitty_Quit();
+        return 1;
+    }
+
+    Kitty_ObjPointCloud* cloud_data = (Kitty_ObjPointCloud*)cloud->data;
+    Kitty_ObjPointCloud* quantized_data = (Kitty_ObjPointCloud*)quantized->data;
+    cloud_data->position = (Kitty_Point3D){400, 300, 0};
+    quantized_data->position = (Kitty_Point3D){200, 300, 0};
+    quantized_data->splat_size = 1;
+    if ((result = Kitty_AddObject(*cloud)) || (result = Kitty_AddObject(*quantized))) {
+        printf("Kitty_AddObject (point cloud) failed with error code: %d\n", result);
+        Kitty_Quit();
+        return 1;
+    }
+
+    for (int i = 0; i < 5; i++){
+        Kitty_ClearScreen((Kitty_Color){0, 0, 0, 255});
+        if ((result = Kitty_RenderObjects())){
+            printf("Kitty_RenderObjects (point cloud) failed with error code: %d\n", result);
+            Kitty_Quit();
+            return 1;
+        }
+        Kitty_FlipBuffers();
+        if (cloud_data->points_drawn == 0 || cloud_data->points_drawn > count){
+            printf("Point cloud drew %zu points.\n", cloud_data->points_drawn);
+            Kitty_Quit();
+            return 1;
+        }
+        cloud_data->position.z -= 50; // move away, LOD thins the cloud out
+    }
+
+    // building leaves the application's rand() sequence alone, and points far off screen are skipped
+    Kitty_Vertex3D far_points[64];
+    for (int i = 0; i < 64; i++){
+        far_points[i] = (Kitty_Vertex3D){i * 1e9f, -i * 1e9f, i * 0.01f};
+    }
+    srand(42);
+    int expected = rand();
+    srand(42);
+    Kitty_Object* far = Kitty_CreatePointCloud(far_points, NULL, 64, false);
+    if (!far || rand() != expected){
+        printf("Building a point cloud changed the rand() sequence.\n");
+        Kitty_Quit();
+        return 1;
+    }
+    Kitty_AddObject(*far);
+    free(far);
+    if ((result = Kitty_RenderObjects())){
+        printf("Kitty_RenderObjects (far points) failed with error code: %d\n", result);
+        Kitty_Quit();
+        return 1;
+    }
+    Kitty_FlipBuffers();
+
+    free(cloud);
+    free(quantized);
+    if ((result = Kitty_Quit())) {
+        printf("Kitty_Quit failed with error code: %d\n", result);
+        return 1;
+    }
+
+    printf("Point cloud test passed successfully.\n");
+    return 0;
+}
+
+int test_skinning(){
+    int result = Kitty_Init("Kitty Engine Skinning Test", 800, 600);
+    if (result != KITTY_SUCCESS){
+        printf("Kitty_Init failed with error code: %d\n", result);
+        return 1;
+    }
+
+    // a strip of quads along x, the second half bound to a child joint at x = 10
+    Kitty_Object* mesh = Kitty_CreateMesh();
+    size_t columns = 21;
+    Kitty_JointWeights* weights = malloc(columns * 2 * sizeof(Kitty_JointWeights));
+    for (size_t i = 0; i < columns; i++){
+        for (int row = 0; row < 2; row++){
+            Kitty_AddVertexToObjMesh(mesh, (Kitty_Vertex3D){(float)i, (float)row, 0});
+            weights[i * 2 + row] = (Kitty_JointWeights){{i < 10 ? 0 : 1, 0, 0, 0}, {1, 0, 0, 0}};
+        }
+        if (i > 0){
+            Kitty_AddFaceToObjMesh(mesh, (Kitty_Face){(i - 1) * 2, i * 2, i * 2 + 1, 0, 0, 0}, (Kitty_Color){255, 0, 0, 255});
+        }
+    }
+    Kitty_AddUVToObjMesh(mesh, (Kitty_UV){0, 0});
+    int parents[2] = {-1, 0};
+    Kitty_Matrix4 inverse_bind[2] = {KittyM_MatrixIdentity(), KittyM_MatrixCompose((Kitty_Vertex3D){-10, 0, 0}, (Kitty_Quaternion){0, 0, 0, 1}, (Kitty_Vertex3D){1, 1, 1})};
+    Kitty_Skeleton* skeleton = Kitty_CreateSkeleton(2, parents, inverse_bind);
+    Kitty_AnimationClip* clip = Kitty_CreateAnimationClip(2, 1.0f);
+    if (!skeleton || !clip || (result = Kitty_SetMeshSkin(mesh, skeleton, weights))){
+        printf("Skeleton setup failed with error code: %d\n", result);
+        Kitty_Quit();
+        return 1;
+    }
+    free(weights);
+
+    // child joint sits at x = 10 and bends 90 degrees around z over one second
+    Kitty_Vertex3D one = {1, 1, 1};
+    Kitty_Quaternion rest = {0, 0, 0, 1};
+    Kitty_Quaternion bent = KittyM_QuaternionAxisAngle((Kitty_Vertex3D){0, 0, 1}, 90);
+    Kitty_AddJointKeyframe(clip, 0, (Kitty_JointKeyframe){0, {0, 0, 0}, rest, one});
+    Kitty_AddJointKeyframe(clip, 1, (Kitty_JointKeyframe){0, {10, 0, 0}, rest, one});
+    Kitty_AddJointKeyframe(clip, 1, (Kitty_JointKeyframe){1, {10, 0, 0}, bent, one});
+    if (Kitty_AddJointKeyframe(clip, 1, (Kitty_JointKeyframe){0.5f, {10, 0, 0}, rest, one}) != KITTY_INVALID_ARGUMENT){
+        printf("Out of order keyframe was accepted.\n");
+        Kitty_Quit();
+        return 1;
+    }
+
+    Kitty_ObjMesh* mesh_data = (Kitty_ObjMesh*)mesh->data;
+    mesh_data->position = (Kitty_Point3D){400, 300, 0};
+    mesh_data->scale = 10;
+    mesh_data->wrap = false; // flat shaded, no texture
+    if ((result = Kitty_AddObject(*mesh))){
+        printf("Kitty_AddObject (skinned mesh) failed with error code: %d\n", result);
+        Kitty_Quit();
+        return 1;
+    }
+
+    for (int i = 0; i <= 4; i++){
+        Kitty_PoseMesh(mesh, clip, i * 0.25f, false);
+        Kitty_ClearScreen((Kitty_Color){0, 0, 0, 255});
+        if ((result = Kitty_RenderObjects())){
+            printf("Kitty_RenderObjects (skinned mesh) failed with error code: %d\n", result);
+            Kitty_Quit();
+            return 1;
+        }
+        Kitty_FlipBuffers();
+    }
+
+    // fully bent: the tip (20, 0) swings around the joint to (10, 10), the root stays put
+    Kitty_Vertex3D tip = mesh_data->skin->skinned_vertices[(columns - 1) * 2];
+    Kitty_Vertex3D root = mesh_data->skin->skinned_vertices[1];
+    if (fabsf(tip.x - 10) > 0.001f || fabsf(tip.y - 10) > 0.001f || root.x != 0 || root.y != 1){
+        printf("Skinned vertices are wrong: tip (%f, %f), root (%f, %f).\n", tip.x, tip.y, root.x, root.y);
+        Kitty_Quit();
+        return 1;
+    }
+
+    // the weights cover the bound vertices only: adding one needs an unbind and a rebind with one weight more
+    Kitty_Vertex3D extra = {20, 2, 0};
+    if (Kitty_AddVertexToObjMesh(mesh, extra) != KITTY_INVALID_ARGUMENT || mesh_data->vertex_count != columns * 2){
+        printf("A vertex was added to a skinned mesh.\n");
+        Kitty_Quit();
+        return 1;
+    }
+    Kitty_JointWeights* rebound = malloc((columns * 2 + 1) * sizeof(Kitty_JointWeights));
+    for (size_t i = 0; i <= columns * 2; i++){
+        rebound[i] = (Kitty_JointWeights){{1, 0, 0, 0}, {1, 0, 0, 0}};
+    }
+    if (Kitty_SetMeshSkin(mesh, NULL, NULL) || Kitty_AddVertexToObjMesh(mesh, extra) ||
+        Kitty_SetMeshSkin(mesh, skeleton, rebound) || Kitty_PoseMesh(mesh, clip, 1.0f, false) || Kitty_RenderObjects()){
+        printf("Rebinding a skin after adding a vertex failed.\n");
+        free(rebound);
+        Kitty_Quit();
+        return 1;
+    }
+    free(rebound);
+    Kitty_FlipBuffers();
+    Kitty_Vertex3D added = mesh_data->skin->skinned_vertices[columns * 2];
+    if (fabsf(added.x - 8) > 0.001f || fabsf(added.y - 10) > 0.001f){
+        printf("The added vertex was skinned to (%f, %f).\n", added.x, added.y);
+        Kitty_Quit();
+        return 1;
+    }
+
+    // 200 meshes of 5000 vertices, two influences each; faceless so the frame is the skinning stage
+    Kitty_ClearObjects();
+    size_t crowd_vertices = 5000;
+    Kitty_JointWeights* crowd_weights = malloc(crowd_vertices * sizeof(Kitty_JointWeights));
+    for (size_t i = 0; i < crowd_vertices; i++){
+        float blend = (float)(i % 100) / 99.0f;
+        crowd_weights[i] = (Kitty_JointWeights){{0, 1, 0, 0}, {1.0f - blend, blend, 0, 0}};
+    }
+    for (int m = 0; m < 200; m++){
+        Kitty_Object* member = Kitty_CreateMesh();
+        for (size_t i = 0; i < crowd_vertices; i++){
+            Kitty_AddVertexToObjMesh(member, (Kitty_Vertex3D){(float)(i % 100) * 0.2f, (float)(i / 100), 0});
+        }
+        if ((result = Kitty_SetMeshSkin(member, skeleton, crowd_weights)) || (result = Kitty_AddObject(*member))){
+            printf("Skinned crowd setup failed with error code: %d\n", result);
+            Kitty_Quit();
+            return 1;
+        }
+        free(member);
+    }
+    free(crowd_weights);
+    double crowd_ms = 0.0;
+    for (int frame = 0; frame < 5; frame++){
+        for (size_t m = 0; m < 200; m++){
+            Kitty_Object member;
+            Kitty_GetObject(m, &member);
+            Kitty_PoseMesh(&member, clip, frame * 0.2f, false);
+        }
+        Kitty_RenderObjects();
+        Kitty_FlipBuffers();
+        crowd_ms += Kitty_GetFrameStats().vertex_stage_ms / 5.0;
+    }
+    printf("Skinning 200 meshes of 5000 vertices: %.3f ms per frame.\n", crowd_ms);
+
+    free(mesh);
+    if ((result = Kitty_Quit())) {
+        printf("Kitty_Quit failed with error code: %d\n", result);
+        return 1;
+    }
+    Kitty_FreeAnimationClip(clip);
+    Kitty_FreeSkeleton(skeleton);
+
+    printf("Skinning test passed successfully.\n");
+    return 0;
+}
+
+int test_morph_targets(){
+    int result = Kitty_Init("Kitty Engine Morph Target Test", 800, 600);
+    if (result != KITTY_SUCCESS){
+        printf("Kitty_Init failed with error code: %d\n", result);
+        return 1;
+    }
+
+    // base quad plus a two keyframe OBJ sequence that lifts one corner
+    const char* keyframes[3] = {
+        "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nvt 0 0\nf 1/1/1 2/1/1 3/1/1\nf 1/1/1 3/1/1 4/1/1\n",
+        "v 0 0 0\nv 1 0 0\nv 1 1 2\nv 0 1 0\n",
+        "v 0 0 0\nv 1 0 0\nv 1 1 4\nv 0 1 0\n"
+    };
+    FILE* files[3];
+    for (int i = 0; i < 3; i++){
+        files[i] = tmpfile();
+        fputs(keyframes[i], files[i]);
+        rewind(files[i]);
+    }
+    Kitty_Object* mesh = Kitty_CreateMesh();
+    Kitty_LoadDotObj(files[0], mesh);
+    result = Kitty_LoadDotObjSequence(&files[1], 2, mesh);
+    for (int i = 0; i < 3; i++){
+        fclose(files[i]);
+    }
+    Kitty_ObjMesh* mesh_data = (Kitty_ObjMesh*)mesh->data;
+    if (result || mesh_data->morph->target_count != 2 || mesh_data->morph->targets[0].count != 1){
+        printf("Kitty_LoadDotObjSequence failed with error code: %d\n", result);
+        Kitty_Quit();
+        return 1;
+    }
+
+    mesh_data->position = (Kitty_Point3D){400, 300, 0};
+    mesh_data->scale = 50;
+    mesh_data->wrap = false; // flat shaded, no texture
+    if ((result = Kitty_AddObject(*mesh))){
+        printf("Kitty_AddObject (morph mesh) failed with error code: %d\n", result);
+        Kitty_Quit();
+        return 1;
+    }
+
+    float frames[3] = {0.5f, 1.0f, 0.25f};
+    float expected[3] = {3.0f, 4.0f, 2.5f};
+    for (int i = 0; i < 3; i++){
+        Kitty_SetMorphKeyframe(mesh, 0, 2, frames[i]);
+        Kitty_ClearScreen((Kitty_Color){0, 0, 0, 255});
+        if ((result = Kitty_RenderObjects())){
+            printf("Kitty_RenderObjects (morph mesh) failed with error code: %d\n", result);
+            Kitty_Quit();
+            return 1;
+        }
+        Kitty_FlipBuffers();
+        float z = mesh_data->morph->morphed_vertices[2].z;
+        if (fabsf(z - expected[i]) > 0.0001f || mesh_data->vertices[2].z != 0){
+            printf("Morphed vertex z is %f, expected %f.\n", z, expected[i]);
+            Kitty_Quit();
+            return 1;
+        }
+    }
+
+    free(mesh);
+    if ((result = Kitty_Quit())) {
+        printf("Kitty_Quit failed with error code: %d\n", result);
+        return 1;
+    }
+
+    printf("Morph target test passed successfully.\n");
+    return 0;
+}
+
+int test_impostors(){
+    int result = Kitty_Init("Kitty Engine Impostor Test", 800, 600);
+    if (result != KITTY_SUCCESS){
+        printf("Kitty_Init failed with error code: %d\n", result);
+        return 1;
+    }
+
+    // a field of small background props, more than one atlas page holds, and one big prop up front
+    size_t prop_count = 300;
+    Kitty_Object* props[301];
+    for (size_t i = 0; i <= prop_count; i++){
+        props[i] = Kitty_CreateMesh();
+        Kitty_AddVertexToObjMesh(props[i], (Kitty_Vertex3D){-1, -1, 0});
+        Kitty_AddVertexToObjMesh(props[i], (Kitty_Vertex3D){1, -1, 0});
+        Kitty_AddVertexToObjMesh(props[i], (Kitty_Vertex3D){0, 1, 0});
+        Kitty_AddUVToObjMesh(props[i], (Kitty_UV){0, 0});
+        Kitty_AddFaceToObjMesh(props[i], (Kitty_Face){0, 2, 1, 0, 0, 0}, (Kitty_Color){0, 255, 0, 255});
+        Kitty_ObjMesh* prop = (Kitty_ObjMesh*)props[i]->data;
+        prop->wrap = false; // flat shaded, no texture
+        prop->position = (Kitty_Point3D){(i % 20) * 40 + 20, (i / 20) * 38 + 20, 0};
+        prop->scale = i == prop_count ? 100 : 3;
+        if ((result = Kitty_SetMeshImpostor(props[i], 16)) || (result = Kitty_AddObject(*props[i]))){
+            printf("Impostor setup failed with error code: %d\n", result);
+            Kitty_Quit();
+            return 1;
+        }
+    }
+
+    for (int frame = 0; frame < 4; frame++){
+        if (frame == 2){
+            Kitty_SetCameraPosition((Kitty_Vertex3D){5000, 0, 0}); // new view angle bucket
+        }
+        Kitty_ClearScreen((Kitty_Color){0, 0, 0, 255});
+        if ((result = Kitty_RenderObjects())){
+            printf("Kitty_RenderObjects (impostors) failed with error code: %d\n", result);
+            Kitty_Quit();
+            return 1;
+        }
+        Kitty_FlipBuffers();
+    }
+
+    for (size_t i = 0; i <= prop_count; i++){
+        Kitty_Impostor* impostor = ((Kitty_ObjMesh*)props[i]->data)->impostor;
+        bool background = i < prop_count;
+        // background props snapshot once per view angle bucket, the big one is drawn face by face
+        if (impostor->active != background || impostor->refresh_count != (background ? 2u : 0u)){
+            printf("Prop %zu: active %d, refreshed %zu times.\n", i, impostor->active, impostor->refresh_count);
+            Kitty_Quit();
+            return 1;
+        }
+    }
+
+    // a prop brought up close gives its cell back
+    Kitty_ObjMesh* near_prop = (Kitty_ObjMesh*)props[0]->data;
+    near_prop->scale = 100;
+    Kitty_RenderObjects();
+    Kitty_FlipBuffers();
+    if (near_prop->impostor->active || near_prop->impostor->cell != -1){
+        printf("A prop drawn face by face kept its impostor cell.\n");
+        Kitty_Quit();
+        return 1;
+    }
+    for (size_t i = 0; i <= prop_count; i++){
+        free(props[i]);
+    }
+
+    // more props than the atlas has cells: the rest draw their faces and say so, until cells are given back
+    Kitty_ClearObjects();
+    size_t crowd = 4100;
+    Kitty_Object* first = NULL;
+    for (size_t i = 0; i < crowd; i++){
+        Kitty_Object* prop = Kitty_CreateMesh();
+        Kitty_AddVertexToObjMesh(prop, (Kitty_Vertex3D){-1, -1, 0});
+        Kitty_AddVertexToObjMesh(prop, (Kitty_Vertex3D){1, -1, 0});
+        Kitty_AddVertexToObjMesh(prop, (Kitty_Vertex3D){0, 1, 0});
+        Kitty_AddUVToObjMesh(prop, (Kitty_UV){0, 0});
+        Kitty_AddFaceToObjMesh(prop, (Kitty_Face){0, 2, 1, 0, 0, 0}, (Kitty_Color){0, 255, 0, 255});
+        Kitty_ObjMesh* mesh = (Kitty_ObjMesh*)prop->data;
+        mesh->wrap = false;
+        mesh->position = (Kitty_Point3D){(i % 80) * 10, (i / 80) * 10, 0};
+        mesh->scale = 2;
+        Kitty_SetMeshImpostor(prop, 16);
+        Kitty_AddObject(*prop);
+        if (i == 0){
+            first = prop;
+        } else {
+            free(prop);
+        }
+    }
+    Kitty_RenderObjects();
+    Kitty_FlipBuffers();
+    size_t over = Kitty_GetFrameStats().impostors_over_capacity;
+    for (size_t i = 0; i < 4; i++){
+        Kitty_Object prop;
+        Kitty_GetObject(i, &prop);
+        ((Kitty_ObjMesh*)prop.data)->scale = 100;
+    }
+    Kitty_RenderObjects();
+    Kitty_FlipBuffers();
+    if (over != crowd - 4096 || Kitty_GetFrameStats().impostors_over_capacity != 0 || ((Kitty_ObjMesh*)first->data)->impostor->cell != -1){
+        printf("Impostor atlas: %zu meshes over capacity, then %zu.\n", over, Kitty_GetFrameStats().impostors_over_capacity);
+        Kitty_Quit();
+        return 1;
+    }
+    free(first);
+    Kitty_SetCameraPosition((Kitty_Vertex3D){10, 0, 0}); // back to the default for later tests
+    if ((result = Kitty_Quit())) {
+        printf("Kitty_Quit failed with error code: %d\n", result);
+        return 1;
+    }
+
+    printf("Impostor test passed successfully.\n");
+    return 0;
+}
+
+int test_dynamic_resolution(){
+    int result = Kitty_Init("Kitty Engine Dynamic Resolution Test", 800, 600);
+    if (result != KITTY_SUCCESS){
+        printf("Kitty_Init failed with error code: %d\n", result);
+        return 1;
+    }
+
+    size_t count = 100000;
+    Kitty_Vertex3D* positions = malloc(count * sizeof(Kitty_Vertex3D));
+    for (size_t i = 0; i < count; i++){
+        positions[i] = (Kitty_Vertex3D){(rand() % 4000 - 2000) / 10.0f, (rand() % 4000 - 2000) / 10.0f, (rand() % 1000) / 10.0f};
+    }
+    Kitty_Object* cloud = Kitty_CreatePointCloud(positions, NULL, count, false);
+    free(positions);
+    ((Kitty_ObjPointCloud*)cloud->data)->position = (Kitty_Point3D){400, 300, 0};
+    Kitty_AddObject(*cloud);
+
+    Kitty_DynamicResolution defaults = Kitty_GetDynamicResolution();
+    Kitty_DynamicResolution settings = defaults;
+    settings.max_scale = 2.0f;
+    if (Kitty_SetDynamicResolution(settings) != KITTY_INVALID_ARGUMENT){
+        printf("Scale above 1 was accepted.\n");
+        Kitty_Quit();
+        return 1;
+    }
+
+    // a budget no frame can meet walks the scale down to the minimum
+    settings = defaults;
+    settings.enabled = true;
+    settings.budget_ms = 0.001f;
+    settings.smoothing = 0.5f;
+    Kitty_SetDynamicResolution(settings);
+    for (int i = 0; i < 20; i++){
+        Kitty_ClearScreen((Kitty_Color){0, 0, 0, 255});
+        if ((result = Kitty_RenderObjects())){
+            printf("Kitty_RenderObjects (dynamic resolution) failed with error code: %d\n", result);
+            Kitty_Quit();
+            return 1;
+        }
+        Kitty_FlipBuffers();
+    }
+    if (Kitty_GetResolutionScale() != settings.min_scale || Kitty_GetRasterTime() <= 0.0){
+        printf("Resolution scale is %f after overrunning the budget.\n", Kitty_GetResolutionScale());
+        Kitty_Quit();
+        return 1;
+    }
+
+    Kitty_SetDynamicResolution(defaults);
+    Kitty_SetResolutionScale(1.0f);
+    free(cloud);
+    if ((result = Kitty_Quit())) {
+        printf("Kitty_Quit failed with error code: %d\n", result);
+        return 1;
+    }
+
+    printf("Dynamic resolution test passed successfully.\n");
+    return 0;
+}
+
+int test_frame_governor(){
+    int result = Kitty_Init("Kitty Engine Frame Governor Test", 800, 600);
+    if (result != KITTY_SUCCESS){
+        printf("Kitty_Init failed with error code: %d\n", result);
+        return 1;
+    }
+
+    // a textured mesh, a low priority label and a low priority point cloud
+    Kitty_Texture texture = { .sdl_surface = SDL_CreateRGBSurfaceWithFormat(0, 16, 16, 32, SDL_PIXELFORMAT_RGBA32) };
+    Kitty_Object* mesh = Kitty_CreateMesh();
+    Kitty_AddVertexToObjMesh(mesh, (Kitty_Vertex3D){-1, -1, 0});
+    Kitty_AddVertexToObjMesh(mesh, (Kitty_Vertex3D){1, -1, 0});
+    Kitty_AddVertexToObjMesh(mesh, (Kitty_Vertex3D){0, 1, 0});
+    Kitty_AddUVToObjMesh(mesh, (Kitty_UV){0, 0});
+    Kitty_AddUVToObjMesh(mesh, (Kitty_UV){1, 0});
+    Kitty_AddUVToObjMesh(mesh, (Kitty_UV){0, 1});
+    Kitty_AddFaceToObjMesh(mesh, (Kitty_Face){0, 2, 1, 0, 2, 1}, (Kitty_Color){0, 0, 255, 255});
+    ((Kitty_ObjMesh*)mesh->data)->texture = &texture;
+    ((Kitty_ObjMesh*)mesh->data)->position = (Kitty_Point3D){400, 300, 0};
+    ((Kitty_ObjMesh*)mesh->data)->scale = 50;
+    Kitty_Object* label = Kitty_CreateText((Kitty_Point){10, 10}, 0, 24, (Kitty_Color){255, 255, 255, 255}, "fps");
+    label->priority = KITTY_PRIORITY_LOW;
+    Kitty_Vertex3D points[64];
+    for (int i = 0; i < 64; i++){
+        points[i] = (Kitty_Vertex3D){(float)(i % 8), (float)(i / 8), 10};
+    }
+    Kitty_Object* cloud = Kitty_CreatePointCloud(points, NULL, 64, false);
+    Kitty_AddObject(*mesh);
+    Kitty_AddObject(*label);
+    Kitty_AddObject(*cloud);
+    Kitty_Object stored_cloud;
+    if (Kitty_SetObjectPriority(2, KITTY_PRIORITY_HIGH) || Kitty_SetObjectPriority(3, KITTY_PRIORITY_LOW) != KITTY_INVALID_OBJECT_INDEX ||
+        Kitty_SetObjectID(2, 77) || Kitty_SetObjectPriorityByID(77, KITTY_PRIORITY_LOW) ||
+        Kitty_SetObjectPriorityByID(78, KITTY_PRIORITY_LOW) != KITTY_OBJECT_NOT_FOUND ||
+        Kitty_GetObject(2, &stored_cloud) || stored_cloud.priority != KITTY_PRIORITY_LOW){
+        printf("Kitty_SetObjectPriority failed.\n");
+        Kitty_Quit();
+        return 1;
+    }
+
+    // an impossible budget drops a level after every two frames
+    Kitty_FrameGovernor defaults = Kitty_GetFrameGovernor();
+    Kitty_FrameGovernor governor = defaults;
+    governor.enabled = true;
+    governor.budget_ms = 0.00001f;
+    governor.degrade_after = 2;
+    Kitty_SetFrameGovernor(governor);
+    int expected_levels[8] = {0, 0, 1, 1, 2, 2, 3, 3};
+    for (int frame = 0; frame < 8; frame++){
+        Kitty_FrameStats stats = Kitty_GetFrameStats();
+        if (stats.quality_level != expected_levels[frame]){
+            printf("Frame %d ran at quality level %d.\n", frame, stats.quality_level);
+            Kitty_Quit();
+            return 1;
+        }
+        if ((result = Kitty_RenderObjects())){
+            printf("Kitty_RenderObjects (governor) failed with error code: %d\n", result);
+            Kitty_Quit();
+            return 1;
+        }
+        stats = Kitty_GetFrameStats();
+        int level = expected_levels[frame];
+        if (stats.meshes_flattened != (level >= 2) || stats.texts_skipped != (level >= 2) ||
+            stats.texts_cached != (level == 1 && frame == 3) || stats.lods_dropped != (level >= 1)){
+            printf("Frame %d at level %d: flattened %zu, skipped %zu, cached %zu, lods %zu.\n", frame, level,
+                   stats.meshes_flattened, stats.texts_skipped, stats.texts_cached, stats.lods_dropped);
+            Kitty_Quit();
+            return 1;
+        }
+    }
+
+    // with plenty of headroom quality comes back one level per restore_after frames
+    governor.budget_ms = 100000.0f;
+    governor.restore_after = 1;
+    Kitty_SetFrameGovernor(governor);
+    for (int frame = 0; frame < 3; frame++){
+        Kitty_RenderObjects();
+    }
+    if (Kitty_GetFrameStats().quality_level != 0 || Kitty_GetFrameStats().level_changes != 6){
+        printf("Quality level %d after restoring.\n", Kitty_GetFrameStats().quality_level);
+        Kitty_Quit();
+        return 1;
+    }
+    Kitty_SetFrameGovernor(defaults);
+
+    free(mesh);
+    free(label);
+    free(cloud);
+    if ((result = Kitty_Quit())) {
+        printf("Kitty_Quit failed with error code: %d\n", result);
+        return 1;
+    }
+    SDL_FreeSurface(texture.sdl_surface);
+
+    printf("Frame governor test passed successfully.\n");
+    return 0;
+}
+
+int test_render_backends(){
+    int result = Kitty_Init("Kitty Engine Render Backend Test", 800, 600);
+    if (result != KITTY_SUCCESS){
+        printf("Kitty_Init failed with error code: %d\n", result);
+        return 1;
+    }
+
+    Kitty_Object* rectangle = Kitty_CreateRectangle((Kitty_Point){100, 100}, 200, 150, true, (Kitty_Color){0, 255, 0, 255});
+    Kitty_Object* line = Kitty_CreateLine((Kitty_Point){0, 50}, (Kitty_Point){799, 50}, (Kitty_Color){255, 0, 0, 255});
+    Kitty_AddObject(*rectangle);
+    Kitty_AddObject(*line);
+
+    // the software backend rasterizes on the CPU and reads its own pixels back
+    Kitty_SetRenderBackend(KITTY_BACKEND_SOFTWARE);
+    Uint32* pixels = malloc(800 * 600 * sizeof(Uint32));
+    Kitty_ClearScreen((Kitty_Color){0, 0, 0, 255});
+    if ((result = Kitty_RenderObjects()) || (result = Kitty_ReadPixels(pixels, 800 * sizeof(Uint32)))){
+        printf("Software backend frame failed with error code: %d\n", result);
+        free(pixels);
+        Kitty_Quit();
+        return 1;
+    }
+    Kitty_FlipBuffers();
+    if (pixels[150 * 800 + 150] != 0xFF00FF00u || pixels[50 * 800 + 400] != 0xFFFF0000u || pixels[10 * 800 + 10] == 0xFF00FF00u){
+        printf("Software backend read back %08X %08X.\n", (unsigned)pixels[150 * 800 + 150], (unsigned)pixels[50 * 800 + 400]);
+        free(pixels);
+        Kitty_Quit();
+        return 1;
+    }
+
+    // a text drawn after the rectangle is copied through SDL; the rectangle must go to SDL first
+    // instead of staying in the buffer that covers the copy
+    Kitty_Object* label = Kitty_CreateText((Kitty_Point){120, 120}, 0, 24, (Kitty_Color){255, 255, 255, 255}, "over");
+    Kitty_AddObject(*label);
+    free(label);
+    Kitty_ClearScreen((Kitty_Color){0, 0, 0, 255});
+    Kitty_RenderObjects();
+    Kitty_ReadPixels(pixels, 800 * sizeof(Uint32));
+    Kitty_FlipBuffers();
+    if (pixels[150 * 800 + 150] == 0xFF00FF00u){
+        printf("Software backend drew its buffer over a later texture copy.\n");
+        free(pixels);
+        Kitty_Quit();
+        return 1;
+    }
+    free(pixels);
+
+    // the null backend measures the engine without any drawing
+    if (Kitty_SetRenderBackend(KITTY_BACKEND_NULL) || strcmp(Kitty_GetRenderBackend()->name, "null") != 0){
+        printf("Switching to the null backend failed.\n");
+        Kitty_Quit();
+        return 1;
+    }
+    clock_t begin = clock();
+    for (int i = 0; i < 1000; i++){
+        Kitty_ClearScreen((Kitty_Color){0, 0, 0, 255});
+        if ((result = Kitty_RenderObjects())){
+            printf("Kitty_RenderObjects (null backend) failed with error code: %d\n", result);
+            Kitty_Quit();
+            return 1;
+        }
+        Kitty_FlipBuffers();
+    }
+    double seconds = (double)(clock() - begin) / CLOCKS_PER_SEC;
+    printf("Null backend: 1000 frames in %.3f s (%.0f fps).\n", seconds, seconds > 0 ? 1000.0 / seconds : 0.0);
+
+    Kitty_RenderBackend incomplete = *Kitty_GetRenderBackend();
+    incomplete.present = NULL;
+    if (Kitty_SetCustomRenderBackend(&incomplete) != KITTY_INVALID_ARGUMENT){
+        printf("A backend without present was accepted.\n");
+        Kitty_Quit();
+        return 1;
+    }
+
+    free(rectangle);
+    free(line);
+    if ((result = Kitty_Quit())) {
+        printf("Kitty_Quit failed with error code: %d\n", result);
+        return 1;
+    }
+
+    printf("Render backend test passed successfully.\n");
+    return 0;
+}
+
+int test_frames_in_flight(){
+    int result = Kitty_Init("Kitty Engine Frames In Flight Test", 800, 600);
+    if (result != KITTY_SUCCESS){
+        printf("Kitty_Init failed with error code: %d\n", result);
+        return 1;
+    }
+
+    Kitty_Vertex3D point = {0.0f, 0.0f, 0.0f};
+    Kitty_Color red = {255, 0, 0, 255};
+    Kitty_Object* cloud = Kitty_CreatePointCloud(&point, &red, 1, false);
+    Kitty_ObjPointCloud* pc = (Kitty_ObjPointCloud*)cloud->data;
+    pc->position = (Kitty_Point3D){100, 100, 0};
+    pc->splat_size = 8;
+    Kitty_AddObject(*cloud);
+
+    if (Kitty_SetFramesInFlight(KITTY_MAX_FRAMES_IN_FLIGHT + 1) != KITTY_INVALID_ARGUMENT){
+        printf("Too many frames in flight were accepted.\n");
+        Kitty_Quit();
+        return 1;
+    }
+
+    // with two frames in flight the point cloud is still shown in the frame that drew it
+    Kitty_SetRenderBackend(KITTY_BACKEND_SOFTWARE);
+    Kitty_SetFramesInFlight(2);
+    Uint32* pixels = malloc(800 * 600 * sizeof(Uint32));
+    Uint32 expected[3][2] = {{0xFFFF0000u, 0}, {0, 0xFFFF0000u}, {0, 0xFFFF0000u}};
+    for (int frame = 0; frame < 3; frame++){
+        Kitty_ClearScreen((Kitty_Color){0, 0, 0, 255});
+        if ((result = Kitty_RenderObjects()) || (result = Kitty_ReadPixels(pixels, 800 * sizeof(Uint32)))){
+            printf("Frame %d in flight failed with error code: %d\n", frame, result);
+            free(pixels);
+            Kitty_Quit();
+            return 1;
+        }
+        Kitty_FlipBuffers();
+        if ((pixels[100 * 800 + 100] == 0xFFFF0000u) != (expected[frame][0] != 0) ||
+            (pixels[300 * 800 + 300] == 0xFFFF0000u) != (expected[frame][1] != 0)){
+            printf("Frame %d presented the wrong frame (%08X, %08X).\n", frame, (unsigned)pixels[100 * 800 + 100], (unsigned)pixels[300 * 800 + 300]);
+            free(pixels);
+            Kitty_Quit();
+            return 1;
+        }
+        pc->position = (Kitty_Point3D){300, 300, 0};
+    }
+    free(pixels);
+
+    Kitty_SetFramesInFlight(KITTY_MAX_FRAMES_IN_FLIGHT);
+    for (int frame = 0; frame < 100; frame++){
+        pc->position = (Kitty_Point3D){rand() % 800, rand() % 600, 0};
+        Kitty_ClearScreen((Kitty_Color){0, 0, 0, 255});
+        if ((result = Kitty_RenderObjects())){
+            printf("Kitty_RenderObjects (frames in flight) failed with error code: %d\n", result);
+            Kitty_Quit();
+            return 1;
+        }
+        Kitty_FlipBuffers();
+    }
+
+    Kitty_SetFramesInFlight(1);
+    free(cloud);
+    if ((result = Kitty_Quit())) {
+        printf("Kitty_Quit failed with error code: %d\n", result);
+        return 1;
+    }
+
+    printf("Frames in flight test passed successfully.\n");
+    return 0;
+}
+
+int test_post_processing(){
+    int result = Kitty_Init("Kitty Engine Post Processing Test", 800, 600);
+    if (result != KITTY_SUCCESS){
+        printf("Kitty_Init failed with error code: %d\n", result);
+        return 1;
+    }
+
+    // an 8x8 white splat covering [96, 104) on both axes
+    Kitty_Vertex3D point = {0.0f, 0.0f, 0.0f};
+    Kitty_Color white = {255, 255, 255, 255};
+    Kitty_Object* cloud = Kitty_CreatePointCloud(&point, &white, 1, false);
+    Kitty_ObjPointCloud* pc = (Kitty_ObjPointCloud*)cloud->data;
+    pc->position = (Kitty_Point3D){100, 100, 0};
+    pc->splat_size = 8;
+    Kitty_AddObject(*cloud);
+    Kitty_SetRenderBackend(KITTY_BACKEND_SOFTWARE);
+
+    Kitty_PostEffect invalid[] = {{KITTY_POST_UPSAMPLE, 0, NULL}};
+    Kitty_PostEffect no_radius[] = {{KITTY_POST_BOX_BLUR, 0, NULL}};
+    if (Kitty_SetPostChain(invalid, 1) != KITTY_INVALID_ARGUMENT || Kitty_SetPostChain(no_radius, 1) != KITTY_INVALID_ARGUMENT){
+        printf("An invalid post chain was accepted.\n");
+        Kitty_Quit();
+        return 1;
+    }
+
+    Kitty_ColorLUT* lut = Kitty_CreateColorLUT(2);
+    for (int i = 0; i < 8; i++){
+        Kitty_SetColorLUTEntry(lut, i & 1, (i >> 1) & 1, i >> 2, (Kitty_Color){0, 0, 255, 255});
+    }
+    Kitty_PostEffect blur[] = {{KITTY_POST_BOX_BLUR, 1, NULL}};
+    Kitty_PostEffect grade[] = {{KITTY_POST_COLOR_LUT, 0, lut}};
+    Kitty_PostEffect bloom[] = {{KITTY_POST_DOWNSAMPLE, 0, NULL}, {KITTY_POST_GAUSSIAN_BLUR, 2, NULL}, {KITTY_POST_DOWNSAMPLE, 0, NULL}};
+    struct {
+        const Kitty_PostEffect* chain;
+        size_t count;
+        Uint32 inside;      // at (100, 100)
+        Uint32 outside;     // at (95, 100), next to the splat
+    } cases[] = {
+        {NULL, 0, 0xFFFFFFFFu, 0},
+        {blur, 1, 0xFFFFFFFFu, 0xFF555555u},    // a third of the 3x3 window is white
+        {grade, 1, 0xFF0000FFu, 0},
+        {bloom, 3, 0, 0},                       // just has to run, downsamples are undone at the end
+    };
+    Uint32* pixels = malloc(800 * 600 * sizeof(Uint32));
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++){
+        Kitty_SetPostChain(cases[c].chain, cases[c].count);
+        Kitty_ClearScreen((Kitty_Color){0, 0, 0, 255});
+        if ((result = Kitty_RenderObjects()) || (result = Kitty_ReadPixels(pixels, 800 * sizeof(Uint32)))){
+            printf("Post chain %zu failed with error code: %d\n", c, result);
+            free(pixels);
+            Kitty_Quit();
+            return 1;
+        }
+        Kitty_FlipBuffers();
+        Uint32 inside = pixels[100 * 800 + 100] | 0xFF000000u;
+        Uint32 outside = pixels[100 * 800 + 95] | (pixels[100 * 800 + 95] ? 0xFF000000u : 0);
+        if (c == 3 ? (inside == 0xFF000000u || Kitty_GetFrameStats().post_ms <= 0.0)
+                   : (inside != cases[c].inside || outside != cases[c].outside)){
+            printf("Post chain %zu gave %08X inside and %08X outside.\n", c, (unsigned)inside, (unsigned)outside);
+            free(pixels);
+            Kitty_Quit();
+            return 1;
+        }
+    }
+    free(pixels);
+
+    Kitty_SetPostChain(NULL, 0);
+    Kitty_FreeColorLUT(lut);
+    free(cloud);
+    if ((result = Kitty_Quit())) {
+        printf("Kitty_Quit failed with error code: %d\n", result);
+        return 1;
+    }
+
+    printf("Post processing test passed successfully.\n");
+    return 0;
+}
+
+int test_anti_aliasing(){
+    int result = Kitty_Init("Kitty Engine Anti Aliasing Test", 800, 600);
+    if (result != KITTY_SUCCESS){
+        printf("Kitty_Init failed with error code: %d\n", result);
+        return 1;
+    }
+    if (Kitty_SetAntiAliasing((enum Kitty_AntiAliasing)3) != KITTY_INVALID_ARGUMENT){
+        printf("An unknown anti-aliasing level was accepted.\n");
+        Kitty_Quit();
+        return 1;
+    }
+
+    // right triangle with a 200 x 150 pixel bounding box, its area is 15000 pixels
+    Kitty_Object* triangle = Kitty_CreateTriangle((Kitty_Point){100, 100}, (Kitty_Point){300, 100}, (Kitty_Point){100, 250}, true, (Kitty_Color){255, 255, 255, 255});
+    Kitty_AddObject(*triangle);
+    Kitty_SetRenderBackend(KITTY_BACKEND_SOFTWARE);
+    Uint32* pixels = malloc(800 * 600 * sizeof(Uint32));
+    enum Kitty_AntiAliasing levels[] = {KITTY_AA_OFF, KITTY_AA_4X, KITTY_AA_8X, KITTY_AA_16X};
+    for (int l = 0; l < 4; l++){
+        Kitty_SetAntiAliasing(levels[l]);
+        Kitty_ClearScreen((Kitty_Color){0, 0, 0, 255});
+        if ((result = Kitty_RenderObjects()) || (result = Kitty_ReadPixels(pixels, 800 * sizeof(Uint32)))){
+            printf("Anti-aliased frame failed with error code: %d\n", result);
+            free(pixels);
+            Kitty_Quit();
+            return 1;
+        }
+        Kitty_FlipBuffers();
+        int partial = 0;
+        double covered = 0.0;
+        for (int i = 0; i < 800 * 600; i++){
+            int red = (pixels[i] >> 16) & 0xFF;
+            partial += red > 0 && red < 255;
+            covered += red / 255.0;
+        }
+        bool expected_partial = levels[l] == KITTY_AA_OFF ? partial == 0 : partial > 100;
+        if (!expected_partial || (levels[l] != KITTY_AA_OFF && fabs(covered - 15000.0) > 150.0)){
+            printf("%dx anti-aliasing covered %.1f pixels with %d partial pixels.\n", levels[l], covered, partial);
+            free(pixels);
+            Kitty_Quit();
+            return 1;
+        }
+    }
+    free(pixels);
+    free(triangle);
+    Kitty_ClearObjects();
+
+    // benchmark: cost of each level on a field of triangles, rasterized by the software backend
+    for (int i = 0; i < 300; i++){
+        Kitty_Point a = {rand() % 800, rand() % 600};
+        Kitty_Object* t = Kitty_CreateTriangle(a, (Kitty_Point){a.x + rand() % 100 - 50, a.y + rand() % 100 - 50},
+                                               (Kitty_Point){a.x + rand() % 100 - 50, a.y + rand() % 100 - 50}, true,
+                                               (Kitty_Color){rand() % 256, rand() % 256, rand() % 256, 255});
+        Kitty_AddObject(*t);
+        free(t);
+    }
+    for (int l = 0; l < 4; l++){
+        Kitty_SetAntiAliasing(levels[l]);
+        clock_t begin = clock();
+        for (int frame = 0; frame < 10; frame++){
+            Kitty_ClearScreen((Kitty_Color){0, 0, 0, 255});
+            Kitty_RenderObjects();
+            Kitty_FlipBuffers();
+        }
+        printf("Anti-aliasing %2dx: %.3f ms per frame (300 triangles).\n", levels[l], (double)(clock() - begin) * 1000.0 / CLOCKS_PER_SEC / 10.0);
+    }
+
+    Kitty_SetAntiAliasing(KITTY_AA_OFF);
+    if ((result = Kitty_Quit())) {
+        printf("Kitty_Quit failed with error code: %d\n", result);
+        return 1;
+    }
+
+    printf("Anti aliasing test passed successfully.\n");
+    return 0;
+}
+
+// RGBA32 texture filled with a smooth gradient, or with a 16 color checker when few_colors is set
+static Kitty_Texture* make_texture(int size, bool few_colors){
+    Kitty_Texture* texture = calloc(1, sizeof(Kitty_Texture));
+    texture->sdl_surface = SDL_CreateRGBSurfaceWithFormat(0, size, size, 32, SDL_PIXELFORMAT_RGBA32);
+    for (int y = 0; y < size; y++){
+        Uint8* row = (Uint8*)texture->sdl_surface->pixels + y * texture->sdl_surface->pitch;
+        for (int x = 0; x < size; x++){
+            Kitty_Color c = few_colors ? (Kitty_Color){((x / 8) % 4) * 85, ((y / 8) % 4) * 85, 40, 255}
+                                       : (Kitty_Color){x * 255 / size, y * 255 / size, (x + y) * 127 / size, 255};
+            memcpy(row + x * 4, &c, 4);
+        }
+    }
+    return texture;
+}
+
+// mean absolute channel error of a compact texture against the RGBA32 original
+static double texture_error(Kitty_Texture* original, Kitty_Texture* compact){
+    double error = 0.0;
+    int size = original->sdl_surface->w;
+    for (int y = 0; y < size; y++){
+        for (int x = 0; x < size; x++){
+            Kitty_Color a = Kitty_SampleTexture(original, x, y);
+            Kitty_Color b = Kitty_SampleTexture(compact, x, y);
+            error += abs(a.r - b.r) + abs(a.g - b.g) + abs(a.b - b.b);
+        }
+    }
+    return error / (size * size * 3.0);
+}
+
+int test_texture_formats(){
+    int result = Kitty_Init("Kitty Engine Texture Format Test", 800, 600);
+    if (result != KITTY_SUCCESS){
+        printf("Kitty_Init failed with error code: %d\n", result);
+        return 1;
+    }
+
+    Kitty_Texture* original = make_texture(64, false);
+    size_t rgba_bytes = Kitty_GetTextureMemory(original);
+    enum Kitty_TextureFormat formats[] = {KITTY_TEXTURE_INDEXED8, KITTY_TEXTURE_BC1};
+    const char* names[] = {"indexed", "BC1"};
+    double max_error[] = {4.0, 6.0};
+    for (int f = 0; f < 2; f++){
+        Kitty_Texture* compact = make_texture(64, false);
+        if ((result = Kitty_ConvertTexture(compact, formats[f])) || compact->sdl_surface || compact->width != 64){
+            printf("Converting to %s failed with error code: %d\n", names[f], result);
+            Kitty_Quit();
+            return 1;
+        }
+        double error = texture_error(original, compact);
+        size_t bytes = Kitty_GetTextureMemory(compact);
+        printf("%s texture: %zu of %zu bytes, mean error %.2f.\n", names[f], bytes, rgba_bytes, error);
+        if (error > max_error[f] || bytes * 3 > rgba_bytes || Kitty_ConvertTexture(compact, KITTY_TEXTURE_BC1) != KITTY_INVALID_ARGUMENT){
+            printf("The %s texture is too lossy or too large.\n", names[f]);
+            Kitty_Quit();
+            return 1;
+        }
+        Kitty_FreeTexture(compact);
+    }
+
+    // up to 256 colors survive indexing exactly, transparent texels survive BC1
+    Kitty_Texture* checker = make_texture(64, true);
+    Kitty_Texture* exact = make_texture(64, true);
+    Kitty_ConvertTexture(exact, KITTY_TEXTURE_INDEXED8);
+    Kitty_Texture* cutout = make_texture(8, false);
+    ((Uint8*)cutout->sdl_surface->pixels)[3] = 0;
+    Kitty_ConvertTexture(cutout, KITTY_TEXTURE_BC1);
+    if (texture_error(checker, exact) != 0.0 || Kitty_SampleTexture(cutout, 0, 0).a != 0 || Kitty_SampleTexture(cutout, 1, 0).a != 255){
+        printf("Exact palette or BC1 transparency was lost.\n");
+        Kitty_Quit();
+        return 1;
+    }
+    Kitty_FreeTexture(checker);
+    Kitty_FreeTexture(exact);
+    Kitty_FreeTexture(cutout);
+
+    // benchmark: a textured mesh rendered with each format
+    Kitty_Object* mesh = Kitty_CreateMesh();
+    Kitty_AddVertexToObjMesh(mesh, (Kitty_Vertex3D){-1, -1, 0});
+    Kitty_AddVertexToObjMesh(mesh, (Kitty_Vertex3D){1, -1, 0});
+    Kitty_AddVertexToObjMesh(mesh, (Kitty_Vertex3D){0, 1, 0});
+    Kitty_AddUVToObjMesh(mesh, (Kitty_UV){0, 0});
+    Kitty_AddUVToObjMesh(mesh, (Kitty_UV){1, 0});
+    Kitty_AddUVToObjMesh(mesh, (Kitty_UV){0, 1});
+    Kitty_AddFaceToObjMesh(mesh, (Kitty_Face){0, 2, 1, 0, 2, 1}, (Kitty_Color){0, 0, 255, 255});
+    ((Kitty_ObjMesh*)mesh->data)->position = (Kitty_Point3D){400, 300, 0};
+    ((Kitty_ObjMesh*)mesh->data)->scale = 200;
+    Kitty_AddObject(*mesh);
+    Kitty_SetRenderBackend(KITTY_BACKEND_NULL);
+    for (int f = -1; f < 2; f++){
+        Kitty_Texture* texture = make_texture(256, false);
+        if (f >= 0){
+            Kitty_ConvertTexture(texture, formats[f]);
+        }
+        Kitty_Object stored;
+        Kitty_GetObject(0, &stored);
+        ((Kitty_ObjMesh*)stored.data)->texture = texture;
+        clock_t begin = clock();
+        for (int frame = 0; frame < 10; frame++){
+            Kitty_ClearScreen((Kitty_Color){0, 0, 0, 255});
+            Kitty_RenderObjects();
+            Kitty_FlipBuffers();
+        }
+        printf("Textured mesh, %s: %.3f ms per frame.\n", f < 0 ? "RGBA32" : names[f], (double)(clock() - begin) * 1000.0 / CLOCKS_PER_SEC / 10.0);
+        ((Kitty_ObjMesh*)stored.data)->texture = NULL;
+        Kitty_FreeTexture(texture);
+    }
+    free(mesh);
+    Kitty_FreeTexture(original);
+
+    if ((result = Kitty_Quit())) {
+        printf("Kitty_Quit failed with error code: %d\n", result);
+        return 1;
+    }
+
+    printf("Texture format test passed successfully.\n");
+    return 0;
+}
+
+// samples, updates and renders empty frames until the wanted page arrives
+static Kitty_Color stream_texel(Kitty_VirtualTexture* vt, float u, float v, int level){
+    for (int frame = 0; frame < 2000; frame++){
+        Kitty_Color texel = Kitty_SampleVirtualTexture(vt, u, v, level);
+        Kitty_VirtualTextureStats before, after;
+        Kitty_GetVirtualTextureStats(vt, &before);
+        Kitty_SampleVirtualTexture(vt, u, v, level);
+        Kitty_GetVirtualTextureStats(vt, &after);
+        if (after.fallback_samples == before.fallback_samples){
+            return texel;
+        }
+        Kitty_UpdateVirtualTexture(vt);
+        Kitty_RenderObjects();
+        SDL_Delay(1);
+    }
+    return (Kitty_Color){0, 0, 0, 0};
+}
+
+int test_virtual_texture(){
+    int result = Kitty_Init("Kitty Engine Virtual Texture Test", 800, 600);
+    if (result != KITTY_SUCCESS){
+        printf("Kitty_Init failed with error code: %d\n", result);
+        return 1;
+    }
+
+    // 512 x 512 in 64 texel pages: 64 + 16 + 4 + 1 pages over four levels
+    const char* path = "kitty_virtual_texture_test.kvt";
+    Kitty_Texture* source = make_texture(512, false);
+    if (Kitty_BakeVirtualTexture(source, 24, path) != KITTY_INVALID_ARGUMENT || (result = Kitty_BakeVirtualTexture(source, 64, path))){
+        printf("Baking the page file failed with error code: %d\n", result);
+        Kitty_Quit();
+        return 1;
+    }
+    Kitty_VirtualTexture* vt = Kitty_OpenVirtualTexture(path, 8);
+    if (!vt || vt->level_count != 4 || vt->page_count != 85 || Kitty_OpenVirtualTexture(path, 1) || Kitty_OpenVirtualTexture("missing.kvt", 8)){
+        printf("Opening the page file failed.\n");
+        Kitty_Quit();
+        return 1;
+    }
+
+    // the first sample falls back to the pinned coarsest level, then level 0 streams in;
+    // sixteen pages through a cache of eight make the LRU evict
+    Kitty_Color coarse = Kitty_SampleVirtualTexture(vt, 0.5f, 0.5f, 0);
+    Kitty_VirtualTextureStats stats;
+    Kitty_GetVirtualTextureStats(vt, &stats);
+    if (stats.fallback_samples != 1 || stats.resident_pages != 1 || coarse.a != 255){
+        printf("The first sample did not fall back to the coarsest level.\n");
+        Kitty_Quit();
+        return 1;
+    }
+    for (int i = 0; i < 16; i++){
+        float u = (i % 8 + 0.5f) / 8.0f, v = ((i / 8) * 3 + 0.5f) / 8.0f;
+        Kitty_Color texel = stream_texel(vt, u, v, 0);
+        Kitty_Color expected = Kitty_SampleTexture(source, (int)(u * 512), (int)(v * 512));
+        if (memcmp(&texel, &expected, sizeof(Kitty_Color)) != 0){
+            printf("Streamed page %d holds the wrong texels.\n", i);
+            Kitty_Quit();
+            return 1;
+        }
+    }
+    Kitty_GetVirtualTextureStats(vt, &stats);
+    if (stats.resident_pages > 8 || stats.pages_loaded < 17){
+        printf("The page cache holds %d pages after %zu loads.\n", stats.resident_pages, stats.pages_loaded);
+        Kitty_Quit();
+        return 1;
+    }
+
+    // a mesh sampling the virtual texture requests its pages from the rasterizer
+    Kitty_Object* mesh = Kitty_CreateMesh();
+    Kitty_AddVertexToObjMesh(mesh, (Kitty_Vertex3D){-1, -1, 0});
+    Kitty_AddVertexToObjMesh(mesh, (Kitty_Vertex3D){1, -1, 0});
+    Kitty_AddVertexToObjMesh(mesh, (Kitty_Vertex3D){0, 1, 0});
+    Kitty_AddUVToObjMesh(mesh, (Kitty_UV){0, 0});
+    Kitty_AddUVToObjMesh(mesh, (Kitty_UV){1, 0});
+    Kitty_AddUVToObjMesh(mesh, (Kitty_UV){0, 1});
+    Kitty_AddFaceToObjMesh(mesh, (Kitty_Face){0, 2, 1, 0, 2, 1}, (Kitty_Color){0, 0, 255, 255});
+    ((Kitty_ObjMesh*)mesh->data)->virtual_texture = vt;
+    ((Kitty_ObjMesh*)mesh->data)->position = (Kitty_Point3D){400, 300, 0};
+    ((Kitty_ObjMesh*)mesh->data)->scale = 60;
+    Kitty_AddObject(*mesh);
+    size_t loaded = stats.pages_loaded;
+    for (int frame = 0; frame < 50; frame++){
+        Kitty_ClearScreen((Kitty_Color){0, 0, 0, 255});
+        Kitty_RenderObjects();
+        Kitty_FlipBuffers();
+        SDL_Delay(1);
+    }
+    Kitty_GetVirtualTextureStats(vt, &stats);
+    printf("Virtual texture: %d pages resident, %zu loaded, %zu fallback samples.\n", stats.resident_pages, stats.pages_loaded, stats.fallback_samples);
+    if (stats.pages_loaded <= loaded || stats.resident_pages > 8){
+        printf("The mesh did not stream any pages.\n");
+        Kitty_Quit();
+        return 1;
+    }
+    Kitty_ClearObjects();
+    free(mesh);
+    Kitty_CloseVirtualTexture(vt);
+    Kitty_FreeTexture(source);
+    remove(path);
+
+    if ((result = Kitty_Quit())) {
+        printf("Kitty_Quit failed with error code: %d\n", result);
+        return 1;
+    }
+
+    printf("Virtual texture test passed successfully.\n");
+    return 0;
+}
+
+typedef struct {
+    size_t allocations;
+    size_t releases;
+} counting_heap;
+
+static void* counting_allocate(void* user_data, size_t size, enum Kitty_MemoryTag tag){
+    (void)tag;
+    ((counting_heap*)user_data)->allocations++;
+    return malloc(size);
+}
+
+static void counting_release(void* user_data, void* block, enum Kitty_MemoryTag tag){
+    (void)tag;
+    ((counting_heap*)user_data)->releases++;
+    free(block);
+}
+
+int test_memory_stats(){
+    // everything earlier tests allocated went back when they quit
+    Kitty_MemoryStats stats;
+    Kitty_GetMemoryStats(&stats);
+    if (stats.total.current_bytes != 0 || stats.total.live_allocations != 0){
+        printf("%zu bytes in %zu blocks outlived Kitty_Quit.\n", stats.total.current_bytes, stats.total.live_allocations);
+        return 1;
+    }
+
+    // a user heap (reallocate left NULL) sees every engine block
+    counting_heap heap = {0, 0};
+    Kitty_Allocator allocator = {counting_allocate, NULL, counting_release, &heap};
+    if (Kitty_SetAllocator(&(Kitty_Allocator){NULL, NULL, counting_release, &heap}) != KITTY_INVALID_ARGUMENT ||
+        Kitty_SetAllocator(&allocator) != KITTY_SUCCESS){
+        printf("Kitty_SetAllocator accepted an incomplete heap or rejected a complete one.\n");
+        return 1;
+    }
+    int result = Kitty_Init("Kitty Engine Memory Stats Test", 800, 600);
+    if (result != KITTY_SUCCESS){
+        printf("Kitty_Init failed with error code: %d\n", result);
+        return 1;
+    }
+    if (Kitty_SetAllocator(NULL) != KITTY_MEMORYSPACE_DATA_NOT_FREED){
+        printf("The heap was swapped while the engine held memory.\n");
+        Kitty_Quit();
+        return 1;
+    }
+
+    Kitty_Object* mesh = Kitty_CreateMesh();
+    for (int i = 0; i < 100; i++){
+        Kitty_AddVertexToObjMesh(mesh, (Kitty_Vertex3D){(float)(i % 10), (float)(i / 10), 0});
+    }
+    Kitty_Object* text = Kitty_CreateText((Kitty_Point){10, 10}, 0, 24, (Kitty_Color){255, 255, 255, 255}, "memory");
+    Kitty_Vertex3D points[256];
+    for (int i = 0; i < 256; i++){
+        points[i] = (Kitty_Vertex3D){(float)(i % 16), (float)(i / 16), 10};
+    }
+    Kitty_Object* cloud = Kitty_CreatePointCloud(points, NULL, 256, false);
+    // vertices the caller allocated stay on its heap and out of the stats, even once the engine grows them
+    Kitty_Object* own = Kitty_CreateMesh();
+    Kitty_ObjMesh* own_mesh = (Kitty_ObjMesh*)own->data;
+    own_mesh->vertices = (Kitty_Vertex3D*)malloc(4 * sizeof(Kitty_Vertex3D));
+    own_mesh->vertex_count = 4;
+    for (int i = 0; i < 4; i++){
+        own_mesh->vertices[i] = (Kitty_Vertex3D){(float)i, 0, 20};
+    }
+    Kitty_AddVertexToObjMesh(own, (Kitty_Vertex3D){0, 1, 20});
+    Kitty_AddObject(*mesh);
+    Kitty_AddObject(*text);
+    Kitty_AddObject(*cloud);
+    Kitty_AddObject(*own);
+    Kitty_ClearScreen((Kitty_Color){0, 0, 0, 255});
+    Kitty_RenderObjects();
+    Kitty_FlipBuffers();
+
+    Kitty_GetMemoryStats(&stats);
+    const char* names[] = {"objects", "meshes", "textures", "text", "shapes", "point clouds", "frame"};
+    for (int t = 0; t < KITTY_MEMORY_TAG_COUNT; t++){
+        printf("Memory %-12s %8zu bytes, peak %8zu, %zu blocks.\n", names[t], stats.tags[t].current_bytes, stats.tags[t].peak_bytes, stats.tags[t].live_allocations);
+    }
+    size_t sum = 0;
+    for (int t = 0; t < KITTY_MEMORY_TAG_COUNT; t++){
+        sum += stats.tags[t].current_bytes;
+    }
+    if (stats.tags[KITTY_MEMORY_MESHES].current_bytes < 100 * sizeof(Kitty_Vertex3D) || stats.tags[KITTY_MEMORY_TEXT].current_bytes != strlen("memory") + 1 ||
+        stats.tags[KITTY_MEMORY_POINT_CLOUDS].current_bytes < 256 * 3 * sizeof(float) || stats.tags[KITTY_MEMORY_OBJECTS].current_bytes == 0 ||
+        stats.tags[KITTY_MEMORY_TEXTURES].current_bytes < 800 * 600 * sizeof(Uint32) || stats.tags[KITTY_MEMORY_TEXTURES].live_allocations != 0 ||
+        sum != stats.total.current_bytes || stats.total.peak_bytes < stats.total.current_bytes ||
+        heap.allocations - heap.releases != stats.total.live_allocations){
+        printf("Memory stats do not add up.\n");
+        Kitty_Quit();
+        return 1;
+    }
+    free(mesh);
+    free(text);
+    free(cloud);
+    free(own);
+
+    if ((result = Kitty_Quit())) {
+        printf("Kitty_Quit failed with error code: %d\n", result);
+        return 1;
+    }
+    Kitty_GetMemoryStats(&stats);
+    if (stats.total.current_bytes != 0 || heap.allocations != heap.releases || Kitty_SetAllocator(NULL) != KITTY_SUCCESS){
+        printf("Kitty_Quit left %zu bytes on the user heap.\n", stats.total.current_bytes);
+        return 1;
+    }
+
+    printf("Memory stats test passed successfully.\n");
+    return 0;
+}
+
+static void (*zero_allocation_clear)(void* ctx, Kitty_Color color);
+
+static int allocate_color_lut(void* data){
+    (void)data;
+    Kitty_FreeColorLUT(Kitty_CreateColorLUT(2));
+    return 0;
+}
+
+static void clear_beside_other_thread(void* ctx, Kitty_Color color){
+    SDL_WaitThread(SDL_CreateThread(allocate_color_lut, "lut", NULL), NULL);
+    zero_allocation_clear(ctx, color);
+}
+
+int test_zero_allocation(){
+    int result = Kitty_Init("Kitty Engine Zero Allocation Test", 800, 600);
+    if (result != KITTY_SUCCESS){
+        printf("Kitty_Init failed with error code: %d\n", result);
+        return 1;
+    }
+
+    // one of most kinds of object, point clouds upscaled and blurred through the software framebuffer
+    Kitty_Object* objects[6];
+    objects[0] = Kitty_CreatePolygon((Kitty_Point[]){{10, 10}, {200, 40}, {120, 180}}, 3, true, KITTY_FILL_EVEN_ODD, (Kitty_Color){0, 255, 0, 255});
+    objects[1] = Kitty_CreatePolyline((Kitty_Point[]){{300, 10}, {400, 80}, {500, 20}}, 3, 4.0f, KITTY_JOIN_MITER, (Kitty_Color){255, 255, 0, 255});
+    objects[2] = Kitty_CreatePath((Kitty_Point){600, 100}, 3.0f, KITTY_JOIN_ROUND, (Kitty_Color){0, 255, 255, 255});
+    Kitty_PathMoveTo(objects[2], (Kitty_Vertex2D){0, 0});
+    Kitty_PathCubicTo(objects[2], (Kitty_Vertex2D){50, -80}, (Kitty_Vertex2D){100, 80}, (Kitty_Vertex2D){150, 0});
+    objects[3] = Kitty_CreatePlot((Kitty_Point){10, 400}, 300, 100, 0.0f, 1.0f, 200);
+    Kitty_AddPlotSeries(objects[3], 200, (Kitty_Color){255, 0, 0, 255});
+    objects[4] = Kitty_CreateText((Kitty_Point){10, 300}, 0, 24, (Kitty_Color){255, 255, 255, 255}, "steady");
+    Kitty_Vertex3D points[1024];
+    for (int i = 0; i < 1024; i++){
+        points[i] = (Kitty_Vertex3D){(float)(i % 32), (float)(i / 32), 10};
+    }
+    objects[5] = Kitty_CreatePointCloud(points, NULL, 1024, false);
+    for (int i = 0; i < 6; i++){
+        Kitty_AddObject(*objects[i]);
+        free(objects[i]);
+    }
+    Kitty_SetResolutionScale(0.5f);
+    Kitty_SetPostChain((Kitty_PostEffect[]){{KITTY_POST_GAUSSIAN_BLUR, 2, NULL}}, 1);
+    Kitty_SetAntiAliasing(KITTY_AA_4X);
+
+    // warm-up sizes every cache, after that a frame must not touch the heap
+    for (int frame = 0; frame < 70; frame++){
+        if (frame == 10){
+            Kitty_SetAllocationCheck(true);
+        }
+        Kitty_Object plot;
+        Kitty_GetObject(3, &plot);
+        Kitty_PlotAppend(&plot, 0, (float)(frame % 10) / 10.0f);
+        Kitty_ClearScreen((Kitty_Color){0, 0, 0, 255});
+        Kitty_UpdateObjectState();
+        Kitty_RenderObjects();
+        Kitty_FlipBuffers();
+        if (frame >= 10 && Kitty_GetFrameStats().allocations != 0){
+            printf("Frame %d allocated %zu times after warm-up.\n", frame, Kitty_GetFrameStats().allocations);
+            Kitty_Quit();
+            return 1;
+        }
+    }
+    if (Kitty_GetAllocationReports(NULL, 0) != 0){
+        printf("The allocation check reported a steady state allocation.\n");
+        Kitty_Quit();
+        return 1;
+    }
+
+    // a new polygon sizes its edge buffers on its first frame, which the check catches
+    Kitty_Object* late = Kitty_CreatePolygon((Kitty_Point[]){{600, 400}, {700, 450}, {650, 550}}, 3, true, KITTY_FILL_EVEN_ODD, (Kitty_Color){0, 0, 255, 255});
+    Kitty_AddObject(*late);
+    free(late);
+    Kitty_ClearScreen((Kitty_Color){0, 0, 0, 255});
+    Kitty_RenderObjects();
+    Kitty_FlipBuffers();
+    Kitty_AllocationReport reports[4];
+    size_t caught = Kitty_GetAllocationReports(reports, 4);
+    if (caught == 0 || Kitty_GetFrameStats().allocations != caught || reports[0].tag != KITTY_MEMORY_SHAPES){
+        printf("The allocation check missed the new polygon (%zu reports).\n", caught);
+        Kitty_Quit();
+        return 1;
+    }
+
+    // another thread allocating while a frame runs is not the frame's allocation
+    Kitty_RenderBackend backend = *Kitty_GetRenderBackend();
+    zero_allocation_clear = backend.clear;
+    backend.clear = clear_beside_other_thread;
+    Kitty_SetCustomRenderBackend(&backend);
+    Kitty_ClearScreen((Kitty_Color){0, 0, 0, 255});
+    Kitty_RenderObjects();
+    Kitty_FlipBuffers();
+    if (Kitty_GetFrameStats().allocations != 0 || Kitty_GetAllocationReports(NULL, 0) != caught){
+        printf("Another thread's allocations counted towards the frame.\n");
+        Kitty_Quit();
+        return 1;
+    }
+    Kitty_SetAllocationCheck(false);
+    Kitty_SetPostChain(NULL, 0);
+    Kitty_SetResolutionScale(1.0f);
+    Kitty_SetAntiAliasing(KITTY_AA_OFF);
+
+    if ((result = Kitty_Quit())) {
+        printf("Kitty_Quit failed with error code: %d\n", result);
+        return 1;
+    }
+
+    printf("Zero allocation test passed successfully.\n");
+    return 0;
+}
+
+static bool pixel_x_divisible_by_4(const Kitty_Object* obj, void* user_data){
+    Kitty_ObjPixel* pixel = (Kitty_ObjPixel*)obj->data;
+    if (pixel->position.x % 4 != 0){
+        return false;
+    }
+    // the predicate owns what it removes
+    free(obj->data);
+    (*(size_t*)user_data)++;
+    return true;
+}
+
+int test_bulk_objects(){
+    int result = Kitty_Init("Kitty Engine Bulk Objects Test", 800, 600);
+    if (result != KITTY_SUCCESS){
+        printf("Kitty_Init failed with error code: %d\n", result);
+        return 1;
+    }
+
+    const size_t count = 100000;
+    Kitty_Object* objects = malloc(count * sizeof(Kitty_Object));
+    size_t* odd = malloc(count / 2 * sizeof(size_t));
+    for (size_t i = 0; i < count; i++){
+        Kitty_Object* pixel = Kitty_CreatePixel((Kitty_Point){(int)i, 0}, (Kitty_Color){255, 255, 255, 255});
+        objects[i] = *pixel;
+        free(pixel);
+    }
+    for (size_t i = 0; i < count / 2; i++){
+        odd[i] = count / 2 * 2 - 1 - 2 * i; // any order works
+    }
+
+    clock_t begin = clock();
+    result = Kitty_AddObjects(objects, count);
+    if (result != KITTY_SUCCESS || Kitty_GetObjectCount() != count){
+        printf("Kitty_AddObjects failed with error code: %d\n", result);
+        Kitty_Quit();
+        return 1;
+    }
+    size_t bad[] = {0, count};
+    if (Kitty_RemoveObjects(bad, 2) != KITTY_INVALID_OBJECT_INDEX || Kitty_GetObjectCount() != count){
+        printf("Kitty_RemoveObjects accepted an index past the end.\n");
+        Kitty_Quit();
+        return 1;
+    }
+    result = Kitty_RemoveObjects(odd, count / 2);
+    if (result != KITTY_SUCCESS || Kitty_GetObjectCount() != count / 2){
+        printf("Kitty_RemoveObjects failed with error code: %d\n", result);
+        Kitty_Quit();
+        return 1;
+    }
+    size_t freed = 0;
+    size_t removed = 0;
+    result = Kitty_RemoveIf(pixel_x_divisible_by_4, &freed, &removed);
+    double ms = (double)(clock() - begin) * 1000.0 / CLOCKS_PER_SEC;
+    if (result != KITTY_SUCCESS || removed != count / 4 || freed != removed || Kitty_GetObjectCount() != count / 4){
+        printf("Kitty_RemoveIf failed with error code: %d (%zu removed)\n", result, removed);
+        Kitty_Quit();
+        return 1;
+    }
+
+    // the survivors keep their order
+    for (size_t i = 0; i < Kitty_GetObjectCount(); i++){
+        Kitty_Object obj;
+        Kitty_GetObject(i, &obj);
+        if (((Kitty_ObjPixel*)obj.data)->position.x != (int)(4 * i + 2)){
+            printf("Object %zu is out of order after the bulk removals.\n", i);
+            Kitty_Quit();
+            return 1;
+        }
+    }
+    printf("Bulk add and remove of %zu objects: %.3f ms.\n", count, ms);
+
+    for (size_t i = 0; i < count / 2; i++){
+        free(objects[odd[i]].data);
+    }
+    free(odd);
+    free(objects);
+
+    if ((result = Kitty_Quit())) {
+        printf("Kitty_Quit failed with error code: %d\n", result);
+        return 1;
+    }
+
+    printf("Bulk objects test passed successfully.\n");
+    return 0;
+}
+
+static bool pixel_id_divisible_by_3(const Kitty_Object* obj, void* user_data){
+    (void)user_data;
+    if (obj->id % 3 != 0){
+        return false;
+    }
+    free(obj->data);
+    return true;
+}
+
+int test_object_ids(){
+    int result = Kitty_Init("Kitty Engine Object ID Test", 800, 600);
+    if (result != KITTY_SUCCESS){
+        printf("Kitty_Init failed with error code: %d\n", result);
+        return 1;
+    }
+
+    // ids i * 7 + 1 for objects at x = i, stored in the order they are added
+    const size_t count = 200000;
+    Kitty_Object* objects = malloc(count * sizeof(Kitty_Object));
+    for (size_t i = 0; i < count; i++){
+        Kitty_Object* pixel = Kitty_CreatePixel((Kitty_Point){(int)i, 0}, (Kitty_Color){255, 255, 255, 255});
+        objects[i] = *pixel;
+        objects[i].id = i * 7 + 1;
+        free(pixel);
+    }
+    if ((result = Kitty_AddObjects(objects, count)) != KITTY_SUCCESS){
+        printf("Kitty_AddObjects failed with error code: %d\n", result);
+        Kitty_Quit();
+        return 1;
+    }
+    free(objects);
+    Kitty_Object* twin = Kitty_CreatePixel((Kitty_Point){0, 0}, (Kitty_Color){0, 0, 0, 255});
+    twin->id = 8;
+    if (Kitty_AddObject(*twin) != KITTY_DUPLICATE_OBJECT_ID || Kitty_GetObjectCount() != count){
+        printf("Kitty_AddObject accepted a duplicate id.\n");
+        Kitty_Quit();
+        return 1;
+    }
+    free(twin->data);
+    free(twin);
+
+    // every third id goes, the rest must still resolve to the objects that now sit at shifted indices
+    Kitty_Object first;
+    Kitty_GetObject(0, &first);
+    free(first.data);
+    Kitty_RemoveObject(0);
+    Kitty_RemoveIf(pixel_id_divisible_by_3, NULL, NULL);
+    clock_t begin = clock();
+    size_t found = 0;
+    for (size_t i = 0; i < count; i++){
+        Uint64 id = i * 7 + 1;
+        size_t index;
+        result = Kitty_FindObject(id, &index);
+        if (i == 0 || id % 3 == 0){
+            if (result != KITTY_OBJECT_NOT_FOUND){
+                printf("Removed id %llu is still found.\n", (unsigned long long)id);
+                Kitty_Quit();
+                return 1;
+            }
+            continue;
+        }
+        Kitty_Object obj;
+        Kitty_GetObject(index, &obj);
+        if (result != KITTY_SUCCESS || obj.id != id || ((Kitty_ObjPixel*)obj.data)->position.x != (int)i){
+            printf("Id %llu resolves to the wrong object.\n", (unsigned long long)id);
+            Kitty_Quit();
+            return 1;
+        }
+        found++;
+    }
+    printf("Found %zu objects by id: %.3f ms.\n", found, (double)(clock() - begin) * 1000.0 / CLOCKS_PER_SEC);
+    if (found != Kitty_GetObjectCount()){
+        printf("Only %zu of %zu stored objects were found by id.\n", found, Kitty_GetObjectCount());
+        Kitty_Quit();
+        return 1;
+    }
+
+    // names hash to ids, renaming frees the old id
+    Uint64 player = Kitty_ObjectIDFromName("player");
+    size_t index;
+    if (Kitty_SetObjectID(5, player) != KITTY_SUCCESS || Kitty_FindObject(player, &index) != KITTY_SUCCESS || index != 5 ||
+        Kitty_SetObjectID(6, player) != KITTY_DUPLICATE_OBJECT_ID || Kitty_SetObjectID(5, 0) != KITTY_SUCCESS ||
+        Kitty_FindObject(player, &index) != KITTY_OBJECT_NOT_FOUND){
+        printf("Named object ids are not kept in sync.\n");
+        Kitty_Quit();
+        return 1;
+    }
+
+    if ((result = Kitty_Quit())) {
+        printf("Kitty_Quit failed with error code: %d\n", result);
+        return 1;
+    }
+
+    printf("Object ID test passed successfully.\n");
+    return 0;
+}
+
+static int snapshot_failure(const char* what){
+    printf("Scene snapshot: %s.\n", what);
+    Kitty_Quit();
+    return 1;
+}
+
+///@brief Saves the store as it is and checks that loading it back fails as a damaged file without touching the store.
+static bool snapshot_rejected(Kitty_Texture* atlas){
+    const char* path = "kitty_scene_corrupt.ksn";
+    size_t count = Kitty_GetObjectCount();
+    bool rejected = Kitty_SaveScene(path, &atlas, 1) == KITTY_SUCCESS && Kitty_LoadScene(path, &atlas, 1) == KITTY_INVALID_FILE &&
+                    Kitty_GetObjectCount() == count;
+    remove(path);
+    return rejected;
+}
+
+int test_scene_snapshot(){
+    int result = Kitty_Init("Kitty Engine Scene Snapshot Test", 800, 600);
+    if (result != KITTY_SUCCESS){
+        printf("Kitty_Init failed with error code: %d\n", result);
+        return 1;
+    }
+    const char* path = "kitty_scene_test.ksn";
+    Kitty_Texture* atlas = make_texture(64, true);
+
+    // one object of every type
+    Kitty_Object* objects[13];
+    objects[0] = Kitty_CreateCircle((Kitty_Point){50, 50}, 20.0f, true, (Kitty_Color){255, 0, 0, 255});
+    objects[1] = Kitty_CreateRectangle((Kitty_Point){10, 10}, 30, 40, false, (Kitty_Color){0, 255, 0, 255});
+    objects[2] = Kitty_CreateLine((Kitty_Point){0, 0}, (Kitty_Point){100, 80}, (Kitty_Color){0, 0, 255, 255});
+    objects[3] = Kitty_CreateTriangle((Kitty_Point){100, 100}, (Kitty_Point){200, 100}, (Kitty_Point){150, 180}, true, (Kitty_Color){9, 9, 9, 255});
+    objects[4] = Kitty_CreatePixel((Kitty_Point){7, 8}, (Kitty_Color){1, 2, 3, 4});
+    objects[5] = Kitty_CreateMesh();
+    Kitty_AddVertexToObjMesh(objects[5], (Kitty_Vertex3D){-1, -1, 0});
+    Kitty_AddVertexToObjMesh(objects[5], (Kitty_Vertex3D){1, -1, 0});
+    Kitty_AddVertexToObjMesh(objects[5], (Kitty_Vertex3D){0, 1, 0});
+    Kitty_AddUVToObjMesh(objects[5], (Kitty_UV){0, 0});
+    Kitty_AddFaceToObjMesh(objects[5], (Kitty_Face){0, 2, 1, 0, 0, 0}, (Kitty_Color){0, 255, 0, 255});
+    ((Kitty_ObjMesh*)objects[5]->data)->origin = (Kitty_Vertex3D){0, 0, 0};
+    ((Kitty_ObjMesh*)objects[5]->data)->texture = atlas;
+    Kitty_SetMeshImpostor(objects[5], 12.0f);
+    objects[6] = Kitty_CreateText((Kitty_Point){300, 20}, 18, 0, (Kitty_Color){255, 255, 255, 255}, "snapshot");
+    objects[7] = Kitty_CreateTilemap((Kitty_Point){0, 300}, 40, 40, 16, 16, atlas);
+    Kitty_SetTile(objects[7], 33, 5, 3);
+    objects[8] = Kitty_CreatePolygon((Kitty_Point[]){{400, 400}, {500, 400}, {450, 500}}, 3, true, KITTY_FILL_NONZERO, (Kitty_Color){0, 128, 255, 255});
+    Kitty_AddPolygonContour(objects[8], (Kitty_Point[]){{420, 410}, {480, 410}, {480, 440}, {420, 440}}, 4);
+    objects[9] = Kitty_CreatePolyline((Kitty_Point[]){{600, 10}, {650, 60}, {700, 20}}, 3, 3.0f, KITTY_JOIN_ROUND, (Kitty_Color){255, 255, 0, 255});
+    objects[10] = Kitty_CreatePath((Kitty_Point){600, 200}, 2.0f, KITTY_JOIN_MITER, (Kitty_Color){0, 255, 255, 255});
+    Kitty_PathMoveTo(objects[10], (Kitty_Vertex2D){0, 0});
+    Kitty_PathCubicTo(objects[10], (Kitty_Vertex2D){30, -40}, (Kitty_Vertex2D){60, 40}, (Kitty_Vertex2D){90, 0});
+    objects[11] = Kitty_CreatePlot((Kitty_Point){10, 500}, 200, 80, -1.0f, 1.0f, 50);
+    Kitty_AddPlotSeries(objects[11], 64, (Kitty_Color){255, 0, 255, 255});
+    for (int i = 0; i < 100; i++){
+        Kitty_PlotAppend(objects[11], 0, (float)(i % 7) / 7.0f);
+    }
+    Kitty_Vertex3D points[1000];
+    for (int i = 0; i < 1000; i++){
+        points[i] = (Kitty_Vertex3D){(float)(i % 10), (float)((i / 10) % 10), (float)(i / 100)};
+    }
+    objects[12] = Kitty_CreatePointCloud(points, NULL, 1000, true);
+    for (int i = 0; i < 13; i++){
+        objects[i]->id = (Uint64)i * 10 + 1;
+        objects[i]->priority = i % 2 ? KITTY_PRIORITY_LOW : KITTY_PRIORITY_HIGH;
+        Kitty_AddObject(*objects[i]);
+        free(objects[i]);
+    }
+    Kitty_SetObjectID(6, Kitty_ObjectIDFromName("title"));
+    Kitty_SetCameraPosition((Kitty_Vertex3D){3, 4, 5});
+    Kitty_SetCameraOrigin((Kitty_Point3D){1, 1, 1});
+
+    if (Kitty_SaveScene(path, NULL, 0) != KITTY_INVALID_ARGUMENT){
+        return snapshot_failure("saved meshes whose texture is missing from the table");
+    }
+    if ((result = Kitty_SaveScene(path, &atlas, 1)) != KITTY_SUCCESS){
+        printf("Kitty_SaveScene failed with error code: %d\n", result);
+        return snapshot_failure("save failed");
+    }
+
+    // a truncated file is rejected and leaves the store alone
+    FILE* source = fopen(path, "rb");
+    FILE* truncated = fopen("kitty_scene_truncated.ksn", "wb");
+    char buffer[512];
+    size_t bytes = fread(buffer, 1, sizeof(buffer), source);
+    fwrite(buffer, 1, bytes, truncated);
+    fclose(source);
+    fclose(truncated);
+    if (Kitty_LoadScene("kitty_scene_truncated.ksn", &atlas, 1) != KITTY_INVALID_FILE || Kitty_GetObjectCount() != 13 ||
+        Kitty_LoadScene("missing.ksn", &atlas, 1) != KITTY_FILE_NOT_FOUND){
+        return snapshot_failure("a damaged or missing snapshot was not rejected");
+    }
+    remove("kitty_scene_truncated.ksn");
+
+    Kitty_ClearObjects();
+    Kitty_SetCameraPosition((Kitty_Vertex3D){10, 0, 0});
+    Kitty_SetCameraOrigin((Kitty_Point3D){0, 0, 0});
+    if ((result = Kitty_LoadScene(path, &atlas, 1)) != KITTY_SUCCESS || Kitty_GetObjectCount() != 13){
+        printf("Kitty_LoadScene failed with error code: %d\n", result);
+        return snapshot_failure("load failed");
+    }
+    Kitty_Vertex3D camera = Kitty_GetCameraPosition();
+    if (camera.x != 3 || camera.y != 4 || camera.z != 5){
+        return snapshot_failure("the camera was not restored");
+    }
+    Kitty_Object loaded[13];
+    for (int i = 0; i < 13; i++){
+        Kitty_GetObject(i, &loaded[i]);
+        Uint64 id = i == 6 ? Kitty_ObjectIDFromName("title") : (Uint64)i * 10 + 1;
+        size_t index;
+        if (loaded[i].id != id || Kitty_FindObject(id, &index) != KITTY_SUCCESS || index != (size_t)i ||
+            loaded[i].priority != (i % 2 ? KITTY_PRIORITY_LOW : KITTY_PRIORITY_HIGH)){
+            return snapshot_failure("object order, ids or priorities changed");
+        }
+    }
+    Kitty_ObjCircle* circle = loaded[0].data;
+    Kitty_ObjMesh* mesh = loaded[5].data;
+    Kitty_ObjText* text = loaded[6].data;
+    Kitty_ObjPolygon* polygon = loaded[8].data;
+    Kitty_ObjPath* path_data = loaded[10].data;
+    Kitty_ObjPlot* plot = loaded[11].data;
+    Kitty_ObjPointCloud* cloud = loaded[12].data;
+    Uint16 tile;
+    Kitty_GetTile(&loaded[7], 33, 5, &tile);
+    if (loaded[0].type != KITTY_OBJECT_CIRCLE || circle->radius != 20.0f || circle->color.r != 255 ||
+        mesh->vertex_count != 3 || mesh->faces[0].b != 2 || mesh->texture != atlas || !mesh->impostor || mesh->impostor->threshold != 12.0f ||
+        strcmp(text->text, "snapshot") != 0 || tile != 3 ||
+        polygon->contour_count != 2 || polygon->point_count != 7 || polygon->points[4].x != 480 ||
+        path_data->segment_count != 2 || path_data->segments[1].points[2].x != 90 ||
+        plot->series_count != 1 || plot->series[0].total != 100 || plot->series[0].samples[99 % 64] != (float)(99 % 7) / 7.0f ||
+        cloud->point_count != 1000 || !cloud->quantized || cloud->node_count == 0){
+        return snapshot_failure("object data differs after the round trip");
+    }
+    Kitty_ClearScreen((Kitty_Color){0, 0, 0, 255});
+    Kitty_UpdateObjectState();
+    if ((result = Kitty_RenderObjects()) != KITTY_SUCCESS){
+        printf("Kitty_RenderObjects failed with error code: %d\n", result);
+        return snapshot_failure("the loaded scene does not render");
+    }
+    Kitty_FlipBuffers();
+
+    // indices outside their arrays make the snapshot damaged, the store stays as it was
+    int* face_fields[] = { &mesh->faces[0].c, &mesh->faces[0].uv_b };
+    int face_values[] = { 3, -1 };
+    for (int i = 0; i < 2; i++){
+        int kept = *face_fields[i];
+        *face_fields[i] = face_values[i];
+        bool rejected = snapshot_rejected(atlas);
+        *face_fields[i] = kept;
+        if (!rejected){
+            return snapshot_failure("a face outside the mesh was accepted");
+        }
+    }
+    polygon->contour_ends[0] = 8;
+    bool rejected = snapshot_rejected(atlas);
+    polygon->contour_ends[0] = 3;
+    if (!rejected){
+        return snapshot_failure("contours out of order were accepted");
+    }
+    cloud->nodes[0].first = 1;
+    rejected = snapshot_rejected(atlas);
+    cloud->nodes[0].first = 0;
+    int kept_child = cloud->nodes[0].children[0];
+    cloud->nodes[0].children[0] = 0;
+    rejected = rejected && snapshot_rejected(atlas);
+    cloud->nodes[0].children[0] = kept_child;
+    if (!rejected){
+        return snapshot_failure("point cloud nodes outside the cloud were accepted");
+    }
+
+    // a large scene of plain shapes restores with one bulk add
+    const size_t count = 1000000;
+    Kitty_Object* circles = malloc(count * sizeof(Kitty_Object));
+    for (size_t i = 0; i < count; i++){
+        Kitty_Object* c = Kitty_CreateCircle((Kitty_Point){(int)(i % 800), (int)(i / 800 % 600)}, 2.0f, i % 2, (Kitty_Color){255, 255, 255, 255});
+        circles[i] = *c;
+        circles[i].id = i + 1;
+        free(c);
+    }
+    Kitty_ClearObjects();
+    Kitty_AddObjects(circles, count);
+    free(circles);
+    clock_t begin = clock();
+    result = Kitty_SaveScene(path, NULL, 0);
+    double save_ms = (double)(clock() - begin) * 1000.0 / CLOCKS_PER_SEC;
+    begin = clock();
+    if (result != KITTY_SUCCESS || (result = Kitty_LoadScene(path, NULL, 0)) != KITTY_SUCCESS || Kitty_GetObjectCount() != count){
+        printf("Snapshot of %zu circles failed with error code: %d\n", count, result);
+        return snapshot_failure("large scene round trip failed");
+    }
+    double load_ms = (double)(clock() - begin) * 1000.0 / CLOCKS_PER_SEC;
+    size_t index;
+    Kitty_Object last;
+    if (Kitty_FindObject(count, &index) != KITTY_SUCCESS || index != count - 1 || Kitty_GetObject(index, &last) != KITTY_SUCCESS ||
+        ((Kitty_ObjCircle*)last.data)->position.x != (int)((count - 1) % 800)){
+        return snapshot_failure("large scene lost objects");
+    }
+    printf("Scene snapshot of %zu circles: save %.1f ms, load %.1f ms.\n", count, save_ms, load_ms);
+    remove(path);
+
+    Kitty_SetCameraPosition((Kitty_Vertex3D){10, 0, 0}); // back to the defaults for later tests
+    Kitty_SetCameraOrigin((Kitty_Point3D){0, 0, 0});
+    if ((result = Kitty_Quit())) {
+        printf("Kitty_Quit failed with error code: %d\n", result);
+        return 1;
+    }
+    SDL_FreeSurface(atlas->sdl_surface);
+    free(atlas);
+
+    printf("Scene snapshot test passed successfully.\n");
+    return 0;
+}
+
+// updates the world until nothing is loading or integrating, checking the integration budget on the way
+static int settle_world(Kitty_World* world, size_t budget){
+    for (int frame = 0; frame < 2000; frame++){
+        size_t before = Kitty_GetObjectCount();
+        Kitty_WorldStats stats;
+        int result = Kitty_UpdateWorld(world);
+        Kitty_GetWorldStats(world, &stats);
+        if (result != KITTY_SUCCESS || Kitty_GetObjectCount() > before + budget){
+            printf("World update failed (%d) or went over its budget (%zu objects).\n", result, Kitty_GetObjectCount() - before);
+            return 1;
+        }
+        if (stats.loading_cells == 0 && stats.integrating_cells == 0){
+            return 0;
+        }
+        SDL_Delay(1);
+    }
+    printf("The world never settled.\n");
+    return 1;
+}
+
+static bool world_has(Uint64 id){
+    size_t index;
+    return Kitty_FindObject(id, &index) == KITTY_SUCCESS;
+}
+
+int test_world_partition(){
+    int result = Kitty_Init("Kitty Engine World Partition Test", 800, 600);
+    if (result != KITTY_SUCCESS){
+        printf("Kitty_Init failed with error code: %d\n", result);
+        return 1;
+    }
+
+    // cells 0..5 along x, 100 pixels each with ids cell * 1000 + i; the neighbours along z have no snapshot
+    for (int cx = 0; cx < 6; cx++){
+        Kitty_Object pixels[100];
+        for (int i = 0; i < 100; i++){
+            Kitty_Object* pixel = Kitty_CreatePixel((Kitty_Point){cx * 100 + i, 0}, (Kitty_Color){255, 255, 255, 255});
+            pixels[i] = *pixel;
+            pixels[i].id = (Uint64)cx * 1000 + i + 1;
+            free(pixel);
+        }
+        result = Kitty_SaveWorldCell(".", cx, 0, pixels, 100, NULL, 0);
+        for (int i = 0; i < 100; i++){
+            free(pixels[i].data);
+        }
+        if (result != KITTY_SUCCESS){
+            printf("Kitty_SaveWorldCell failed with error code: %d\n", result);
+            Kitty_Quit();
+            return 1;
+        }
+    }
+
+    Kitty_WorldSettings settings = { ".", 100.0f, 120.0f, 220.0f, 50, NULL, 0 };
+    Kitty_WorldSettings bad = settings;
+    bad.unload_radius = 50.0f;
+    if (Kitty_OpenWorld(&bad)){
+        printf("Kitty_OpenWorld accepted an unload radius inside the load radius.\n");
+        Kitty_Quit();
+        return 1;
+    }
+    Kitty_World* world = Kitty_OpenWorld(&settings);
+    Kitty_SetCameraPosition((Kitty_Vertex3D){50, 0, 50});
+    if (!world || settle_world(world, 50)){
+        Kitty_CloseWorld(world);
+        Kitty_Quit();
+        return 1;
+    }
+    // centers within 120: cells 0 and 1 plus three empty neighbours
+    Kitty_WorldStats stats;
+    Kitty_GetWorldStats(world, &stats);
+    if (Kitty_GetObjectCount() != 200 || !world_has(1) || !world_has(1100) || world_has(2001) ||
+        stats.resident_cells != 5 || stats.objects_integrated != 200 || stats.bytes_read == 0){
+        printf("Wrong cells resident around the start (%zu objects, %d cells).\n", Kitty_GetObjectCount(), stats.resident_cells);
+        Kitty_CloseWorld(world);
+        Kitty_Quit();
+        return 1;
+    }
+
+    // a small step stays inside the hysteresis band, then a long move swaps the cells;
+    // cell 2 was queued by the step and is still within the unload radius at the end
+    Kitty_SetCameraPosition((Kitty_Vertex3D){130, 0, 50});
+    Kitty_UpdateWorld(world);
+    if (!world_has(1)){
+        printf("Cell 0 was dropped inside the unload radius.\n");
+        Kitty_CloseWorld(world);
+        Kitty_Quit();
+        return 1;
+    }
+    Kitty_SetCameraPosition((Kitty_Vertex3D){450, 0, 50});
+    if (settle_world(world, 50)){
+        Kitty_CloseWorld(world);
+        Kitty_Quit();
+        return 1;
+    }
+    Kitty_GetWorldStats(world, &stats);
+    if (world_has(1) || world_has(1100) || !world_has(2001) || !world_has(5100) || Kitty_GetObjectCount() != 400 ||
+        stats.cells_unloaded == 0 || stats.objects_removed == 0){
+        printf("Wrong cells resident after moving (%zu objects).\n", Kitty_GetObjectCount());
+        Kitty_CloseWorld(world);
+        Kitty_Quit();
+        return 1;
+    }
+    printf("World partition: %zu cells loaded, %zu unloaded, %zu bytes read in %.2f ms.\n",
+           stats.cells_loaded, stats.cells_unloaded, stats.bytes_read, stats.read_ms);
+    Kitty_CloseWorld(world);
+    if (Kitty_GetObjectCount() != 0){
+        printf("Kitty_CloseWorld left %zu objects in the store.\n", Kitty_GetObjectCount());
+        Kitty_Quit();
+        return 1;
+    }
+    for (int cx = 0; cx < 6; cx++){
+        char path[64];
+        snprintf(path, sizeof(path), "./cell_%d_0.ksn", cx);
+        remove(path);
+    }
+
+    Kitty_SetCameraPosition((Kitty_Vertex3D){10, 0, 0}); // back to the default for later tests
+    if ((result = Kitty_Quit())) {
+        printf("Kitty_Quit failed with error code: %d\n", result);
+        return 1;
+    }
+
+    printf("World partition test passed successfully.\n");
+    return 0;
+}
+
+typedef struct {
+    int fired;
+    int limit;                  // a periodic timer cancels itself after this many calls, 0 for never
+    Kitty_TimerID cancel;       // cancelled by the first call
+    double first_ms;            // when it fired first, relative to the start of the test
+} timer_probe;
+
+static double timer_test_start = 0.0;
+
+static void count_timer(Kitty_TimerID timer, void* user_data){
+    timer_probe* probe = (timer_probe*)user_data;
+    if (probe->fired++ == 0){
+        probe->first_ms = (double)SDL_GetPerformanceCounter() * 1000.0 / (double)SDL_GetPerformanceFrequency() - timer_test_start;
+        if (probe->cancel){
+            Kitty_CancelTimer(probe->cancel);
+        }
+    }
+    if (probe->limit && probe->fired == probe->limit){
+        Kitty_CancelTimer(timer);
+    }
+}
+
+int test_timer_wheel(){
+    int result = Kitty_Init("Kitty Engine Timer Wheel Test", 800, 600);
+    if (result != KITTY_SUCCESS){
+        printf("Kitty_Init failed with error code: %d\n", result);
+        return 1;
+    }
+    timer_test_start = (double)SDL_GetPerformanceCounter() * 1000.0 / (double)SDL_GetPerformanceFrequency();
+
+    // 100k timers far in the future, spread over every level of the wheel
+    const int far_count = 100000;
+    Kitty_TimerID* far = (Kitty_TimerID*)malloc(far_count * sizeof(Kitty_TimerID));
+    timer_probe far_probe = {0};
+    for (int i = 0; i < far_count; i++){
+        Uint32 delay = 1000 + (Uint32)(((Uint64)i * 2654435761u) % 3000000000u);
+        if (Kitty_StartTimer(delay, 0, count_timer, &far_probe, &far[i]) != KITTY_SUCCESS){
+            printf("Kitty_StartTimer failed for a far timer.\n");
+            free(far);
+            Kitty_Quit();
+            return 1;
+        }
+    }
+
+    timer_probe now = {0}, victim = {0}, periodic = {0}, cascaded = {0};
+    Kitty_TimerID victim_id, periodic_id, cascaded_id;
+    Kitty_StartTimer(20, 0, count_timer, &victim, &victim_id);
+    now.cancel = victim_id;
+    periodic.limit = 3;
+    Kitty_StartTimer(0, 0, count_timer, &now, NULL);
+    Kitty_StartTimer(5, 5, count_timer, &periodic, &periodic_id);
+    Kitty_StartTimer(100, 0, count_timer, &cascaded, &cascaded_id); // starts above level 0
+    if (Kitty_StartTimer(1, 0, NULL, NULL, NULL) != KITTY_INVALID_ARGUMENT){
+        printf("Kitty_StartTimer accepted a timer without a callback.\n");
+        free(far);
+        Kitty_Quit();
+        return 1;
+    }
+
+    double worst_ms = 0.0;
+    int frames = 0;
+    while (cascaded.fired == 0 && frames < 2000){
+        SDL_Delay(1);
+        Kitty_UpdateObjectState();
+        Kitty_FrameStats stats = Kitty_GetFrameStats();
+        if (stats.timer_ms > worst_ms){
+            worst_ms = stats.timer_ms;
+        }
+        frames++;
+    }
+    if (now.fired != 1 || victim.fired != 0 || periodic.fired != 3 || cascaded.fired != 1 || far_probe.fired != 0 ||
+        cascaded.first_ms < 100.0 || Kitty_GetTimerCount() != (size_t)far_count){
+        printf("Timers fired wrong: now %d, cancelled %d, periodic %d, cascaded %d at %.1f ms, far %d, %zu outstanding.\n",
+               now.fired, victim.fired, periodic.fired, cascaded.fired, cascaded.first_ms, far_probe.fired, Kitty_GetTimerCount());
+        free(far);
+        Kitty_Quit();
+        return 1;
+    }
+    if (Kitty_CancelTimer(victim_id) != KITTY_OBJECT_NOT_FOUND || Kitty_CancelTimer(periodic_id) != KITTY_OBJECT_NOT_FOUND ||
+        Kitty_CancelTimer(cascaded_id) != KITTY_OBJECT_NOT_FOUND || Kitty_CancelTimer(0) != KITTY_OBJECT_NOT_FOUND){
+        printf("Kitty_CancelTimer accepted a stale timer.\n");
+        free(far);
+        Kitty_Quit();
+        return 1;
+    }
+
+    double cancel_start = (double)SDL_GetPerformanceCounter() * 1000.0 / (double)SDL_GetPerformanceFrequency();
+    for (int i = 0; i < far_count; i++){
+        if (Kitty_CancelTimer(far[i]) != KITTY_SUCCESS){
+            printf("Kitty_CancelTimer failed for a far timer.\n");
+            free(far);
+            Kitty_Quit();
+            return 1;
+        }
+    }
+    double cancel_ms = (double)SDL_GetPerformanceCounter() * 1000.0 / (double)SDL_GetPerformanceFrequency() - cancel_start;
+    free(far);
+    if (Kitty_GetTimerCount() != 0){
+        printf("%zu timers left after cancelling all of them.\n", Kitty_GetTimerCount());
+        Kitty_Quit();
+        return 1;
+    }
+    printf("Timer wheel: %d updates with %d timers waiting, worst %.3f ms; cancelling them took %.2f ms.\n",
+           frames, far_count, worst_ms, cancel_ms);
+
+    if ((result = Kitty_Quit())) {
+        printf("Kitty_Quit failed with error code: %d\n", result);
+        return 1;
+    }
+
+    printf("Timer wheel test passed successfully.\n");
+    return 0;
+}
+
+#define LOG_TEST_THREADS 4
+#define LOG_TEST_RECORDS 20000
+
+static int log_writer(void* data){
+    int thread = (int)(intptr_t)data;
+    for (Sint64 i = 0; i < LOG_TEST_RECORDS; i++){
+        Kitty_LogRecord record = { 0.0, KITTY_EVENT_USER + thread, 0, 0, -1, { i, i * 3, ~i, thread } };
+        Kitty_LogEvent(&record);
+    }
+    return 0;
+}
+
+// a record is torn if its args do not belong together; per thread the sequence must not skip or go back
+static int check_log(const Kitty_LogRecord* records, size_t count, size_t* out_user){
+    Sint64 last[LOG_TEST_THREADS];
+    for (int t = 0; t < LOG_TEST_THREADS; t++){
+        last[t] = -1;
+    }
+    *out_user = 0;
+    for (size_t i = 0; i < count; i++){
+        const Kitty_LogRecord* r = &records[i];
+        if (i > 0 && r->time_ms < records[i - 1].time_ms){
+            return 1;
+        }
+        int t = r->code - KITTY_EVENT_USER;
+        if (t < 0 || t >= LOG_TEST_THREADS){
+            continue;
+        }
+        if (r->args[1] != r->args[0] * 3 || r->args[2] != ~r->args[0] || r->args[3] != t || (last[t] >= 0 && r->args[0] != last[t] + 1)){
+            return 1;
+        }
+        last[t] = r->args[0];
+        (*out_user)++;
+    }
+    return 0;
+}
+
+int test_diagnostic_log(){
+    int result = Kitty_Init("Kitty Engine Diagnostic Log Test", 800, 600);
+    if (result != KITTY_SUCCESS){
+        printf("Kitty_Init failed with error code: %d\n", result);
+        return 1;
+    }
+
+    // an object of no known type fails to draw, the rectangle after it is still drawn
+    Kitty_SetRenderBackend(KITTY_BACKEND_SOFTWARE);
+    Kitty_Object broken = {0};
+    broken.type = (enum Kitty_ObjType)99;
+    broken.id = 77;
+    Kitty_Object* rectangle = Kitty_CreateRectangle((Kitty_Point){100, 100}, 200, 150, true, (Kitty_Color){0, 255, 0, 255});
+    Kitty_AddObject(broken);
+    Kitty_AddObject(*rectangle);
+    free(rectangle);
+    Uint32* pixels = malloc(800 * 600 * sizeof(Uint32));
+    Kitty_ClearScreen((Kitty_Color){0, 0, 0, 255});
+    int frame_result = Kitty_RenderObjects();
+    Kitty_ReadPixels(pixels, 800 * sizeof(Uint32));
+    Kitty_FlipBuffers();
+    Uint32 drawn = pixels[150 * 800 + 150];
+    free(pixels);
+    Kitty_SetQualityLevel(2);
+    Kitty_SetQualityLevel(0);
+
+    Kitty_LogRecord records[16];
+    size_t count = Kitty_ReadLog(60.0, records, 16);
+    char line[256];
+    int length = count >= 3 ? Kitty_FormatLogRecord(&records[0], line, sizeof(line)) : 0;
+    if (frame_result != KITTY_UNKNOWN_ERROR || drawn != 0xFF00FF00u || count != 3 || records[0].code != KITTY_UNKNOWN_ERROR ||
+        records[0].object_index != 0 || records[0].object_id != 77 || records[1].code != KITTY_EVENT_QUALITY_CHANGED ||
+        records[1].args[1] != 2 || records[2].args[1] != 0 || length <= 0 || !strstr(line, "KITTY_UNKNOWN_ERROR") || !strstr(line, "id 77")){
+        printf("Frame errors were not logged: frame %d, pixel %08X, %zu records.\n", frame_result, (unsigned)drawn, count);
+        Kitty_Quit();
+        return 1;
+    }
+    Kitty_ClearObjects();
+
+    // writers on several threads while the log is read, nothing read may be torn or out of order
+    size_t capacity = LOG_TEST_THREADS * LOG_TEST_RECORDS;
+    Kitty_LogRecord* all = malloc(capacity * sizeof(Kitty_LogRecord));
+    SDL_Thread* writers[LOG_TEST_THREADS];
+    for (int t = 0; t < LOG_TEST_THREADS; t++){
+        writers[t] = SDL_CreateThread(log_writer, "log writer", (void*)(intptr_t)t);
+    }
+    int torn = 0;
+    size_t user = 0;
+    for (int pass = 0; pass < 20; pass++){
+        torn |= check_log(all, Kitty_ReadLog(60.0, all, capacity), &user);
+    }
+    for (int t = 0; t < LOG_TEST_THREADS; t++){
+        SDL_WaitThread(writers[t], NULL);
+    }
+    torn |= check_log(all, Kitty_ReadLog(60.0, all, capacity), &user);
+    free(all);
+    if (torn || user < LOG_TEST_THREADS * 4000){
+        printf("Concurrent log read back torn (%d) or short (%zu records).\n", torn, user);
+        Kitty_Quit();
+        return 1;
+    }
+
+    // disabled the log drops records, and appending costs little when on
+    Kitty_SetLogEnabled(false);
+    Kitty_LogRecord user_record = { 0.0, KITTY_EVENT_USER + 100, 0, 0, -1, {0} };
+    Kitty_LogEvent(&user_record);
+    Kitty_SetLogEnabled(true);
+    if (Kitty_ReadLog(60.0, records, 1) != 1 || records[0].code == KITTY_EVENT_USER + 100){
+        printf("A record was logged while the log was off.\n");
+        Kitty_Quit();
+        return 1;
+    }
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (int i = 0; i < 1000000; i++){
+        user_record.args[0] = i;
+        Kitty_LogEvent(&user_record);
+    }
+    double ns = (double)(SDL_GetPerformanceCounter() - start) * 1e9 / (double)SDL_GetPerformanceFrequency() / 1000000.0;
+    FILE* dump = tmpfile();
+    if (!dump || Kitty_DumpLog(dump, 60.0) != KITTY_SUCCESS || ftell(dump) <= 0){
+        printf("Kitty_DumpLog wrote nothing.\n");
+        if (dump){
+            fclose(dump);
+        }
+        Kitty_Quit();
+        return 1;
+    }
+    fclose(dump);
+    printf("Diagnostic log: %zu records read back from %d threads, %.1f ns per record.\n", user, LOG_TEST_THREADS, ns);
+
+    if ((result = Kitty_Quit())) {
+        printf("Kitty_Quit failed with error code: %d\n", result);
+        return 1;
+    }
+
+    printf("Diagnostic log test passed successfully.\n");
+    return 0;
+}
+
+int test_terrain(){
+    int result = Kitty_Init("Kitty Engine Terrain Test", 800, 600);
+    if (result != KITTY_SUCCESS){
+        printf("Kitty_Init failed with error code: %d\n", result);
+        return 1;
+    }
+
+    // rolling hills on a 257 x 257 grid, 8 x 8 chunks of 32 quads
+    Kitty_SetRenderBackend(KITTY_BACKEND_SOFTWARE);
+    int size = 257;
+    Uint16* heights = malloc((size_t)size * size * sizeof(Uint16));
+    for (int z = 0; z < size; z++){
+        for (int x = 0; x < size; x++){
+            heights[z * size + x] = (Uint16)(32767 + 16000 * sinf(x * 0.05f) + 16000 * cosf(z * 0.07f));
+        }
+    }
+    Kitty_TerrainSettings settings = { {-128, 40, 0}, 1.0f, 30.0f, 32, 150.0f, 4.0f, {40, 90, 30, 255}, {230, 230, 220, 255} };
+    Kitty_Object* terrain = Kitty_CreateTerrain(heights, size, size, &settings);
+    settings.chunk_size = 24;
+    if (!terrain || Kitty_CreateTerrain(heights, size, size, &settings) || Kitty_CreateTerrain(heights, 1, size, &settings)){
+        printf("Kitty_CreateTerrain failed or took a bad chunk size.\n");
+        Kitty_Quit();
+        return 1;
+    }
+    Kitty_ObjTerrain* terrain_data = (Kitty_ObjTerrain*)terrain->data;
+    terrain_data->position = (Kitty_Point3D){400, 300, 0};
+    Kitty_AddObject(*terrain);
+    free(terrain);
+
+    // the second frame steps over the first rows, which go behind the viewer
+    Uint32* pixels = malloc(800 * 600 * sizeof(Uint32));
+    size_t full_triangles = 64 * 32 * 32 * 2;
+    for (int frame = 0; frame < 2; frame++){
+        Kitty_Object current;
+        Kitty_GetObject(0, &current);
+        terrain_data = (Kitty_ObjTerrain*)current.data;
+        terrain_data->position.z = frame * 150.0f;
+        Kitty_ClearScreen((Kitty_Color){0, 0, 0, 255});
+        if ((result = Kitty_RenderObjects())){
+            printf("Kitty_RenderObjects (terrain) failed with error code: %d\n", result);
+            free(pixels);
+            free(heights);
+            Kitty_Quit();
+            return 1;
+        }
+        Kitty_ReadPixels(pixels, 800 * sizeof(Uint32));
+        Kitty_FlipBuffers();
+        size_t lit = 0;
+        for (size_t i = 0; i < 800 * 600; i++){
+            lit += (pixels[i] & 0x00FFFFFF) != 0;
+        }
+        if (terrain_data->chunks_drawn + terrain_data->chunks_culled != 64 || terrain_data->triangles_drawn == 0 ||
+            terrain_data->triangles_drawn >= full_triangles || lit < 1000 || (frame == 1 && terrain_data->chunks_culled == 0)){
+            printf("Terrain drew %zu chunks, culled %zu, %zu triangles, %zu pixels.\n", terrain_data->chunks_drawn,
+                   terrain_data->chunks_culled, terrain_data->triangles_drawn, lit);
+            free(pixels);
+            free(heights);
+            Kitty_Quit();
+            return 1;
+        }
+    }
+    free(pixels);
+
+    // the same heights through a raw file and through a snapshot
+    settings.chunk_size = 32;
+    FILE* file = fopen("kitty_terrain.r16", "wb");
+    for (int i = 0; i < size * size; i++){
+        Uint8 sample[2] = { heights[i] & 0xFF, heights[i] >> 8 };
+        fwrite(sample, 1, 2, file);
+    }
+    fclose(file);
+    Kitty_Object* loaded = Kitty_LoadTerrain("kitty_terrain.r16", &settings);
+    remove("kitty_terrain.r16");
+    bool same = loaded && ((Kitty_ObjTerrain*)loaded->data)->width == size &&
+                memcmp(((Kitty_ObjTerrain*)loaded->data)->heights, heights, (size_t)size * size * sizeof(Uint16)) == 0;
+    if (loaded){
+        Kitty_AddObject(*loaded);
+        free(loaded);
+    }
+    if (!same || Kitty_LoadTerrain("missing.r16", &settings)){
+        printf("Kitty_LoadTerrain did not read the heights back.\n");
+        free(heights);
+        Kitty_Quit();
+        return 1;
+    }
+    if ((result = Kitty_SaveScene("kitty_terrain.ksn", NULL, 0)) || Kitty_ClearObjects() ||
+        (result = Kitty_LoadScene("kitty_terrain.ksn", NULL, 0)) || Kitty_GetObjectCount() != 2){
+        printf("Terrain snapshot failed with error code: %d\n", result);
+        free(heights);
+        Kitty_Quit();
+        return 1;
+    }
+    remove("kitty_terrain.ksn");
+    for (size_t i = 0; i < 2; i++){
+        Kitty_Object restored;
+        Kitty_GetObject(i, &restored);
+        Kitty_ObjTerrain* restored_data = (Kitty_ObjTerrain*)restored.data;
+        if (restored.type != KITTY_OBJECT_TERRAIN || restored_data->chunks_x != 8 || restored_data->lod_count != 6 ||
+            memcmp(restored_data->heights, heights, (size_t)size * size * sizeof(Uint16)) != 0){
+            printf("Terrain snapshot did not restore the heights.\n");
+            free(heights);
+            Kitty_Quit();
+            return 1;
+        }
+    }
+    free(heights);
+
+    if ((result = Kitty_Quit())) {
+        printf("Kitty_Quit failed with error code: %d\n", result);
+        return 1;
+    }
+
+    printf("Terrain test passed successfully.\n");
+    return 0;
+}
+
 int main(void){
     unsigned int failed = 0;
 
@@ -311,6 +2839,32 @@ int main(void){
     failed += test_memory_free();
     failed += test_memory_stress_1000();
     failed += test_memory_stress_100000();
+    failed += test_object_store_growth();
+    failed += test_tilemap();
+    failed += test_polygon();
+    failed += test_polyline_and_path();
+    failed += test_plot();
+    failed += test_point_cloud();
+    failed += test_skinning();
+    failed += test_morph_targets();
+    failed += test_impostors();
+    failed += test_dynamic_resolution();
+    failed += test_frame_governor();
+    failed += test_render_backends();
+    failed += test_frames_in_flight();
+    failed += test_post_processing();
+    failed += test_anti_aliasing();
+    failed += test_texture_formats();
+    failed += test_virtual_texture();
+    failed += test_memory_stats();
+    failed += test_zero_allocation();
+    failed += test_bulk_objects();
+    failed += test_object_ids();
+    failed += test_scene_snapshot();
+    failed += test_world_partition();
+    failed += test_timer_wheel();
+    failed += test_diagnostic_log();
+    failed += test_terrain();
 
     if (failed){
         printf("%u tests failed.\n", failed);